@@ -1,44 +1,126 @@
 #include "SuffixArray.h"
 
+#include <algorithm>
 #include <fstream>
 #include <string>
 #include <cstdlib>
 #include <cstring>
 
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "../util/suffix_array.hh"
+
+using namespace std;
+
 namespace
 {
 
+typedef SuffixArray::INDEX INDEX;
+
 const int LINE_MAX_LENGTH = 10000;
 
-} // namespace
+// longest common prefix stored in the LCP array, in words
+const INDEX MAX_LCP = 255;
 
-using namespace std;
+// neighbours checked with the LCP array before falling back to binary search
+const int LCP_SCAN_LIMIT = 64;
+
+const INDEX EMPTY = (INDEX) -1;
+
+// On-disk layout: the header, then each array at an 8-byte aligned offset,
+// so that a saved suffix array can be used straight from a memory mapping.
+const char FILE_MAGIC[8] = { 'b', 'i', 'c', 'o', 'n', 'S', 'A', '\0' };
+const INDEX FILE_VERSION = 1;
+
+struct FileHeader {
+  char magic[8];
+  INDEX version;
+  INDEX size;
+  INDEX sentenceCount;
+  INDEX useDocument;
+  INDEX documentCount;
+  INDEX documentNameLength;
+};
+
+size_t Align( size_t offset )
+{
+  return (offset + 7) & ~(size_t)7;
+}
+
+struct FileLayout {
+  size_t array, index, sentence, lcp, wordInSentence, sentenceLength;
+  size_t document, documentName, documentNameBuffer, end;
+
+  explicit FileLayout( const FileHeader &header ) {
+    array = Align( sizeof( FileHeader ) );
+    index = Align( array + sizeof( WORD_ID ) * header.size );
+    sentence = Align( index + sizeof( INDEX ) * header.size );
+    lcp = Align( sentence + sizeof( INDEX ) * header.size );
+    wordInSentence = Align( lcp + header.size );
+    sentenceLength = Align( wordInSentence + header.size );
+    document = Align( sentenceLength + header.sentenceCount );
+    documentName = Align( document + sizeof( INDEX ) * header.documentCount );
+    documentNameBuffer = Align( documentName + sizeof( INDEX ) * header.documentCount );
+    end = documentNameBuffer + header.documentNameLength;
+  }
+};
+
+// write an array at the given offset of the file, padding up to it
+void WriteAt( FILE *pFile, size_t &position, size_t offset, const void *data, size_t bytes )
+{
+  static const char padding[8] = { 0 };
+  fwrite( padding, 1, offset - position, pFile );
+  fwrite( data, 1, bytes, pFile );
+  position = offset + bytes;
+}
+
+struct CompareWordString {
+  explicit CompareWordString( const vector< WORD > &vocab ) : m_vocab(vocab) {}
+  bool operator()( WORD_ID a, WORD_ID b ) const {
+    return m_vocab[a] < m_vocab[b];
+  }
+  const vector< WORD > &m_vocab;
+};
+
+} // namespace
 
 SuffixArray::SuffixArray()
   : m_array(NULL),
     m_index(NULL),
-    m_buffer(NULL),
+    m_lcp(NULL),
     m_wordInSentence(NULL),
     m_sentence(NULL),
     m_sentenceLength(NULL),
     m_document(NULL),
     m_documentName(NULL),
+    m_documentNameBuffer(NULL),
     m_documentNameLength(0),
     m_documentCount(0),
     m_useDocument(false),
     m_vcb(),
     m_size(0),
-    m_sentenceCount(0) { }
+    m_sentenceCount(0),
+    m_mapped(NULL),
+    m_mappedSize(0) { }
 
 SuffixArray::~SuffixArray()
 {
+  if (m_mapped != NULL) {
+    munmap(m_mapped, m_mappedSize);
+    return;
+  }
   free(m_array);
   free(m_index);
+  free(m_lcp);
   free(m_wordInSentence);
   free(m_sentence);
   free(m_sentenceLength);
   free(m_document);
   free(m_documentName);
+  free(m_documentNameBuffer);
 }
 
 void SuffixArray::Create(const string& fileName )
@@ -82,12 +164,14 @@ void SuffixArray::Create(const string& fileName )
 
   // allocate memory
   m_array = (WORD_ID*) calloc( sizeof( WORD_ID ), m_size );
-  m_index = (INDEX*) calloc( sizeof( INDEX ), m_size );
+  m_index = (INDEX*) calloc( sizeof( INDEX ), m_size+1 ); // room for the sentinel
+  m_lcp = (unsigned char*) calloc( sizeof( unsigned char ), m_size );
   m_wordInSentence = (char*) calloc( sizeof( char ), m_size );
   m_sentence = (INDEX*) calloc( sizeof( INDEX ), m_size );
   m_sentenceLength = (char*) calloc( sizeof( char ), m_sentenceCount );
   CheckAllocation(m_array != NULL, "m_array");
   CheckAllocation(m_index != NULL, "m_index");
+  CheckAllocation(m_lcp != NULL, "m_lcp");
   CheckAllocation(m_wordInSentence != NULL, "m_wordInSentence");
   CheckAllocation(m_sentence != NULL, "m_sentence");
   CheckAllocation(m_sentenceLength != NULL, "m_sentenceLength");
@@ -115,12 +199,10 @@ void SuffixArray::Create(const string& fileName )
     vector< WORD_ID >::const_iterator i;
 
     for( i=words.begin(); i!=words.end(); i++) {
-      m_index[ wordIndex ] = wordIndex;
       m_sentence[ wordIndex ] = sentenceId;
       m_wordInSentence[ wordIndex ] = i-words.begin();
       m_array[ wordIndex++ ] = *i;
     }
-    m_index[ wordIndex ] = wordIndex;
     m_array[ wordIndex++ ] = m_endOfSentence;
     m_sentenceLength[ sentenceId++ ] = words.size();
   }
@@ -129,16 +211,10 @@ void SuffixArray::Create(const string& fileName )
   // List(0,9);
 
   // sort
-  m_buffer = (INDEX*) calloc( sizeof( INDEX ), m_size );
-
-  if (m_buffer == NULL) {
-    cerr << "Error: cannot allocate memory to m_buffer" << endl;
-    exit(1);
-  }
-
-  Sort( 0, m_size-1 );
-  free( m_buffer );
+  ComputeWordRanks();
+  Sort();
   cerr << "done sorting" << endl;
+  ComputeLcp();
 }
 
 // very specific code to deal with common crawl document ids
@@ -180,35 +256,68 @@ bool SuffixArray::ProcessDocumentLine( const char *line, const size_t sentenceId
   return true;
 }
 
-// good ol' quick sort
-void SuffixArray::Sort(INDEX start, INDEX end)
-{
-  if (start == end) return;
-  INDEX mid = (start+end+1)/2;
-  Sort( start, mid-1 );
-  Sort( mid, end );
-
-  // merge
-  INDEX i = start;
-  INDEX j = mid;
-  INDEX k = 0;
-  INDEX length = end-start+1;
-  while( k<length ) {
-    if (i == mid ) {
-      m_buffer[ k++ ] = m_index[ j++ ];
-    } else if (j > end ) {
-      m_buffer[ k++ ] = m_index[ i++ ];
-    } else {
-      if (CompareIndex( m_index[i], m_index[j] ) < 0) {
-        m_buffer[ k++ ] = m_index[ i++ ];
-      } else {
-        m_buffer[ k++ ] = m_index[ j++ ];
-      }
-    }
+// the order of the words in the suffix array is the string order, so
+// number them in that order to compare words as integers
+void SuffixArray::ComputeWordRanks()
+{
+  vector< WORD_ID > ids( m_vcb.vocab.size() );
+  for(WORD_ID id=0; id<ids.size(); id++) {
+    ids[id] = id;
   }
+  sort( ids.begin(), ids.end(), CompareWordString( m_vcb.vocab ) );
+  m_wordRank.resize( ids.size() );
+  for(INDEX rank=0; rank<ids.size(); rank++) {
+    m_wordRank[ ids[rank] ] = rank;
+  }
+}
 
-  memcpy( ((char*)m_index) + sizeof( INDEX ) * start,
-          ((char*)m_buffer), sizeof( INDEX ) * (end-start+1) );
+// induced sorting over the word ranks, with a sentinel that makes a suffix
+// that runs into the end of the corpus sort before its extensions
+void SuffixArray::Sort()
+{
+  if (m_size >= EMPTY - 1) {
+    cerr << "Error: corpus too large for a suffix array with 32-bit indices" << endl;
+    exit(1);
+  }
+  INDEX *text = (INDEX*) calloc( sizeof( INDEX ), m_size+1 );
+  CheckAllocation(text != NULL, "text");
+  for(INDEX i=0; i<m_size; i++) {
+    text[i] = m_wordRank[ m_array[i] ] + 1;
+  }
+  text[ m_size ] = 0;
+  util::InducedSuffixSort< INDEX >( text, m_index, m_size+1, m_wordRank.size()+1 );
+  free( text );
+
+  // drop the sentinel, which is the smallest suffix
+  memmove( m_index, m_index+1, sizeof( INDEX ) * m_size );
+}
+
+// longest common prefix of each suffix with the previous one in the suffix
+// array (Kasai et al, 2001)
+void SuffixArray::ComputeLcp()
+{
+  INDEX *rank = (INDEX*) calloc( sizeof( INDEX ), m_size );
+  CheckAllocation(rank != NULL, "rank");
+  for(INDEX i=0; i<m_size; i++) {
+    rank[ m_index[i] ] = i;
+  }
+  INDEX common = 0;
+  for(INDEX position=0; position<m_size; position++) {
+    if (rank[position] == 0) {
+      m_lcp[0] = 0;
+      common = 0;
+      continue;
+    }
+    INDEX previous = m_index[ rank[position]-1 ];
+    while( position+common < m_size &&
+           previous+common < m_size &&
+           m_array[ position+common ] == m_array[ previous+common ] ) {
+      common++;
+    }
+    m_lcp[ rank[position] ] = min( common, MAX_LCP );
+    if (common > 0) common--;
+  }
+  free( rank );
 }
 
 int SuffixArray::CompareIndex( INDEX a, INDEX b ) const
@@ -257,9 +366,11 @@ int SuffixArray::FindMatches( const vector< WORD > &phrase, INDEX &firstMatch, I
 int SuffixArray::LimitedCount( const vector< WORD > &phrase, INDEX min, INDEX &firstMatch, INDEX &lastMatch, INDEX search_start, INDEX search_end )
 {
   // cerr << "FindFirst\n";
+  vector< INDEX > ranks;
+  GetWordRanks( phrase, ranks );
   INDEX start = search_start;
   INDEX end = (search_end == (INDEX)-1) ? (m_size-1) : search_end;
-  INDEX mid = FindFirst( phrase, start, end );
+  INDEX mid = FindFirst( ranks, start, end );
   // cerr << "done\n";
   if (mid == m_size) return 0; // no matches
   if (min == 1) return 1;      // only existance check
@@ -267,11 +378,11 @@ int SuffixArray::LimitedCount( const vector< WORD > &phrase, INDEX min, INDEX &f
   int matchCount = 1;
 
   //cerr << "before...\n";
-  firstMatch = FindLast( phrase, mid, start, -1 );
+  firstMatch = FindLast( ranks, mid, start, -1 );
   matchCount += mid - firstMatch;
 
   //cerr << "after...\n";
-  lastMatch = FindLast( phrase, mid, end, 1 );
+  lastMatch = FindLast( ranks, mid, end, 1 );
   matchCount += lastMatch - mid;
 
   return matchCount;
@@ -279,12 +390,52 @@ int SuffixArray::LimitedCount( const vector< WORD > &phrase, INDEX min, INDEX &f
 
 SuffixArray::INDEX SuffixArray::FindLast( const vector< WORD > &phrase, INDEX start, INDEX end, int direction )
 {
+  vector< INDEX > ranks;
+  GetWordRanks( phrase, ranks );
+  return FindLast( ranks, start, end, direction );
+}
+
+SuffixArray::INDEX SuffixArray::FindFirst( const vector< WORD > &phrase, INDEX &start, INDEX &end )
+{
+  vector< INDEX > ranks;
+  GetWordRanks( phrase, ranks );
+  return FindFirst( ranks, start, end );
+}
+
+int SuffixArray::Match( const vector< WORD > &phrase, INDEX index )
+{
+  vector< INDEX > ranks;
+  GetWordRanks( phrase, ranks );
+  return Match( ranks, index );
+}
+
+void SuffixArray::GetWordRanks( const vector< WORD > &phrase, vector< INDEX > &ranks ) const
+{
+  ranks.resize( phrase.size() );
+  for(size_t i=0; i<phrase.size(); i++) {
+    ranks[i] = m_wordRank[ m_vcb.GetWordID( phrase[i] ) ];
+  }
+}
+
+SuffixArray::INDEX SuffixArray::FindLast( const vector< INDEX > &phrase, INDEX start, INDEX end, int direction ) const
+{
+  // matches are usually few, so first walk along the LCP array
+  if (m_lcp != NULL && !phrase.empty() && phrase.size() <= MAX_LCP) {
+    for(int i=0; i<LCP_SCAN_LIMIT; i++) {
+      if (start == end) return start;
+      INDEX next = start + direction;
+      if (m_lcp[ direction > 0 ? next : start ] < phrase.size()) return start;
+      start = next;
+    }
+  }
+
   end += direction;
   while(true) {
     INDEX mid = ( start + end + (direction>0 ? 0 : 1) )/2;
 
     int match = Match( phrase, mid );
-    int matchNext = Match( phrase, mid+direction );
+    INDEX next = mid+direction;
+    int matchNext = next < m_size ? Match( phrase, next ) : 1; // also catches -1
     //cerr << "\t" << start << ";" << mid << ";" << end << " -> " << match << "," << matchNext << endl;
 
     if (match == 0 && matchNext != 0) return mid;
@@ -296,7 +447,7 @@ SuffixArray::INDEX SuffixArray::FindLast( const vector< WORD > &phrase, INDEX st
   }
 }
 
-SuffixArray::INDEX SuffixArray::FindFirst( const vector< WORD > &phrase, INDEX &start, INDEX &end )
+SuffixArray::INDEX SuffixArray::FindFirst( const vector< INDEX > &phrase, INDEX &start, INDEX &end ) const
 {
   while(true) {
     INDEX mid = ( start + end + 1 )/2;
@@ -313,14 +464,13 @@ SuffixArray::INDEX SuffixArray::FindFirst( const vector< WORD > &phrase, INDEX &
   }
 }
 
-int SuffixArray::Match( const vector< WORD > &phrase, INDEX index )
+int SuffixArray::Match( const vector< INDEX > &phrase, INDEX index ) const
 {
   INDEX pos = m_index[ index ];
   for(INDEX i=0; i<phrase.size() && i+pos<m_size; i++) {
-    int match = CompareWord( m_vcb.GetWordID( phrase[i] ), m_array[ pos+i ] );
-    // cerr << "{" << index << "+" << i << "," << pos+i << ":" << match << "}" << endl;
-    if (match != 0)
-      return match;
+    INDEX word = m_wordRank[ m_array[ pos+i ] ];
+    if (phrase[i] != word)
+      return phrase[i] < word ? -1 : 1;
   }
   return 0;
 }
@@ -345,16 +495,18 @@ void SuffixArray::PrintSentenceMatches( const std::vector< WORD > &phrase )
     cout <<  phrase[i];
   }
   cout << '\t';
+  vector< INDEX > ranks;
+  GetWordRanks( phrase, ranks );
   INDEX start = 0;
   INDEX end = m_size-1;
-  INDEX mid = FindFirst( phrase, start, end );
+  INDEX mid = FindFirst( ranks, start, end );
   if (mid == m_size) { // no matches
     cout << "0 matches" << endl;
     return;
   }
 
-  INDEX firstMatch = FindLast( phrase, mid, start, -1 );
-  INDEX lastMatch = FindLast( phrase, mid, end, 1 );
+  INDEX firstMatch = FindLast( ranks, mid, start, -1 );
+  INDEX lastMatch = FindLast( ranks, mid, end, 1 );
 
   // loop through all matches
   cout << (lastMatch-firstMatch+1) << " matches" << endl;
@@ -405,24 +557,33 @@ void SuffixArray::Save(const string& fileName ) const
   FILE *pFile = fopen ( fileName.c_str() , "w" );
   if (pFile == NULL) Error("cannot open",fileName);
 
-  fwrite( &m_size, sizeof(INDEX), 1, pFile );
-  fwrite( m_array, sizeof(WORD_ID), m_size, pFile ); // corpus
-  fwrite( m_index, sizeof(INDEX), m_size, pFile );   // suffix array
-  fwrite( m_wordInSentence, sizeof(char), m_size, pFile); // word index
-  fwrite( m_sentence, sizeof(INDEX), m_size, pFile); // sentence index
-
-  fwrite( &m_sentenceCount, sizeof(INDEX), 1, pFile );
-  fwrite( m_sentenceLength, sizeof(char), m_sentenceCount, pFile); // sentence length
-
-  char useDocument = m_useDocument; // not sure if that is needed
-  fwrite( &useDocument, sizeof(char), 1, pFile );
+  FileHeader header;
+  memset( &header, 0, sizeof( header ) );
+  memcpy( header.magic, FILE_MAGIC, sizeof( FILE_MAGIC ) );
+  header.version = FILE_VERSION;
+  header.size = m_size;
+  header.sentenceCount = m_sentenceCount;
+  header.useDocument = m_useDocument;
   if (m_useDocument) {
-    fwrite( &m_documentCount, sizeof(INDEX), 1, pFile );
-    fwrite( m_document, sizeof(INDEX), m_documentCount, pFile );
-    fwrite( m_documentName, sizeof(INDEX), m_documentCount, pFile );
-    fwrite( &m_documentNameLength, sizeof(INDEX), 1, pFile );
-    fwrite( m_documentNameBuffer, sizeof(char), m_documentNameLength, pFile );
+    header.documentCount = m_documentCount;
+    header.documentNameLength = m_documentNameLength;
   }
+  FileLayout layout( header );
+
+  size_t position = 0;
+  WriteAt( pFile, position, 0, &header, sizeof( header ) );
+  WriteAt( pFile, position, layout.array, m_array, sizeof(WORD_ID) * m_size ); // corpus
+  WriteAt( pFile, position, layout.index, m_index, sizeof(INDEX) * m_size );   // suffix array
+  WriteAt( pFile, position, layout.sentence, m_sentence, sizeof(INDEX) * m_size ); // sentence index
+  WriteAt( pFile, position, layout.lcp, m_lcp, m_size ); // common prefix with previous suffix
+  WriteAt( pFile, position, layout.wordInSentence, m_wordInSentence, m_size ); // word index
+  WriteAt( pFile, position, layout.sentenceLength, m_sentenceLength, m_sentenceCount ); // sentence length
+  if (m_useDocument) {
+    WriteAt( pFile, position, layout.document, m_document, sizeof(INDEX) * m_documentCount );
+    WriteAt( pFile, position, layout.documentName, m_documentName, sizeof(INDEX) * m_documentCount );
+    WriteAt( pFile, position, layout.documentNameBuffer, m_documentNameBuffer, m_documentNameLength );
+  }
+  if (ferror( pFile )) Error("could not write",fileName);
   fclose( pFile );
 
   m_vcb.Save( fileName + ".src-vcb" );
@@ -430,14 +591,69 @@ void SuffixArray::Save(const string& fileName ) const
 
 void SuffixArray::Load(const string& fileName )
 {
-  FILE *pFile = fopen ( fileName.c_str() , "r" );
-  if (pFile == NULL) Error("no such file or directory", fileName);
-
   cerr << "loading from " << fileName << endl;
 
+  int fd = open( fileName.c_str(), O_RDONLY );
+  if (fd == -1) Error("no such file or directory", fileName);
+  struct stat status;
+  if (fstat( fd, &status ) == -1) Error("could not stat", fileName);
+  FileHeader header;
+  if ((size_t)status.st_size >= sizeof( header ) &&
+      read( fd, &header, sizeof( header ) ) == (ssize_t)sizeof( header ) &&
+      memcmp( header.magic, FILE_MAGIC, sizeof( FILE_MAGIC ) ) == 0) {
+    LoadMapped( fileName, fd, status.st_size );
+    close( fd );
+  } else {
+    // suffix arrays saved before the mmap layout are read into memory
+    close( fd );
+    FILE *pFile = fopen ( fileName.c_str() , "r" );
+    if (pFile == NULL) Error("no such file or directory", fileName);
+    LoadStream( fileName, pFile );
+    fclose( pFile );
+  }
+  cerr << "words in corpus: " << m_size << endl;
+  cerr << "sentences in corpus: " << m_sentenceCount << endl;
+
+  m_vcb.Load( fileName + ".src-vcb" );
+  ComputeWordRanks();
+}
+
+void SuffixArray::LoadMapped(const string& fileName, int fd, size_t fileSize )
+{
+  m_mapped = (char*) mmap( NULL, fileSize, PROT_READ, MAP_SHARED, fd, 0 );
+  if (m_mapped == MAP_FAILED) {
+    m_mapped = NULL;
+    Error("could not map", fileName);
+  }
+  m_mappedSize = fileSize;
+
+  const FileHeader &header = *(const FileHeader*) m_mapped;
+  if (header.version != FILE_VERSION) Error("unsupported suffix array version in", fileName);
+  FileLayout layout( header );
+  if (layout.end != fileSize) Error("truncated suffix array in", fileName);
+  if (m_useDocument && !header.useDocument) {
+    cerr << "Error: stored suffix array does not have a document index\n";
+    exit(1);
+  }
+  m_size = header.size;
+  m_sentenceCount = header.sentenceCount;
+  m_documentCount = header.documentCount;
+  m_documentNameLength = header.documentNameLength;
+  m_array = (WORD_ID*) (m_mapped + layout.array);
+  m_index = (INDEX*) (m_mapped + layout.index);
+  m_sentence = (INDEX*) (m_mapped + layout.sentence);
+  m_lcp = (unsigned char*) (m_mapped + layout.lcp);
+  m_wordInSentence = m_mapped + layout.wordInSentence;
+  m_sentenceLength = m_mapped + layout.sentenceLength;
+  m_document = (INDEX*) (m_mapped + layout.document);
+  m_documentName = (INDEX*) (m_mapped + layout.documentName);
+  m_documentNameBuffer = m_mapped + layout.documentNameBuffer;
+}
+
+void SuffixArray::LoadStream(const string& fileName, FILE *pFile )
+{
   fread( &m_size, sizeof(INDEX), 1, pFile )
   || Error("could not read m_size from", fileName);
-  cerr << "words in corpus: " << m_size << endl;
 
   m_array = (WORD_ID*) calloc( sizeof( WORD_ID ), m_size );
   m_index = (INDEX*) calloc( sizeof( INDEX ), m_size );
@@ -458,7 +674,6 @@ void SuffixArray::Load(const string& fileName )
 
   fread( &m_sentenceCount, sizeof(INDEX), 1, pFile )
   || Error("could not read m_sentenceCount from", fileName);
-  cerr << "sentences in corpus: " << m_sentenceCount << endl;
 
   m_sentenceLength = (char*) calloc( sizeof( char ), m_sentenceCount );
   CheckAllocation(m_sentenceLength != NULL, "m_sentenceLength");
@@ -491,9 +706,6 @@ void SuffixArray::Load(const string& fileName )
     || Error("could not read m_document from", fileName);
   }
 
-  fclose( pFile );
-
-  m_vcb.Load( fileName + ".src-vcb" );
 }
 
 void SuffixArray::CheckAllocation( bool check, const char *dataStructure ) const
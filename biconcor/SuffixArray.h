@@ -1,5 +1,7 @@
 #pragma once
 
+#include <cstdio>
+
 #include "Vocabulary.h"
 
 class SuffixArray
@@ -10,7 +12,7 @@ public:
 private:
   WORD_ID *m_array;
   INDEX *m_index;
-  INDEX *m_buffer;
+  unsigned char *m_lcp; // words shared with the previous suffix, capped
   char *m_wordInSentence;
   INDEX *m_sentence;
   char *m_sentenceLength;
@@ -24,6 +26,9 @@ private:
   Vocabulary m_vcb;
   INDEX m_size;
   INDEX m_sentenceCount;
+  std::vector< INDEX > m_wordRank; // position of each word in string order
+  char *m_mapped; // file the arrays point into, if loaded with mmap
+  size_t m_mappedSize;
 
   // No copying allowed.
   SuffixArray(const SuffixArray&);
@@ -35,7 +40,9 @@ public:
 
   void Create(const std::string& fileName );
   bool ProcessDocumentLine( const char* const, const size_t );
-  void Sort(INDEX start, INDEX end);
+  void Sort();
+  void ComputeLcp();
+  void ComputeWordRanks();
   int CompareIndex( INDEX a, INDEX b ) const;
   inline int CompareWord( WORD_ID a, WORD_ID b ) const;
   int Count( const std::vector< WORD > &phrase );
@@ -46,6 +53,10 @@ public:
   INDEX FindFirst( const std::vector< WORD > &phrase, INDEX &start, INDEX &end );
   INDEX FindLast( const std::vector< WORD > &phrase, INDEX start, INDEX end, int direction );
   int Match( const std::vector< WORD > &phrase, INDEX index );
+  void GetWordRanks( const std::vector< WORD > &phrase, std::vector< INDEX > &ranks ) const;
+  INDEX FindFirst( const std::vector< INDEX > &ranks, INDEX &start, INDEX &end ) const;
+  INDEX FindLast( const std::vector< INDEX > &ranks, INDEX start, INDEX end, int direction ) const;
+  int Match( const std::vector< INDEX > &ranks, INDEX index ) const;
   void List( INDEX start, INDEX end );
   void PrintSentenceMatches( const std::vector< WORD > &phrase );
   inline INDEX GetPosition( INDEX index ) const {
@@ -77,6 +88,8 @@ public:
   }
   void Save(const std::string& fileName ) const;
   void Load(const std::string& fileName );
+  void LoadMapped(const std::string& fileName, int fd, size_t fileSize );
+  void LoadStream(const std::string& fileName, FILE *pFile );
   void CheckAllocation(bool, const char *dataStructure) const;
   bool Error( const char* message, const std::string& fileName) const;
 };
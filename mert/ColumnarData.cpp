@@ -0,0 +1,367 @@
+#include "ColumnarData.h"
+
+#include <cstring>
+#include <fstream>
+#include <map>
+
+#include "util/exception.hh"
+#include "util/file.hh"
+
+#include "FeatureData.h"
+#include "FeatureDataIterator.h"
+#include "ScoreData.h"
+#include "Util.h"
+
+using namespace std;
+
+namespace MosesTuning
+{
+
+namespace
+{
+
+const size_t kAlignment = 8;
+
+size_t Padded(size_t bytes)
+{
+  return (bytes + kAlignment - 1) & ~(kAlignment - 1);
+}
+
+void AppendBytes(string& out, const void* data, size_t bytes)
+{
+  out.append(reinterpret_cast<const char*>(data), bytes);
+  out.resize(Padded(out.size()), '\0');
+}
+
+template <class T> void AppendColumn(string& out, const vector<T>& values)
+{
+  AppendBytes(out, values.empty() ? NULL : &values[0], values.size() * sizeof(T));
+}
+
+// Next section of a chunk.
+template <class T> const T* TakeColumn(const char*& cur, const char* end, uint64_t count, const string& filename)
+{
+  const T* ret = reinterpret_cast<const T*>(cur);
+  const uint64_t bytes = Padded(count * sizeof(T));
+  UTIL_THROW_IF2(bytes > static_cast<uint64_t>(end - cur),
+                 "Truncated columnar chunk in " << filename);
+  cur += bytes;
+  return ret;
+}
+
+void InitHeader(ColumnarHeader& header, ColumnarHeader::Kind kind)
+{
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, COLUMNAR_MAGIC, sizeof(header.magic));
+  header.version = COLUMNAR_VERSION;
+  header.kind = kind;
+}
+
+void WriteChunk(ColumnarHeader& header, const string& body, const string& filename, bool append)
+{
+  if (append && !IsColumnarFile(filename)) {
+    ifstream existing(filename.c_str());
+    UTIL_THROW_IF2(existing && existing.peek() != EOF,
+                   "Cannot append columnar data to " << filename << ", which is in another format");
+  }
+  header.chunk_size = sizeof(header) + body.size();
+  ofstream ofs(filename.c_str(), ios::out | ios::binary | (append ? ios::app : ios::trunc));
+  UTIL_THROW_IF2(!ofs, "Unable to open " << filename);
+  ofs.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  ofs.write(body.data(), body.size());
+  UTIL_THROW_IF2(!ofs, "Failed to write " << filename);
+}
+
+bool IsIntegral(ScoreStatsType value)
+{
+  return value >= -2147483648.0f && value < 2147483648.0f
+         && static_cast<ScoreStatsType>(static_cast<int32_t>(value)) == value;
+}
+
+} // namespace
+
+
+ColumnarChunk::ColumnarChunk(const char* begin, const char* end, const string& filename)
+  : m_header(reinterpret_cast<const ColumnarHeader*>(begin)),
+    m_sparse_offsets(NULL), m_sparse_ids(NULL), m_sparse_values(NULL)
+{
+  const char* cur = begin + sizeof(ColumnarHeader);
+  const ColumnarHeader& h = *m_header;
+  m_description = TakeColumn<char>(cur, end, h.description_size, filename);
+  m_sentence_ids = TakeColumn<uint32_t>(cur, end, h.sentences, filename);
+  m_hypothesis_offsets = TakeColumn<uint64_t>(cur, end, h.sentences + 1, filename);
+  m_dense = TakeColumn<char>(cur, end, h.hypotheses * h.columns * sizeof(float), filename);
+  UTIL_THROW_IF2(m_hypothesis_offsets[h.sentences] != h.hypotheses,
+                 "Corrupt columnar chunk in " << filename);
+  if (!IsFeatures()) return;
+
+  m_sparse_offsets = TakeColumn<uint64_t>(cur, end, h.hypotheses + 1, filename);
+  m_sparse_ids = TakeColumn<uint32_t>(cur, end, h.sparse_entries, filename);
+  m_sparse_values = TakeColumn<float>(cur, end, h.sparse_entries, filename);
+  const uint32_t* name_offsets = TakeColumn<uint32_t>(cur, end, h.sparse_names + 1, filename);
+  const char* names = TakeColumn<char>(cur, end, name_offsets[h.sparse_names], filename);
+  m_sparse_map.resize(h.sparse_names);
+  for (size_t i = 0; i < h.sparse_names; ++i) {
+    m_sparse_map[i] = SparseVector::encode(
+                        string(names + name_offsets[i], name_offsets[i + 1] - name_offsets[i]));
+  }
+}
+
+void ColumnarChunk::GetSparse(uint64_t hypothesis, SparseVector& sparse) const
+{
+  for (uint64_t i = m_sparse_offsets[hypothesis]; i < m_sparse_offsets[hypothesis + 1]; ++i) {
+    sparse.set(m_sparse_map[m_sparse_ids[i]], m_sparse_values[i]);
+  }
+}
+
+
+ColumnarFile::ColumnarFile(const string& filename)
+  : m_filename(filename)
+{
+  util::scoped_fd fd(util::OpenReadOrThrow(filename.c_str()));
+  const uint64_t size = util::SizeOrThrow(fd.get());
+  if (size == 0) return;
+  util::MapRead(util::LAZY, fd.get(), 0, size, m_mem);
+
+  const char* cur = static_cast<const char*>(m_mem.get());
+  const char* end = cur + size;
+  map<int, size_t> positions;
+  while (cur != end) {
+    UTIL_THROW_IF2(static_cast<size_t>(end - cur) < sizeof(ColumnarHeader),
+                   "Truncated columnar chunk in " << filename);
+    const ColumnarHeader* header = reinterpret_cast<const ColumnarHeader*>(cur);
+    UTIL_THROW_IF2(memcmp(header->magic, COLUMNAR_MAGIC, sizeof(header->magic)) != 0,
+                   "Bad columnar chunk header in " << filename);
+    UTIL_THROW_IF2(header->version != COLUMNAR_VERSION,
+                   "Unsupported columnar version " << header->version << " in " << filename);
+    UTIL_THROW_IF2(header->chunk_size < sizeof(ColumnarHeader)
+                   || header->chunk_size > static_cast<uint64_t>(end - cur),
+                   "Truncated columnar chunk in " << filename);
+    m_chunks.push_back(ColumnarChunk(cur, cur + header->chunk_size, filename));
+    UTIL_THROW_IF2(m_chunks.back().IsFeatures() != m_chunks.front().IsFeatures(),
+                   "Mixed feature and score chunks in " << filename);
+    cur += header->chunk_size;
+
+    const ColumnarChunk& chunk = m_chunks.back();
+    for (size_t s = 0; s < chunk.NumSentences(); ++s) {
+      pair<map<int, size_t>::iterator, bool> inserted =
+        positions.insert(make_pair(chunk.SentenceId(s), m_sentences.size()));
+      if (inserted.second) m_sentences.push_back(vector<Part>());
+      Part part;
+      part.chunk = m_chunks.size() - 1;
+      part.sentence = s;
+      m_sentences[inserted.first->second].push_back(part);
+    }
+  }
+}
+
+void ColumnarFile::GetFeatures(size_t sentence, vector<FeatureDataItem>& out) const
+{
+  out.clear();
+  const vector<Part>& parts = m_sentences[sentence];
+  for (size_t p = 0; p < parts.size(); ++p) {
+    const ColumnarChunk& chunk = m_chunks[parts[p].chunk];
+    for (uint64_t h = chunk.BeginHypothesis(parts[p].sentence); h < chunk.EndHypothesis(parts[p].sentence); ++h) {
+      out.push_back(FeatureDataItem());
+      const float* row = chunk.FloatRow(h);
+      out.back().dense.assign(row, row + chunk.NumColumns());
+      chunk.GetSparse(h, out.back().sparse);
+    }
+  }
+}
+
+void ColumnarFile::GetScores(size_t sentence, vector<vector<float> >& out) const
+{
+  out.clear();
+  const vector<Part>& parts = m_sentences[sentence];
+  for (size_t p = 0; p < parts.size(); ++p) {
+    const ColumnarChunk& chunk = m_chunks[parts[p].chunk];
+    for (uint64_t h = chunk.BeginHypothesis(parts[p].sentence); h < chunk.EndHypothesis(parts[p].sentence); ++h) {
+      out.push_back(vector<float>());
+      if (chunk.Header().integral) {
+        const int32_t* row = chunk.IntRow(h);
+        out.back().assign(row, row + chunk.NumColumns());
+      } else {
+        const float* row = chunk.FloatRow(h);
+        out.back().assign(row, row + chunk.NumColumns());
+      }
+    }
+  }
+}
+
+
+bool IsColumnarFile(const string& filename)
+{
+  ifstream ifs(filename.c_str(), ios::in | ios::binary);
+  char magic[sizeof(COLUMNAR_MAGIC)];
+  return ifs.read(magic, sizeof(magic)) && memcmp(magic, COLUMNAR_MAGIC, sizeof(magic)) == 0;
+}
+
+void SaveColumnar(const FeatureData& data, const string& filename, bool append)
+{
+  if (filename.empty()) return;
+  TRACE_ERR("saving columnar features into " << filename << endl);
+  ColumnarHeader header;
+  InitHeader(header, ColumnarHeader::FEATURES);
+  header.sentences = data.size();
+  header.columns = data.NumberOfFeatures();
+
+  vector<uint32_t> sentence_ids;
+  vector<uint64_t> hypothesis_offsets(1, 0);
+  vector<float> dense;
+  vector<uint64_t> sparse_offsets(1, 0);
+  vector<uint32_t> sparse_ids;
+  vector<float> sparse_values;
+  // SparseVector id -> chunk sparse id
+  map<size_t, uint32_t> sparse_map;
+  vector<uint32_t> name_offsets(1, 0);
+  string names;
+
+  for (size_t i = 0; i < data.size(); ++i) {
+    const FeatureArray& array = data.get(i);
+    sentence_ids.push_back(array.getIndex());
+    for (size_t j = 0; j < array.size(); ++j) {
+      const FeatureStats& stats = array.get(j);
+      UTIL_THROW_IF2(stats.size() != header.columns,
+                     "Sentence " << array.getIndex() << " has " << stats.size()
+                     << " dense features, expected " << header.columns);
+      dense.insert(dense.end(), stats.getArray(), stats.getArray() + stats.size());
+      const SparseVector& sparse = stats.getSparse();
+      const vector<size_t> ids = sparse.feats();
+      for (size_t k = 0; k < ids.size(); ++k) {
+        pair<map<size_t, uint32_t>::iterator, bool> inserted =
+          sparse_map.insert(make_pair(ids[k], static_cast<uint32_t>(sparse_map.size())));
+        if (inserted.second) {
+          names += SparseVector::decode(ids[k]);
+          name_offsets.push_back(names.size());
+        }
+        sparse_ids.push_back(inserted.first->second);
+        sparse_values.push_back(sparse.get(ids[k]));
+      }
+      sparse_offsets.push_back(sparse_ids.size());
+    }
+    hypothesis_offsets.push_back(sparse_offsets.size() - 1);
+  }
+  header.hypotheses = hypothesis_offsets.back();
+  header.sparse_entries = sparse_ids.size();
+  header.sparse_names = sparse_map.size();
+
+  const string description = data.Features();
+  header.description_size = description.size();
+  string body;
+  AppendBytes(body, description.data(), description.size());
+  AppendColumn(body, sentence_ids);
+  AppendColumn(body, hypothesis_offsets);
+  AppendColumn(body, dense);
+  AppendColumn(body, sparse_offsets);
+  AppendColumn(body, sparse_ids);
+  AppendColumn(body, sparse_values);
+  AppendColumn(body, name_offsets);
+  AppendBytes(body, names.data(), names.size());
+  WriteChunk(header, body, filename, append);
+}
+
+void SaveColumnar(const ScoreData& data, const string& filename, bool append)
+{
+  if (filename.empty()) return;
+  TRACE_ERR("saving columnar scores into " << filename << endl);
+  ColumnarHeader header;
+  InitHeader(header, ColumnarHeader::SCORES);
+  header.sentences = data.size();
+  header.columns = data.NumberOfScores();
+  header.integral = 1;
+
+  vector<uint32_t> sentence_ids;
+  vector<uint64_t> hypothesis_offsets(1, 0);
+  vector<ScoreStatsType> values;
+  for (size_t i = 0; i < data.size(); ++i) {
+    const ScoreArray& array = data.get(i);
+    sentence_ids.push_back(array.getIndex());
+    for (size_t j = 0; j < array.size(); ++j) {
+      const ScoreStats& stats = array.get(j);
+      UTIL_THROW_IF2(stats.size() != header.columns,
+                     "Sentence " << array.getIndex() << " has " << stats.size()
+                     << " statistics, expected " << header.columns);
+      for (size_t k = 0; k < stats.size(); ++k) {
+        values.push_back(stats.get(k));
+        if (!IsIntegral(stats.get(k))) header.integral = 0;
+      }
+    }
+    hypothesis_offsets.push_back(hypothesis_offsets.back() + array.size());
+  }
+  header.hypotheses = hypothesis_offsets.back();
+
+  const string description = data.name();
+  header.description_size = description.size();
+  string body;
+  AppendBytes(body, description.data(), description.size());
+  AppendColumn(body, sentence_ids);
+  AppendColumn(body, hypothesis_offsets);
+  if (header.integral) {
+    AppendColumn(body, vector<int32_t>(values.begin(), values.end()));
+  } else {
+    AppendColumn(body, values);
+  }
+  WriteChunk(header, body, filename, append);
+}
+
+void LoadColumnar(const string& filename, FeatureData& data, const SparseVector& sparseWeights)
+{
+  ColumnarFile file(filename);
+  for (size_t c = 0; c < file.NumChunks(); ++c) {
+    const ColumnarChunk& chunk = file.Chunk(c);
+    UTIL_THROW_IF2(!chunk.IsFeatures(), filename << " does not contain feature data");
+    for (size_t s = 0; s < chunk.NumSentences(); ++s) {
+      FeatureArray entry;
+      entry.setIndex(chunk.SentenceId(s));
+      entry.NumberOfFeatures(chunk.NumColumns());
+      entry.Features(chunk.Description());
+      FeatureStats stats(chunk.NumColumns());
+      for (uint64_t h = chunk.BeginHypothesis(s); h < chunk.EndHypothesis(s); ++h) {
+        stats.reset();
+        const float* row = chunk.FloatRow(h);
+        for (size_t k = 0; k < chunk.NumColumns(); ++k) {
+          stats.add(row[k]);
+        }
+        SparseVector sparse;
+        chunk.GetSparse(h, sparse);
+        if (sparseWeights.size()) {
+          // Merge the sparse features, as FeatureStats::set() does
+          stats.add(inner_product(sparseWeights, sparse));
+        } else {
+          stats.setSparse(sparse);
+        }
+        entry.add(stats);
+      }
+      if (data.size() == 0) data.setFeatureMap(entry.Features());
+      data.add(entry);
+    }
+  }
+}
+
+void LoadColumnar(const string& filename, ScoreData& data)
+{
+  ColumnarFile file(filename);
+  for (size_t c = 0; c < file.NumChunks(); ++c) {
+    const ColumnarChunk& chunk = file.Chunk(c);
+    UTIL_THROW_IF2(chunk.IsFeatures(), filename << " does not contain score data");
+    string score_type = chunk.Description();
+    for (size_t s = 0; s < chunk.NumSentences(); ++s) {
+      ScoreArray entry;
+      entry.setIndex(chunk.SentenceId(s));
+      entry.NumberOfScores(chunk.NumColumns());
+      entry.name(score_type);
+      ScoreStats stats(chunk.NumColumns());
+      for (uint64_t h = chunk.BeginHypothesis(s); h < chunk.EndHypothesis(s); ++h) {
+        stats.reset();
+        for (size_t k = 0; k < chunk.NumColumns(); ++k) {
+          stats.add(chunk.Header().integral ? chunk.IntRow(h)[k] : chunk.FloatRow(h)[k]);
+        }
+        entry.add(stats);
+      }
+      data.add(entry);
+    }
+  }
+}
+
+}
@@ -0,0 +1,191 @@
+#ifndef MERT_COLUMNAR_DATA_H_
+#define MERT_COLUMNAR_DATA_H_
+
+/*
+ * Columnar binary format for feature and score data.
+ *
+ * A file is a sequence of self-contained chunks, one per call to
+ * SaveColumnar(), so the output of a new tuning iteration can be appended
+ * to the file of the previous ones. Each chunk stores the hypotheses of its
+ * sentences column by column:
+ *
+ *   header | description | sentence ids | hypothesis offsets |
+ *   dense values | sparse offsets | sparse ids | sparse values | sparse names
+ *
+ * Dense features are float arrays, sufficient statistics are int32 arrays
+ * (float if any statistic is fractional) and sparse features are
+ * (id, value) runs whose ids index the sparse name table of the chunk.
+ * Every section starts on an 8 byte boundary, so the file is read through
+ * mmap without parsing or copying.
+ */
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include <boost/shared_ptr.hpp>
+#include <stdint.h>
+
+#include "util/mmap.hh"
+
+namespace MosesTuning
+{
+
+class FeatureData;
+class FeatureDataItem;
+class ScoreData;
+class SparseVector;
+
+const char COLUMNAR_MAGIC[8] = { 'M', 'E', 'R', 'T', 'C', 'O', 'L', '\0' };
+const uint32_t COLUMNAR_VERSION = 1;
+
+struct ColumnarHeader {
+  enum Kind { FEATURES = 0, SCORES = 1 };
+
+  char magic[8];
+  uint32_t version;
+  uint32_t kind;
+  // Size of the chunk in bytes, including this header.
+  uint64_t chunk_size;
+  uint64_t hypotheses;
+  uint64_t sparse_entries;
+  uint32_t sentences;
+  // Dense features or statistics per hypothesis.
+  uint32_t columns;
+  uint32_t sparse_names;
+  // Feature names or score type.
+  uint32_t description_size;
+  // Scores only: statistics are stored as int32 rather than float.
+  uint32_t integral;
+  uint32_t reserved;
+};
+
+/**
+ * View of one chunk of a mapped columnar file.
+ */
+class ColumnarChunk
+{
+public:
+  ColumnarChunk(const char* begin, const char* end, const std::string& filename);
+
+  const ColumnarHeader& Header() const {
+    return *m_header;
+  }
+
+  bool IsFeatures() const {
+    return m_header->kind == ColumnarHeader::FEATURES;
+  }
+
+  std::size_t NumSentences() const {
+    return m_header->sentences;
+  }
+
+  std::size_t NumColumns() const {
+    return m_header->columns;
+  }
+
+  std::string Description() const {
+    return std::string(m_description, m_header->description_size);
+  }
+
+  int SentenceId(std::size_t sentence) const {
+    return m_sentence_ids[sentence];
+  }
+
+  uint64_t BeginHypothesis(std::size_t sentence) const {
+    return m_hypothesis_offsets[sentence];
+  }
+
+  uint64_t EndHypothesis(std::size_t sentence) const {
+    return m_hypothesis_offsets[sentence + 1];
+  }
+
+  /** Dense features, or scores when !Header().integral. */
+  const float* FloatRow(uint64_t hypothesis) const {
+    return reinterpret_cast<const float*>(m_dense) + hypothesis * m_header->columns;
+  }
+
+  /** Scores when Header().integral. */
+  const int32_t* IntRow(uint64_t hypothesis) const {
+    return reinterpret_cast<const int32_t*>(m_dense) + hypothesis * m_header->columns;
+  }
+
+  /** Adds the sparse features of a hypothesis to the vector. */
+  void GetSparse(uint64_t hypothesis, SparseVector& sparse) const;
+
+private:
+  const ColumnarHeader* m_header;
+  const char* m_description;
+  const uint32_t* m_sentence_ids;
+  const uint64_t* m_hypothesis_offsets;
+  const char* m_dense;
+  const uint64_t* m_sparse_offsets;
+  const uint32_t* m_sparse_ids;
+  const float* m_sparse_values;
+  // Chunk sparse id -> SparseVector id.
+  std::vector<std::size_t> m_sparse_map;
+};
+
+/**
+ * A columnar file mapped into memory.
+ */
+class ColumnarFile
+{
+public:
+  explicit ColumnarFile(const std::string& filename);
+
+  const std::string& FileName() const {
+    return m_filename;
+  }
+
+  std::size_t NumChunks() const {
+    return m_chunks.size();
+  }
+
+  const ColumnarChunk& Chunk(std::size_t i) const {
+    return m_chunks[i];
+  }
+
+  /**
+   * Position of a sentence in a chunk.
+   */
+  struct Part {
+    std::size_t chunk;
+    std::size_t sentence;
+  };
+
+  /**
+   * The sentences of the file in order of first appearance; each is the
+   * list of chunks (tuning iterations) that contain hypotheses for it.
+   */
+  const std::vector<std::vector<Part> >& Sentences() const {
+    return m_sentences;
+  }
+
+  /** Hypotheses of the given entry of Sentences(). */
+  void GetFeatures(std::size_t sentence, std::vector<FeatureDataItem>& out) const;
+  void GetScores(std::size_t sentence, std::vector<std::vector<float> >& out) const;
+
+private:
+  std::string m_filename;
+  util::scoped_memory m_mem;
+  std::vector<ColumnarChunk> m_chunks;
+  std::vector<std::vector<Part> > m_sentences;
+};
+
+/** True if the file starts with a columnar chunk. */
+bool IsColumnarFile(const std::string& filename);
+
+/**
+ * Write the data as one chunk, appending it to the file if append is set
+ * and the file exists.
+ */
+void SaveColumnar(const FeatureData& data, const std::string& filename, bool append);
+void SaveColumnar(const ScoreData& data, const std::string& filename, bool append);
+
+void LoadColumnar(const std::string& filename, FeatureData& data, const SparseVector& sparseWeights);
+void LoadColumnar(const std::string& filename, ScoreData& data);
+
+}
+
+#endif  // MERT_COLUMNAR_DATA_H_
@@ -0,0 +1,137 @@
+#include "ColumnarData.h"
+
+#define BOOST_TEST_MODULE MertColumnarData
+#include <boost/test/unit_test.hpp>
+
+#include <boost/filesystem.hpp>
+#include <boost/lexical_cast.hpp>
+#include <boost/scoped_ptr.hpp>
+
+#include "Data.h"
+#include "FeatureDataIterator.h"
+#include "ScoreDataIterator.h"
+#include "Scorer.h"
+#include "ScorerFactory.h"
+
+using namespace std;
+using namespace MosesTuning;
+
+namespace
+{
+
+// Removes the file when going out of scope.
+class TempFile
+{
+public:
+  TempFile() : m_path(boost::filesystem::temp_directory_path() / boost::filesystem::unique_path()) {}
+  ~TempFile() {
+    boost::filesystem::remove(m_path);
+  }
+  string Name() const {
+    return m_path.string();
+  }
+private:
+  boost::filesystem::path m_path;
+};
+
+// Sentences 0..2 with one hypothesis more than their index; the first
+// feature and statistic of every hypothesis are offset by the iteration.
+void AddIteration(Data& data, int iteration)
+{
+  data.getFeatureData()->setFeatureMap("d_0 lm_0");
+  for (int s = 0; s < 3; ++s) {
+    for (int h = 0; h <= s; ++h) {
+      FeatureStats fs;
+      fs.add(iteration + h);
+      fs.add(-0.5f * s);
+      if (h % 2 == 0) fs.addSparse("sparse_" + boost::lexical_cast<string>(s), 0.25f * h);
+      fs.addSparse("common", 1.0f);
+      data.getFeatureData()->add(fs, s);
+
+      ScoreStats ss;
+      ss.add(iteration);
+      for (int k = 1; k < 9; ++k) ss.add(s + h + k);
+      data.getScoreData()->add(ss, s);
+    }
+  }
+}
+
+void CheckSame(const FeatureData& a, const FeatureData& b)
+{
+  BOOST_REQUIRE_EQUAL(a.size(), b.size());
+  BOOST_CHECK_EQUAL(a.Features(), b.Features());
+  for (size_t i = 0; i < a.size(); ++i) {
+    BOOST_CHECK_EQUAL(a.get(i).getIndex(), b.get(i).getIndex());
+    BOOST_REQUIRE_EQUAL(a.get(i).size(), b.get(i).size());
+    for (size_t j = 0; j < a.get(i).size(); ++j) {
+      BOOST_CHECK(a.get(i, j) == b.get(i, j));
+    }
+  }
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(columnar_round_trip)
+{
+  boost::scoped_ptr<Scorer> scorer(ScorerFactory::getScorer("BLEU", ""));
+  Data data(scorer.get());
+  AddIteration(data, 0);
+  TempFile features, scores;
+  data.saveColumnar(features.Name(), scores.Name());
+  BOOST_CHECK(IsColumnarFile(features.Name()));
+  BOOST_CHECK(IsColumnarFile(scores.Name()));
+
+  Data loaded(scorer.get());
+  loaded.load(features.Name(), scores.Name());
+  CheckSame(*data.getFeatureData(), *loaded.getFeatureData());
+  BOOST_REQUIRE_EQUAL(loaded.getScoreData()->size(), (size_t)3);
+  BOOST_CHECK_EQUAL(loaded.getScoreData()->name(), "BLEU");
+  for (size_t i = 0; i < 3; ++i) {
+    for (size_t j = 0; j <= i; ++j) {
+      BOOST_CHECK(data.getScoreData()->get(i, j) == loaded.getScoreData()->get(i, j));
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(columnar_append_iterators)
+{
+  boost::scoped_ptr<Scorer> scorer(ScorerFactory::getScorer("BLEU", ""));
+  TempFile features, scores;
+  for (int iteration = 0; iteration < 2; ++iteration) {
+    Data data(scorer.get());
+    AddIteration(data, iteration);
+    data.saveColumnar(features.Name(), scores.Name(), true);
+  }
+
+  // the iterators see the hypotheses of both iterations together
+  FeatureDataIterator fi(features.Name());
+  ScoreDataIterator si(scores.Name());
+  for (size_t s = 0; s < 3; ++s, ++fi, ++si) {
+    BOOST_REQUIRE(fi != FeatureDataIterator::end());
+    BOOST_REQUIRE(si != ScoreDataIterator::end());
+    BOOST_REQUIRE_EQUAL(fi->size(), 2 * (s + 1));
+    BOOST_REQUIRE_EQUAL(si->size(), 2 * (s + 1));
+    for (size_t h = 0; h < fi->size(); ++h) {
+      const size_t iteration = h / (s + 1);
+      const size_t rank = h % (s + 1);
+      const FeatureDataItem& item = (*fi)[h];
+      BOOST_REQUIRE_EQUAL(item.dense.size(), (size_t)2);
+      BOOST_CHECK_EQUAL(item.dense[0], float(iteration + rank));
+      BOOST_CHECK_EQUAL(item.dense[1], -0.5f * s);
+      BOOST_CHECK_EQUAL(item.sparse.get("common"), 1.0f);
+      BOOST_CHECK_EQUAL(item.sparse.size(), rank % 2 == 0 ? (size_t)2 : (size_t)1);
+      BOOST_REQUIRE_EQUAL((*si)[h].size(), (size_t)9);
+      BOOST_CHECK_EQUAL((*si)[h][0], float(iteration));
+      BOOST_CHECK_EQUAL((*si)[h][8], float(s + rank + 8));
+    }
+  }
+  BOOST_CHECK(fi == FeatureDataIterator::end());
+  BOOST_CHECK(si == ScoreDataIterator::end());
+
+  // and FeatureData merges them by sentence
+  Data loaded(scorer.get());
+  loaded.load(features.Name(), scores.Name());
+  BOOST_CHECK_EQUAL(loaded.getFeatureData()->size(), (size_t)3);
+  BOOST_CHECK_EQUAL(loaded.getFeatureData()->get(2).size(), (size_t)6);
+  BOOST_CHECK_EQUAL(loaded.getScoreData()->get(2).size(), (size_t)6);
+}
@@ -206,6 +206,12 @@ void Data::save(const std::string &featfile, const std::string &scorefile, bool
   m_score_data->save(scorefile, bin);
 }
 
+void Data::saveColumnar(const std::string &featfile, const std::string &scorefile, bool append)
+{
+  m_feature_data->saveColumnar(featfile, append);
+  m_score_data->saveColumnar(scorefile, append);
+}
+
 void Data::InitFeatureMap(const string& str)
 {
   string buf = str;
@@ -73,6 +73,12 @@ public:
 
   void save(const std::string &featfile, const std::string &scorefile, bool bin=false);
 
+  /**
+   * Save in the mmappable columnar format; with append, the data is added
+   * as a new chunk to existing columnar files.
+   */
+  void saveColumnar(const std::string &featfile, const std::string &scorefile, bool append=false);
+
   //ADDED BY TS
   void removeDuplicates();
   //END_ADDED
@@ -9,6 +9,7 @@
 #include "FeatureData.h"
 
 #include <limits>
+#include "ColumnarData.h"
 #include "FileStream.h"
 #include "Util.h"
 
@@ -43,6 +44,11 @@ void FeatureData::save(bool bin)
   save(&cout, bin);
 }
 
+void FeatureData::saveColumnar(const string &file, bool append) const
+{
+  SaveColumnar(*this, file, append);
+}
+
 void FeatureData::load(istream* is, const SparseVector& sparseWeights)
 {
   FeatureArray entry;
@@ -70,6 +76,10 @@ void FeatureData::load(istream* is, const SparseVector& sparseWeights)
 void FeatureData::load(const string &file, const SparseVector& sparseWeights)
 {
   TRACE_ERR("loading feature data from " << file << endl);
+  if (IsColumnarFile(file)) {
+    LoadColumnar(file, *this, sparseWeights);
+    return;
+  }
   inputfilestream input_stream(file); // matches a stream with a file. Opens the file
   if (!input_stream) {
     throw runtime_error("Unable to open feature file: " + file);
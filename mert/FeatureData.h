@@ -85,6 +85,8 @@ public:
   void save(const std::string &file, bool bin=false);
   void save(std::ostream* os, bool bin=false);
   void save(bool bin=false);
+  // see ColumnarData.h
+  void saveColumnar(const std::string &file, bool append=false) const;
 
   void load(std::istream* is, const SparseVector& sparseWeights);
   void load(const std::string &file, const SparseVector& sparseWeights);
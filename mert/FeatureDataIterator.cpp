@@ -23,6 +23,7 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #include "util/file_piece.hh"
 #include "util/tokenize_piece.hh"
 
+#include "ColumnarData.h"
 #include "FeatureArray.h"
 #include "FeatureDataIterator.h"
 
@@ -69,11 +70,15 @@ size_t hash_value(FeatureDataItem const& item)
 }
 
 
-FeatureDataIterator::FeatureDataIterator() {}
+FeatureDataIterator::FeatureDataIterator() : m_sentence(0) {}
 
-FeatureDataIterator::FeatureDataIterator(const string& filename)
+FeatureDataIterator::FeatureDataIterator(const string& filename) : m_sentence(0)
 {
-  m_in.reset(new FilePiece(filename.c_str()));
+  if (IsColumnarFile(filename)) {
+    m_columns.reset(new ColumnarFile(filename));
+  } else {
+    m_in.reset(new FilePiece(filename.c_str()));
+  }
   readNext();
 }
 
@@ -82,6 +87,14 @@ FeatureDataIterator::~FeatureDataIterator() {}
 void FeatureDataIterator::readNext()
 {
   m_next.clear();
+  if (m_columns) {
+    if (m_sentence < m_columns->Sentences().size()) {
+      m_columns->GetFeatures(m_sentence++, m_next);
+    } else {
+      m_columns.reset();
+    }
+    return;
+  }
   try {
     StringPiece marker = m_in->ReadDelimited();
     if (marker != StringPiece(FEATURES_TXT_BEGIN)) {
@@ -131,7 +144,9 @@ void FeatureDataIterator::increment()
 
 bool FeatureDataIterator::equal(const FeatureDataIterator& rhs) const
 {
-  if (!m_in && !rhs.m_in) {
+  if (m_columns || rhs.m_columns) {
+    return m_columns == rhs.m_columns && m_sentence == rhs.m_sentence;
+  } else if (!m_in && !rhs.m_in) {
     return true;
   } else if (!m_in) {
     return false;
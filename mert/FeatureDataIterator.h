@@ -45,6 +45,8 @@ class FilePiece;
 namespace MosesTuning
 {
 
+class ColumnarFile;
+
 
 class FileFormatException : public util::Exception
 {
@@ -97,6 +99,9 @@ private:
   void readNext();
 
   boost::shared_ptr<util::FilePiece> m_in;
+  // Set instead of m_in for columnar files.
+  boost::shared_ptr<ColumnarFile> m_columns;
+  std::size_t m_sentence;
   std::vector<FeatureDataItem> m_next;
 };
 
@@ -116,6 +116,9 @@ public:
   const SparseVector& getSparse() const {
     return m_map;
   }
+  void setSparse(const SparseVector& sparse) {
+    m_map = sparse;
+  }
 
   void set(std::string &theString, const SparseVector& sparseWeights);
 
@@ -30,6 +30,7 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 
 #include "Scorer.h"
 #include "HopeFearDecoder.h"
+#include "ParallelFor.h"
 
 using namespace std;
 namespace fs = boost::filesystem;
@@ -39,6 +40,109 @@ namespace MosesTuning
 
 static const ValType BLEU_RATIO = 5;
 
+namespace
+{
+
+// The hypotheses of the current sentence of an enumerator.
+struct CurrentPack {
+  HypPackEnumerator* train;
+  size_t size() const {
+    return train->cur_size();
+  }
+  const MiraFeatureVector& featuresAt(size_t i) const {
+    return train->featuresAt(i);
+  }
+  const ScoreDataItem& scoresAt(size_t i) const {
+    return train->scoresAt(i);
+  }
+};
+
+// The hypotheses of the sentence at a position of an in-memory enumerator.
+struct PositionPack {
+  const RandomAccessHypPackEnumerator* train;
+  size_t position;
+  size_t size() const {
+    return train->sizeAt(position);
+  }
+  const MiraFeatureVector& featuresAt(size_t i) const {
+    return train->featuresAt(position, i);
+  }
+  const ScoreDataItem& scoresAt(size_t i) const {
+    return train->scoresAt(position, i);
+  }
+};
+
+template <class Pack>
+void NbestHopeFear(const Pack& pack, Scorer* scorer, bool safe_hope,
+                   const vector<ValType>& backgroundBleu,
+                   const MiraWeightVector& wv, HopeFearData* hopeFear)
+{
+  // Hope / fear decode
+  ValType hope_scale = 1.0;
+  size_t hope_index=0, fear_index=0, model_index=0;
+  ValType hope_score=0, fear_score=0, model_score=0;
+  for(size_t safe_loop=0; safe_loop<2; safe_loop++) {
+    ValType hope_bleu=0, hope_model=0;
+    for(size_t i=0; i< pack.size(); i++) {
+      const MiraFeatureVector& vec=pack.featuresAt(i);
+      ValType score = wv.score(vec);
+      ValType bleu = scorer->calculateSentenceLevelBackgroundScore(pack.scoresAt(i),backgroundBleu);
+      // Hope
+      if(i==0 || (hope_scale*score + bleu) > hope_score) {
+        hope_score = hope_scale*score + bleu;
+        hope_index = i;
+        hope_bleu = bleu;
+        hope_model = score;
+      }
+      // Fear
+      if(i==0 || (score - bleu) > fear_score) {
+        fear_score = score - bleu;
+        fear_index = i;
+      }
+      // Model
+      if(i==0 || score > model_score) {
+        model_score = score;
+        model_index = i;
+      }
+    }
+    // Outer loop rescales the contribution of model score to 'hope' in antagonistic cases
+    // where model score is having far more influence than BLEU
+    hope_bleu *= BLEU_RATIO; // We only care about cases where model has MUCH more influence than BLEU
+    if(safe_hope && safe_loop==0 && abs(hope_model)>1e-8 && abs(hope_bleu)/abs(hope_model)<hope_scale)
+      hope_scale = abs(hope_bleu) / abs(hope_model);
+    else break;
+  }
+  hopeFear->modelFeatures = pack.featuresAt(model_index);
+  hopeFear->hopeFeatures = pack.featuresAt(hope_index);
+  hopeFear->fearFeatures = pack.featuresAt(fear_index);
+
+  hopeFear->hopeStats = pack.scoresAt(hope_index);
+  hopeFear->hopeBleu = scorer->calculateSentenceLevelBackgroundScore(hopeFear->hopeStats, backgroundBleu);
+  const vector<float>& fear_stats = pack.scoresAt(fear_index);
+  hopeFear->fearBleu = scorer->calculateSentenceLevelBackgroundScore(fear_stats, backgroundBleu);
+
+  hopeFear->modelStats = pack.scoresAt(model_index);
+  hopeFear->hopeFearEqual = (hope_index == fear_index);
+}
+
+template <class Pack>
+size_t MaxModelIndex(const Pack& pack, const AvgWeightVector& wv)
+{
+  // Find max model
+  size_t max_index=0;
+  ValType max_score=0;
+  for(size_t i=0; i<pack.size(); i++) {
+    ValType score = wv.score(pack.featuresAt(i));
+    if(i==0 || score > max_score) {
+      max_index = i;
+      max_score = score;
+    }
+  }
+  return max_index;
+}
+
+} // namespace
+
 std::pair<MiraWeightVector*,size_t>
 InitialiseWeights(const string& denseInitFile, const string& sparseInitFile,
                   const string& type, bool verbose)
@@ -132,14 +236,91 @@ InitialiseWeights(const string& denseInitFile, const string& sparseInitFile,
   return pair<MiraWeightVector*,size_t>(new MiraWeightVector(initParams), initDenseSize);
 }
 
+struct HopeFearDecoder::HopeFearTask {
+  const HopeFearDecoder* decoder;
+  const vector<size_t>* positions;
+  const vector<ValType>* backgroundBleu;
+  const MiraWeightVector* wv;
+  vector<HopeFearData>* hopeFear;
+  void operator()(size_t i) {
+    decoder->HopeFearAt((*positions)[i], *backgroundBleu, *wv, &(*hopeFear)[i]);
+  }
+};
+
+struct HopeFearDecoder::MaxModelTask {
+  const HopeFearDecoder* decoder;
+  const vector<size_t>* positions;
+  const AvgWeightVector* wv;
+  vector<vector<ValType> >* stats;
+  void operator()(size_t i) {
+    decoder->MaxModelAt((*positions)[i], *wv, &(*stats)[i]);
+  }
+};
+
+void HopeFearDecoder::HopeFearAt(size_t, const vector<ValType>&, const MiraWeightVector&, HopeFearData*) const
+{
+  UTIL_THROW(util::Exception, "Random access decoding is not supported");
+}
+
+void HopeFearDecoder::MaxModelAt(size_t, const AvgWeightVector&, vector<ValType>*) const
+{
+  UTIL_THROW(util::Exception, "Random access decoding is not supported");
+}
+
+void HopeFearDecoder::HopeFearBatch(
+  const vector<ValType>& backgroundBleu,
+  const MiraWeightVector& wv,
+  size_t batchSize,
+  vector<HopeFearData>* hopeFear)
+{
+  hopeFear->clear();
+  vector<size_t> positions;
+  size_t position;
+  if (threads_ > 1) {
+    for (; positions.size() < batchSize && !finished() && CurrentPosition(&position); next()) {
+      positions.push_back(position);
+    }
+  }
+  if (positions.empty()) {
+    for (size_t i = 0; i < batchSize && !finished(); ++i, next()) {
+      hopeFear->push_back(HopeFearData());
+      HopeFear(backgroundBleu, wv, &hopeFear->back());
+    }
+    return;
+  }
+  hopeFear->resize(positions.size());
+  HopeFearTask task = { this, &positions, &backgroundBleu, &wv, hopeFear };
+  ParallelFor(task, positions.size(), threads_);
+}
+
 ValType HopeFearDecoder::Evaluate(const AvgWeightVector& wv)
 {
   vector<ValType> stats(scorer_->NumberOfScores(),0);
-  for(reset(); !finished(); next()) {
-    vector<ValType> sent;
-    MaxModel(wv,&sent);
-    for(size_t i=0; i<sent.size(); i++) {
-      stats[i]+=sent[i];
+  reset();
+  vector<size_t> positions;
+  size_t position;
+  if (threads_ > 1) {
+    for (; !finished() && CurrentPosition(&position); next()) {
+      positions.push_back(position);
+    }
+  }
+  if (positions.empty()) {
+    for(; !finished(); next()) {
+      vector<ValType> sent;
+      MaxModel(wv,&sent);
+      for(size_t i=0; i<sent.size(); i++) {
+        stats[i]+=sent[i];
+      }
+    }
+  } else {
+    // Sum in the same order as the serial loop
+    vector<vector<ValType> > sents(positions.size());
+    MaxModelTask task = { this, &positions, &wv, &sents };
+    ParallelFor(task, positions.size(), threads_);
+    for (size_t s = 0; s < sents.size(); ++s) {
+      for(size_t i=0; i<sents[s].size(); i++) {
+        stats[i]+=sents[s][i];
+      }
     }
   }
   return scorer_->calculateScore(stats);
@@ -152,13 +333,14 @@ NbestHopeFearDecoder::NbestHopeFearDecoder(
   bool  no_shuffle,
   bool safe_hope,
   Scorer* scorer
-) : safe_hope_(safe_hope)
+) : randomAccess_(NULL), safe_hope_(safe_hope)
 {
   scorer_ = scorer;
   if (streaming) {
     train_.reset(new StreamingHypPackEnumerator(featureFiles, scoreFiles));
   } else {
-    train_.reset(new RandomAccessHypPackEnumerator(featureFiles, scoreFiles, no_shuffle));
+    randomAccess_ = new RandomAccessHypPackEnumerator(featureFiles, scoreFiles, no_shuffle);
+    train_.reset(randomAccess_);
   }
 }
 
@@ -178,76 +360,44 @@ void NbestHopeFearDecoder::reset()
   train_->reset();
 }
 
+bool NbestHopeFearDecoder::CurrentPosition(size_t* position)
+{
+  if (!randomAccess_) return false;
+  *position = randomAccess_->cur_position();
+  return true;
+}
+
 void NbestHopeFearDecoder::HopeFear(
   const std::vector<ValType>& backgroundBleu,
   const MiraWeightVector& wv,
   HopeFearData* hopeFear
 )
 {
+  CurrentPack pack = { train_.get() };
+  NbestHopeFear(pack, scorer_, safe_hope_, backgroundBleu, wv, hopeFear);
+}
 
-
-  // Hope / fear decode
-  ValType hope_scale = 1.0;
-  size_t hope_index=0, fear_index=0, model_index=0;
-  ValType hope_score=0, fear_score=0, model_score=0;
-  for(size_t safe_loop=0; safe_loop<2; safe_loop++) {
-    ValType hope_bleu=0, hope_model=0;
-    for(size_t i=0; i< train_->cur_size(); i++) {
-      const MiraFeatureVector& vec=train_->featuresAt(i);
-      ValType score = wv.score(vec);
-      ValType bleu = scorer_->calculateSentenceLevelBackgroundScore(train_->scoresAt(i),backgroundBleu);
-      // Hope
-      if(i==0 || (hope_scale*score + bleu) > hope_score) {
-        hope_score = hope_scale*score + bleu;
-        hope_index = i;
-        hope_bleu = bleu;
-        hope_model = score;
-      }
-      // Fear
-      if(i==0 || (score - bleu) > fear_score) {
-        fear_score = score - bleu;
-        fear_index = i;
-      }
-      // Model
-      if(i==0 || score > model_score) {
-        model_score = score;
-        model_index = i;
-      }
-    }
-    // Outer loop rescales the contribution of model score to 'hope' in antagonistic cases
-    // where model score is having far more influence than BLEU
-    hope_bleu *= BLEU_RATIO; // We only care about cases where model has MUCH more influence than BLEU
-    if(safe_hope_ && safe_loop==0 && abs(hope_model)>1e-8 && abs(hope_bleu)/abs(hope_model)<hope_scale)
-      hope_scale = abs(hope_bleu) / abs(hope_model);
-    else break;
-  }
-  hopeFear->modelFeatures = train_->featuresAt(model_index);
-  hopeFear->hopeFeatures = train_->featuresAt(hope_index);
-  hopeFear->fearFeatures = train_->featuresAt(fear_index);
-
-  hopeFear->hopeStats = train_->scoresAt(hope_index);
-  hopeFear->hopeBleu = scorer_->calculateSentenceLevelBackgroundScore(hopeFear->hopeStats, backgroundBleu);
-  const vector<float>& fear_stats = train_->scoresAt(fear_index);
-  hopeFear->fearBleu = scorer_->calculateSentenceLevelBackgroundScore(fear_stats, backgroundBleu);
-
-  hopeFear->modelStats = train_->scoresAt(model_index);
-  hopeFear->hopeFearEqual = (hope_index == fear_index);
+void NbestHopeFearDecoder::HopeFearAt(
+  size_t position,
+  const std::vector<ValType>& backgroundBleu,
+  const MiraWeightVector& wv,
+  HopeFearData* hopeFear
+) const
+{
+  PositionPack pack = { randomAccess_, position };
+  NbestHopeFear(pack, scorer_, safe_hope_, backgroundBleu, wv, hopeFear);
 }
 
 void NbestHopeFearDecoder::MaxModel(const AvgWeightVector& wv, std::vector<ValType>* stats)
 {
-  // Find max model
-  size_t max_index=0;
-  ValType max_score=0;
-  for(size_t i=0; i<train_->cur_size(); i++) {
-    MiraFeatureVector vec(train_->featuresAt(i));
-    ValType score = wv.score(vec);
-    if(i==0 || score > max_score) {
-      max_index = i;
-      max_score = score;
-    }
-  }
-  *stats = train_->scoresAt(max_index);
+  CurrentPack pack = { train_.get() };
+  *stats = pack.scoresAt(MaxModelIndex(pack, wv));
+}
+
+void NbestHopeFearDecoder::MaxModelAt(size_t position, const AvgWeightVector& wv, std::vector<ValType>* stats) const
+{
+  PositionPack pack = { randomAccess_, position };
+  *stats = pack.scoresAt(MaxModelIndex(pack, wv));
 }
 
 
@@ -328,16 +478,32 @@ bool HypergraphHopeFearDecoder::finished()
   return sentenceIdIter_ == sentenceIds_.end();
 }
 
+bool HypergraphHopeFearDecoder::CurrentPosition(size_t* position)
+{
+  *position = sentenceIdIter_ - sentenceIds_.begin();
+  return true;
+}
+
 void HypergraphHopeFearDecoder::HopeFear(
   const vector<ValType>& backgroundBleu,
   const MiraWeightVector& wv,
   HopeFearData* hopeFear
 )
 {
-  size_t sentenceId = *sentenceIdIter_;
+  HopeFearAt(sentenceIdIter_ - sentenceIds_.begin(), backgroundBleu, wv, hopeFear);
+}
+
+void HypergraphHopeFearDecoder::HopeFearAt(
+  size_t position,
+  const vector<ValType>& backgroundBleu,
+  const MiraWeightVector& wv,
+  HopeFearData* hopeFear
+) const
+{
+  size_t sentenceId = sentenceIds_[position];
   SparseVector weights;
   wv.ToSparse(&weights, num_dense_);
-  const Graph& graph = *(graphs_[sentenceId]);
+  const Graph& graph = *(graphs_.find(sentenceId)->second);
 
   // ValType hope_scale = 1.0;
   HgHypothesis hopeHypo, fearHypo, modelHypo;
@@ -428,13 +594,18 @@ void HypergraphHopeFearDecoder::HopeFear(
 void HypergraphHopeFearDecoder::MaxModel(const AvgWeightVector& wv, vector<ValType>* stats)
 {
   assert(!finished());
+  MaxModelAt(sentenceIdIter_ - sentenceIds_.begin(), wv, stats);
+}
+
+void HypergraphHopeFearDecoder::MaxModelAt(size_t position, const AvgWeightVector& wv, vector<ValType>* stats) const
+{
   HgHypothesis bestHypo;
-  size_t sentenceId = *sentenceIdIter_;
+  size_t sentenceId = sentenceIds_[position];
   SparseVector weights;
   wv.ToSparse(&weights, num_dense_);
   vector<ValType> bg(scorer_->NumberOfScores());
   //cerr << "Calculating bleu on " << sentenceId << endl;
-  Viterbi(*(graphs_[sentenceId]), weights, 0, references_, sentenceId, bg, &bestHypo);
+  Viterbi(*(graphs_.find(sentenceId)->second), weights, 0, references_, sentenceId, bg, &bestHypo);
   stats->resize(bestHypo.bleuStats.size());
   /*
   for (size_t i = 0; i < bestHypo.text.size(); ++i) {
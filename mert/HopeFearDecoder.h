@@ -64,6 +64,8 @@ struct HopeFearData {
 class HopeFearDecoder
 {
 public:
+  HopeFearDecoder() : scorer_(NULL), threads_(1) {}
+
   //iterator methods
   virtual void reset() = 0;
   virtual void next() = 0;
@@ -84,11 +86,56 @@ public:
   virtual void MaxModel(const AvgWeightVector& wv, std::vector<ValType>* stats)
   = 0;
 
+  /**
+    * Calculate hope, fear and model hypotheses of the current sentence and
+    * the ones after it, up to batchSize sentences, all against the same
+    * weights and background. Leaves the decoder after the last of them.
+    * The sentences are decoded in parallel if the decoder supports random
+    * access; the result does not depend on the number of threads.
+    **/
+  void HopeFearBatch(
+    const std::vector<ValType>& backgroundBleu,
+    const MiraWeightVector& wv,
+    std::size_t batchSize,
+    std::vector<HopeFearData>* hopeFear
+  );
+
   /** Calculate bleu on training set */
   ValType Evaluate(const AvgWeightVector& wv);
 
+  /** Threads used by HopeFearBatch and Evaluate */
+  void SetThreads(std::size_t threads) {
+    threads_ = threads;
+  }
+
 protected:
+  /**
+    * Random access used for parallel decoding. Returns false if the
+    * decoder does not support it, otherwise sets the position of the
+    * current sentence, which may be passed to HopeFearAt and MaxModelAt
+    * from several threads at once until the next reset().
+    **/
+  virtual bool CurrentPosition(std::size_t* position) {
+    return false;
+  }
+
+  virtual void HopeFearAt(
+    std::size_t position,
+    const std::vector<ValType>& backgroundBleu,
+    const MiraWeightVector& wv,
+    HopeFearData* hopeFear
+  ) const;
+
+  virtual void MaxModelAt(std::size_t position, const AvgWeightVector& wv,
+                          std::vector<ValType>* stats) const;
+
   Scorer* scorer_;
+  std::size_t threads_;
+
+private:
+  // ParallelFor bodies
+  struct HopeFearTask;
+  struct MaxModelTask;
 };
 
 
@@ -116,8 +163,23 @@ public:
 
   virtual void MaxModel(const AvgWeightVector& wv, std::vector<ValType>* stats);
 
+protected:
+  virtual bool CurrentPosition(std::size_t* position);
+
+  virtual void HopeFearAt(
+    std::size_t position,
+    const std::vector<ValType>& backgroundBleu,
+    const MiraWeightVector& wv,
+    HopeFearData* hopeFear
+  ) const;
+
+  virtual void MaxModelAt(std::size_t position, const AvgWeightVector& wv,
+                          std::vector<ValType>* stats) const;
+
 private:
   boost::scoped_ptr<HypPackEnumerator> train_;
+  // train_ when it is in memory, NULL when streaming
+  RandomAccessHypPackEnumerator* randomAccess_;
   bool safe_hope_;
 
 };
@@ -152,6 +214,19 @@ public:
 
   virtual void MaxModel(const AvgWeightVector& wv, std::vector<ValType>* stats);
 
+protected:
+  virtual bool CurrentPosition(std::size_t* position);
+
+  virtual void HopeFearAt(
+    std::size_t position,
+    const std::vector<ValType>& backgroundBleu,
+    const MiraWeightVector& wv,
+    HopeFearData* hopeFear
+  ) const;
+
+  virtual void MaxModelAt(std::size_t position, const AvgWeightVector& wv,
+                          std::vector<ValType>* stats) const;
+
 private:
   size_t num_dense_;
   //maps sentence Id to graph ptr
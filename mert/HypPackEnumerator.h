@@ -95,6 +95,21 @@ public:
   virtual const MiraFeatureVector& featuresAt(std::size_t i);
   virtual const ScoreDataItem& scoresAt(std::size_t i);
 
+  // Random access by position in the current order, for use from several
+  // threads; the position of the current sentence is cur_position().
+  std::size_t cur_position() const {
+    return m_cur_index;
+  }
+  std::size_t sizeAt(std::size_t position) const {
+    return m_features[m_indexes[position]].size();
+  }
+  const MiraFeatureVector& featuresAt(std::size_t position, std::size_t i) const {
+    return m_features[m_indexes[position]][i];
+  }
+  const ScoreDataItem& scoresAt(std::size_t position, std::size_t i) const {
+    return m_scores[m_indexes[position]][i];
+  }
+
 private:
   bool m_no_shuffle;
   std::size_t m_cur_index;
@@ -8,7 +8,9 @@
 #include <cfloat>
 #include <iostream>
 #include <stdint.h>
+#include <algorithm>
 
+#include "ParallelFor.h"
 #include "Point.h"
 #include "Util.h"
 
@@ -20,6 +22,15 @@ static const float MAX_FLOAT = numeric_limits<float>::max();
 namespace
 {
 
+// Minimal distance between two thresholds of the same sentence.
+const float kMinInterval = 0.0001;
+
+struct CompareGradient {
+  bool operator()(const pair<float,unsigned>& a, const pair<float,unsigned>& b) const {
+    return a.first < b.first;
+  }
+};
+
 /**
  * Compute the intersection of 2 lines.
  */
@@ -39,7 +50,7 @@ namespace MosesTuning
 
 
 Optimizer::Optimizer(unsigned Pd, const vector<unsigned>& i2O, const vector<bool>& pos, const vector<parameter_t>& start, unsigned int nrandom)
-  : m_scorer(NULL), m_feature_data(), m_num_random_directions(nrandom), m_positive(pos)
+  : m_scorer(NULL), m_feature_data(), m_num_random_directions(nrandom), m_line_threads(1), m_positive(pos)
 {
   // Warning: the init vector is a full set of parameters, of dimension m_pdim!
   Point::m_pdim = Pd;
@@ -90,148 +101,168 @@ map<float,diff_t >::iterator AddThreshold(map<float,diff_t >& thresholdmap, floa
   return it;
 }
 
-statscore_t Optimizer::LineOptimize(const Point& origin, const Point& direction, Point& bestpoint) const
+void Optimizer::GetSentenceEnvelope(unsigned S, const Point& origin, const Point& direction,
+                                    unsigned& first1best, vector<pair<float,unsigned> >& changes) const
 {
-  // We are looking for the best Point on the line y=Origin+x*direction
-  float min_int = 0.0001;
-  //typedef pair<unsigned,unsigned> diff;//first the sentence that changes, second is the new 1best for this sentence
-  //list<threshold> thresholdlist;
-
-  map<float,diff_t> thresholdmap;
-  thresholdmap[MIN_FLOAT] = diff_t();
-  vector<unsigned> first1best;       // the vector of nbests for x=-inf
-  for (unsigned int S = 0; S < size(); S++) {
-    map<float,diff_t >::iterator previnserted = thresholdmap.begin();
-    // First, we determine the translation with the best feature score
-    // for each sentence and each value of x.
-    //cerr << "Sentence " << S << endl;
-    multimap<float, unsigned> gradient;
-    vector<float> f0;
-    f0.resize(m_feature_data->get(S).size());
-    for (unsigned j = 0; j < m_feature_data->get(S).size(); j++) {
-      // gradient of the feature function for this particular target sentence
-      gradient.insert(pair<float, unsigned>(direction * (m_feature_data->get(S,j)), j));
-      // compute the feature function at the origin point
-      f0[j] = origin * m_feature_data->get(S, j);
-    }
-    // Now let's compute the 1best for each value of x.
-
-    //    vector<pair<float,unsigned> > onebest;
+  changes.clear();
+  const unsigned nbest = m_feature_data->get(S).size();
+
+  // First, we determine the translation with the best feature score
+  // for each sentence and each value of x.
+  //cerr << "Sentence " << S << endl;
+  // Candidates sorted by gradient; stable, so that equal gradients keep their
+  // n-best order (as the multimap used to).
+  vector<pair<float, unsigned> > gradient(nbest);
+  vector<float> f0(nbest);
+  for (unsigned j = 0; j < nbest; j++) {
+    // gradient of the feature function for this particular target sentence
+    gradient[j] = pair<float, unsigned>(direction * (m_feature_data->get(S,j)), j);
+    // compute the feature function at the origin point
+    f0[j] = origin * m_feature_data->get(S, j);
+  }
+  stable_sort(gradient.begin(), gradient.end(), CompareGradient());
 
+  // Now let's compute the 1best for each value of x.
 
-    multimap<float,unsigned>::iterator gradientit = gradient.begin();
-    multimap<float,unsigned>::iterator highest_f0 = gradient.begin();
+  size_t gradientit = 0;
+  size_t highest_f0 = 0;
 
-    float smallest = gradientit->first;//smallest gradient
-    // Several candidates can have the lowest slope (e.g., for word penalty where the gradient is an integer).
+  float smallest = gradient[gradientit].first;//smallest gradient
+  // Several candidates can have the lowest slope (e.g., for word penalty where the gradient is an integer).
 
+  gradientit++;
+  while (gradientit != nbest && gradient[gradientit].first == smallest) {
+    if (f0[gradient[gradientit].second] > f0[gradient[highest_f0].second])
+      highest_f0 = gradientit;//the highest line is the one with he highest f0
     gradientit++;
-    while (gradientit != gradient.end() && gradientit->first == smallest) {
-      //   cerr<<"ni"<<gradientit->second<<endl;;
-      //cerr<<"fos"<<f0[gradientit->second]<<" "<<f0[index]<<" "<<index<<endl;
-      if (f0[gradientit->second] > f0[highest_f0->second])
-        highest_f0 = gradientit;//the highest line is the one with he highest f0
-      gradientit++;
-    }
+  }
 
-    gradientit = highest_f0;
-    first1best.push_back(highest_f0->second);
-
-    // Now we look for the intersections points indicating a change of 1 best.
-    // We use the fact that the function is convex, which means that the gradient can only go up.
-    while (gradientit != gradient.end()) {
-      map<float,unsigned>::iterator leftmost = gradientit;
-      float m = gradientit->first;
-      float b = f0[gradientit->second];
-      multimap<float,unsigned>::iterator gradientit2 = gradientit;
-      gradientit2++;
-      float leftmostx = MAX_FLOAT;
-      for (; gradientit2 != gradient.end(); gradientit2++) {
-        //cerr<<"--"<<d++<<' '<<gradientit2->first<<' '<<gradientit2->second<<endl;
-        // Look for all candidate with a gradient bigger than the current one, and
-        // find the one with the leftmost intersection.
-        float curintersect;
-        if (m != gradientit2->first) {
-          curintersect = intersect(m, b, gradientit2->first, f0[gradientit2->second]);
-          //cerr << "curintersect: " << curintersect << " leftmostx: " << leftmostx << endl;
-          if (curintersect<=leftmostx) {
-            // We have found an intersection to the left of the leftmost we had so far.
-            // We might have curintersect==leftmostx for example is 2 candidates are the same
-            // in that case its better its better to update leftmost to gradientit2 to avoid some recomputing later.
-            leftmostx = curintersect;
-            leftmost = gradientit2; // this is the new reference
-          }
+  gradientit = highest_f0;
+  first1best = gradient[highest_f0].second;
+
+  // Now we look for the intersections points indicating a change of 1 best.
+  // We use the fact that the function is convex, which means that the gradient can only go up.
+  while (gradientit != nbest) {
+    size_t leftmost = gradientit;
+    float m = gradient[gradientit].first;
+    float b = f0[gradient[gradientit].second];
+    float leftmostx = MAX_FLOAT;
+    for (size_t gradientit2 = gradientit + 1; gradientit2 != nbest; gradientit2++) {
+      // Look for all candidate with a gradient bigger than the current one, and
+      // find the one with the leftmost intersection.
+      float curintersect;
+      if (m != gradient[gradientit2].first) {
+        curintersect = intersect(m, b, gradient[gradientit2].first, f0[gradient[gradientit2].second]);
+        if (curintersect<=leftmostx) {
+          // We have found an intersection to the left of the leftmost we had so far.
+          // We might have curintersect==leftmostx for example is 2 candidates are the same
+          // in that case its better its better to update leftmost to gradientit2 to avoid some recomputing later.
+          leftmostx = curintersect;
+          leftmost = gradientit2; // this is the new reference
         }
       }
-      if (leftmost == gradientit) {
-        // We didn't find any more intersections.
-        // The rightmost bestindex is the one with the highest slope.
-
-        // They should be equal but there might be.
-        UTIL_THROW_IF(abs(leftmost->first-gradient.rbegin()->first) >= 0.0001,
-                      util::Exception, "Error");
-        // A small difference due to rounding error
-        break;
-      }
-      // We have found the next intersection!
-
-      pair<unsigned,unsigned> newd(S, leftmost->second);//new onebest for Sentence S is leftmost->second
-
-      if (leftmostx-previnserted->first < min_int) {
-        // Require that the intersection Point be at least min_int to the right of the previous
-        // one (for this sentence). If not, we replace the previous intersection Point with
-        // this one.
-        // Yes, it can even happen that the new intersection Point is slightly to the left of
-        // the old one, because of numerical imprecision. We do not check that we are to the
-        // right of the penultimate point also. It this happen the 1best the interval will
-        // be wrong we are going to replace previnsert by the new one because we do not want to keep
-        // 2 very close threshold: if the minima is there it could be an artifact.
-
-        map<float,diff_t>::iterator tit = thresholdmap.find(leftmostx);
-        if (tit == previnserted) {
-          // The threshold is the same as before can happen if 2 candidates are the same for example.
-          UTIL_THROW_IF(previnserted->second.back().first != newd.first,
-                        util::Exception,
-                        "Error");
-          previnserted->second.back()=newd; // just replace the 1 best for sentence S
-          // previnsert doesn't change
-        } else {
-
-          if (tit == thresholdmap.end()) {
-            thresholdmap[leftmostx]=previnserted->second; // We keep the diffs at previnsert
-            thresholdmap.erase(previnserted); // erase old previnsert
-            previnserted = thresholdmap.find(leftmostx); // point previnsert to the new threshold
-            previnserted->second.back()=newd; // We update the diff for sentence S
-            // Threshold already exists but is not the previous one.
-          } else {
-            // We append the diffs in previnsert to tit before destroying previnsert.
-            tit->second.insert(tit->second.end(),previnserted->second.begin(),previnserted->second.end());
-            UTIL_THROW_IF(tit->second.back().first != newd.first,
-                          util::Exception,
-                          "Error");
-            tit->second.back()=newd;    // change diff for sentence S
-            thresholdmap.erase(previnserted); // erase old previnsert
-            previnserted = tit;  // point previnsert to the new threshold
-          }
-        }
+    }
+    if (leftmost == gradientit) {
+      // We didn't find any more intersections.
+      // The rightmost bestindex is the one with the highest slope.
+
+      // They should be equal but there might be.
+      UTIL_THROW_IF(abs(gradient[leftmost].first-gradient.back().first) >= 0.0001,
+                    util::Exception, "Error");
+      // A small difference due to rounding error
+      break;
+    }
+    // We have found the next intersection!
+    changes.push_back(pair<float,unsigned>(leftmostx, gradient[leftmost].second));
+    gradientit = leftmost;
+  }
+}
 
-        UTIL_THROW_IF(previnserted == thresholdmap.end(),
+void Optimizer::AddSentenceThresholds(map<float,diff_t>& thresholdmap, unsigned S,
+                                      const vector<pair<float,unsigned> >& changes) const
+{
+  map<float,diff_t >::iterator previnserted = thresholdmap.begin();
+  for (size_t i = 0; i < changes.size(); ++i) {
+    float leftmostx = changes[i].first;
+    pair<unsigned,unsigned> newd(S, changes[i].second);//new onebest for Sentence S is changes[i].second
+
+    if (leftmostx-previnserted->first < kMinInterval) {
+      // Require that the intersection Point be at least kMinInterval to the right of the previous
+      // one (for this sentence). If not, we replace the previous intersection Point with
+      // this one.
+      // Yes, it can even happen that the new intersection Point is slightly to the left of
+      // the old one, because of numerical imprecision. We do not check that we are to the
+      // right of the penultimate point also. It this happen the 1best the interval will
+      // be wrong we are going to replace previnsert by the new one because we do not want to keep
+      // 2 very close threshold: if the minima is there it could be an artifact.
+
+      map<float,diff_t>::iterator tit = thresholdmap.find(leftmostx);
+      if (tit == previnserted) {
+        // The threshold is the same as before can happen if 2 candidates are the same for example.
+        UTIL_THROW_IF(previnserted->second.back().first != newd.first,
                       util::Exception,
                       "Error");
-      } else { //normal insertion process
-        previnserted = AddThreshold(thresholdmap, leftmostx, newd);
+        previnserted->second.back()=newd; // just replace the 1 best for sentence S
+        // previnsert doesn't change
+      } else {
+
+        if (tit == thresholdmap.end()) {
+          thresholdmap[leftmostx]=previnserted->second; // We keep the diffs at previnsert
+          thresholdmap.erase(previnserted); // erase old previnsert
+          previnserted = thresholdmap.find(leftmostx); // point previnsert to the new threshold
+          previnserted->second.back()=newd; // We update the diff for sentence S
+          // Threshold already exists but is not the previous one.
+        } else {
+          // We append the diffs in previnsert to tit before destroying previnsert.
+          tit->second.insert(tit->second.end(),previnserted->second.begin(),previnserted->second.end());
+          UTIL_THROW_IF(tit->second.back().first != newd.first,
+                        util::Exception,
+                        "Error");
+          tit->second.back()=newd;    // change diff for sentence S
+          thresholdmap.erase(previnserted); // erase old previnsert
+          previnserted = tit;  // point previnsert to the new threshold
+        }
       }
-      gradientit = leftmost;
-    } // while (gradientit!=gradient.end()){
-  }   // loop on S
+
+      UTIL_THROW_IF(previnserted == thresholdmap.end(),
+                    util::Exception,
+                    "Error");
+    } else { //normal insertion process
+      previnserted = AddThreshold(thresholdmap, leftmostx, newd);
+    }
+  }
+}
+
+statscore_t Optimizer::LineOptimize(const Point& origin, const Point& direction, Point& bestpoint) const
+{
+  // We are looking for the best Point on the line y=Origin+x*direction
+  vector<unsigned> first1best;       // the vector of nbests for x=-inf
+  vector<threshold> thresholds;
+
+#ifdef WITH_THREADS
+  if (m_line_threads > 1) {
+    GetThresholdsParallel(origin, direction, first1best, thresholds);
+  } else
+#endif
+  {
+    map<float,diff_t> thresholdmap;
+    thresholdmap[MIN_FLOAT] = diff_t();
+    first1best.resize(size());
+    vector<pair<float,unsigned> > changes;
+    for (unsigned int S = 0; S < size(); S++) {
+      GetSentenceEnvelope(S, origin, direction, first1best[S], changes);
+      AddSentenceThresholds(thresholdmap, S, changes);
+    }
+    thresholds.assign(thresholdmap.begin(), thresholdmap.end());
+  }
 
   // Now the thresholdlist is up to date: it contains a list of all the parameter_ts where
   // the function changed its value, along with the nbest list for the interval after each threshold.
 
-  map<float,diff_t >::iterator thrit;
+  vector<threshold>::const_iterator thrit;
   if (verboselevel() > 6) {
-    cerr << "Thresholds:(" << thresholdmap.size() << ")" << endl;
-    for (thrit = thresholdmap.begin(); thrit != thresholdmap.end(); thrit++) {
+    cerr << "Thresholds:(" << thresholds.size() << ")" << endl;
+    for (thrit = thresholds.begin(); thrit != thresholds.end(); thrit++) {
       cerr << "x: " << thrit->first << " diffs";
       for (size_t j = 0; j < thrit->second.size(); ++j) {
         cerr << " " <<thrit->second[j].first << "," << thrit->second[j].second;
@@ -241,19 +272,19 @@ statscore_t Optimizer::LineOptimize(const Point& origin, const Point& direction,
   }
 
   // Last thing to do is compute the Stat score (i.e., BLEU) and find the minimum.
-  thrit = thresholdmap.begin();
+  thrit = thresholds.begin();
   ++thrit;       // first diff corrrespond to MIN_FLOAT and first1best
   diffs_t diffs;
-  for (; thrit != thresholdmap.end(); thrit++)
+  for (; thrit != thresholds.end(); thrit++)
     diffs.push_back(thrit->second);
   vector<statscore_t> scores = GetIncStatScore(first1best, diffs);
 
-  thrit = thresholdmap.begin();
+  thrit = thresholds.begin();
   statscore_t bestscore = MIN_FLOAT;
   float bestx = MIN_FLOAT;
 
   // We skipped the first el of thresholdlist but GetIncStatScore return 1 more for first1best.
-  UTIL_THROW_IF(scores.size() != thresholdmap.size(),
+  UTIL_THROW_IF(scores.size() != thresholds.size(),
                 util::Exception,
                 "Error");
   for (unsigned int sc = 0; sc != scores.size(); sc++) {
@@ -279,12 +310,12 @@ statscore_t Optimizer::LineOptimize(const Point& origin, const Point& direction,
       // interval, take x to be the first interval boundary - 1000.
       // These values are taken from cmert.
       float leftx = thrit->first;
-      if (thrit == thresholdmap.begin()) {
+      if (thrit == thresholds.begin()) {
         leftx = MIN_FLOAT;
       }
       ++thrit;
       float rightx = MAX_FLOAT;
-      if (thrit != thresholdmap.end()) {
+      if (thrit != thresholds.end()) {
         rightx = thrit->first;
       }
       --thrit;
@@ -319,6 +350,155 @@ statscore_t Optimizer::LineOptimize(const Point& origin, const Point& direction,
   return bestscore;
 }
 
+#ifdef WITH_THREADS
+namespace
+{
+
+// A change of the 1-best of a sentence at position x on the line.
+struct LineChange {
+  float x;
+  unsigned sentence;
+  unsigned best;
+};
+
+inline bool CompareLineChange(const LineChange& a, const LineChange& b)
+{
+  return a.x < b.x;
+}
+
+/**
+ * Computes the envelope of one sentence and applies the kMinInterval rule
+ * of AddSentenceThresholds to it. A sentence's thresholds only depend on
+ * its own earlier thresholds, so this can be done independently for each
+ * sentence. Positions that a threshold is moved away from are recorded:
+ * if another sentence's threshold sits there, the threshold map would move
+ * that one too, and the merge must fall back to the map.
+ */
+struct EnvelopeBody {
+  const Optimizer* optimizer;
+  const Point* origin;
+  const Point* direction;
+  vector<unsigned>* first1best;
+  vector<vector<pair<float,unsigned> > >* changes;
+  vector<vector<LineChange> >* runs;
+  vector<vector<float> >* moved;
+  vector<char>* fallback;
+
+  void operator()(size_t S) {
+    vector<pair<float,unsigned> >& sentChanges = (*changes)[S];
+    optimizer->GetSentenceEnvelope(S, *origin, *direction, (*first1best)[S], sentChanges);
+    vector<LineChange>& run = (*runs)[S];
+    float previous = MIN_FLOAT;
+    for (size_t i = 0; i < sentChanges.size(); ++i) {
+      LineChange change = { sentChanges[i].first, (unsigned) S, sentChanges[i].second };
+      if (change.x - previous < kMinInterval) {
+        if (run.empty()) {
+          // would collapse into the -inf entry
+          (*fallback)[S] = true;
+          return;
+        }
+        if (change.x != previous) {
+          (*moved)[S].push_back(previous);
+        }
+        run.back() = change;
+      } else {
+        run.push_back(change);
+      }
+      previous = change.x;
+    }
+  }
+};
+
+struct MergeBody {
+  vector<vector<LineChange> >* runs;
+  vector<vector<LineChange> >* merged;
+
+  void operator()(size_t i) {
+    vector<LineChange>& out = (*merged)[i];
+    if (2 * i + 1 == runs->size()) {
+      out.swap((*runs)[2 * i]);
+      return;
+    }
+    const vector<LineChange>& left = (*runs)[2 * i];
+    const vector<LineChange>& right = (*runs)[2 * i + 1];
+    out.resize(left.size() + right.size());
+    // std::merge is stable: on ties, the lower sentence numbers come first
+    std::merge(left.begin(), left.end(), right.begin(), right.end(), out.begin(), CompareLineChange);
+    vector<LineChange>().swap((*runs)[2 * i]);
+    vector<LineChange>().swap((*runs)[2 * i + 1]);
+  }
+};
+
+} // namespace
+
+void Optimizer::GetThresholdsParallel(const Point& origin, const Point& direction,
+                                      vector<unsigned>& first1best,
+                                      vector<threshold>& thresholds) const
+{
+  const size_t num_sentences = size();
+  first1best.resize(num_sentences);
+  vector<vector<pair<float,unsigned> > > changes(num_sentences);
+  vector<vector<LineChange> > runs(num_sentences);
+  vector<vector<float> > moved(num_sentences);
+  vector<char> fallback(num_sentences, false);
+
+  EnvelopeBody envelopes = { this, &origin, &direction, &first1best, &changes, &runs, &moved, &fallback };
+  ParallelFor(envelopes, num_sentences, m_line_threads);
+
+  // Would the threshold map have moved the threshold of one sentence
+  // together with that of a later one?
+  bool collision = find(fallback.begin(), fallback.end(), true) != fallback.end();
+  vector<pair<float,unsigned> > moved_from;
+  for (size_t S = 0; S < num_sentences; ++S) {
+    for (size_t i = 0; i < moved[S].size(); ++i) {
+      moved_from.push_back(make_pair(moved[S][i], (unsigned) S));
+    }
+  }
+  if (!collision && !moved_from.empty()) {
+    sort(moved_from.begin(), moved_from.end());
+    for (size_t S = 0; S < num_sentences && !collision; ++S) {
+      for (size_t i = 0; i < runs[S].size() && !collision; ++i) {
+        vector<pair<float,unsigned> >::const_iterator it
+        = lower_bound(moved_from.begin(), moved_from.end(), make_pair(runs[S][i].x, 0U), CompareGradient());
+        for (; it != moved_from.end() && !(runs[S][i].x < it->first); ++it) {
+          if (it->second > S) collision = true;
+        }
+      }
+    }
+  }
+
+  thresholds.clear();
+  if (collision) {
+    if (verboselevel() > 4)
+      cerr << "threshold collision, merging sequentially" << endl;
+    map<float,diff_t> thresholdmap;
+    thresholdmap[MIN_FLOAT] = diff_t();
+    for (size_t S = 0; S < num_sentences; ++S) {
+      AddSentenceThresholds(thresholdmap, S, changes[S]);
+    }
+    thresholds.assign(thresholdmap.begin(), thresholdmap.end());
+    return;
+  }
+
+  while (runs.size() > 1) {
+    vector<vector<LineChange> > merged((runs.size() + 1) / 2);
+    MergeBody merge = { &runs, &merged };
+    ParallelFor(merge, merged.size(), m_line_threads);
+    runs.swap(merged);
+  }
+
+  thresholds.push_back(threshold(MIN_FLOAT, diff_t()));
+  if (runs.empty()) return;
+  const vector<LineChange>& all = runs[0];
+  for (size_t i = 0; i < all.size(); ++i) {
+    if (all[i].x != thresholds.back().first) {
+      thresholds.push_back(threshold(all[i].x, diff_t()));
+    }
+    thresholds.back().second.push_back(make_pair(all[i].sentence, all[i].best));
+  }
+}
+#endif
+
 void Optimizer::Get1bests(const Point& P, vector<unsigned>& bests) const
 {
   UTIL_THROW_IF(m_feature_data == NULL, util::Exception, "Error");
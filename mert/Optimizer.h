@@ -1,8 +1,10 @@
 #ifndef MERT_OPTIMIZER_H_
 #define MERT_OPTIMIZER_H_
 
+#include <map>
 #include <vector>
 #include <string>
+#include <utility>
 #include "Data.h"
 #include "FeatureData.h"
 #include "Scorer.h"
@@ -25,9 +27,25 @@ protected:
   Scorer *m_scorer;      // no accessor for them only child can use them
   FeatureDataHandle m_feature_data;  // no accessor for them only child can use them
   unsigned int m_num_random_directions;
+  unsigned int m_line_threads;
 
   const std::vector<bool>& m_positive;
 
+  /**
+   * Merge the 1-best changes of sentence S into the threshold map.
+   */
+  void AddSentenceThresholds(std::map<float,diff_t>& thresholdmap, unsigned S,
+                             const std::vector<std::pair<float,unsigned> >& changes) const;
+
+  /**
+   * LineOptimize helper: computes the sentence envelopes on m_line_threads
+   * threads and merges them with a parallel merge. Same result as the
+   * sequential threshold map.
+   */
+  void GetThresholdsParallel(const Point& origin, const Point& direction,
+                             std::vector<unsigned>& first1best,
+                             std::vector<threshold>& thresholds) const;
+
 public:
   Optimizer(unsigned Pd, const std::vector<unsigned>& i2O, const std::vector<bool>& positive, const std::vector<parameter_t>& start, unsigned int nrandom);
 
@@ -37,6 +55,12 @@ public:
   void SetFeatureData(FeatureDataHandle feature_data) {
     m_feature_data = feature_data;
   }
+  /**
+   * Number of threads used inside each line search (default 1).
+   */
+  void SetLineThreads(unsigned int num_threads) {
+    m_line_threads = num_threads;
+  }
   virtual ~Optimizer();
 
   unsigned size() const {
@@ -73,6 +97,15 @@ public:
    * Get the optimal Lambda and the best score in a particular direction from a given Point.
    */
   statscore_t LineOptimize(const Point& start, const Point& direction, Point& best) const;
+
+  /**
+   * Upper envelope of the n-best list of sentence S along the line
+   * y=origin+x*direction: the 1-best at x=-inf and the (x, new 1-best)
+   * points, in increasing order of x, where the 1-best changes.
+   */
+  void GetSentenceEnvelope(unsigned S, const Point& origin, const Point& direction,
+                           unsigned& first1best,
+                           std::vector<std::pair<float,unsigned> >& changes) const;
 };
 
 
@@ -0,0 +1,159 @@
+#include "Optimizer.h"
+
+#define BOOST_TEST_MODULE MertOptimizer
+#include <boost/test/unit_test.hpp>
+
+#include <boost/scoped_ptr.hpp>
+
+#include "Data.h"
+#include "OptimizerFactory.h"
+#include "Point.h"
+#include "Scorer.h"
+#include "ScorerFactory.h"
+#include "util/random.hh"
+
+using namespace std;
+using namespace MosesTuning;
+
+namespace
+{
+
+void AddSentence(Data& data, const vector<vector<float> >& features)
+{
+  const size_t index = data.getFeatureData()->size();
+  FeatureArray fa;
+  ScoreArray sa;
+  fa.setIndex(index);
+  sa.setIndex(index);
+  for (size_t j = 0; j < features.size(); ++j) {
+    FeatureStats fs;
+    for (size_t k = 0; k < features[j].size(); ++k) {
+      fs.add(features[j][k]);
+    }
+    fa.add(fs);
+
+    // BLEU statistics: matches and totals for orders 1-4, reference length
+    ScoreStats ss;
+    const int length = 10 + util::rand_excl(5);
+    for (int n = 0; n < 4; ++n) {
+      ss.add(util::rand_excl(length - n + 1));
+      ss.add(length - n);
+    }
+    ss.add(12);
+    sa.add(ss);
+  }
+  data.getFeatureData()->add(fa);
+  data.getScoreData()->add(sa);
+}
+
+// Line search with the given number of threads.
+statscore_t LineOptimize(Optimizer& optimizer, unsigned int threads,
+                         const Point& origin, const Point& direction, Point& best)
+{
+  optimizer.SetLineThreads(threads);
+  return optimizer.LineOptimize(origin, direction, best);
+}
+
+void CheckSamePoint(const Point& a, const Point& b)
+{
+  BOOST_REQUIRE_EQUAL(a.size(), b.size());
+  for (size_t i = 0; i < a.size(); ++i) {
+    BOOST_CHECK_EQUAL(a[i], b[i]);
+  }
+  BOOST_CHECK_EQUAL(a.GetScore(), b.GetScore());
+}
+
+} // namespace
+
+#ifdef WITH_THREADS
+
+BOOST_AUTO_TEST_CASE(parallel_line_optimize_random)
+{
+  util::rand_init(1234);
+  const unsigned int dim = 4;
+  boost::scoped_ptr<Scorer> scorer(ScorerFactory::getScorer("BLEU", ""));
+  Data data(scorer.get());
+  for (size_t s = 0; s < 50; ++s) {
+    vector<vector<float> > features(40, vector<float>(dim));
+    for (size_t j = 0; j < features.size(); ++j) {
+      for (size_t k = 0; k < dim; ++k) {
+        // integer values give many ties between the lines
+        features[j][k] = (k == 0) ? -float(util::rand_excl(10))
+                         : util::rand_excl(1000) / 100.0f - 5.0f;
+      }
+    }
+    AddSentence(data, features);
+  }
+
+  vector<unsigned> to_optimize;
+  for (unsigned int k = 0; k < dim; ++k) to_optimize.push_back(k);
+  vector<bool> positive(dim, false);
+  vector<parameter_t> start(dim, 0.5f);
+  vector<parameter_t> min(dim, -1.0f);
+  vector<parameter_t> max(dim, 1.0f);
+  boost::scoped_ptr<Optimizer> optimizer(OptimizerFactory::BuildOptimizer(dim, to_optimize, positive, start, "powell", 0));
+  optimizer->SetScorer(scorer.get());
+  optimizer->SetFeatureData(data.getFeatureData());
+
+  for (int i = 0; i < 10; ++i) {
+    Point origin(start, min, max);
+    origin.Randomize();
+    Point direction(start, min, max);
+    direction.Randomize();
+    Point serial, parallel;
+    const statscore_t serial_score = LineOptimize(*optimizer, 1, origin, direction, serial);
+    const statscore_t parallel_score = LineOptimize(*optimizer, 3, origin, direction, parallel);
+    BOOST_CHECK_EQUAL(serial_score, parallel_score);
+    CheckSamePoint(serial, parallel);
+  }
+}
+
+// The second sentence moves its threshold away from x=1, where the first
+// sentence has one; the threshold map moves both, and so must the
+// parallel line search.
+BOOST_AUTO_TEST_CASE(parallel_line_optimize_collision)
+{
+  util::rand_init(1234);
+  const unsigned int dim = 2;
+  boost::scoped_ptr<Scorer> scorer(ScorerFactory::getScorer("BLEU", ""));
+  Data data(scorer.get());
+
+  // feature 0 is the slope, feature 1 the intercept of each line
+  vector<vector<float> > first(2, vector<float>(dim));
+  first[0][0] = 0.0f;
+  first[0][1] = 0.0f;
+  first[1][0] = 1.0f;
+  first[1][1] = -1.0f;
+  AddSentence(data, first);
+  vector<vector<float> > second(first);
+  second.push_back(vector<float>(dim));
+  second[2][0] = 2.0f;
+  second[2][1] = -2.00005f;
+  AddSentence(data, second);
+
+  vector<unsigned> to_optimize;
+  to_optimize.push_back(0);
+  to_optimize.push_back(1);
+  vector<bool> positive(dim, false);
+  vector<parameter_t> start(dim);
+  start[0] = 0.0f;
+  start[1] = 1.0f;
+  vector<parameter_t> unit(dim);
+  unit[0] = 1.0f;
+  unit[1] = 0.0f;
+  vector<parameter_t> min(dim, -1.0f);
+  vector<parameter_t> max(dim, 1.0f);
+  boost::scoped_ptr<Optimizer> optimizer(OptimizerFactory::BuildOptimizer(dim, to_optimize, positive, start, "powell", 0));
+  optimizer->SetScorer(scorer.get());
+  optimizer->SetFeatureData(data.getFeatureData());
+
+  Point origin(start, min, max);
+  Point direction(unit, min, max);
+  Point serial, parallel;
+  const statscore_t serial_score = LineOptimize(*optimizer, 1, origin, direction, serial);
+  const statscore_t parallel_score = LineOptimize(*optimizer, 2, origin, direction, parallel);
+  BOOST_CHECK_EQUAL(serial_score, parallel_score);
+  CheckSamePoint(serial, parallel);
+}
+
+#endif // WITH_THREADS
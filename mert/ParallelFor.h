@@ -0,0 +1,59 @@
+#ifndef MERT_PARALLEL_FOR_H_
+#define MERT_PARALLEL_FOR_H_
+
+#include <cstddef>
+#include <exception>
+#include <string>
+#include <vector>
+
+#ifdef WITH_THREADS
+#include <boost/thread.hpp>
+#endif
+
+#include "util/exception.hh"
+
+namespace MosesTuning
+{
+
+template <class Body>
+struct ParallelForWorker {
+  Body* body;
+  std::size_t begin, end, step;
+  std::string* error;
+  void operator()() {
+    try {
+      for (std::size_t i = begin; i < end; i += step) (*body)(i);
+    } catch (const std::exception& e) {
+      *error = e.what();
+    }
+  }
+};
+
+/**
+ * Runs body(i) for i in [0,count) on num_threads threads, thread t taking
+ * i = t, t + num_threads, ... Without thread support, runs serially.
+ */
+template <class Body>
+void ParallelFor(Body& body, std::size_t count, std::size_t num_threads)
+{
+#ifdef WITH_THREADS
+  if (num_threads > 1 && count > 1) {
+    std::vector<std::string> errors(num_threads);
+    boost::thread_group threads;
+    for (std::size_t t = 0; t < num_threads && t < count; ++t) {
+      ParallelForWorker<Body> worker = { &body, t, count, num_threads, &errors[t] };
+      threads.create_thread(worker);
+    }
+    threads.join_all();
+    for (std::size_t t = 0; t < errors.size(); ++t) {
+      UTIL_THROW_IF(!errors[t].empty(), util::Exception, errors[t]);
+    }
+    return;
+  }
+#endif
+  for (std::size_t i = 0; i < count; ++i) body(i);
+}
+
+}
+
+#endif  // MERT_PARALLEL_FOR_H_
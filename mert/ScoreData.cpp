@@ -13,6 +13,7 @@
 #include "Scorer.h"
 #include "Util.h"
 #include "FileStream.h"
+#include "ColumnarData.h"
 
 using namespace std;
 
@@ -55,6 +56,11 @@ void ScoreData::save(bool bin)
   save(&cout, bin);
 }
 
+void ScoreData::saveColumnar(const string &file, bool append) const
+{
+  SaveColumnar(*this, file, append);
+}
+
 void ScoreData::load(istream* is)
 {
   ScoreArray entry;
@@ -75,6 +81,10 @@ void ScoreData::load(istream* is)
 void ScoreData::load(const string &file)
 {
   TRACE_ERR("loading score data from " << file << endl);
+  if (IsColumnarFile(file)) {
+    LoadColumnar(file, *this);
+    return;
+  }
   inputfilestream input_stream(file); // matches a stream with a file. Opens the file
   if (!input_stream) {
     throw runtime_error("Unable to open score file: " + file);
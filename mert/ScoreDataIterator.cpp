@@ -21,6 +21,7 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #include "util/file_piece.hh"
 #include "util/tokenize_piece.hh"
 
+#include "ColumnarData.h"
 #include "ScoreArray.h"
 #include "ScoreDataIterator.h"
 
@@ -31,11 +32,15 @@ namespace MosesTuning
 {
 
 
-ScoreDataIterator::ScoreDataIterator() {}
+ScoreDataIterator::ScoreDataIterator() : m_sentence(0) {}
 
-ScoreDataIterator::ScoreDataIterator(const string& filename)
+ScoreDataIterator::ScoreDataIterator(const string& filename) : m_sentence(0)
 {
-  m_in.reset(new FilePiece(filename.c_str()));
+  if (IsColumnarFile(filename)) {
+    m_columns.reset(new ColumnarFile(filename));
+  } else {
+    m_in.reset(new FilePiece(filename.c_str()));
+  }
   readNext();
 }
 
@@ -44,6 +49,14 @@ ScoreDataIterator::~ScoreDataIterator() {}
 void ScoreDataIterator::readNext()
 {
   m_next.clear();
+  if (m_columns) {
+    if (m_sentence < m_columns->Sentences().size()) {
+      m_columns->GetScores(m_sentence++, m_next);
+    } else {
+      m_columns.reset();
+    }
+    return;
+  }
   try {
     StringPiece marker = m_in->ReadDelimited();
     if (marker != StringPiece(SCORES_TXT_BEGIN)) {
@@ -82,7 +95,9 @@ void ScoreDataIterator::increment()
 
 bool ScoreDataIterator::equal(const ScoreDataIterator& rhs) const
 {
-  if (!m_in && !rhs.m_in) {
+  if (m_columns || rhs.m_columns) {
+    return m_columns == rhs.m_columns && m_sentence == rhs.m_sentence;
+  } else if (!m_in && !rhs.m_in) {
     return true;
   } else if (!m_in) {
     return false;
@@ -41,6 +41,8 @@ class FilePiece;
 namespace MosesTuning
 {
 
+class ColumnarFile;
+
 
 typedef std::vector<float> ScoreDataItem;
 
@@ -69,6 +71,9 @@ private:
   void readNext();
 
   boost::shared_ptr<util::FilePiece> m_in;
+  // Set instead of m_in for columnar files.
+  boost::shared_ptr<ColumnarFile> m_columns;
+  std::size_t m_sentence;
   std::vector<ScoreDataItem> m_next;
 };
 
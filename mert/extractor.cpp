@@ -31,6 +31,8 @@ void usage()
   cerr << "\tThis is of the form NAME1:VAL1,NAME2:VAL2 etc " << endl;
   cerr << "[--reference|-r] comma separated list of reference files" << endl;
   cerr << "[--binary|-b] use binary output format (default to text )" << endl;
+  cerr << "[--columnar|-C] use the mmappable columnar output format, read by mert, pro and kbmira" << endl;
+  cerr << "[--append|-a] add the data to existing columnar output files instead of overwriting them" << endl;
   cerr << "[--nbest|-n] the nbest file" << endl;
   cerr << "[--scfile|-S] the scorer data output file" << endl;
   cerr << "[--ffile|-F] the feature data output file" << endl;
@@ -51,6 +53,8 @@ static struct option long_options[] = {
   {"filter", required_argument,0, 'l'},
   {"reference", required_argument, 0, 'r'},
   {"binary", no_argument, 0, 'b'},
+  {"columnar", no_argument, 0, 'C'},
+  {"append", no_argument, 0, 'a'},
   {"nbest", required_argument, 0, 'n'},
   {"scfile", required_argument, 0, 'S'},
   {"ffile", required_argument, 0, 'F'},
@@ -75,6 +79,8 @@ struct ProgramOption {
   string prevScoreDataFile;
   string prevFeatureDataFile;
   bool binmode;
+  bool columnar;
+  bool append;
   bool allowDuplicates;
   int verbosity;
 
@@ -90,6 +96,8 @@ struct ProgramOption {
       prevScoreDataFile(""),
       prevFeatureDataFile(""),
       binmode(false),
+      columnar(false),
+      append(false),
       allowDuplicates(false),
       verbosity(0) { }
 };
@@ -99,7 +107,7 @@ void ParseCommandOptions(int argc, char** argv, ProgramOption* opt)
   int c;
   int option_index;
 
-  while ((c = getopt_long(argc, argv, "s:r:f:l:n:S:F:R:E:v:hbd", long_options, &option_index)) != -1) {
+  while ((c = getopt_long(argc, argv, "s:r:f:l:n:S:F:R:E:v:hbCad", long_options, &option_index)) != -1) {
     switch (c) {
     case 's':
       opt->scorerType = string(optarg);
@@ -119,6 +127,12 @@ void ParseCommandOptions(int argc, char** argv, ProgramOption* opt)
     case 'b':
       opt->binmode = true;
       break;
+    case 'C':
+      opt->columnar = true;
+      break;
+    case 'a':
+      opt->append = true;
+      break;
     case 'n':
       opt->nbestFile = string(optarg);
       break;
@@ -195,6 +209,10 @@ int main(int argc, char** argv)
       throw runtime_error("Error: there is a different number of previous score and feature files");
     }
 
+    if (option.append && !option.columnar) {
+      throw runtime_error("Error: --append requires the columnar format");
+    }
+
     if (option.binmode) {
       cerr << "Binary write mode is selected" << endl;
     } else {
@@ -238,7 +256,11 @@ int main(int argc, char** argv)
     }
     //END_ADDED
 
-    data.save(option.featureDataFile, option.scoreDataFile, option.binmode);
+    if (option.columnar) {
+      data.saveColumnar(option.featureDataFile, option.scoreDataFile, option.append);
+    } else {
+      data.save(option.featureDataFile, option.scoreDataFile, option.binmode);
+    }
     PrintUserTime("Stopping...");
 
     return EXIT_SUCCESS;
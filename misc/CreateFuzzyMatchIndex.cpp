@@ -0,0 +1,23 @@
+// Builds the index of a translation memory for PhraseDictionaryFuzzyMatch,
+// which then opens it with index=<file> instead of reading and sorting the
+// source, target and alignment files in every decoder process.
+
+#include <iostream>
+
+#include "moses/TranslationModel/fuzzy-match/FuzzyMatchWrapper.h"
+#include "util/usage.hh"
+
+int main(int argc, char* argv[])
+{
+  if (argc != 5) {
+    std::cerr << "Usage: " << argv[0] << " source target alignment output_index" << std::endl;
+    std::cerr << "The files are those given to PhraseDictionaryFuzzyMatch as source=, target= and alignment=." << std::endl;
+    return 1;
+  }
+
+  tmmt::FuzzyMatchWrapper wrapper(argv[1], argv[2], argv[3]);
+  wrapper.SaveIndex(argv[4]);
+
+  util::PrintUsage(std::cerr);
+  return 0;
+}
@@ -0,0 +1,102 @@
+/***********************************************************************
+Moses - factored phrase-based language decoder
+Copyright (C) 2006 University of Edinburgh
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+
+/* Measures how fast target phrase alignments are interned, as done by
+ * TargetPhrase::SetAlignTerm for every phrase decoded from a phrase table
+ * with alignment information:
+ *
+ *   alignment_benchmark [phrases] [threads] [distinct alignments]
+ */
+
+#include <iostream>
+#include <set>
+#include <vector>
+
+#include <boost/bind.hpp>
+#include <boost/lexical_cast.hpp>
+#ifdef WITH_THREADS
+#include <boost/thread.hpp>
+#endif
+
+#include "AlignmentInfoCollection.h"
+#include "util/random.hh"
+#include "util/usage.hh"
+
+using namespace std;
+using namespace Moses;
+
+namespace
+{
+
+typedef set<pair<size_t, size_t> > Alignment;
+
+void Decode(const vector<Alignment> &alignments, size_t begin, size_t end, size_t numPhrases)
+{
+  for (size_t i = 0; i < numPhrases; ++i) {
+    AlignmentInfoCollection::Instance().Add(alignments[begin + i % (end - begin)]);
+  }
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+  const size_t numPhrases = argc > 1 ? boost::lexical_cast<size_t>(argv[1]) : 10000000;
+  const size_t numThreads = argc > 2 ? boost::lexical_cast<size_t>(argv[2]) : 1;
+  const size_t numAlignments = argc > 3 ? boost::lexical_cast<size_t>(argv[3]) : 100000;
+
+  // alignments of phrases of up to 7 words, with one or two links per word
+  util::rand_init(1);
+  vector<Alignment> alignments(numAlignments);
+  for (size_t i = 0; i < numAlignments; ++i) {
+    const size_t sourceSize = 1 + util::rand_excl(7);
+    const size_t targetSize = 1 + util::rand_excl(7);
+    for (size_t s = 0; s < sourceSize; ++s) {
+      alignments[i].insert(make_pair(s, util::rand_excl(targetSize)));
+      if (util::rand_excl(4) == 0) {
+        alignments[i].insert(make_pair(s, util::rand_excl(targetSize)));
+      }
+    }
+  }
+
+  // the phrases of a thread come from an overlapping window of the
+  // alignments, as sentences share most of their phrase pairs
+  const size_t window = numAlignments / 2 + 1;
+  const double start = util::WallTime();
+#ifdef WITH_THREADS
+  boost::thread_group threads;
+  for (size_t t = 0; t < numThreads; ++t) {
+    const size_t begin = (numAlignments - window) * t / numThreads;
+    threads.create_thread(boost::bind(&Decode, boost::cref(alignments),
+                                      begin, begin + window, numPhrases / numThreads));
+  }
+  threads.join_all();
+#else
+  Decode(alignments, 0, window, numPhrases);
+#endif
+  const double elapsed = util::WallTime() - start;
+
+  cerr << "Threads: " << numThreads
+       << " distinct alignments: " << AlignmentInfoCollection::Instance().GetSize() << endl;
+  cerr << "Phrases per second: " << numPhrases / elapsed
+       << " (" << elapsed << " s)" << endl;
+
+  util::PrintUsage(cerr);
+  return 0;
+}
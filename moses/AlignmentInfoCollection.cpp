@@ -19,11 +19,48 @@
 
 #include "AlignmentInfoCollection.h"
 
+#include <algorithm>
+#include <cassert>
+
+#include <boost/functional/hash.hpp>
+
 namespace Moses
 {
 
+namespace
+{
+
+void EncodePosition(size_t pos, std::string &key)
+{
+  // 7 bits per byte, the high bit marks continuation
+  while (pos >= 0x80) {
+    key += char((pos & 0x7f) | 0x80);
+    pos >>= 7;
+  }
+  key += char(pos);
+}
+
+size_t DecodePosition(const std::string &key, size_t &i)
+{
+  size_t pos = 0;
+  for (size_t shift = 0; ; shift += 7) {
+    const unsigned char c = key[i++];
+    pos |= size_t(c & 0x7f) << shift;
+    if (!(c & 0x80)) {
+      return pos;
+    }
+  }
+}
+
+}
+
 AlignmentInfoCollection AlignmentInfoCollection::s_instance;
 
+AlignmentInfoCollection::Cache::Cache()
+{
+  std::fill(values, values + SIZE, static_cast<const AlignmentInfo*>(NULL));
+}
+
 AlignmentInfoCollection::AlignmentInfoCollection()
 {
   std::set<std::pair<size_t,size_t> > pairs;
@@ -38,23 +75,110 @@ const AlignmentInfo &AlignmentInfoCollection::GetEmptyAlignmentInfo() const
   return *m_emptyAlignmentInfo;
 }
 
+size_t AlignmentInfoCollection::GetSize() const
+{
+  size_t size = 0;
+  for (size_t i = 0; i < NUM_SHARDS; ++i) {
+#ifdef WITH_THREADS
+    boost::shared_lock<boost::shared_mutex> read_lock(m_shards[i].accessLock);
+#endif
+    size += m_shards[i].collection.size();
+  }
+  return size;
+}
+
+void
+AlignmentInfoCollection::
+Encode(const std::set<std::pair<size_t,size_t> > &pairs, std::string &key)
+{
+  key.clear();
+  std::set<std::pair<size_t,size_t> >::const_iterator p;
+  for (p = pairs.begin(); p != pairs.end(); ++p) {
+    EncodePosition(p->first, key);
+    EncodePosition(p->second, key);
+  }
+}
+
+void
+AlignmentInfoCollection::
+Encode(const std::vector<unsigned char> &aln, std::string &key)
+{
+  assert(aln.size()%2==0);
+  std::vector<std::pair<size_t,size_t> > pairs;
+  pairs.reserve(aln.size() / 2);
+  for (size_t i = 0; i < aln.size(); i += 2) {
+    pairs.push_back(std::make_pair(size_t(aln[i]), size_t(aln[i+1])));
+  }
+  std::sort(pairs.begin(), pairs.end());
+  pairs.erase(std::unique(pairs.begin(), pairs.end()), pairs.end());
+
+  key.clear();
+  for (size_t i = 0; i < pairs.size(); ++i) {
+    EncodePosition(pairs[i].first, key);
+    EncodePosition(pairs[i].second, key);
+  }
+}
+
+AlignmentInfoCollection::Cache &AlignmentInfoCollection::GetCache()
+{
+#ifdef WITH_THREADS
+  Cache *cache = m_cache.get();
+  if (cache == NULL) {
+    cache = new Cache;
+    m_cache.reset(cache);
+  }
+  return *cache;
+#else
+  return m_cache;
+#endif
+}
+
 AlignmentInfo const *
 AlignmentInfoCollection::
-Add(AlignmentInfo const& ainfo)
+Add(const std::string &key)
 {
+  const size_t hash = boost::hash_value(key);
+
+  // lock free if this thread saw the alignment recently
+  Cache &cache = GetCache();
+  const size_t slot = hash % Cache::SIZE;
+  if (cache.values[slot] && cache.keys[slot] == key) {
+    return cache.values[slot];
+  }
+
+  Shard &shard = m_shards[(hash / Cache::SIZE) % NUM_SHARDS];
+  const AlignmentInfo *ret = NULL;
 #ifdef WITH_THREADS
   {
-    boost::shared_lock<boost::shared_mutex> read_lock(m_accessLock);
-    AlignmentInfoSet::const_iterator i = m_collection.find(ainfo);
-    if (i != m_collection.end())
-      return &*i;
+    boost::shared_lock<boost::shared_mutex> read_lock(shard.accessLock);
+    AlignmentInfoMap::const_iterator i = shard.collection.find(key);
+    if (i != shard.collection.end())
+      ret = &i->second;
   }
-  boost::unique_lock<boost::shared_mutex> lock(m_accessLock);
+#else
+  AlignmentInfoMap::const_iterator found = shard.collection.find(key);
+  if (found != shard.collection.end())
+    ret = &found->second;
 #endif
-  std::pair<AlignmentInfoSet::iterator, bool> ret = m_collection.insert(ainfo);
-  return &(*ret.first);
-}
 
+  if (ret == NULL) {
+    std::set<std::pair<size_t,size_t> > pairs;
+    for (size_t i = 0; i < key.size(); ) {
+      const size_t sourcePos = DecodePosition(key, i);
+      pairs.insert(std::make_pair(sourcePos, DecodePosition(key, i)));
+    }
+    AlignmentInfo ainfo(pairs);
+
+#ifdef WITH_THREADS
+    boost::unique_lock<boost::shared_mutex> lock(shard.accessLock);
+#endif
+    // elements of an unordered_map are not moved by rehashing
+    ret = &shard.collection.insert(std::make_pair(key, ainfo)).first->second;
+  }
 
+  cache.keys[slot] = key;
+  cache.values[slot] = ret;
+  return ret;
+}
 
 }
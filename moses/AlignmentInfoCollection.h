@@ -22,10 +22,15 @@
 #include "AlignmentInfo.h"
 
 #include <set>
+#include <string>
+#include <vector>
+
+#include <boost/unordered_map.hpp>
 
 #ifdef WITH_THREADS
 #include <boost/thread/shared_mutex.hpp>
 #include <boost/thread/locks.hpp>
+#include <boost/thread/tss.hpp>
 #endif
 
 namespace Moses
@@ -33,6 +38,11 @@ namespace Moses
 
 /** Singleton collection of all AlignmentInfo objects.
  *  Used as a cache of all alignment info to save space.
+ *
+ *  Alignments are looked up by a compact key, the sorted alignment points
+ *  as variable length byte pairs. The collection is split into shards with
+ *  their own lock, and each thread keeps a small cache of the alignments
+ *  it interned recently, so the common case takes no lock at all.
  */
 class AlignmentInfoCollection
 {
@@ -45,23 +55,49 @@ public:
     * alignment pairs as given in the argument.  If the collection already
     * contains such an object then returns a pointer to it; otherwise a new
     * one is inserted.
+    * ALNREP is a std::set<std::pair<size_t,size_t> > or a
+    * std::vector<unsigned char> of source/target positions.
    */
-private:
-  const AlignmentInfo* Add(AlignmentInfo const& ainfo);
-
-public:
   template<typename ALNREP>
   AlignmentInfo const *
   Add(ALNREP const & aln) {
-    return this->Add(AlignmentInfo(aln));
+    std::string key;
+    Encode(aln, key);
+    return this->Add(key);
   }
 
   //! Returns a pointer to an empty AlignmentInfo object.
   const AlignmentInfo &GetEmptyAlignmentInfo() const;
 
+  //! Number of distinct alignments.
+  size_t GetSize() const;
+
+  static void Encode(const std::set<std::pair<size_t,size_t> > &pairs, std::string &key);
+  static void Encode(const std::vector<unsigned char> &aln, std::string &key);
+
 private:
-  typedef std::set<AlignmentInfo, AlignmentInfoOrderer> AlignmentInfoSet;
+  typedef boost::unordered_map<std::string, AlignmentInfo> AlignmentInfoMap;
 
+  struct Shard {
+#ifdef WITH_THREADS
+    //reader-writer lock
+    mutable boost::shared_mutex accessLock;
+#endif
+    AlignmentInfoMap collection;
+  };
+
+  //! direct mapped cache of recently interned alignments
+  struct Cache {
+    static const size_t SIZE = 1024;
+    std::string keys[SIZE];
+    const AlignmentInfo *values[SIZE];
+    Cache();
+  };
+
+  static const size_t NUM_SHARDS = 64;
+
+  const AlignmentInfo* Add(const std::string &key);
+  Cache &GetCache();
 
   //! Only a single static variable should be created.
   AlignmentInfoCollection();
@@ -69,12 +105,12 @@ private:
 
   static AlignmentInfoCollection s_instance;
 
+  Shard m_shards[NUM_SHARDS];
 #ifdef WITH_THREADS
-  //reader-writer lock
-  mutable boost::shared_mutex m_accessLock;
+  boost::thread_specific_ptr<Cache> m_cache;
+#else
+  Cache m_cache;
 #endif
-
-  AlignmentInfoSet m_collection;
   const AlignmentInfo *m_emptyAlignmentInfo;
 };
 
@@ -68,4 +68,36 @@ BOOST_FIXTURE_TEST_CASE(hasher, AlignmentInfoFixture)
   BOOST_CHECK_EQUAL(hash(*ai1), hash(*ai2));
 }
 
+BOOST_FIXTURE_TEST_CASE(interning, AlignmentInfoFixture)
+{
+  BOOST_CHECK_EQUAL(ai1, ai2);
+  BOOST_CHECK(ai1 != ai3);
+
+  // same alignment from another representation, unsorted and duplicated
+  vector<unsigned char> aln;
+  aln.push_back(2);
+  aln.push_back(1);
+  aln.push_back(1);
+  aln.push_back(1);
+  aln.push_back(2);
+  aln.push_back(1);
+  BOOST_CHECK_EQUAL(AlignmentInfoCollection::Instance().Add(aln), ai1);
+}
+
+BOOST_AUTO_TEST_CASE(large_positions)
+{
+  AlignmentInfoCollection& collection = AlignmentInfoCollection::Instance();
+  IndexSet aligns;
+  aligns.insert(IndexPair(0,300));
+  aligns.insert(IndexPair(127,128));
+  aligns.insert(IndexPair(70000,5));
+  const AlignmentInfo *ai = collection.Add(aligns);
+  BOOST_CHECK(ai->GetAlignments() == aligns);
+  BOOST_CHECK_EQUAL(collection.Add(aligns), ai);
+
+  const AlignmentInfo *empty = collection.Add(IndexSet());
+  BOOST_CHECK_EQUAL(empty, &collection.GetEmptyAlignmentInfo());
+  BOOST_CHECK_EQUAL(empty->GetSize(), 0);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
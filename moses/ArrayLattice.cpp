@@ -0,0 +1,362 @@
+// -*- mode: c++; indent-tabs-mode: nil; tab-width: 2 -*-
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include <boost/unordered_set.hpp>
+
+#include "ArrayLattice.h"
+#include "Phrase.h"
+#include "Word.h"
+#include "util/exception.hh"
+#include "util/murmur_hash.hh"
+
+using namespace std;
+
+namespace Moses
+{
+
+namespace
+{
+
+const float LOG_ZERO = -numeric_limits<float>::infinity();
+
+inline float LogAdd(float a, float b)
+{
+  if (a == LOG_ZERO) return b;
+  if (b == LOG_ZERO) return a;
+  return a < b ? b + log1p(exp(a - b)) : a + log1p(exp(b - a));
+}
+
+inline void LogAddTo(NgramLogScores &scores, uint64_t ngram, float score)
+{
+  pair<NgramLogScores::iterator, bool> ins = scores.insert(make_pair(ngram, score));
+  if (!ins.second) {
+    ins.first->second = LogAdd(ins.first->second, score);
+  }
+}
+
+// the n-gram order is kept in the top bits of the id
+const int ORDER_SHIFT = 60;
+
+}
+
+//! a suffix of the paths into a node, and the log score of those paths
+struct ArrayLattice::Context {
+  uint64_t ngram;
+  size_t length;
+  float score;
+};
+
+/** Receives the n-gram occurrences of the edges into each node during
+ *  Traverse(), in topological order of the nodes */
+class ArrayLattice::Visitor
+{
+public:
+  virtual ~Visitor() {}
+  //! occurrence within the edge, on all paths through the edge
+  virtual void Inside(size_t edge, size_t head, uint64_t ngram, float score) = 0;
+  //! occurrence starting on a previous edge, on the paths with that context
+  virtual void Straddling(size_t edge, size_t head, uint64_t ngram, float score) = 0;
+  virtual void EndEdge(size_t edge, size_t tail, size_t head, float score) {}
+  //! all outgoing edges of the node have been visited
+  virtual void Release(size_t node) {}
+};
+
+size_t ArrayLattice::AddNode(bool isFinal)
+{
+  m_isFinal.push_back(isFinal);
+  return m_isFinal.size() - 1;
+}
+
+void ArrayLattice::AddEdge(size_t tail, size_t head, float score, const Phrase &words)
+{
+  UTIL_THROW_IF2(tail >= head || head >= m_isFinal.size(),
+                 "Lattice edge " << tail << "->" << head << " is not in topological order");
+  UTIL_THROW_IF2(!m_head.empty() && head < m_head.back(),
+                 "Lattice edges must be added in order of head node");
+  if (m_wordBegin.empty()) m_wordBegin.push_back(0);
+  m_tail.push_back(tail);
+  m_head.push_back(head);
+  m_score.push_back(score);
+  for (size_t i = 0; i < words.GetSize(); ++i) {
+    m_words.push_back(words.GetWord(i).hash());
+  }
+  m_wordBegin.push_back(m_words.size());
+}
+
+void ArrayLattice::GetInEdges(vector<size_t> &inBegin) const
+{
+  inBegin.assign(GetNumNodes() + 1, 0);
+  size_t e = 0;
+  for (size_t node = 0; node < GetNumNodes(); ++node) {
+    inBegin[node] = e;
+    while (e < m_head.size() && m_head[e] == node) ++e;
+  }
+  inBegin[GetNumNodes()] = e;
+}
+
+uint64_t ArrayLattice::ExtendNgram(uint64_t prefix, uint64_t word)
+{
+  const uint64_t key[2] = { prefix, word };
+  const uint64_t order = GetNgramOrder(prefix) + 1;
+  return (util::MurmurHashNative(key, sizeof(key)) >> 4) | (order << ORDER_SHIFT);
+}
+
+uint64_t ArrayLattice::ExtendNgram(uint64_t prefix, const Word &word)
+{
+  return ExtendNgram(prefix, (uint64_t) word.hash());
+}
+
+size_t ArrayLattice::GetNgramOrder(uint64_t ngram)
+{
+  return ngram >> ORDER_SHIFT;
+}
+
+void ArrayLattice::CalcForward(const vector<size_t> &inBegin, vector<float> &alpha) const
+{
+  alpha.assign(GetNumNodes(), LOG_ZERO);
+  if (alpha.empty()) return;
+  alpha[0] = 0;
+  for (size_t head = 1; head < GetNumNodes(); ++head) {
+    for (size_t e = inBegin[head]; e < inBegin[head + 1]; ++e) {
+      alpha[head] = LogAdd(alpha[head], alpha[m_tail[e]] + m_score[e]);
+    }
+  }
+}
+
+void ArrayLattice::CalcBackward(const vector<size_t> &inBegin, vector<float> &beta) const
+{
+  beta.assign(GetNumNodes(), LOG_ZERO);
+  for (size_t node = 0; node < GetNumNodes(); ++node) {
+    if (m_isFinal[node]) beta[node] = 0;
+  }
+  // heads follow their tails, so going backwards over the heads
+  // completes beta of a node before it is used
+  for (size_t head = GetNumNodes(); head-- > 1;) {
+    for (size_t e = inBegin[head]; e < inBegin[head + 1]; ++e) {
+      beta[m_tail[e]] = LogAdd(beta[m_tail[e]], m_score[e] + beta[head]);
+    }
+  }
+}
+
+float ArrayLattice::GetTotalScore() const
+{
+  vector<size_t> inBegin;
+  GetInEdges(inBegin);
+  vector<float> alpha;
+  CalcForward(inBegin, alpha);
+  return GetTotalScore(alpha);
+}
+
+float ArrayLattice::GetTotalScore(const vector<float> &alpha) const
+{
+  float total = LOG_ZERO;
+  for (size_t node = 0; node < GetNumNodes(); ++node) {
+    if (m_isFinal[node]) total = LogAdd(total, alpha[node]);
+  }
+  return total;
+}
+
+void ArrayLattice::Traverse(size_t order, const vector<size_t> &inBegin,
+                            const vector<float> &alpha, Visitor &visitor) const
+{
+  const size_t numNodes = GetNumNodes();
+  vector<size_t> outDegree(numNodes, 0);
+  for (size_t e = 0; e < GetNumEdges(); ++e) {
+    ++outDegree[m_tail[e]];
+  }
+
+  vector<Contexts> contexts(numNodes);
+  boost::unordered_map<uint64_t, size_t> suffixes;
+  for (size_t head = 1; head < numNodes; ++head) {
+    Contexts &headContexts = contexts[head];
+    suffixes.clear();
+
+    for (size_t e = inBegin[head]; e < inBegin[head + 1]; ++e) {
+      const size_t tail = m_tail[e];
+      const uint64_t *words = &m_words[0] + m_wordBegin[e];
+      const size_t size = m_wordBegin[e + 1] - m_wordBegin[e];
+      const float score = alpha[tail] + m_score[e];
+
+      // n-grams within the edge
+      for (size_t start = 0; start < size; ++start) {
+        uint64_t ngram = 0;
+        for (size_t end = start; end < size && end < start + order; ++end) {
+          ngram = ExtendNgram(ngram, words[end]);
+          visitor.Inside(e, head, ngram, score);
+        }
+      }
+
+      // n-grams starting on previous edges
+      const Contexts &tailContexts = contexts[tail];
+      for (size_t c = 0; c < tailContexts.size(); ++c) {
+        const Context &context = tailContexts[c];
+        uint64_t ngram = context.ngram;
+        for (size_t end = 0; end < size && context.length + end < order; ++end) {
+          ngram = ExtendNgram(ngram, words[end]);
+          visitor.Straddling(e, head, ngram, context.score + m_score[e]);
+        }
+      }
+
+      // the suffixes of the paths through the edge, for the next edges
+      vector<pair<uint64_t, pair<size_t, float> > > newContexts;
+      for (size_t length = 1; length < order && length <= size; ++length) {
+        uint64_t ngram = 0;
+        for (size_t i = size - length; i < size; ++i) {
+          ngram = ExtendNgram(ngram, words[i]);
+        }
+        newContexts.push_back(make_pair(ngram, make_pair(length, score)));
+      }
+      for (size_t c = 0; c < tailContexts.size(); ++c) {
+        const Context &context = tailContexts[c];
+        if (context.length + size >= order) continue;
+        uint64_t ngram = context.ngram;
+        for (size_t i = 0; i < size; ++i) {
+          ngram = ExtendNgram(ngram, words[i]);
+        }
+        newContexts.push_back(make_pair(ngram, make_pair(context.length + size,
+                                        context.score + m_score[e])));
+      }
+      for (size_t c = 0; c < newContexts.size(); ++c) {
+        pair<boost::unordered_map<uint64_t, size_t>::iterator, bool> ins
+        = suffixes.insert(make_pair(newContexts[c].first, headContexts.size()));
+        if (ins.second) {
+          Context context;
+          context.ngram = newContexts[c].first;
+          context.length = newContexts[c].second.first;
+          context.score = newContexts[c].second.second;
+          headContexts.push_back(context);
+        } else {
+          Context &context = headContexts[ins.first->second];
+          context.score = LogAdd(context.score, newContexts[c].second.second);
+        }
+      }
+
+      visitor.EndEdge(e, tail, head, m_score[e]);
+
+      if (--outDegree[tail] == 0) {
+        Contexts().swap(contexts[tail]);
+        visitor.Release(tail);
+      }
+    }
+  }
+}
+
+/** Expected counts: each occurrence contributes the score of the paths
+ *  through it, forward score to its start times backward score from its
+ *  end */
+class ArrayLattice::ExpectationVisitor : public ArrayLattice::Visitor
+{
+public:
+  ExpectationVisitor(const vector<float> &beta, NgramLogScores &expectations)
+    : m_beta(beta), m_expectations(expectations) {
+  }
+
+  void Inside(size_t edge, size_t head, uint64_t ngram, float score) {
+    LogAddTo(m_expectations, ngram, score + m_beta[head]);
+  }
+
+  void Straddling(size_t edge, size_t head, uint64_t ngram, float score) {
+    LogAddTo(m_expectations, ngram, score + m_beta[head]);
+  }
+
+private:
+  const vector<float> &m_beta;
+  NgramLogScores &m_expectations;
+};
+
+/** Posteriors: for each node, the score of the paths into the node that
+ *  contain each n-gram. An edge adds the paths on which the n-gram occurs
+ *  on the edge to the paths on which it occurred before; the two sets may
+ *  overlap, so their sum is capped by the score of all paths through the
+ *  edge. */
+class ArrayLattice::PosteriorVisitor : public ArrayLattice::Visitor
+{
+public:
+  PosteriorVisitor(size_t numNodes, const vector<float> &alpha)
+    : m_alpha(alpha), m_scores(numNodes) {
+  }
+
+  void Inside(size_t edge, size_t head, uint64_t ngram, float score) {
+    // on all paths through the edge
+    m_inside.insert(ngram);
+    m_edgeScores[ngram] = score;
+  }
+
+  void Straddling(size_t edge, size_t head, uint64_t ngram, float score) {
+    if (m_inside.find(ngram) == m_inside.end()) {
+      LogAddTo(m_edgeScores, ngram, score);
+    }
+  }
+
+  void EndEdge(size_t edge, size_t tail, size_t head, float score) {
+    const float total = m_alpha[tail] + score;
+    NgramLogScores &headScores = m_scores[head];
+    const NgramLogScores &tailScores = m_scores[tail];
+    for (NgramLogScores::const_iterator it = tailScores.begin(); it != tailScores.end(); ++it) {
+      LogAddTo(m_edgeScores, it->first, it->second + score);
+    }
+    for (NgramLogScores::const_iterator it = m_edgeScores.begin(); it != m_edgeScores.end(); ++it) {
+      LogAddTo(headScores, it->first, min(it->second, total));
+    }
+    m_edgeScores.clear();
+    m_inside.clear();
+  }
+
+  void Release(size_t node) {
+    NgramLogScores().swap(m_scores[node]);
+  }
+
+  const NgramLogScores &GetScores(size_t node) const {
+    return m_scores[node];
+  }
+
+private:
+  const vector<float> &m_alpha;
+  vector<NgramLogScores> m_scores;
+  NgramLogScores m_edgeScores;
+  boost::unordered_set<uint64_t> m_inside;
+};
+
+void ArrayLattice::CalcNgramExpectations(size_t order, NgramLogScores &expectations) const
+{
+  vector<size_t> inBegin;
+  GetInEdges(inBegin);
+  vector<float> alpha, beta;
+  CalcForward(inBegin, alpha);
+  CalcBackward(inBegin, beta);
+  ExpectationVisitor visitor(beta, expectations);
+  Traverse(order, inBegin, alpha, visitor);
+
+  const float total = GetTotalScore(alpha);
+  for (NgramLogScores::iterator it = expectations.begin(); it != expectations.end(); ++it) {
+    it->second -= total;
+  }
+}
+
+void ArrayLattice::CalcNgramPosteriors(size_t order, NgramLogScores &posteriors) const
+{
+  vector<size_t> inBegin;
+  GetInEdges(inBegin);
+  vector<float> alpha;
+  CalcForward(inBegin, alpha);
+  PosteriorVisitor visitor(GetNumNodes(), alpha);
+  Traverse(order, inBegin, alpha, visitor);
+
+  float total = LOG_ZERO;
+  for (size_t node = 0; node < GetNumNodes(); ++node) {
+    if (!m_isFinal[node]) continue;
+    total = LogAdd(total, alpha[node]);
+    const NgramLogScores &scores = visitor.GetScores(node);
+    for (NgramLogScores::const_iterator it = scores.begin(); it != scores.end(); ++it) {
+      LogAddTo(posteriors, it->first, it->second);
+    }
+  }
+  for (NgramLogScores::iterator it = posteriors.begin(); it != posteriors.end(); ++it) {
+    it->second -= total;
+  }
+}
+
+}
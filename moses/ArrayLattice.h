@@ -0,0 +1,83 @@
+// -*- mode: c++; indent-tabs-mode: nil; tab-width: 2 -*-
+#pragma once
+
+#include <vector>
+#include <stdint.h>
+
+#include <boost/unordered_map.hpp>
+
+namespace Moses
+{
+
+class Phrase;
+class Word;
+
+/** Log scores of n-grams, keyed by n-gram id (see ArrayLattice::ExtendNgram) */
+typedef boost::unordered_map<uint64_t, float> NgramLogScores;
+
+/** Word lattice for lattice MBR and consensus decoding, stored in flat
+ *  arrays. Nodes have dense ids in topological order, node 0 being the
+ *  start node; the edges are stored by head node. N-grams are identified
+ *  by a rolling hash of their words, so that extending an n-gram by one
+ *  word costs one hash computation.
+ */
+class ArrayLattice
+{
+public:
+  //! add a node, after all nodes that precede it; returns its id
+  size_t AddNode(bool isFinal);
+
+  //! add an edge, in order of head node; the tail precedes the head
+  void AddEdge(size_t tail, size_t head, float score, const Phrase &words);
+
+  size_t GetNumNodes() const {
+    return m_isFinal.size();
+  }
+
+  size_t GetNumEdges() const {
+    return m_tail.size();
+  }
+
+  //! log of the total score of the paths from the start to a final node
+  float GetTotalScore() const;
+
+  /** Expected counts (as log scores) of all n-grams up to the given order,
+   *  computed exactly with forward-backward over the edges. */
+  void CalcNgramExpectations(size_t order, NgramLogScores &expectations) const;
+
+  /** Posteriors (as log scores) of all n-grams up to the given order, the
+   *  probability of the paths containing the n-gram at least once. The mass
+   *  of the paths into a node that contain an n-gram is propagated along
+   *  the edges, so this is an approximation when an n-gram occurs more than
+   *  once on a path (Tromble et al, 2008). */
+  void CalcNgramPosteriors(size_t order, NgramLogScores &posteriors) const;
+
+  //! id of the n-gram made of the n-gram prefix (0 for none) and word
+  static uint64_t ExtendNgram(uint64_t prefix, uint64_t word);
+  static uint64_t ExtendNgram(uint64_t prefix, const Word &word);
+  static size_t GetNgramOrder(uint64_t ngram);
+
+private:
+  struct Context;
+  typedef std::vector<Context> Contexts;
+  class Visitor;
+  class ExpectationVisitor;
+  class PosteriorVisitor;
+
+  std::vector<bool> m_isFinal;
+  std::vector<size_t> m_tail;
+  std::vector<size_t> m_head;
+  std::vector<float> m_score;
+  std::vector<size_t> m_wordBegin; //! words of each edge in m_words, and end
+  std::vector<uint64_t> m_words; //! word hashes
+
+  //! first incoming edge of each node, and the end of the edges
+  void GetInEdges(std::vector<size_t> &inBegin) const;
+  void CalcForward(const std::vector<size_t> &inBegin, std::vector<float> &alpha) const;
+  void CalcBackward(const std::vector<size_t> &inBegin, std::vector<float> &beta) const;
+  float GetTotalScore(const std::vector<float> &alpha) const;
+  void Traverse(size_t order, const std::vector<size_t> &inBegin,
+                const std::vector<float> &alpha, Visitor &visitor) const;
+};
+
+}
@@ -0,0 +1,121 @@
+/***********************************************************************
+Moses - factored phrase-based language decoder
+Copyright (C) 2006 University of Edinburgh
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+#include <cmath>
+#include <string>
+
+#include <boost/test/unit_test.hpp>
+
+#include "ArrayLattice.h"
+#include "FactorCollection.h"
+#include "Phrase.h"
+#include "util/exception.hh"
+
+using namespace Moses;
+using namespace std;
+
+namespace
+{
+
+Phrase MakePhrase(const string &a, const string &b = "")
+{
+  Phrase phrase;
+  phrase.AddWord().SetFactor(0, FactorCollection::Instance().AddFactor(a));
+  if (!b.empty()) {
+    phrase.AddWord().SetFactor(0, FactorCollection::Instance().AddFactor(b));
+  }
+  return phrase;
+}
+
+uint64_t Ngram(const Phrase &phrase)
+{
+  uint64_t ngram = 0;
+  for (size_t i = 0; i < phrase.GetSize(); ++i) {
+    ngram = ArrayLattice::ExtendNgram(ngram, phrase.GetWord(i));
+  }
+  return ngram;
+}
+
+float Prob(const NgramLogScores &scores, uint64_t ngram)
+{
+  NgramLogScores::const_iterator it = scores.find(ngram);
+  return it == scores.end() ? 0 : exp(it->second);
+}
+
+// two paths: "a b b" with probability .6 and "a b" with probability .4
+struct TwoPaths {
+  TwoPaths() {
+    for (size_t i = 0; i < 3; ++i) lattice.AddNode(i == 2);
+    lattice.AddEdge(0, 1, log(.6), MakePhrase("a", "b"));
+    lattice.AddEdge(0, 1, log(.4), MakePhrase("a"));
+    lattice.AddEdge(1, 2, 0, MakePhrase("b"));
+  }
+  ArrayLattice lattice;
+};
+
+}
+
+BOOST_AUTO_TEST_SUITE(array_lattice)
+
+BOOST_AUTO_TEST_CASE(ngram_ids)
+{
+  const uint64_t ab = Ngram(MakePhrase("a", "b"));
+  BOOST_CHECK_EQUAL(ArrayLattice::GetNgramOrder(ab), 2);
+  BOOST_CHECK(ab != Ngram(MakePhrase("b", "a")));
+  BOOST_CHECK(Ngram(MakePhrase("a")) != Ngram(MakePhrase("b")));
+}
+
+BOOST_AUTO_TEST_CASE(expectations)
+{
+  TwoPaths paths;
+  BOOST_CHECK_CLOSE(exp(paths.lattice.GetTotalScore()), 1.0, 1e-3);
+
+  NgramLogScores expectations;
+  paths.lattice.CalcNgramExpectations(3, expectations);
+  BOOST_CHECK_EQUAL(expectations.size(), 5);
+  BOOST_CHECK_CLOSE(Prob(expectations, Ngram(MakePhrase("a"))), 1.0, 1e-3);
+  BOOST_CHECK_CLOSE(Prob(expectations, Ngram(MakePhrase("b"))), 1.6, 1e-3);
+  BOOST_CHECK_CLOSE(Prob(expectations, Ngram(MakePhrase("a", "b"))), 1.0, 1e-3);
+  BOOST_CHECK_CLOSE(Prob(expectations, Ngram(MakePhrase("b", "b"))), 0.6, 1e-3);
+  Phrase abb = MakePhrase("a", "b");
+  abb.Append(MakePhrase("b"));
+  BOOST_CHECK_CLOSE(Prob(expectations, Ngram(abb)), 0.6, 1e-3);
+}
+
+BOOST_AUTO_TEST_CASE(posteriors)
+{
+  TwoPaths paths;
+  NgramLogScores posteriors;
+  paths.lattice.CalcNgramPosteriors(2, posteriors);
+  BOOST_CHECK_EQUAL(posteriors.size(), 4);
+  BOOST_CHECK_CLOSE(Prob(posteriors, Ngram(MakePhrase("a"))), 1.0, 1e-3);
+  BOOST_CHECK_CLOSE(Prob(posteriors, Ngram(MakePhrase("b"))), 1.0, 1e-3);
+  BOOST_CHECK_CLOSE(Prob(posteriors, Ngram(MakePhrase("a", "b"))), 1.0, 1e-3);
+  BOOST_CHECK_CLOSE(Prob(posteriors, Ngram(MakePhrase("b", "b"))), 0.6, 1e-3);
+}
+
+BOOST_AUTO_TEST_CASE(edge_order)
+{
+  ArrayLattice lattice;
+  for (size_t i = 0; i < 3; ++i) lattice.AddNode(i == 2);
+  lattice.AddEdge(0, 2, 0, MakePhrase("a"));
+  BOOST_CHECK_THROW(lattice.AddEdge(0, 1, 0, MakePhrase("b")), util::Exception);
+  BOOST_CHECK_THROW(lattice.AddEdge(2, 1, 0, MakePhrase("b")), util::Exception);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -19,6 +19,7 @@ namespace Moses
 
 BaseManager::BaseManager(ttasksptr const& ttask)
   : m_ttask(ttask), m_source(*(ttask->GetSource().get()))
+  , m_deadline(ttask->options()->search.deadline)
 { }
 
 const InputType&
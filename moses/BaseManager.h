@@ -5,6 +5,7 @@
 #include <string>
 #include "ScoreComponentCollection.h"
 #include "InputType.h"
+#include "Deadline.h"
 #include "moses/parameters/AllOptions.h"
 namespace Moses
 {
@@ -18,6 +19,7 @@ protected:
   // const InputType &m_source; /**< source sentence to be translated */
   ttaskwptr m_ttask;
   InputType const& m_source;
+  Deadline m_deadline; /**< latency budget of this sentence */
 
   BaseManager(ttasksptr const& ttask);
 
@@ -51,6 +53,11 @@ public:
   const ttasksptr  GetTtask() const;
   AllOptions::ptr const& options() const;
 
+  //! the latency budget, consulted by the search for its beam limits
+  Deadline &GetDeadline() {
+    return m_deadline;
+  }
+
   virtual void Decode() = 0;
   // outputs
   virtual void OutputBest(OutputCollector *collector) const = 0;
@@ -102,10 +102,13 @@ void ChartCell::Decode(const ChartTranslationOptionList &transOptList
   }
 
   // pluck things out of queue and add to hypo collection
+  // (the pop limit shrinks when the deadline gets close)
   const size_t popLimit = m_manager.options()->cube.pop_limit;
-  for (size_t numPops = 0; numPops < popLimit && !queue.IsEmpty(); ++numPops) {
+  Deadline &deadline = m_manager.GetDeadline();
+  for (size_t numPops = 0; numPops < deadline.Limit(popLimit) && !queue.IsEmpty(); ++numPops) {
     ChartHypothesis *hypo = queue.Pop();
     AddHypothesis(hypo);
+    deadline.Update();
   }
 }
 
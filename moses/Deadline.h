@@ -0,0 +1,85 @@
+// -*- mode: c++; indent-tabs-mode: nil; tab-width: 2 -*-
+#pragma once
+
+#include <cstddef>
+
+#include "util/usage.hh"
+
+namespace Moses
+{
+
+/** Wall-clock budget for decoding one sentence. Instead of aborting the
+ *  search, the decoder asks for its beam limits through Limit(), which
+ *  steps down through cheaper settings as the budget is used up:
+ *
+ *   level 0: the configured stack size / pop limit
+ *   level 1 (half of the budget used): half of it
+ *   level 2 (three quarters used): a tenth of it
+ *   level 3 (90% used): a single hypothesis, monotone decoding
+ *
+ *  The level never goes back down within a sentence, so that the remaining
+ *  stacks are searched at least as cheaply as the current one. Search
+ *  always completes, the deadline only bounds the work done per stack.
+ */
+class Deadline
+{
+public:
+  enum Level {
+    Full = 0,
+    HalfBeam = 1,
+    NarrowBeam = 2,
+    Monotone = 3
+  };
+
+  //! seconds of wall-clock time from now, 0 for no deadline
+  explicit Deadline(float seconds = 0)
+    : m_start(util::WallTime())
+    , m_seconds(seconds)
+    , m_level(Full) {
+  }
+
+  bool IsSet() const {
+    return m_seconds > 0;
+  }
+
+  //! check the clock, raising the degradation level if needed
+  Level Update() {
+    if (!IsSet() || m_level == Monotone) return m_level;
+    const double used = (util::WallTime() - m_start) / m_seconds;
+    Level level = Full;
+    if (used >= 0.9) level = Monotone;
+    else if (used >= 0.75) level = NarrowBeam;
+    else if (used >= 0.5) level = HalfBeam;
+    if (level > m_level) m_level = level;
+    return m_level;
+  }
+
+  Level GetLevel() const {
+    return m_level;
+  }
+
+  bool IsMonotone() const {
+    return m_level == Monotone;
+  }
+
+  //! a configured stack size or pop limit at the current level (0 = no limit)
+  size_t Limit(size_t configured) const {
+    switch (m_level) {
+    case Full:
+      return configured;
+    case HalfBeam:
+      return configured ? configured / 2 + (configured == 1) : 0;
+    case NarrowBeam:
+      return configured ? (configured >= 10 ? configured / 10 : 1) : 0;
+    default:
+      return 1;
+    }
+  }
+
+private:
+  double m_start;
+  double m_seconds;
+  Level m_level;
+};
+
+}
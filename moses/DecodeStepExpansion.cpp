@@ -0,0 +1,151 @@
+// -*- mode: c++; indent-tabs-mode: nil; tab-width: 2 -*-
+
+/***********************************************************************
+Moses - factored phrase-based language decoder
+Copyright (C) 2006 University of Edinburgh
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+
+#include <algorithm>
+#include <queue>
+
+#include "DecodeStepExpansion.h"
+#include "PartialTranslOptColl.h"
+#include "TranslationOption.h"
+
+using namespace std;
+
+namespace Moses
+{
+
+TranslationOption *DecodeStepExpansion::Create(const std::vector<size_t> & /* alts */) const
+{
+  return new TranslationOption(m_input);
+}
+
+namespace
+{
+
+//! one alternative per dimension of an expansion
+struct Candidate {
+  float score;
+  size_t expansion;
+  vector<size_t> alts;
+
+  bool operator<(const Candidate &other) const {
+    return score < other.score;
+  }
+};
+
+bool CompareExpansionInput(const DecodeStepExpansion *a, const DecodeStepExpansion *b)
+{
+  return a->GetInput().GetFutureScore() > b->GetInput().GetFutureScore();
+}
+
+bool HasAlternatives(const DecodeStepExpansion &expansion)
+{
+  for (size_t dim = 0; dim < expansion.GetNumDimensions(); ++dim) {
+    if (expansion.GetNumAlternatives(dim) == 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+//! push the best candidate of the first expansion from pos on that has one
+void PushFirst(const vector<DecodeStepExpansion*> &expansions, size_t pos
+               , priority_queue<Candidate> &queue)
+{
+  for (; pos < expansions.size(); ++pos) {
+    const DecodeStepExpansion &expansion = *expansions[pos];
+    if (!HasAlternatives(expansion)) {
+      continue;
+    }
+    Candidate candidate;
+    candidate.score = expansion.GetInput().GetFutureScore();
+    candidate.expansion = pos;
+    candidate.alts.resize(expansion.GetNumDimensions(), 0);
+    for (size_t dim = 0; dim < candidate.alts.size(); ++dim) {
+      candidate.score += expansion.GetScore(dim, 0);
+    }
+    queue.push(candidate);
+    return;
+  }
+}
+
+}
+
+size_t ExpandBestFirst(std::vector<DecodeStepExpansion*> &expansions
+                       , PartialTranslOptColl &outputPartialTranslOptColl
+                       , size_t maxOptions
+                       , float threshold)
+{
+  stable_sort(expansions.begin(), expansions.end(), CompareExpansionInput);
+
+  priority_queue<Candidate> queue;
+  PushFirst(expansions, 0, queue);
+
+  size_t added = 0;
+  bool first = true;
+  float bestScore = 0;
+  while (!queue.empty() && (maxOptions == 0 || added < maxOptions)) {
+    const Candidate candidate = queue.top();
+    queue.pop();
+
+    if (first) {
+      bestScore = candidate.score;
+      first = false;
+    } else if (candidate.score < bestScore + threshold) {
+      break;
+    }
+
+    const DecodeStepExpansion &expansion = *expansions[candidate.expansion];
+    TranslationOption *newTransOpt = expansion.Create(candidate.alts);
+    if (newTransOpt) {
+      outputPartialTranslOptColl.Add(newTransOpt);
+      ++added;
+    }
+
+    // The best candidate of an expansion brings in the next expansion,
+    // the inputs being sorted. Within an expansion, each candidate is
+    // reached from exactly one neighbour, the one with its last non-zero
+    // alternative decremented, so no candidate is queued twice.
+    size_t lastDim = 0;
+    for (size_t dim = 0; dim < candidate.alts.size(); ++dim) {
+      if (candidate.alts[dim]) {
+        lastDim = dim;
+      }
+    }
+    if (candidate.alts.empty() || candidate.alts[lastDim] == 0) {
+      PushFirst(expansions, candidate.expansion + 1, queue);
+    }
+
+    for (size_t dim = lastDim; dim < candidate.alts.size(); ++dim) {
+      const size_t alt = candidate.alts[dim];
+      if (alt + 1 >= expansion.GetNumAlternatives(dim)) {
+        continue;
+      }
+      Candidate next(candidate);
+      next.alts[dim] = alt + 1;
+      next.score += expansion.GetScore(dim, alt + 1) - expansion.GetScore(dim, alt);
+      queue.push(next);
+    }
+  }
+
+  return added;
+}
+
+}
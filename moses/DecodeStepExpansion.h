@@ -0,0 +1,88 @@
+// -*- mode: c++; indent-tabs-mode: nil; tab-width: 2 -*-
+
+/***********************************************************************
+Moses - factored phrase-based language decoder
+Copyright (C) 2006 University of Edinburgh
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+
+#ifndef moses_DecodeStepExpansion_h
+#define moses_DecodeStepExpansion_h
+
+#include <vector>
+
+namespace Moses
+{
+
+class TranslationOption;
+class PartialTranslOptColl;
+
+/** The ways a decode step can extend one partial translation option,
+ *  for the lazy (cube pruning) combination of factored decode steps.
+ *  Each dimension is a list of alternatives sorted by decreasing score,
+ *  e.g. the target phrases of a translation step, or the generated factors
+ *  of one target word of a generation step. A new partial translation
+ *  option is made of one alternative per dimension.
+ *
+ *  The base class has no dimension and passes the input option through
+ *  unchanged, as required for word deletion.
+ */
+class DecodeStepExpansion
+{
+public:
+  explicit DecodeStepExpansion(const TranslationOption &input)
+    : m_input(input) {
+  }
+  virtual ~DecodeStepExpansion() {}
+
+  const TranslationOption &GetInput() const {
+    return m_input;
+  }
+
+  virtual size_t GetNumDimensions() const {
+    return 0;
+  }
+
+  virtual size_t GetNumAlternatives(size_t /* dim */) const {
+    return 0;
+  }
+
+  //! weighted score of an alternative, not increasing within a dimension
+  virtual float GetScore(size_t /* dim */, size_t /* alt */) const {
+    return 0;
+  }
+
+  //! new partial translation option, or NULL if the alternatives conflict with the input
+  virtual TranslationOption *Create(const std::vector<size_t> &alts) const;
+
+protected:
+  const TranslationOption &m_input;
+};
+
+/** Combine the input options with their expansions best-first, ordered by
+ *  the future score of the input plus the scores of the alternatives.
+ *  Stops after maxOptions new options (0 for no limit), or when the
+ *  estimate falls below the best estimate plus threshold (a log score).
+ *  The expansions are sorted by the future score of their input.
+ *  Returns the number of options added.
+ */
+size_t ExpandBestFirst(std::vector<DecodeStepExpansion*> &expansions
+                       , PartialTranslOptColl &outputPartialTranslOptColl
+                       , size_t maxOptions
+                       , float threshold);
+
+}
+#endif
@@ -19,7 +19,10 @@ License along with this library; if not, write to the Free Software
 Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 ***********************************************************************/
 
+#include <algorithm>
+
 #include "DecodeStepGeneration.h"
+#include "DecodeStepExpansion.h"
 #include "GenerationDictionary.h"
 #include "TranslationOption.h"
 #include "TranslationOptionCollection.h"
@@ -80,7 +83,6 @@ void DecodeStepGeneration::Process(const TranslationOption &inputPartialTranslOp
   const GenerationDictionary* generationDictionary  = decodeStep.GetGenerationDictionaryFeature();
 
   const Phrase &targetPhrase  = inputPartialTranslOpt.GetTargetPhrase();
-  const InputPath &inputPath = inputPartialTranslOpt.GetInputPath();
   size_t targetLength         = targetPhrase.GetSize();
 
   // generation list for each word in phrase
@@ -138,32 +140,121 @@ void DecodeStepGeneration::Process(const TranslationOption &inputPartialTranslOp
     // merge with existing trans opt
     Phrase genPhrase( mergeWords);
 
-    if (IsFilteringStep()) {
-      if (!inputPartialTranslOpt.IsCompatible(genPhrase, m_conflictFactors))
-        continue;
+    TranslationOption *newTransOpt = Merge(inputPartialTranslOpt, genPhrase, generationScore);
+    if (newTransOpt) {
+      outputPartialTranslOptColl.Add(newTransOpt);
     }
 
-    const TargetPhrase &inPhrase = inputPartialTranslOpt.GetTargetPhrase();
-    TargetPhrase outPhrase(inPhrase);
-    outPhrase.GetScoreBreakdown().PlusEquals(generationScore);
+    // increment iterators
+    IncrementIterators(wordListIterVector, wordListVector);
+  }
+}
 
-    outPhrase.MergeFactors(genPhrase, m_newOutputFactors);
-    outPhrase.EvaluateInIsolation(inputPath.GetPhrase(), m_featuresToApply);
+TranslationOption *DecodeStepGeneration::Merge(const TranslationOption &inputPartialTranslOpt
+    , const Phrase &genPhrase
+    , const ScoreComponentCollection &generationScore) const
+{
+  if (IsFilteringStep()) {
+    if (!inputPartialTranslOpt.IsCompatible(genPhrase, m_conflictFactors))
+      return NULL;
+  }
 
-    const Range &sourceWordsRange = inputPartialTranslOpt.GetSourceWordsRange();
+  const InputPath &inputPath = inputPartialTranslOpt.GetInputPath();
+  TargetPhrase outPhrase(inputPartialTranslOpt.GetTargetPhrase());
+  outPhrase.GetScoreBreakdown().PlusEquals(generationScore);
 
-    TranslationOption *newTransOpt = new TranslationOption(sourceWordsRange, outPhrase);
-    assert(newTransOpt);
+  outPhrase.MergeFactors(genPhrase, m_newOutputFactors);
+  outPhrase.EvaluateInIsolation(inputPath.GetPhrase(), m_featuresToApply);
 
-    newTransOpt->SetInputPath(inputPath);
+  TranslationOption *newTransOpt = new TranslationOption(inputPartialTranslOpt.GetSourceWordsRange(), outPhrase);
+  newTransOpt->SetInputPath(inputPath);
+  return newTransOpt;
+}
 
-    outputPartialTranslOptColl.Add(newTransOpt);
+namespace
+{
 
-    // increment iterators
-    IncrementIterators(wordListIterVector, wordListVector);
-  }
+//! a generated word with its weighted score
+typedef pair<float, const OutputWordCollection::value_type*> ScoredGeneration;
+
+bool CompareScoredGeneration(const ScoredGeneration &a, const ScoredGeneration &b)
+{
+  return a.first > b.first;
 }
 
+//! the generations of each target word, by weighted score
+class GenerationExpansion : public DecodeStepExpansion
+{
+public:
+  GenerationExpansion(const DecodeStepGeneration &step
+                      , const TranslationOption &input)
+    : DecodeStepExpansion(input)
+    , m_step(step)
+    , m_generations(input.GetTargetPhrase().GetSize()) {
+  }
+
+  //! false if the word is not in the generation dictionary
+  bool Add(size_t pos, const OutputWordCollection *wordColl) {
+    if (wordColl == NULL) {
+      return false;
+    }
+    vector<ScoredGeneration> &generations = m_generations[pos];
+    generations.reserve(wordColl->size());
+    OutputWordCollection::const_iterator iterWordColl;
+    for (iterWordColl = wordColl->begin() ; iterWordColl != wordColl->end(); ++iterWordColl) {
+      generations.push_back(ScoredGeneration(iterWordColl->second.GetWeightedScore(), &*iterWordColl));
+    }
+    stable_sort(generations.begin(), generations.end(), CompareScoredGeneration);
+    return true;
+  }
+
+  size_t GetNumDimensions() const {
+    return m_generations.size();
+  }
+
+  size_t GetNumAlternatives(size_t dim) const {
+    return m_generations[dim].size();
+  }
+
+  float GetScore(size_t dim, size_t alt) const {
+    return m_generations[dim][alt].first;
+  }
+
+  TranslationOption *Create(const vector<size_t> &alts) const {
+    ScoreComponentCollection generationScore;
+    vector<const Word*> mergeWords(alts.size());
+    for (size_t pos = 0; pos < alts.size(); ++pos) {
+      const OutputWordCollection::value_type &generation = *m_generations[pos][alts[pos]].second;
+      mergeWords[pos] = &generation.first;
+      generationScore.PlusEquals(generation.second);
+    }
+    return m_step.Merge(m_input, Phrase(mergeWords), generationScore);
+  }
+
+private:
+  const DecodeStepGeneration &m_step;
+  vector< vector<ScoredGeneration> > m_generations;
+};
+
 }
 
+DecodeStepExpansion *DecodeStepGeneration::CreateExpansion(const TranslationOption &inputPartialTranslOpt) const
+{
+  const Phrase &targetPhrase = inputPartialTranslOpt.GetTargetPhrase();
+  if (targetPhrase.GetSize() == 0) {
+    // word deletion
+    return new DecodeStepExpansion(inputPartialTranslOpt);
+  }
+
+  const GenerationDictionary* generationDictionary = GetGenerationDictionaryFeature();
+  GenerationExpansion *expansion = new GenerationExpansion(*this, inputPartialTranslOpt);
+  for (size_t currPos = 0 ; currPos < targetPhrase.GetSize() ; currPos++) {
+    if (!expansion->Add(currPos, generationDictionary->FindWord(targetPhrase.GetWord(currPos)))) {
+      delete expansion;
+      return NULL;
+    }
+  }
+  return expansion;
+}
 
+}
@@ -30,6 +30,7 @@ namespace Moses
 class GenerationDictionary;
 class Phrase;
 class ScoreComponentCollection;
+class DecodeStepExpansion;
 
 //! subclass of DecodeStep for generation step
 class DecodeStepGeneration : public DecodeStep
@@ -46,6 +47,16 @@ public:
                , TranslationOptionCollection *toc
                , bool adhereTableLimit) const;
 
+  /*! the generated factors of each target word of the partial translation
+   *  option, for lazy expansion. NULL if a word can't be generated
+   */
+  DecodeStepExpansion *CreateExpansion(const TranslationOption &inputPartialTranslOpt) const;
+
+  //! extend the partial translation option with the generated factors. NULL if they conflict
+  TranslationOption *Merge(const TranslationOption &inputPartialTranslOpt
+                           , const Phrase &genPhrase
+                           , const ScoreComponentCollection &generationScore) const;
+
 private:
 };
 
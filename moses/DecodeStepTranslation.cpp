@@ -19,7 +19,10 @@ License along with this library; if not, write to the Free Software
 Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 ***********************************************************************/
 
+#include <algorithm>
+
 #include "DecodeStepTranslation.h"
+#include "DecodeStepExpansion.h"
 #include "TranslationOption.h"
 #include "TranslationOptionCollection.h"
 #include "PartialTranslOptColl.h"
@@ -59,7 +62,6 @@ void DecodeStepTranslation::Process(const TranslationOption &inputPartialTranslO
 
   // normal trans step
   const Range &sourceWordsRange        = inputPartialTranslOpt.GetSourceWordsRange();
-  const InputPath &inputPath = inputPartialTranslOpt.GetInputPath();
   const PhraseDictionary* phraseDictionary  =
     decodeStep.GetPhraseDictionaryFeature();
   const TargetPhrase &inPhrase = inputPartialTranslOpt.GetTargetPhrase();
@@ -76,28 +78,106 @@ void DecodeStepTranslation::Process(const TranslationOption &inputPartialTranslO
       // skip if the
       if (targetPhrase.GetSize() != currSize) continue;
 
-      TargetPhrase outPhrase(inPhrase);
-
-      if (IsFilteringStep()) {
-        if (!inputPartialTranslOpt.IsCompatible(targetPhrase, m_conflictFactors))
-          continue;
+      TranslationOption *newTransOpt = Merge(inputPartialTranslOpt, targetPhrase);
+      if (newTransOpt) {
+        outputPartialTranslOptColl.Add(newTransOpt);
       }
+    }
+  } else if (sourceWordsRange.GetNumWordsCovered() == 1) {
+    // unknown handler
+    //toc->ProcessUnknownWord(sourceWordsRange.GetStartPos(), factorCollection);
+  }
+}
 
-      outPhrase.Merge(targetPhrase, m_newOutputFactors);
-      outPhrase.EvaluateInIsolation(inputPath.GetPhrase(), m_featuresToApply); // need to do this as all non-transcores would be screwed up
+TranslationOption *DecodeStepTranslation::Merge(const TranslationOption &inputPartialTranslOpt
+    , const TargetPhrase &targetPhrase) const
+{
+  if (IsFilteringStep()) {
+    if (!inputPartialTranslOpt.IsCompatible(targetPhrase, m_conflictFactors))
+      return NULL;
+  }
 
-      TranslationOption *newTransOpt = new TranslationOption(sourceWordsRange, outPhrase);
-      assert(newTransOpt != NULL);
+  const InputPath &inputPath = inputPartialTranslOpt.GetInputPath();
+  TargetPhrase outPhrase(inputPartialTranslOpt.GetTargetPhrase());
+  outPhrase.Merge(targetPhrase, m_newOutputFactors);
+  outPhrase.EvaluateInIsolation(inputPath.GetPhrase(), m_featuresToApply); // need to do this as all non-transcores would be screwed up
 
-      newTransOpt->SetInputPath(inputPath);
+  TranslationOption *newTransOpt = new TranslationOption(inputPartialTranslOpt.GetSourceWordsRange(), outPhrase);
+  newTransOpt->SetInputPath(inputPath);
+  return newTransOpt;
+}
 
-      outputPartialTranslOptColl.Add(newTransOpt );
+namespace
+{
+
+bool CompareTargetPhraseFutureScore(const TargetPhrase *a, const TargetPhrase *b)
+{
+  return a->GetFutureScore() > b->GetFutureScore();
+}
 
+//! the target phrases of the same length as the input, by future score
+class TranslationExpansion : public DecodeStepExpansion
+{
+public:
+  TranslationExpansion(const DecodeStepTranslation &step
+                       , const TranslationOption &input
+                       , const std::vector<const TargetPhrase*> &targetPhrases)
+    : DecodeStepExpansion(input)
+    , m_step(step)
+    , m_targetPhrases(targetPhrases) {
+    std::stable_sort(m_targetPhrases.begin(), m_targetPhrases.end(), CompareTargetPhraseFutureScore);
+  }
+
+  size_t GetNumDimensions() const {
+    return 1;
+  }
+
+  size_t GetNumAlternatives(size_t /* dim */) const {
+    return m_targetPhrases.size();
+  }
+
+  float GetScore(size_t /* dim */, size_t alt) const {
+    return m_targetPhrases[alt]->GetFutureScore();
+  }
+
+  TranslationOption *Create(const std::vector<size_t> &alts) const {
+    return m_step.Merge(m_input, *m_targetPhrases[alts[0]]);
+  }
+
+private:
+  const DecodeStepTranslation &m_step;
+  std::vector<const TargetPhrase*> m_targetPhrases;
+};
+
+}
+
+DecodeStepExpansion *DecodeStepTranslation::CreateExpansion(const TranslationOption &inputPartialTranslOpt
+    , bool adhereTableLimit
+    , TargetPhraseCollection::shared_ptr phraseColl) const
+{
+  const TargetPhrase &inPhrase = inputPartialTranslOpt.GetTargetPhrase();
+  if (inPhrase.GetSize() == 0) {
+    // word deletion
+    return new DecodeStepExpansion(inputPartialTranslOpt);
+  }
+  if (phraseColl == NULL) {
+    return NULL;
+  }
+
+  const size_t tableLimit = GetPhraseDictionaryFeature()->GetTableLimit();
+  TargetPhraseCollection::const_iterator iterTargetPhrase, iterEnd;
+  iterEnd = (!adhereTableLimit || tableLimit == 0 || phraseColl->GetSize() < tableLimit) ? phraseColl->end() : phraseColl->begin() + tableLimit;
+
+  std::vector<const TargetPhrase*> targetPhrases;
+  for (iterTargetPhrase = phraseColl->begin(); iterTargetPhrase != iterEnd; ++iterTargetPhrase) {
+    if ((*iterTargetPhrase)->GetSize() == inPhrase.GetSize()) {
+      targetPhrases.push_back(*iterTargetPhrase);
     }
-  } else if (sourceWordsRange.GetNumWordsCovered() == 1) {
-    // unknown handler
-    //toc->ProcessUnknownWord(sourceWordsRange.GetStartPos(), factorCollection);
   }
+  if (targetPhrases.empty()) {
+    return NULL;
+  }
+  return new TranslationExpansion(*this, inputPartialTranslOpt, targetPhrases);
 }
 
 void
@@ -32,6 +32,7 @@ namespace Moses
 class PhraseDictionary;
 class TargetPhrase;
 class InputPath;
+class DecodeStepExpansion;
 
 //! subclass of DecodeStep for translation step
 class DecodeStepTranslation : public DecodeStep
@@ -50,6 +51,16 @@ public:
                        , bool adhereTableLimit
                        , TargetPhraseCollection::shared_ptr phraseColl) const;
 
+  /*! the target phrases that can extend the partial translation option,
+   *  for lazy expansion. NULL if there are none
+   */
+  DecodeStepExpansion *CreateExpansion(const TranslationOption &inputPartialTranslOpt
+                                       , bool adhereTableLimit
+                                       , TargetPhraseCollection::shared_ptr phraseColl) const;
+
+  //! extend the partial translation option with a target phrase. NULL if they conflict
+  TranslationOption *Merge(const TranslationOption &inputPartialTranslOpt
+                           , const TargetPhrase &targetPhrase) const;
 
   /*! initialize list of partial translation options by applying the first translation step
   * Ideally, this function should be in DecodeStepTranslation class
@@ -293,6 +293,7 @@ batch_run()
 #ifdef WITH_THREADS
   pool.Stop(true); //flush remaining jobs
 #endif
+  ioWrapper->FinishOutput();
 
   FeatureFunction::Destroy();
 
@@ -12,9 +12,12 @@ class KenOSMBase
 public:
   virtual ~KenOSMBase() {}
 
-  virtual float Score(const lm::ngram::State&, const std::string&,
+  virtual float Score(const lm::ngram::State&, lm::WordIndex,
                       lm::ngram::State&) const = 0;
 
+  //! vocabulary id of an operation; look operations up once, not per Score()
+  virtual lm::WordIndex Index(const std::string&) const = 0;
+
   virtual const lm::ngram::State &BeginSentenceState() const = 0;
 
   virtual const lm::ngram::State &NullContextState() const = 0;
@@ -28,10 +31,13 @@ public:
     : m_kenlm(new KenModel(file.c_str())) {}
 
   virtual float Score(const lm::ngram::State &in_state,
-                      const std::string& word,
+                      lm::WordIndex word,
                       lm::ngram::State &out_state) const {
-    return m_kenlm->Score(in_state, m_kenlm->GetVocabulary().Index(word),
-                          out_state);
+    return m_kenlm->Score(in_state, word, out_state);
+  }
+
+  virtual lm::WordIndex Index(const std::string& word) const {
+    return m_kenlm->GetVocabulary().Index(word);
   }
 
   virtual const lm::ngram::State &BeginSentenceState() const {
@@ -31,7 +31,8 @@ void OpSequenceModel :: readLanguageModel(const char *lmFile)
 
   State startState = OSM->NullContextState();
   State endState;
-  unkOpProb = OSM->Score(startState,unkOp,endState);
+  unkOpProb = OSM->Score(startState,OSM->Index(unkOp),endState);
+  m_operationIds.init(*OSM);
 }
 
 
@@ -43,21 +44,12 @@ void OpSequenceModel::Load(AllOptions::ptr const& opts)
 
 
 
-void OpSequenceModel:: EvaluateInIsolation(const Phrase &source
-    , const TargetPhrase &targetPhrase
-    , ScoreComponentCollection &scoreBreakdown
-    , ScoreComponentCollection &estimatedScores) const
+boost::shared_ptr<osmPhrase> OpSequenceModel::CreatePhrase(const Phrase &source
+    , const TargetPhrase &targetPhrase) const
 {
-
-  osmHypothesis obj;
-  obj.setState(OSM->NullContextState());
-  Bitmap myBitmap(source.GetSize());
   vector <string> mySourcePhrase;
   vector <string> myTargetPhrase;
-  vector<float> scores;
   vector <int> alignments;
-  int startIndex = 0;
-  int endIndex = source.GetSize();
 
   const AlignmentInfo &align = targetPhrase.GetAlignTerm();
   AlignmentInfo::const_iterator iter;
@@ -78,8 +70,26 @@ void OpSequenceModel:: EvaluateInIsolation(const Phrase &source
     mySourcePhrase.push_back(source.GetWord(i).GetFactor(sFactor)->GetString().as_string());
   }
 
-  obj.setPhrases(mySourcePhrase , myTargetPhrase);
-  obj.constructCepts(alignments,startIndex,endIndex-1,targetPhrase.GetSize());
+  return boost::shared_ptr<osmPhrase>(new osmPhrase(mySourcePhrase, myTargetPhrase, alignments, *OSM));
+}
+
+void OpSequenceModel:: EvaluateInIsolation(const Phrase &source
+    , const TargetPhrase &targetPhrase
+    , ScoreComponentCollection &scoreBreakdown
+    , ScoreComponentCollection &estimatedScores) const
+{
+
+  osmHypothesis obj;
+  obj.setState(OSM->NullContextState());
+  Bitmap myBitmap(source.GetSize());
+  vector<float> scores;
+  int startIndex = 0;
+
+  // kept with the target phrase for EvaluateWhenApplied()
+  boost::shared_ptr<osmPhrase> phrase = CreatePhrase(source, targetPhrase);
+  targetPhrase.SetData(GetScoreProducerDescription(), phrase);
+
+  obj.setPhrase(*phrase, m_operationIds);
   obj.computeOSMFeature(startIndex,myBitmap);
   obj.calculateOSMProb(*OSM);
   obj.populateScores(scores,numFeatures);
@@ -100,71 +110,26 @@ FFState* OpSequenceModel::EvaluateWhenApplied(
   const InputType &source = manager.GetSource();
   // const Sentence &sourceSentence = static_cast<const Sentence&>(source);
   osmHypothesis obj;
-  vector <string> mySourcePhrase;
-  vector <string> myTargetPhrase;
   vector<float> scores;
 
-
-  //target.GetWord(0)
-
-  //cerr << target <<" --- "<<target.GetSourcePhrase()<< endl;  // English ...
-
-  //cerr << align << endl;   // Alignments ...
-  //cerr << cur_hypo.GetCurrSourceWordsRange() << endl;
-
-  //cerr << source <<endl;
-
-// int a = sourceRange.GetStartPos();
-// cerr << source.GetWord(a);
-  //cerr <<a<<endl;
-
-  //const Sentence &sentence = static_cast<const Sentence&>(curr_hypo.GetManager().GetSource());
-
-
   const Range & sourceRange = cur_hypo.GetCurrSourceWordsRange();
   int startIndex  = sourceRange.GetStartPos();
   int endIndex = sourceRange.GetEndPos();
-  const AlignmentInfo &align = cur_hypo.GetCurrTargetPhrase().GetAlignTerm();
-  // osmState * statePtr;
-
-  vector <int> alignments;
-
-
-
-  AlignmentInfo::const_iterator iter;
-
-  for (iter = align.begin(); iter != align.end(); ++iter) {
-    //cerr << iter->first << "----" << iter->second << " ";
-    alignments.push_back(iter->first);
-    alignments.push_back(iter->second);
-  }
-
-
-  //cerr<<bitmap<<endl;
-  //cerr<<startIndex<<" "<<endIndex<<endl;
-
 
   for (int i = startIndex; i <= endIndex; i++) {
     myBitmap.SetValue(i,0); // resetting coverage of this phrase ...
-    mySourcePhrase.push_back(source.GetWord(i).GetFactor(sFactor)->GetString().as_string());
-    // cerr<<mySourcePhrase[i]<<endl;
   }
 
-  for (size_t i = 0; i < target.GetSize(); i++) {
-
-    if (target.GetWord(i).IsOOV() && sFactor == 0 && tFactor == 0)
-      myTargetPhrase.push_back("_TRANS_SLF_");
-    else
-      myTargetPhrase.push_back(target.GetWord(i).GetFactor(tFactor)->GetString().as_string());
-
+  // the operations were resolved in EvaluateInIsolation(), unless the
+  // target phrase was not created by a phrase table
+  boost::shared_ptr<osmPhrase> phrase = boost::static_pointer_cast<osmPhrase>(
+                                          target.GetData(GetScoreProducerDescription()));
+  if (!phrase) {
+    phrase = CreatePhrase(source.GetSubString(sourceRange), target);
   }
 
-
-  //cerr<<myBitmap<<endl;
-
   obj.setState(prev_state);
-  obj.constructCepts(alignments,startIndex,endIndex,target.GetSize());
-  obj.setPhrases(mySourcePhrase , myTargetPhrase);
+  obj.setPhrase(*phrase, m_operationIds);
   obj.computeOSMFeature(startIndex,myBitmap);
   obj.calculateOSMProb(*OSM);
   obj.populateScores(scores,numFeatures);
@@ -221,7 +186,7 @@ std::string OpSequenceModel::GetScoreProducerWeightShortName(unsigned idx) const
 std::vector<float> OpSequenceModel::GetFutureScores(const Phrase &source, const Phrase &target) const
 {
   ParallelPhrase pp(source, target);
-  std::map<ParallelPhrase, Scores>::const_iterator iter;
+  boost::unordered_map<ParallelPhrase, Scores>::const_iterator iter;
   iter = m_futureCost.find(pp);
 //iter = m_coll.find(pp);
   if (iter == m_futureCost.end()) {
@@ -3,6 +3,8 @@
 #include <string>
 #include <map>
 #include <vector>
+#include <boost/shared_ptr.hpp>
+#include <boost/unordered_map.hpp>
 #include "moses/FF/StatefulFeatureFunction.h"
 #include "moses/Manager.h"
 #include "moses/FF/OSM-Feature/osmHyp.h"
@@ -54,7 +56,12 @@ public:
 protected:
   typedef std::pair<Phrase, Phrase> ParallelPhrase;
   typedef std::vector<float> Scores;
-  std::map<ParallelPhrase, Scores> m_futureCost;
+  boost::unordered_map<ParallelPhrase, Scores> m_futureCost;
+
+  osmOperationIds m_operationIds;
+
+  //! the phrase pair's operations, resolved to OSM vocabulary ids
+  boost::shared_ptr<osmPhrase> CreatePhrase(const Phrase &source, const TargetPhrase &target) const;
 
   std::vector < std::pair < std::set <int> , std::set <int> > > ceptsInPhrase;
   std::set <int> targetNullWords;
@@ -67,6 +67,8 @@ osmHypothesis :: osmHypothesis()
   j = 0;
   E = 0;
   gap.clear();
+  phrase = NULL;
+  ids = NULL;
 }
 
 void osmHypothesis :: setState(const FFState* prev_state)
@@ -89,46 +91,6 @@ osmState * osmHypothesis :: saveState()
   return statePtr;
 }
 
-int osmHypothesis :: isTranslationOperation(int x)
-{
-  if (operations[x].find("_JMP_BCK_") != -1)
-    return 0;
-
-  if (operations[x].find("_JMP_FWD_") != -1)
-    return 0;
-
-  if (operations[x].find("_CONT_CEPT_") != -1)
-    return 0;
-
-  if (operations[x].find("_INS_GAP_") != -1)
-    return 0;
-
-  return 1;
-
-}
-
-void osmHypothesis :: removeReorderingOperations()
-{
-  gapCount = 0;
-  deletionCount = 0;
-  openGapCount = 0;
-  gapWidth = 0;
-
-  std::vector <std::string> tupleSequence;
-
-  for (int x = 0; x < operations.size(); x++) {
-    // cout<<operations[x]<<endl;
-
-    if(isTranslationOperation(x) == 1) {
-      tupleSequence.push_back(operations[x]);
-    }
-
-  }
-
-  operations.clear();
-  operations = tupleSequence;
-}
-
 void osmHypothesis :: calculateOSMProb(OSMLM& ptrOp)
 {
 
@@ -147,29 +109,7 @@ void osmHypothesis :: calculateOSMProb(OSMLM& ptrOp)
 }
 
 
-int osmHypothesis :: firstOpenGap(vector <int> & coverageVector)
-{
-
-  int firstOG =-1;
-
-  for(int nd = 0; nd < coverageVector.size(); nd++) {
-    if(coverageVector[nd]==0) {
-      firstOG = nd;
-      return firstOG;
-    }
-  }
-
-  return firstOG;
-
-}
-
-string osmHypothesis :: intToString(int num)
-{
-  return SPrint(num);
-
-}
-
-void osmHypothesis :: generateOperations(int & startIndex , int j1 , int contFlag , Bitmap & coverageVector , string english , string german , set <int> & targetNullWords , vector <string> & currF)
+void osmHypothesis :: generateOperations(int & startIndex , int j1 , int contFlag , Bitmap & coverageVector , lm::WordIndex op)
 {
 
   int gFlag = 0;
@@ -180,14 +120,14 @@ void osmHypothesis :: generateOperations(int & startIndex , int j1 , int contFla
   if ( j < j1) { // j1 is the index of the source word we are about to generate ...
     //if(coverageVector[j]==0) // if source word at j is not generated yet ...
     if(coverageVector.GetValue(j)==0) { // if source word at j is not generated yet ...
-      operations.push_back("_INS_GAP_");
+      operations.push_back(ids->insertGap);
       gFlag++;
       gap[j]="Unfilled";
     }
     if (j == E) {
       j = j1;
     } else {
-      operations.push_back("_JMP_FWD_");
+      operations.push_back(ids->jumpForward);
       j=E;
     }
   }
@@ -195,13 +135,13 @@ void osmHypothesis :: generateOperations(int & startIndex , int j1 , int contFla
   if (j1 < j) {
     // if(j < E && coverageVector[j]==0)
     if(j < E && coverageVector.GetValue(j)==0) {
-      operations.push_back("_INS_GAP_");
+      operations.push_back(ids->insertGap);
       gFlag++;
       gap[j]="Unfilled";
     }
 
     j=closestGap(gap,j1,gp);
-    operations.push_back("_JMP_BCK_"+ intToString(gp));
+    operations.push_back(ids->jumpBack(gp));
 
     //cout<<"I am j "<<j<<endl;
     //cout<<"I am j1 "<<j1<<endl;
@@ -211,7 +151,7 @@ void osmHypothesis :: generateOperations(int & startIndex , int j1 , int contFla
   }
 
   if (j < j1) {
-    operations.push_back("_INS_GAP_");
+    operations.push_back(ids->insertGap);
     gap[j] = "Unfilled";
     gFlag++;
     j=j1;
@@ -219,11 +159,7 @@ void osmHypothesis :: generateOperations(int & startIndex , int j1 , int contFla
 
   if(contFlag == 0) { // First words of the multi-word cept ...
 
-    if(english == "_TRANS_SLF_") { // Unknown word ...
-      operations.push_back("_TRANS_SLF_");
-    } else {
-      operations.push_back("_TRANS_" + english + "_TO_" + german);
-    }
+    operations.push_back(op);
 
     //ans = firstOpenGap(coverageVector);
     ans = coverageVector.GetFirstGapPos();
@@ -233,14 +169,14 @@ void osmHypothesis :: generateOperations(int & startIndex , int j1 , int contFla
 
   } else if (contFlag == 2) {
 
-    operations.push_back("_INS_" + german);
+    operations.push_back(op);
     ans = coverageVector.GetFirstGapPos();
 
     if (ans != -1)
       gapWidth += j - ans;
     deletionCount++;
   } else {
-    operations.push_back("_CONT_CEPT_");
+    operations.push_back(ids->continueCept);
   }
 
   //coverageVector[j]=1;
@@ -257,11 +193,9 @@ void osmHypothesis :: generateOperations(int & startIndex , int j1 , int contFla
 
   //if (coverageVector[j] == 0 && targetNullWords.find(j) != targetNullWords.end())
   if (j < coverageVector.GetSize()) {
-    if (coverageVector.GetValue(j) == 0 && targetNullWords.find(j) != targetNullWords.end()) {
+    if (coverageVector.GetValue(j) == 0 && phrase->targetNullWords.find(j - startIndex) != phrase->targetNullWords.end()) {
       j1 = j;
-      german = currF[j1-startIndex];
-      english = "_INS_";
-      generateOperations(startIndex, j1, 2 , coverageVector , english , german , targetNullWords , currF);
+      generateOperations(startIndex, j1, 2 , coverageVector , phrase->insert[j1-startIndex]);
     }
   }
 
@@ -285,7 +219,7 @@ void osmHypothesis :: print()
   cerr<<"_______________"<<endl;
 }
 
-int osmHypothesis :: closestGap(map <int,string> gap, int j1, int & gp)
+int osmHypothesis :: closestGap(const map <int,string> & gap, int j1, int & gp)
 {
 
   int dist=1172;
@@ -294,7 +228,7 @@ int osmHypothesis :: closestGap(map <int,string> gap, int j1, int & gp)
   gp=0;
   int opGap=0;
 
-  map <int,string> :: iterator iter;
+  map <int,string> :: const_iterator iter;
 
   iter=gap.end();
 
@@ -345,19 +279,18 @@ int osmHypothesis :: getOpenGaps()
 
 }
 
-void osmHypothesis :: generateDeleteOperations(std::string english, int currTargetIndex, std::set <int> doneTargetIndexes)
+void osmHypothesis :: generateDeleteOperations(int currTargetIndex, const std::set <int> & doneTargetIndexes)
 {
 
-  operations.push_back("_DEL_" + english);
+  operations.push_back(phrase->del[currTargetIndex]);
   currTargetIndex++;
 
   while(doneTargetIndexes.find(currTargetIndex) != doneTargetIndexes.end()) {
     currTargetIndex++;
   }
 
-  if (sourceNullWords.find(currTargetIndex) != sourceNullWords.end()) {
-    english = currE[currTargetIndex];
-    generateDeleteOperations(english,currTargetIndex,doneTargetIndexes);
+  if (phrase->sourceNullWords.find(currTargetIndex) != phrase->sourceNullWords.end()) {
+    generateDeleteOperations(currTargetIndex,doneTargetIndexes);
   }
 
 }
@@ -366,44 +299,34 @@ void osmHypothesis :: computeOSMFeature(int startIndex , Bitmap & coverageVector
 {
 
   set <int> doneTargetIndexes;
-  set <int> eSide;
-  set <int> fSide;
-  set <int> :: iterator iter;
-  string english;
-  string source;
+  set <int> :: const_iterator iter;
   int j1;
   int targetIndex = 0;
-  doneTargetIndexes.clear();
+  const set <int> & targetNullWords = phrase->targetNullWords;
+  const set <int> & sourceNullWords = phrase->sourceNullWords;
 
 
   if (targetNullWords.size() != 0) { // Source words to be deleted in the start of this phrase ...
     iter = targetNullWords.begin();
 
-    if (*iter == startIndex) {
+    if (*iter == 0) {
 
       j1 = startIndex;
-      source = currF[j1-startIndex];
-      english = "_INS_";
-      generateOperations(startIndex, j1, 2 , coverageVector , english , source , targetNullWords , currF);
+      generateOperations(startIndex, j1, 2 , coverageVector , phrase->insert[0]);
     }
   }
 
   if (sourceNullWords.find(targetIndex) != sourceNullWords.end()) { // first word has to be deleted ...
-    english = currE[targetIndex];
-    generateDeleteOperations(english,targetIndex, doneTargetIndexes);
+    generateDeleteOperations(targetIndex, doneTargetIndexes);
   }
 
 
-  for (size_t i = 0; i < ceptsInPhrase.size(); i++) {
-    source = "";
-    english = "";
-
-    fSide = ceptsInPhrase[i].first;
-    eSide = ceptsInPhrase[i].second;
+  for (size_t i = 0; i < phrase->ceptsInPhrase.size(); i++) {
+    const set <int> & fSide = phrase->ceptsInPhrase[i].first;
+    const set <int> & eSide = phrase->ceptsInPhrase[i].second;
 
     iter = eSide.begin();
     targetIndex = *iter;
-    english += currE[*iter];
     iter++;
 
     for (; iter != eSide.end(); iter++) {
@@ -411,30 +334,18 @@ void osmHypothesis :: computeOSMFeature(int startIndex , Bitmap & coverageVector
         targetIndex++;
       else
         doneTargetIndexes.insert(*iter);
-
-      english += "^_^";
-      english += currE[*iter];
-    }
-
-    iter = fSide.begin();
-    source += currF[*iter];
-    iter++;
-
-    for (; iter != fSide.end(); iter++) {
-      source += "^_^";
-      source += currF[*iter];
     }
 
     iter = fSide.begin();
     j1 = *iter + startIndex;
     iter++;
 
-    generateOperations(startIndex, j1, 0 , coverageVector , english , source , targetNullWords , currF);
+    generateOperations(startIndex, j1, 0 , coverageVector , phrase->translate[i]);
 
 
     for (; iter != fSide.end(); iter++) {
       j1 = *iter + startIndex;
-      generateOperations(startIndex, j1, 1 , coverageVector , english , source , targetNullWords , currF);
+      generateOperations(startIndex, j1, 1 , coverageVector , ids->continueCept);
     }
 
     targetIndex++; // Check whether the next target word is unaligned ...
@@ -444,18 +355,85 @@ void osmHypothesis :: computeOSMFeature(int startIndex , Bitmap & coverageVector
     }
 
     if(sourceNullWords.find(targetIndex) != sourceNullWords.end()) {
-      english = currE[targetIndex];
-      generateDeleteOperations(english,targetIndex, doneTargetIndexes);
+      generateDeleteOperations(targetIndex, doneTargetIndexes);
     }
   }
 
-  //removeReorderingOperations();
+}
 
-  //print();
+osmOperationIds :: osmOperationIds()
+  : insertGap(0)
+  , jumpForward(0)
+  , continueCept(0)
+  , m_lm(NULL)
+{
+}
+
+void osmOperationIds :: init(const OSMLM &lm)
+{
+  m_lm = &lm;
+  insertGap = lm.Index("_INS_GAP_");
+  jumpForward = lm.Index("_JMP_FWD_");
+  continueCept = lm.Index("_CONT_CEPT_");
+
+  // jumps over more gaps than this are looked up when they occur
+  m_jumpBack.clear();
+  for (int gaps = 0; gaps < 64; gaps++) {
+    m_jumpBack.push_back(lm.Index("_JMP_BCK_" + SPrint(gaps)));
+  }
+}
+
+lm::WordIndex osmOperationIds :: jumpBack(int gaps) const
+{
+  if (gaps < (int) m_jumpBack.size())
+    return m_jumpBack[gaps];
+
+  return m_lm->Index("_JMP_BCK_" + SPrint(gaps));
+}
+
+//////////////////////////////////////////////////
+
+osmPhrase :: osmPhrase(const vector <string> & currF, const vector <string> & currE,
+                       const vector <int> & align, const OSMLM &lm)
+{
+  constructCepts(align, currF.size(), currE.size());
 
+  for (size_t i = 0; i < ceptsInPhrase.size(); i++) {
+    const set <int> & fSide = ceptsInPhrase[i].first;
+    const set <int> & eSide = ceptsInPhrase[i].second;
+    set <int> :: const_iterator iter;
+    string english;
+    string source;
+
+    for (iter = eSide.begin(); iter != eSide.end(); iter++) {
+      if (iter != eSide.begin())
+        english += "^_^";
+      english += currE[*iter];
+    }
+
+    for (iter = fSide.begin(); iter != fSide.end(); iter++) {
+      if (iter != fSide.begin())
+        source += "^_^";
+      source += currF[*iter];
+    }
+
+    if(english == "_TRANS_SLF_") { // Unknown word ...
+      translate.push_back(lm.Index("_TRANS_SLF_"));
+    } else {
+      translate.push_back(lm.Index("_TRANS_" + english + "_TO_" + source));
+    }
+  }
+
+  for (size_t i = 0; i < currF.size(); i++) {
+    insert.push_back(targetNullWords.count(i) ? lm.Index("_INS_" + currF[i]) : 0);
+  }
+
+  for (size_t i = 0; i < currE.size(); i++) {
+    del.push_back(sourceNullWords.count(i) ? lm.Index("_DEL_" + currE[i]) : 0);
+  }
 }
 
-void osmHypothesis :: getMeCepts ( set <int> & eSide , set <int> & fSide , map <int , vector <int> > & tS , map <int , vector <int> > & sT)
+void osmPhrase :: getMeCepts ( set <int> & eSide , set <int> & fSide , map <int , vector <int> > & tS , map <int , vector <int> > & sT)
 {
   set <int> :: iterator iter;
 
@@ -487,7 +465,7 @@ void osmHypothesis :: getMeCepts ( set <int> & eSide , set <int> & fSide , map <
 
 }
 
-void osmHypothesis :: constructCepts(vector <int> & align , int startIndex , int endIndex, int targetPhraseLength)
+void osmPhrase :: constructCepts(const vector <int> & align , int sourceLength, int targetPhraseLength)
 {
 
   std::map <int , vector <int> > sT;
@@ -508,8 +486,8 @@ void osmHypothesis :: constructCepts(vector <int> & align , int startIndex , int
     sT[src].push_back(tgt);
   }
 
-  for (int i = startIndex; i<= endIndex; i++) { // What are unaligned source words in this phrase ...
-    if (sT.find(i-startIndex) == sT.end()) {
+  for (int i = 0; i < sourceLength; i++) { // What are unaligned source words in this phrase ...
+    if (sT.find(i) == sT.end()) {
       targetNullWords.insert(i);
     }
   }
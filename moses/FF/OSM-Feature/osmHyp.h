@@ -43,13 +43,53 @@ protected:
   lm::ngram::State lmState;
 };
 
+/** Vocabulary ids of the reordering operations, which do not depend on
+ *  the phrase pair */
+class osmOperationIds
+{
+public:
+  osmOperationIds();
+  void init(const OSMLM &lm);
+
+  lm::WordIndex insertGap;
+  lm::WordIndex jumpForward;
+  lm::WordIndex continueCept;
+  lm::WordIndex jumpBack(int gaps) const;
+
+private:
+  const OSMLM *m_lm;
+  std::vector <lm::WordIndex> m_jumpBack; // by number of gaps
+};
+
+/** The cepts and the unaligned words of a phrase pair, and the vocabulary
+ *  ids of its translation, insertion and deletion operations. Built once
+ *  per phrase pair, so that extending a hypothesis only looks up ids. */
+class osmPhrase
+{
+public:
+  osmPhrase(const std::vector <std::string> & currF, const std::vector <std::string> & currE,
+            const std::vector <int> & align, const OSMLM &lm);
+
+  std::vector < std::pair < std::set <int> , std::set <int> > > ceptsInPhrase;
+  std::set <int> targetNullWords; // unaligned source positions
+  std::set <int> sourceNullWords; // unaligned target positions
+
+  std::vector <lm::WordIndex> translate; // for each cept
+  std::vector <lm::WordIndex> insert; // for each source position
+  std::vector <lm::WordIndex> del; // for each target position
+
+private:
+  void constructCepts(const std::vector <int> & align, int sourceLength, int targetLength);
+  void getMeCepts ( std::set <int> & eSide , std::set <int> & fSide , std::map <int , std::vector <int> > & tS , std::map <int , std::vector <int> > & sT);
+};
+
 class osmHypothesis
 {
 
 private:
 
 
-  std::vector <std::string> operations;	// List of operations required to generated this hyp ...
+  std::vector <lm::WordIndex> operations;	// List of operations required to generated this hyp ...
   std::map <int,std::string> gap;	// Maintains gap history ...
   int j;	// Position after the last source word generated ...
   int E; // Position after the right most source word so far generated ...
@@ -61,33 +101,23 @@ private:
   int gapWidth;
   double opProb;
 
-  std::vector <std::string> currE;
-  std::vector <std::string> currF;
-  std::vector < std::pair < std::set <int> , std::set <int> > > ceptsInPhrase;
-  std::set <int> targetNullWords;
-  std::set <int> sourceNullWords;
+  const osmPhrase *phrase;
+  const osmOperationIds *ids;
 
-  int closestGap(std::map <int,std::string> gap,int j1, int & gp);
-  int firstOpenGap(std::vector <int> & coverageVector);
-  std::string intToString(int);
+  int closestGap(const std::map <int,std::string> & gap,int j1, int & gp);
   int  getOpenGaps();
-  int isTranslationOperation(int j);
-  void removeReorderingOperations();
-
-  void getMeCepts ( std::set <int> & eSide , std::set <int> & fSide , std::map <int , std::vector <int> > & tS , std::map <int , std::vector <int> > & sT);
 
 public:
 
   osmHypothesis();
   ~osmHypothesis() {};
-  void generateOperations(int & startIndex, int j1 , int contFlag , Bitmap & coverageVector , std::string english , std::string german , std::set <int> & targetNullWords , std::vector <std::string> & currF);
-  void generateDeleteOperations(std::string english, int currTargetIndex, std::set <int> doneTargetIndexes);
+  void generateOperations(int & startIndex, int j1 , int contFlag , Bitmap & coverageVector , lm::WordIndex op);
+  void generateDeleteOperations(int currTargetIndex, const std::set <int> & doneTargetIndexes);
   void calculateOSMProb(OSMLM& ptrOp);
   void computeOSMFeature(int startIndex , Bitmap & coverageVector);
-  void constructCepts(std::vector <int> & align , int startIndex , int endIndex, int targetPhraseLength);
-  void setPhrases(std::vector <std::string> & val1 , std::vector <std::string> & val2) {
-    currF = val1;
-    currE = val2;
+  void setPhrase(const osmPhrase & val1 , const osmOperationIds & val2) {
+    phrase = &val1;
+    ids = &val2;
   }
   void setState(const FFState* prev_state);
   osmState * saveState();
@@ -100,6 +130,3 @@ public:
 };
 
 } // namespace
-
-
-
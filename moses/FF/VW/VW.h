@@ -4,10 +4,13 @@
 #include <map>
 #include <limits>
 
+#include <boost/unordered_map.hpp>
+
 #include "moses/FF/StatelessFeatureFunction.h"
 #include "moses/PP/CountsPhraseProperty.h"
 #include "moses/TranslationOptionList.h"
 #include "moses/TranslationOption.h"
+#include "moses/InputPath.h"
 #include "moses/Util.h"
 #include "moses/TypeDef.h"
 #include "moses/StaticData.h"
@@ -100,23 +103,40 @@ struct VWTargetSentence {
   std::vector<Constraint> m_sourceConstraints, m_targetConstraints;
 };
 
+/**
+ * VW thread-specific cache of target-side features. They only depend on the
+ * target phrase, which recurs across spans and sentences; the key includes
+ * the source phrase and the phrase table as the target phrase's scores may
+ * be features, too. Feature ids are only valid for the thread's classifier.
+ */
+struct VWTargetFeatureCache {
+  typedef std::pair<const PhraseDictionary*, std::pair<Phrase, Phrase> > Key;
+  typedef boost::unordered_map<Key, Discriminative::FeatureVector> Map;
+
+  Map m_features;
+};
+
 typedef ThreadLocalByFeatureStorage<Discriminative::Classifier, Discriminative::ClassifierFactory &> TLSClassifier;
 
 typedef ThreadLocalByFeatureStorage<VWTargetSentence> TLSTargetSentence;
 
+typedef ThreadLocalByFeatureStorage<VWTargetFeatureCache> TLSTargetFeatureCache;
+
 class VW : public StatelessFeatureFunction, public TLSTargetSentence
 {
 public:
   VW(const std::string &line)
     : StatelessFeatureFunction(1, line)
     , TLSTargetSentence(this)
-    , m_train(false) {
+    , m_train(false)
+    , m_cacheSize(DEFAULT_CACHE_SIZE) {
     ReadParameters();
     Discriminative::ClassifierFactory *classifierFactory = m_train
         ? new Discriminative::ClassifierFactory(m_modelPath)
         : new Discriminative::ClassifierFactory(m_modelPath, m_vwOptions);
 
     m_tlsClassifier = new TLSClassifier(this, *classifierFactory);
+    m_tlsTargetFeatureCache = new TLSTargetFeatureCache(this);
 
     if (! m_normalizer) {
       VERBOSE(1, "VW :: No loss function specified, assuming logistic loss.\n");
@@ -131,6 +151,7 @@ public:
 
   virtual ~VW() {
     delete m_tlsClassifier;
+    delete m_tlsTargetFeatureCache;
     delete m_normalizer;
   }
 
@@ -217,8 +238,10 @@ public:
 
         // extract target-side features for each topt
         const TargetPhrase &targetPhrase = translationOptionList.Get(toptIdx)->GetTargetPhrase();
+        Discriminative::FeatureVector targetFeatureVector;
         for(size_t i = 0; i < targetFeatures.size(); ++i)
-          (*targetFeatures[i])(input, inputPath, targetPhrase, classifier);
+          (*targetFeatures[i])(input, inputPath, targetPhrase, classifier, targetFeatureVector);
+        classifier.AddLabelDependentFeatures(targetFeatureVector);
 
         float loss = (*m_trainingLoss)(targetPhrase, correctPhrase, correct[toptIdx]);
 
@@ -236,18 +259,30 @@ public:
       for(size_t i = 0; i < sourceFeatures.size(); ++i)
         (*sourceFeatures[i])(input, inputPath, sourceRange, classifier);
 
+      // target-side features of each topt, extracted once per phrase pair
+      VWTargetFeatureCache::Map &cache = m_tlsTargetFeatureCache->GetStored()->m_features;
+      if (cache.size() > m_cacheSize)
+        cache.clear();
+
+      std::vector<const Discriminative::FeatureVector*> targetFeatureVectors(translationOptionList.size());
       for (size_t toptIdx = 0; toptIdx < translationOptionList.size(); toptIdx++) {
         const TranslationOption *topt = translationOptionList.Get(toptIdx);
         const TargetPhrase &targetPhrase = topt->GetTargetPhrase();
 
-        // extract target-side features for each topt
-        for(size_t i = 0; i < targetFeatures.size(); ++i)
-          (*targetFeatures[i])(input, inputPath, targetPhrase, classifier);
-
-        // get classifier score
-        losses[toptIdx] = classifier.Predict(MakeTargetLabel(targetPhrase));
+        VWTargetFeatureCache::Key key(targetPhrase.GetContainer(),
+                                      std::make_pair(inputPath.GetPhrase(), static_cast<const Phrase&>(targetPhrase)));
+        std::pair<VWTargetFeatureCache::Map::iterator, bool> cached
+          = cache.insert(std::make_pair(key, Discriminative::FeatureVector()));
+        if (cached.second) {
+          for(size_t i = 0; i < targetFeatures.size(); ++i)
+            (*targetFeatures[i])(input, inputPath, targetPhrase, classifier, cached.first->second);
+        }
+        targetFeatureVectors[toptIdx] = &cached.first->second;
       }
 
+      // get classifier scores of all topts at once
+      classifier.Predict(VW_DUMMY_LABEL, targetFeatureVectors, losses);
+
       // normalize classifier scores to get a probability distribution
       (*m_normalizer)(losses);
 
@@ -280,6 +315,8 @@ public:
       m_modelPath = value;
     } else if (key == "vw-options") {
       m_vwOptions = value;
+    } else if (key == "target-feature-cache-size") {
+      m_cacheSize = Scan<size_t>(value);
     } else if (key == "leave-one-out-from") {
       m_leaveOneOut = value;
     } else if (key == "training-loss") {
@@ -480,6 +517,11 @@ private:
 
   bool m_train; // false means predict
   std::string m_modelPath;
+
+  // phrase pairs per thread whose target-side features are kept
+  static const size_t DEFAULT_CACHE_SIZE = 100000;
+  size_t m_cacheSize;
+  TLSTargetFeatureCache *m_tlsTargetFeatureCache;
   std::string m_vwOptions;
 
   // calculator of training loss
@@ -86,11 +86,14 @@ public:
 
   // Overload to process target-dependent features, create features once for
   // every target phrase. One source word range will have at leat one target
-  // phrase, but may have more.
+  // phrase, but may have more. The features are added to outFeatures by
+  // their ids (see Classifier::GetLabelDependentFeatureId), so that VW can
+  // cache them with the phrase pair.
   virtual void operator()(const InputType &input
                           , const InputPath &inputPath
                           , const TargetPhrase &targetPhrase
-                          , Discriminative::Classifier &classifier) const = 0;
+                          , Discriminative::Classifier &classifier
+                          , Discriminative::FeatureVector &outFeatures) const = 0;
 
 protected:
   std::vector<FactorType> m_sourceFactors, m_targetFactors;
@@ -36,6 +36,12 @@ protected:
   inline std::string GetWord(const TargetPhrase &phrase, size_t pos) const {
     return phrase.GetWord(pos).GetString(m_targetFactors, false);
   }
+
+  inline void AddFeature(Discriminative::Classifier &classifier
+                         , Discriminative::FeatureVector &outFeatures
+                         , const std::string &name, float value = 1.0) const {
+    outFeatures.push_back(std::make_pair(classifier.GetLabelDependentFeatureId(name), value));
+  }
 };
 
 }
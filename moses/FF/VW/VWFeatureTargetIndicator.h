@@ -19,8 +19,9 @@ public:
   void operator()(const InputType &input
                   , const InputPath &inputPath
                   , const TargetPhrase &targetPhrase
-                  , Discriminative::Classifier &classifier) const {
-    classifier.AddLabelDependentFeature("tind^" + targetPhrase.GetStringRep(m_targetFactors));
+                  , Discriminative::Classifier &classifier
+                  , Discriminative::FeatureVector &outFeatures) const {
+    AddFeature(classifier, outFeatures, "tind^" + targetPhrase.GetStringRep(m_targetFactors));
   }
 
   virtual void SetParameter(const std::string& key, const std::string& value) {
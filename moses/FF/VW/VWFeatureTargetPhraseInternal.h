@@ -19,9 +19,10 @@ public:
   void operator()(const InputType &input
                   , const InputPath &inputPath
                   , const TargetPhrase &targetPhrase
-                  , Discriminative::Classifier &classifier) const {
+                  , Discriminative::Classifier &classifier
+                  , Discriminative::FeatureVector &outFeatures) const {
     for (size_t i = 0; i < targetPhrase.GetSize(); i++) {
-      classifier.AddLabelDependentFeature("tin^" + GetWord(targetPhrase, i));
+      AddFeature(classifier, outFeatures, "tin^" + GetWord(targetPhrase, i));
     }
   }
 
@@ -91,8 +91,21 @@ IOWrapper::IOWrapper(AllOptions const& opts)
   size_t nBestSize = m_options->nbest.nbest_size;
   string nBestFilePath = m_options->nbest.output_file_path;
 
+  bool streaming;
+  P.SetParameter(streaming, "streaming-io", false);
+
   staticData.GetParameter().SetParameter<string>(m_inputFilePath, "input-file", "");
-  if (m_inputFilePath.empty()) {
+  if (streaming && m_inputType == SentenceInput) {
+    // mmap or large block reads, decompressing if needed
+    VERBOSE(2,"Streaming IO" << endl);
+    m_inputFile = NULL;
+    m_inputStream = &cin;
+    if (m_inputFilePath.empty()) {
+      m_inputPiece.reset(new util::FilePiece(0, "stdin"));
+    } else {
+      m_inputPiece.reset(new util::FilePiece(m_inputFilePath.c_str()));
+    }
+  } else if (m_inputFilePath.empty()) {
     m_inputFile = NULL;
     m_inputStream = &cin;
   } else {
@@ -141,6 +154,13 @@ IOWrapper::IOWrapper(AllOptions const& opts)
     m_singleBestOutputCollector.reset(new Moses::OutputCollector(&std::cout));
   }
 
+  if (streaming) {
+    if (m_singleBestOutputCollector.get())
+      m_singleBestOutputCollector->StartWriter();
+    if (m_nBestOutputCollector.get())
+      m_nBestOutputCollector->StartWriter();
+  }
+
   // setup file pattern for hypergraph output
   char const* key = "output-search-graph-hypergraph";
   PARAM_VEC const* p = staticData.GetParameter().GetParam(key);
@@ -169,6 +189,7 @@ IOWrapper::IOWrapper(AllOptions const& opts)
 
 IOWrapper::~IOWrapper()
 {
+  FinishOutput();
   if (m_inputFile != NULL)
     delete m_inputFile;
   // if (m_nBestStream != NULL && !m_surpressSingleBestOutput) {
@@ -246,6 +267,28 @@ ReadInput(boost::shared_ptr<std::vector<std::string> >* cw)
   return source;
 }
 
+bool
+IOWrapper::
+ReadInto(Sentence &source)
+{
+  if (!m_inputPiece.get())
+    return source.Read(*m_inputStream);
+  StringPiece line;
+  if (!m_inputPiece->ReadLineOrEOF(line))
+    return false;
+  return source.Read(line);
+}
+
+void
+IOWrapper::
+FinishOutput()
+{
+  if (m_singleBestOutputCollector.get())
+    m_singleBestOutputCollector->StopWriter();
+  if (m_nBestOutputCollector.get())
+    m_nBestOutputCollector->StopWriter();
+}
+
 boost::shared_ptr<std::vector<std::string> >
 IOWrapper::
 GetCurrentContextWindow() const
@@ -56,6 +56,7 @@ POSSIBILITY OF SUCH DAMAGE.
 #include "moses/OutputCollector.h"
 #include "moses/TrellisPathList.h"
 #include "moses/InputFileStream.h"
+#include "util/file_piece.hh"
 #include "moses/InputType.h"
 #include "moses/WordLattice.h"
 #include "moses/LatticeMBR.h"
@@ -88,6 +89,7 @@ protected:
   std::string m_inputFilePath;
   Moses::InputFileStream *m_inputFile;
   std::istream *m_inputStream;
+  std::auto_ptr<util::FilePiece> m_inputPiece; // text input in streaming mode
   std::ostream *m_nBestStream;
   // std::ostream *m_outputWordGraphStream;
   // std::auto_ptr<std::ostream> m_outputSearchGraphStream;
@@ -180,8 +182,12 @@ public:
 
   void SetInputStreamFromString(std::istringstream &input) {
     m_inputStream = &input;
+    m_inputPiece.reset();
   }
 
+  //! write all pending output and stop the writer threads of streaming mode
+  void FinishOutput();
+
   std::string GetHypergraphOutputFileName(size_t const id) const;
 
   // post editing
@@ -207,6 +213,15 @@ private:
   boost::shared_ptr<InputType>
   BufferInput();
 
+  template<class itype>
+  bool
+  ReadInto(itype &source) {
+    return source.Read(*m_inputStream);
+  }
+
+  bool
+  ReadInto(Sentence &source);
+
   boost::shared_ptr<InputType>
   GetBufferedInput();
 
@@ -227,13 +242,13 @@ BufferInput()
     m_buffered_ahead -= ret->GetSize();
   } else {
     source.reset(new itype(m_options));
-    if (!source->Read(*m_inputStream))
+    if (!ReadInto(*source))
       return ret;
     ret = source;
   }
   while (m_buffered_ahead < m_look_ahead) {
     source.reset(new itype(m_options));
-    if (!source->Read(*m_inputStream))
+    if (!ReadInto(*source))
       break;
     m_future_input.push_back(source);
     m_buffered_ahead += source->GetSize();
@@ -10,6 +10,7 @@
 #include "moses/FactorCollection.h"
 #include <boost/shared_ptr.hpp>
 #include "TargetPhraseCollection.h"
+#include "ScratchArena.h"
 namespace Moses
 {
 
@@ -40,6 +41,14 @@ public:
   TargetPhrases;
 
 public:
+  //! allocated from the scratch arena of the sentence, see ScratchArena
+  static void *operator new(size_t size) {
+    return ScratchArena::Allocate(size);
+  }
+  static void operator delete(void *ptr) {
+    ScratchArena::Free(ptr);
+  }
+
   // ttaskwptr const ttask;
   TranslationTask const* ttask;
 protected:
@@ -9,6 +9,8 @@
 
 #include "LatticeMBR.h"
 #include "moses/StaticData.h"
+#include "moses/Timer.h"
+#include "util/exception.hh"
 #include <algorithm>
 #include <set>
 
@@ -48,6 +50,17 @@ void extract_ngrams(const vector<Word >& sentence, map < Phrase, int >  & allngr
   }
 }
 
+void extract_ngrams(const vector<Word >& sentence, boost::unordered_map < uint64_t, int >  & allngrams)
+{
+  for (size_t i = 0; i < sentence.size(); ++i) {
+    uint64_t ngram = 0;
+    for (size_t j = i; j < sentence.size() && j < i + bleu_order; ++j) {
+      ngram = ArrayLattice::ExtendNgram(ngram, sentence[j]);
+      ++allngrams[ngram];
+    }
+  }
+}
+
 
 
 void NgramScores::addScore(const Hypothesis* node, const Phrase& ngram, float score)
@@ -129,6 +142,33 @@ void LatticeMBRSolution::CalcScore(map<Phrase, float>& finalNgramScores, const v
   m_score += m_mapScore*mapWeight;
 }
 
+void LatticeMBRSolution::CalcScore(const NgramLogScores& finalNgramScores, const vector<float>& thetas, float mapWeight)
+{
+  m_ngramScores.assign(thetas.size()-1, -10000);
+
+  boost::unordered_map < uint64_t, int > counts;
+  extract_ngrams(m_words,counts);
+
+  m_score = thetas[0] * m_words.size();
+
+  for (boost::unordered_map < uint64_t, int >::const_iterator ngrams = counts.begin(); ngrams != counts.end(); ++ngrams) {
+    float ngramPosterior = UNKNGRAMLOGPROB;
+    NgramLogScores::const_iterator ngramPosteriorIt = finalNgramScores.find(ngrams->first);
+    if (ngramPosteriorIt != finalNgramScores.end()) {
+      ngramPosterior = ngramPosteriorIt->second;
+    }
+    size_t ngramSize = ArrayLattice::GetNgramOrder(ngrams->first);
+    m_ngramScores[ngramSize-1] = log_sum(log((float)ngrams->second) + ngramPosterior,m_ngramScores[ngramSize-1]);
+  }
+
+  for (size_t i = 0; i < m_ngramScores.size(); ++i) {
+    m_ngramScores[i] = exp(m_ngramScores[i]);
+    m_score += thetas[i+1] * m_ngramScores[i];
+  }
+
+  m_score += m_mapScore*mapWeight;
+}
+
 
 void pruneLatticeFB(Lattice & connectedHyp, map < const Hypothesis*, set <const Hypothesis* > > & outgoingHyps, map<const Hypothesis*, vector<Edge> >& incomingEdges,
                     const vector< float> & estimatedScores, const Hypothesis* bestHypo, size_t edgeDensity, float scale)
@@ -395,6 +435,32 @@ void calcNgramExpectations(Lattice & connectedHyp, map<const Hypothesis*, vector
 
 }
 
+void buildArrayLattice(Lattice & connectedHyp, map<const Hypothesis*, vector<Edge> >& incomingEdges,
+                       ArrayLattice& lattice)
+{
+  //sorting by coverage puts the nodes in topological order, hyp 0 first
+  sort(connectedHyp.begin(),connectedHyp.end(),ascendingCoverageCmp);
+
+  boost::unordered_map<const Hypothesis*, size_t> nodeIds;
+  for (size_t i = 0; i < connectedHyp.size(); ++i) {
+    const Hypothesis* hyp = connectedHyp[i];
+    nodeIds[hyp] = lattice.AddNode(i > 0 && hyp->GetWordsBitmap().IsComplete());
+  }
+
+  for (size_t i = 1; i < connectedHyp.size(); ++i) {
+    const vector<Edge>& edges = incomingEdges[connectedHyp[i]];
+    for (size_t e = 0; e < edges.size(); ++e) {
+      const Edge& edge = edges[e];
+      boost::unordered_map<const Hypothesis*, size_t>::const_iterator tail = nodeIds.find(edge.GetTailNode());
+      UTIL_THROW_IF2(tail == nodeIds.end(),
+                     "Tail of lattice edge is not in the pruned lattice: " << edge);
+      lattice.AddEdge(tail->second, i, edge.GetScore(), edge.GetWords());
+    }
+  }
+  VERBOSE(2, "Lattice for n-gram statistics: " << lattice.GetNumNodes() << " nodes, "
+          << lattice.GetNumEdges() << " edges" << endl);
+}
+
 const NgramHistory& Edge::GetNgrams(map<const Hypothesis*, vector<Edge> > & incomingEdges)
 {
 
@@ -519,7 +585,18 @@ void getLatticeMBRNBest(const Manager& manager, const TrellisPathList& nBestList
   MBR_Options  const& mbr  = manager.options()->mbr;
   pruneLatticeFB(connectedList, outgoingHyps, incomingEdges, estimatedScores,
                  manager.GetBestHypothesis(), lmbr.pruning_factor, mbr.scale);
-  calcNgramExpectations(connectedList, incomingEdges, ngramPosteriors,true);
+  NgramLogScores hashedPosteriors;
+  Timer timer;
+  timer.start();
+  if (lmbr.legacy) {
+    calcNgramExpectations(connectedList, incomingEdges, ngramPosteriors,true);
+  } else {
+    ArrayLattice lattice;
+    buildArrayLattice(connectedList, incomingEdges, lattice);
+    lattice.CalcNgramPosteriors(bleu_order, hashedPosteriors);
+  }
+  VERBOSE(2, "N-gram posteriors: " << ngramPosteriors.size() + hashedPosteriors.size()
+          << " n-grams in " << timer.get_elapsed_time() << " seconds" << endl);
 
   vector<float> mbrThetas = lmbr.theta;
   float p = lmbr.precision;
@@ -546,7 +623,11 @@ void getLatticeMBRNBest(const Manager& manager, const TrellisPathList& nBestList
   for (iter = nBestList.begin() ; iter != nBestList.end() ; ++iter, ++ctr) {
     const TrellisPath &path = **iter;
     solutions.push_back(LatticeMBRSolution(path,iter==nBestList.begin()));
-    solutions.back().CalcScore(ngramPosteriors, mbrThetas, mapWeight);
+    if (lmbr.legacy) {
+      solutions.back().CalcScore(ngramPosteriors, mbrThetas, mapWeight);
+    } else {
+      solutions.back().CalcScore(hashedPosteriors, mbrThetas, mapWeight);
+    }
     sort(solutions.begin(), solutions.end(), comparator);
     while (solutions.size() > n) {
       solutions.pop_back();
@@ -563,16 +644,89 @@ vector<Word> doLatticeMBR(const Manager& manager, const TrellisPathList& nBestLi
   return solutions.at(0).GetWords();
 }
 
-const TrellisPath doConsensusDecoding(const Manager& manager, const TrellisPathList& nBestList)
+namespace
+{
+
+size_t ngramOrder(const Phrase& ngram)
+{
+  return ngram.GetSize();
+}
+
+size_t ngramOrder(uint64_t ngram)
+{
+  return ArrayLattice::GetNgramOrder(ngram);
+}
+
+//expected length is sum of expected unigram counts
+template <class Expectations>
+float expectedLength(const Expectations& ngramExpectations)
+{
+  float ref_length = 0.0f;
+  for (typename Expectations::const_iterator ref_iter = ngramExpectations.begin();
+       ref_iter != ngramExpectations.end(); ++ref_iter) {
+    if (ngramOrder(ref_iter->first) == 1) {
+      ref_length += exp(ref_iter->second);
+    }
+  }
+  return ref_length;
+}
+
+//BLEU of the translation against the expected n-gram counts
+template <class Counts, class Expectations>
+float consensusScore(const vector<Word>& words, const Expectations& ngramExpectations, float ref_length)
 {
   static const int BLEU_ORDER = 4;
   static const float SMOOTH = 1;
 
+  Counts ngrams;
+  extract_ngrams(words,ngrams);
+
+  vector<float> comps(2*BLEU_ORDER+1);
+  float logbleu = 0.0;
+  float brevity = 0.0;
+  int hyp_length = words.size();
+  for (int i = 0; i < BLEU_ORDER; ++i) {
+    comps[2*i] = 0.0;
+    comps[2*i+1] = max(hyp_length-i,0);
+  }
+
+  for (typename Counts::const_iterator hyp_iter = ngrams.begin();
+       hyp_iter != ngrams.end(); ++hyp_iter) {
+    typename Expectations::const_iterator ref_iter = ngramExpectations.find(hyp_iter->first);
+    if (ref_iter != ngramExpectations.end()) {
+      comps[2*(ngramOrder(hyp_iter->first)-1)] += min(exp(ref_iter->second), (float)(hyp_iter->second));
+    }
+  }
+  comps[comps.size()-1] = ref_length;
+
+  float score = 0.0f;
+  if (comps[0] != 0) {
+    for (int i=0; i<BLEU_ORDER; i++) {
+      if ( i > 0 ) {
+        logbleu += log((float)comps[2*i]+SMOOTH)-log((float)comps[2*i+1]+SMOOTH);
+      } else {
+        logbleu += log((float)comps[2*i])-log((float)comps[2*i+1]);
+      }
+    }
+    logbleu /= BLEU_ORDER;
+    brevity = 1.0-(float)comps[comps.size()-1]/comps[1]; // comps[comps_n-1] is the ref length, comps[1] is the test length
+    if (brevity < 0.0) {
+      logbleu += brevity;
+    }
+    score =  exp(logbleu);
+  }
+  return score;
+}
+
+}
+
+const TrellisPath doConsensusDecoding(const Manager& manager, const TrellisPathList& nBestList)
+{
   //calculate the ngram expectations
-  const StaticData& staticData = StaticData::Instance();
   std::map < int, bool > connected;
   std::vector< const Hypothesis *> connectedList;
   map<Phrase, float> ngramExpectations;
+  NgramLogScores hashedExpectations;
   std::map < const Hypothesis*, set <const Hypothesis*> > outgoingHyps;
   map<const Hypothesis*, vector<Edge> > incomingEdges;
   vector< float> estimatedScores;
@@ -581,20 +735,20 @@ const TrellisPath doConsensusDecoding(const Manager& manager, const TrellisPathL
   MBR_Options  const&  mbr = manager.options()->mbr;
   pruneLatticeFB(connectedList, outgoingHyps, incomingEdges, estimatedScores,
                  manager.GetBestHypothesis(), lmbr.pruning_factor, mbr.scale);
-  calcNgramExpectations(connectedList, incomingEdges, ngramExpectations,false);
-
-  //expected length is sum of expected unigram counts
-  //cerr << "Thread " << pthread_self() <<  " Ngram expectations size: " << ngramExpectations.size() << endl;
-  float ref_length = 0.0f;
-  for (map<Phrase,float>::const_iterator ref_iter = ngramExpectations.begin();
-       ref_iter != ngramExpectations.end(); ++ref_iter) {
-    //cerr << "Ngram: " << ref_iter->first << " score: " <<
-    //    ref_iter->second << endl;
-    if (ref_iter->first.GetSize() == 1) {
-      ref_length += exp(ref_iter->second);
-      //    cerr << "Expected for " << ref_iter->first << " is " << exp(ref_iter->second) << endl;
-    }
+  Timer timer;
+  timer.start();
+  float ref_length;
+  if (lmbr.legacy) {
+    calcNgramExpectations(connectedList, incomingEdges, ngramExpectations,false);
+    ref_length = expectedLength(ngramExpectations);
+  } else {
+    ArrayLattice lattice;
+    buildArrayLattice(connectedList, incomingEdges, lattice);
+    lattice.CalcNgramExpectations(bleu_order, hashedExpectations);
+    ref_length = expectedLength(hashedExpectations);
   }
+  VERBOSE(2, "N-gram expectations: " << ngramExpectations.size() + hashedExpectations.size()
+          << " n-grams in " << timer.get_elapsed_time() << " seconds" << endl);
 
   VERBOSE(2,"REF Length: " << ref_length << endl);
 
@@ -602,79 +756,27 @@ const TrellisPath doConsensusDecoding(const Manager& manager, const TrellisPathL
   TrellisPathList::const_iterator iter;
   TrellisPathList::const_iterator best = nBestList.end();
   float bestScore = -100000;
-  //cerr << "nbest list size: " << nBestList.GetSize() << endl;
   for (iter = nBestList.begin() ; iter != nBestList.end() ; ++iter) {
     const TrellisPath &path = **iter;
     vector<Word> words;
-    map<Phrase,int> ngrams;
     GetOutputWords(path,words);
-    /*for (size_t i = 0; i < words.size(); ++i) {
-        cerr << words[i].GetFactor(0)->GetString() << " ";
-    }
-    cerr << endl;
-    */
-    extract_ngrams(words,ngrams);
-
-    vector<float> comps(2*BLEU_ORDER+1);
-    float logbleu = 0.0;
-    float brevity = 0.0;
-    int hyp_length = words.size();
-    for (int i = 0; i < BLEU_ORDER; ++i) {
-      comps[2*i] = 0.0;
-      comps[2*i+1] = max(hyp_length-i,0);
-    }
-
-    for (map<Phrase,int>::const_iterator hyp_iter = ngrams.begin();
-         hyp_iter != ngrams.end(); ++hyp_iter) {
-      map<Phrase,float>::const_iterator ref_iter = ngramExpectations.find(hyp_iter->first);
-      if (ref_iter != ngramExpectations.end()) {
-        comps[2*(hyp_iter->first.GetSize()-1)] += min(exp(ref_iter->second), (float)(hyp_iter->second));
-      }
 
-    }
-    comps[comps.size()-1] = ref_length;
-    /*for (size_t i = 0; i < comps.size(); ++i) {
-        cerr << comps[i] << " ";
-    }
-    cerr << endl;
-    */
-
-    float score = 0.0f;
-    if (comps[0] != 0) {
-      for (int i=0; i<BLEU_ORDER; i++) {
-        if ( i > 0 ) {
-          logbleu += log((float)comps[2*i]+SMOOTH)-log((float)comps[2*i+1]+SMOOTH);
-        } else {
-          logbleu += log((float)comps[2*i])-log((float)comps[2*i+1]);
-        }
-      }
-      logbleu /= BLEU_ORDER;
-      brevity = 1.0-(float)comps[comps.size()-1]/comps[1]; // comps[comps_n-1] is the ref length, comps[1] is the test length
-      if (brevity < 0.0) {
-        logbleu += brevity;
-      }
-      score =  exp(logbleu);
+    float score;
+    if (lmbr.legacy) {
+      score = consensusScore<map<Phrase,int> >(words, ngramExpectations, ref_length);
+    } else {
+      score = consensusScore<boost::unordered_map<uint64_t,int> >(words, hashedExpectations, ref_length);
     }
 
-    //cerr << "score: " << score << " bestScore: " << bestScore <<  endl;
     if (score > bestScore) {
       bestScore = score;
       best = iter;
       VERBOSE(2,"NEW BEST: " << score << endl);
-      //for (size_t i = 0; i < comps.size(); ++i) {
-      //    cerr << comps[i] << " ";
-      //}
-      //cerr << endl;
     }
   }
 
   assert (best != nBestList.end());
   return **best;
-  //vector<Word> bestWords;
-  //GetOutputWords(**best,bestWords);
-  //return bestWords;
 }
 
 }
-
-
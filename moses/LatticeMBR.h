@@ -13,6 +13,7 @@
 #include <map>
 #include <vector>
 #include <set>
+#include "moses/ArrayLattice.h"
 #include "moses/Hypothesis.h"
 #include "moses/Manager.h"
 #include "moses/TrellisPathList.h"
@@ -119,6 +120,7 @@ public:
 
   /** Initialise ngram scores */
   void CalcScore(std::map<Moses::Phrase, float>& finalNgramScores, const std::vector<float>& thetas, float mapWeight);
+  void CalcScore(const NgramLogScores& finalNgramScores, const std::vector<float>& thetas, float mapWeight);
 
 private:
   std::vector<Moses::Word> m_words;
@@ -141,8 +143,12 @@ void getLatticeMBRNBest(const Moses::Manager& manager, const Moses::TrellisPathL
 //calculate expectated ngram counts, clipping at 1 (ie calculating posteriors) if posteriors==true.
 void calcNgramExpectations(Lattice & connectedHyp, std::map<const Moses::Hypothesis*, std::vector<Edge> >& incomingEdges, std::map<Moses::Phrase,
                            float>& finalNgramScores, bool posteriors);
+//the pruned lattice with dense node ids, for calculating the n-gram statistics with ArrayLattice
+void buildArrayLattice(Lattice & connectedHyp, std::map<const Moses::Hypothesis*, std::vector<Edge> >& incomingEdges, ArrayLattice& lattice);
 void GetOutputFactors(const Moses::TrellisPath &path, std::vector <Moses::Word> &translation);
 void extract_ngrams(const std::vector<Moses::Word >& sentence, std::map < Moses::Phrase, int >  & allngrams);
+//as above, with the n-grams identified by ArrayLattice::ExtendNgram
+void extract_ngrams(const std::vector<Moses::Word >& sentence, boost::unordered_map < uint64_t, int >  & allngrams);
 bool ascendingCoverageCmp(const Moses::Hypothesis* a, const Moses::Hypothesis* b);
 std::vector<Moses::Word> doLatticeMBR(const Moses::Manager& manager, const Moses::TrellisPathList& nBestList);
 const Moses::TrellisPath doConsensusDecoding(const Moses::Manager& manager, const Moses::TrellisPathList& nBestList);
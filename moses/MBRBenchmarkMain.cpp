@@ -0,0 +1,164 @@
+/***********************************************************************
+Moses - factored phrase-based language decoder
+Copyright (C) 2006 University of Edinburgh
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+
+/* Compares exact (pairwise) and linear (expected BLEU) n-best MBR on
+ * synthetic n-best lists: each list holds noisy copies of a reference
+ * sentence, scored by their distance to it plus noise. Reports the time of
+ * both modes, how often they agree, and the BLEU of their choices against
+ * the reference:
+ *
+ *   mbr_benchmark [sentences] [n-best size] [threads]
+ */
+
+#include <iostream>
+#include <vector>
+
+#include <boost/lexical_cast.hpp>
+
+#include "FactorCollection.h"
+#include "mbr.h"
+#include "util/random.hh"
+#include "util/usage.hh"
+
+using namespace std;
+using namespace Moses;
+
+namespace
+{
+
+typedef vector<const Factor*> Sentence;
+
+struct NBestList {
+  Sentence reference;
+  vector<Sentence> translations;
+  vector<float> joint_probs;
+};
+
+NBestList MakeNBestList(const vector<const Factor*> &vocab, size_t size)
+{
+  NBestList ret;
+  const size_t length = 10 + util::rand_excl(30);
+  for (size_t i = 0; i < length; ++i) {
+    ret.reference.push_back(vocab[util::rand_excl(vocab.size())]);
+  }
+  for (size_t n = 0; n < size; ++n) {
+    Sentence translation;
+    size_t errors = 0;
+    for (size_t i = 0; i < length; ++i) {
+      switch (util::rand_excl(12)) {
+      case 0: // substitution
+        translation.push_back(vocab[util::rand_excl(vocab.size())]);
+        ++errors;
+        break;
+      case 1: // deletion
+        ++errors;
+        break;
+      case 2: // insertion
+        translation.push_back(vocab[util::rand_excl(vocab.size())]);
+        translation.push_back(ret.reference[i]);
+        ++errors;
+        break;
+      default:
+        translation.push_back(ret.reference[i]);
+      }
+    }
+    ret.translations.push_back(translation);
+    // the model prefers fewer errors, but not reliably
+    ret.joint_probs.push_back(exp(-0.5 * errors + 2.0 * util::rand_excl(1000) / 1000));
+  }
+  return ret;
+}
+
+float SentenceBleu(const Sentence &reference, const Sentence &translation)
+{
+  vector<MBRNgramStats> stats(2);
+  extract_ngrams(reference, stats[0]);
+  extract_ngrams(translation, stats[1]);
+  return calculate_score(stats, 0, 1);
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+  const size_t numSentences = argc > 1 ? boost::lexical_cast<size_t>(argv[1]) : 100;
+  const size_t nbestSize = argc > 2 ? boost::lexical_cast<size_t>(argv[2]) : 1000;
+  const size_t numThreads = argc > 3 ? boost::lexical_cast<size_t>(argv[3]) : 4;
+
+  vector<const Factor*> vocab;
+  for (size_t i = 0; i < 5000; ++i) {
+    vocab.push_back(FactorCollection::Instance().AddFactor("w" + boost::lexical_cast<string>(i)));
+  }
+
+  util::rand_init(1);
+  vector<NBestList> lists;
+  for (size_t s = 0; s < numSentences; ++s) {
+    lists.push_back(MakeNBestList(vocab, nbestSize));
+  }
+
+  MBR_Options exact, threaded, linear;
+  threaded.threads = numThreads;
+  linear.linear = true;
+
+  vector<size_t> exactChoice, threadedChoice, linearChoice;
+  double start = util::WallTime();
+  for (size_t s = 0; s < numSentences; ++s) {
+    exactChoice.push_back(doMBR(lists[s].translations, lists[s].joint_probs, exact));
+  }
+  const double exactTime = util::WallTime() - start;
+
+  start = util::WallTime();
+  for (size_t s = 0; s < numSentences; ++s) {
+    threadedChoice.push_back(doMBR(lists[s].translations, lists[s].joint_probs, threaded));
+  }
+  const double threadedTime = util::WallTime() - start;
+
+  start = util::WallTime();
+  for (size_t s = 0; s < numSentences; ++s) {
+    linearChoice.push_back(doMBR(lists[s].translations, lists[s].joint_probs, linear));
+  }
+  const double linearTime = util::WallTime() - start;
+
+  size_t agree = 0, threadedAgree = 0;
+  float mapBleu = 0, exactBleu = 0, linearBleu = 0;
+  for (size_t s = 0; s < numSentences; ++s) {
+    const NBestList &list = lists[s];
+    size_t best = 0;
+    for (size_t n = 1; n < nbestSize; ++n) {
+      if (list.joint_probs[n] > list.joint_probs[best]) best = n;
+    }
+    mapBleu += SentenceBleu(list.reference, list.translations[best]);
+    exactBleu += SentenceBleu(list.reference, list.translations[exactChoice[s]]);
+    linearBleu += SentenceBleu(list.reference, list.translations[linearChoice[s]]);
+    agree += exactChoice[s] == linearChoice[s];
+    threadedAgree += exactChoice[s] == threadedChoice[s];
+  }
+
+  cerr << "Sentences: " << numSentences << " n-best size: " << nbestSize << endl;
+  cerr << "Exact MBR: " << exactTime << " s, " << numThreads << " threads: "
+       << threadedTime << " s (same choice " << threadedAgree << "/" << numSentences << ")" << endl;
+  cerr << "Linear MBR: " << linearTime << " s (same choice as exact "
+       << agree << "/" << numSentences << ")" << endl;
+  cerr << "Mean sentence BLEU: MAP " << mapBleu / numSentences
+       << " exact MBR " << exactBleu / numSentences
+       << " linear MBR " << linearBleu / numSentences << endl;
+
+  util::PrintUsage(cerr);
+  return 0;
+}
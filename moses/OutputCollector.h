@@ -22,7 +22,10 @@
 #define moses_OutputCollector_h
 
 #ifdef WITH_THREADS
+#include <boost/scoped_ptr.hpp>
+#include <boost/thread/condition_variable.hpp>
 #include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
 #endif
 
 #ifdef BOOST_HAS_PTHREADS
@@ -49,10 +52,12 @@ public:
     , m_outStream(outStream)
     , m_debugStream(debugStream)
     , m_isHoldingOutputStream(false)
-    , m_isHoldingDebugStream(false) {}
+    , m_isHoldingDebugStream(false)
+    , m_stopping(false) {}
 
   OutputCollector(std::string xout, std::string xerr = "")
-    : m_nextOutput(0) {
+    : m_nextOutput(0)
+    , m_stopping(false) {
     // TO DO open magic streams instead of regular ofstreams! [UG]
 
     if (xout == "/dev/stderr") {
@@ -83,6 +88,7 @@ public:
   }
 
   ~OutputCollector() {
+    StopWriter();
     if (m_isHoldingOutputStream)
       delete m_outStream;
     if (m_isHoldingDebugStream)
@@ -101,12 +107,52 @@ public:
     return (m_outStream == &std::cout);
   }
 
+  /**
+    * Write the output from a dedicated thread from now on. The outputs that
+    * are ready are written together, in order, with one large write, so the
+    * translating threads only wait to hand their output over.
+    * Without threads, output is written directly.
+    **/
+  void StartWriter() {
+#ifdef WITH_THREADS
+    boost::mutex::scoped_lock lock(m_mutex);
+    if (!m_writer) {
+      m_writer.reset(new boost::thread(&OutputCollector::RunWriter, this));
+    }
+#endif
+  }
+
+  /**
+    * Write all the output that is ready and stop the writer thread, if any.
+    **/
+  void StopWriter() {
+#ifdef WITH_THREADS
+    {
+      boost::mutex::scoped_lock lock(m_mutex);
+      if (!m_writer) return;
+      m_stopping = true;
+    }
+    m_ready.notify_one();
+    m_writer->join();
+    m_writer.reset();
+    m_stopping = false;
+#endif
+  }
+
   /**
     * Write or cache the output, as appropriate.
     **/
   void Write(int sourceId,const std::string& output,const std::string& debug="") {
 #ifdef WITH_THREADS
     boost::mutex::scoped_lock lock(m_mutex);
+    if (m_writer) {
+      m_outputs[sourceId] = output;
+      m_debugs[sourceId] = debug;
+      if (sourceId == m_nextOutput) {
+        m_ready.notify_one();
+      }
+      return;
+    }
 #endif
     if (sourceId == m_nextOutput) {
       //This is the one we were expecting
@@ -141,8 +187,43 @@ private:
   std::ostream* m_debugStream;
   bool m_isHoldingOutputStream;
   bool m_isHoldingDebugStream;
+  bool m_stopping;
 #ifdef WITH_THREADS
   boost::mutex m_mutex;
+  boost::condition_variable m_ready;
+  boost::scoped_ptr<boost::thread> m_writer;
+
+  void RunWriter() {
+    std::string output, debug;
+    for (;;) {
+      {
+        boost::mutex::scoped_lock lock(m_mutex);
+        while (!m_stopping && m_outputs.find(m_nextOutput) == m_outputs.end()) {
+          m_ready.wait(lock);
+        }
+        std::map<int,std::string>::iterator iter;
+        while ((iter = m_outputs.find(m_nextOutput)) != m_outputs.end()) {
+          output += iter->second;
+          m_outputs.erase(iter);
+          std::map<int,std::string>::iterator debugIter = m_debugs.find(m_nextOutput);
+          if (debugIter != m_debugs.end()) {
+            debug += debugIter->second;
+            m_debugs.erase(debugIter);
+          }
+          ++m_nextOutput;
+        }
+        if (output.empty() && debug.empty() && m_stopping) {
+          return;
+        }
+      }
+      m_outStream->write(output.data(), output.size());
+      m_outStream->flush();
+      m_debugStream->write(debug.data(), debug.size());
+      m_debugStream->flush();
+      output.clear();
+      debug.clear();
+    }
+  }
 #endif
 
 public:
@@ -54,6 +54,7 @@ Parameter::Parameter()
   po::options_description main_opts("Main Options");
   AddParam(main_opts,"config", "f", "location of the configuration file");
   AddParam(main_opts,"input-file", "i", "location of the input file to be translated");
+  AddParam(main_opts,"streaming-io", "read text input with mmap or large block reads (gzip supported) and write output from a dedicated thread");
 
   AddParam(main_opts,"verbose", "v", "verbosity level of the logging");
   AddParam(main_opts,"version", "show version of Moses and libraries used");
@@ -86,6 +87,7 @@ Parameter::Parameter()
   AddParam(search_opts,"early-discarding-threshold", "edt", "threshold for constructing hypotheses based on estimate cost");
   AddParam(search_opts,"stack", "s", "maximum stack size for histogram pruning. 0 = unlimited stack size");
   AddParam(search_opts,"stack-diversity", "sd", "minimum number of hypothesis of each coverage in stack (default 0)");
+  AddParam(search_opts,"decoding-deadline", "wall-clock seconds per sentence after which the search degrades to smaller stacks, smaller pop limits and finally monotone decoding, always completing the translation (0 = no deadline, default)");
 
   // feature weight-related options
   AddParam(search_opts,"weight-file", "wf", "feature weights file. Do *not* put weights for 'core' features in here - they go in moses.ini");
@@ -100,6 +102,7 @@ Parameter::Parameter()
 
   // phrase table limitations:
   AddParam(search_opts,"max-partial-trans-opt", "maximum number of partial translation options per input span (during mapping steps)");
+  AddParam(search_opts,"lazy-decode-steps", "combine the outputs of factored decode steps best-first (cube pruning), stopping at the option limit and translation-option-threshold");
   AddParam(search_opts,"max-trans-opt-per-coverage", "maximum number of translation options per input span (after applying mapping steps)");
   AddParam(search_opts,"max-phrase-length", "maximum phrase length (default 20)");
   AddParam(search_opts,"translation-option-threshold", "tot", "threshold for translation options relative to best for input phrase");
@@ -108,6 +111,7 @@ Parameter::Parameter()
   AddParam(search_opts,"disable-discarding", "dd", "disable hypothesis discarding"); // ??? memory management? UG
   AddParam(search_opts,"phrase-drop-allowed", "da", "if present, allow dropping of source words"); //da = drop any (word); see -du for comparison
   AddParam(search_opts,"threads","th", "number of threads to use in decoding (defaults to single-threaded)");
+  AddParam(search_opts,"load-threads", "number of threads used to load feature functions and phrase tables at start-up (defaults to sequential loading; 'all' = one per core)");
 
   // distortion options
   po::options_description disto_opts("Distortion options");
@@ -130,6 +134,8 @@ Parameter::Parameter()
   AddParam(mbr_opts,"minimum-bayes-risk", "mbr", "use miminum Bayes risk to determine best translation");
   AddParam(mbr_opts,"mbr-size", "number of translation candidates considered in MBR decoding (default 200)");
   AddParam(mbr_opts,"mbr-scale", "scaling factor to convert log linear score probability in MBR decoding (default 1.0)");
+  AddParam(mbr_opts,"mbr-linear", "MBR decoding against the expected n-gram counts of the candidates (linear time) instead of pairwise sentence BLEU");
+  AddParam(mbr_opts,"mbr-threads", "number of threads for pairwise MBR decoding (default 1)");
 
   AddParam(mbr_opts,"lminimum-bayes-risk", "lmbr", "use lattice miminum Bayes risk to determine best translation");
   AddParam(mbr_opts,"consensus-decoding", "con", "use consensus decoding (De Nero et. al. 2009)");
@@ -141,6 +147,7 @@ Parameter::Parameter()
   AddParam(mbr_opts,"lmbr-map-weight", "weight given to map solution when doing lattice MBR (default 0)");
   AddParam(mbr_opts,"lmbr-pruning-factor", "average number of nodes/word wanted in pruned lattice");
   AddParam(mbr_opts,"lattice-hypo-set", "to use lattice as hypo set during lattice MBR");
+  AddParam(mbr_opts,"lmbr-legacy-lattice", "compute the n-gram posteriors of lattice MBR and consensus decoding with the original phrase-keyed lattice traversal");
 
   ///////////////////////////////////////////////////////////////////////////////////////
   // OOV handling options
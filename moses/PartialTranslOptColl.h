@@ -28,6 +28,7 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #include "Util.h"
 #include "StaticData.h"
 #include "FactorTypeSet.h"
+#include "ScratchArena.h"
 
 namespace Moses
 {
@@ -66,6 +67,14 @@ public:
 
   PartialTranslOptColl(size_t const maxSize);
 
+  //! allocated from the scratch arena of the sentence, see ScratchArena
+  static void *operator new(size_t size) {
+    return ScratchArena::Allocate(size);
+  }
+  static void operator delete(void *ptr) {
+    ScratchArena::Free(ptr);
+  }
+
   /** destructor, cleans out list */
   ~PartialTranslOptColl() {
     RemoveAllInColl( m_list );
@@ -85,6 +94,11 @@ public:
     m_list.clear();
   }
 
+  //! maximum number of translation options kept after pruning
+  size_t GetMaxSize() const {
+    return m_maxSize;
+  }
+
   /** return number of pruned partial hypotheses */
   size_t GetPrunedCount() {
     return m_totalPruned;
@@ -0,0 +1,140 @@
+// -*- mode: c++; indent-tabs-mode: nil; tab-width: 2 -*-
+#include "ScratchArena.h"
+
+#include <cstdlib>
+#include <new>
+
+#ifdef WITH_THREADS
+#include <boost/thread/tss.hpp>
+#endif
+
+namespace Moses
+{
+
+namespace
+{
+
+// Precedes every object, keeps it aligned as malloc would
+union Header {
+  struct {
+    ScratchArena *arena;
+    std::size_t size;
+  } owner;
+  long double align;
+};
+
+#ifdef WITH_THREADS
+// the thread doesn't own its active arena
+void NoCleanup(ScratchArena *) {}
+boost::thread_specific_ptr<ScratchArena> s_current(&NoCleanup);
+#else
+ScratchArena *s_current = NULL;
+#endif
+
+void SetCurrent(ScratchArena *arena)
+{
+#ifdef WITH_THREADS
+  s_current.reset(arena);
+#else
+  s_current = arena;
+#endif
+}
+
+}
+
+ScratchArena::ScratchArena()
+  : m_allocations(0)
+  , m_recycled(0)
+  , m_bytes(0)
+  , m_live(0)
+{}
+
+ScratchArena::~ScratchArena()
+{}
+
+ScratchArena::Scope::Scope(ScratchArena &arena)
+  : m_previous(Current())
+{
+  SetCurrent(&arena);
+}
+
+ScratchArena::Scope::~Scope()
+{
+  SetCurrent(m_previous);
+}
+
+ScratchArena *ScratchArena::Current()
+{
+#ifdef WITH_THREADS
+  return s_current.get();
+#else
+  return s_current;
+#endif
+}
+
+void *ScratchArena::Allocate(std::size_t size)
+{
+  // round up, so that recycled objects of similar classes share a list
+  size = (size + sizeof(Header) - 1) / sizeof(Header) * sizeof(Header) + sizeof(Header);
+
+  ScratchArena *arena = Current();
+  Header *header;
+  if (arena) {
+    header = static_cast<Header*>(arena->AllocateHere(size));
+  } else {
+    header = static_cast<Header*>(std::malloc(size));
+    if (header == NULL) {
+      throw std::bad_alloc();
+    }
+  }
+  header->owner.arena = arena;
+  header->owner.size = size;
+  return header + 1;
+}
+
+void ScratchArena::Free(void *ptr)
+{
+  if (ptr == NULL) {
+    return;
+  }
+  Header *header = static_cast<Header*>(ptr) - 1;
+  if (header->owner.arena) {
+    header->owner.arena->FreeHere(header, header->owner.size);
+  } else {
+    std::free(header);
+  }
+}
+
+void *ScratchArena::AllocateHere(std::size_t size)
+{
+  ++m_allocations;
+  ++m_live;
+  for (std::size_t i = 0; i < m_freeLists.size(); ++i) {
+    FreeList &freeList = m_freeLists[i];
+    if (freeList.first == size && freeList.second) {
+      void *block = freeList.second;
+      freeList.second = *static_cast<void**>(block);
+      ++m_recycled;
+      return block;
+    }
+  }
+  m_bytes += size;
+  return m_pool.Allocate(size);
+}
+
+void ScratchArena::FreeHere(void *block, std::size_t size)
+{
+  --m_live;
+  for (std::size_t i = 0; i < m_freeLists.size(); ++i) {
+    FreeList &freeList = m_freeLists[i];
+    if (freeList.first == size) {
+      *static_cast<void**>(block) = freeList.second;
+      freeList.second = block;
+      return;
+    }
+  }
+  *static_cast<void**>(block) = NULL;
+  m_freeLists.push_back(FreeList(size, block));
+}
+
+}
@@ -0,0 +1,83 @@
+// -*- mode: c++; indent-tabs-mode: nil; tab-width: 2 -*-
+#pragma once
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+#include "util/pool.hh"
+
+namespace Moses
+{
+
+/** Memory for the short lived objects of one sentence, such as translation
+ *  options and input paths, released in one go when the sentence is done.
+ *
+ *  A class opts in by defining its operator new and delete with Allocate()
+ *  and Free(). Objects created while an arena is active on the current
+ *  thread (see Scope) come from that arena, others from the heap. Deleted
+ *  objects are recycled by later allocations of the same size. All objects
+ *  of an arena must be deleted before the arena itself.
+ *
+ *  An arena is not thread safe: it is meant to be used by the thread that
+ *  translates the sentence.
+ */
+class ScratchArena
+{
+public:
+  ScratchArena();
+  ~ScratchArena();
+
+  //! Makes the arena the active one of the current thread while in scope
+  class Scope
+  {
+  public:
+    explicit Scope(ScratchArena &arena);
+    ~Scope();
+  private:
+    ScratchArena *m_previous;
+  };
+
+  static void *Allocate(std::size_t size);
+  static void Free(void *ptr);
+
+  //! The active arena of the current thread, NULL if none
+  static ScratchArena *Current();
+
+  //! Number of objects allocated from the arena
+  std::size_t GetAllocations() const {
+    return m_allocations;
+  }
+
+  //! Number of allocations served by recycling a deleted object
+  std::size_t GetRecycled() const {
+    return m_recycled;
+  }
+
+  //! Memory taken from the pool, in bytes
+  std::size_t GetBytes() const {
+    return m_bytes;
+  }
+
+  //! Number of objects not deleted yet
+  std::size_t GetLive() const {
+    return m_live;
+  }
+
+private:
+  // singly linked list of deleted objects of one size
+  typedef std::pair<std::size_t, void*> FreeList;
+
+  void *AllocateHere(std::size_t size);
+  void FreeHere(void *block, std::size_t size);
+
+  util::Pool m_pool;
+  std::vector<FreeList> m_freeLists;
+  std::size_t m_allocations, m_recycled, m_bytes, m_live;
+
+  // no copying
+  ScratchArena(const ScratchArena &);
+  ScratchArena &operator=(const ScratchArena &);
+};
+
+}
@@ -0,0 +1,103 @@
+/***********************************************************************
+Moses - factored phrase-based language decoder
+Copyright (C) 2006 University of Edinburgh
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+#include <boost/test/unit_test.hpp>
+
+#include "ScratchArena.h"
+
+using namespace Moses;
+using namespace std;
+
+namespace
+{
+
+struct Object {
+  static void *operator new(size_t size) {
+    return ScratchArena::Allocate(size);
+  }
+  static void operator delete(void *ptr) {
+    ScratchArena::Free(ptr);
+  }
+
+  explicit Object(int value) : value(value), padding(0) {}
+  int value;
+  double padding;
+};
+
+}
+
+BOOST_AUTO_TEST_SUITE(scratch_arena)
+
+BOOST_AUTO_TEST_CASE(scope)
+{
+  BOOST_CHECK(ScratchArena::Current() == NULL);
+  ScratchArena outer, inner;
+  {
+    ScratchArena::Scope outerScope(outer);
+    BOOST_CHECK_EQUAL(ScratchArena::Current(), &outer);
+    {
+      ScratchArena::Scope innerScope(inner);
+      BOOST_CHECK_EQUAL(ScratchArena::Current(), &inner);
+    }
+    BOOST_CHECK_EQUAL(ScratchArena::Current(), &outer);
+  }
+  BOOST_CHECK(ScratchArena::Current() == NULL);
+}
+
+BOOST_AUTO_TEST_CASE(allocate_and_recycle)
+{
+  ScratchArena arena;
+  Object *heap = new Object(0);
+
+  vector<Object*> objects;
+  {
+    ScratchArena::Scope scope(arena);
+    for (int i = 0; i < 100; ++i) {
+      objects.push_back(new Object(i));
+    }
+    BOOST_CHECK_EQUAL(arena.GetAllocations(), 100);
+    BOOST_CHECK_EQUAL(arena.GetLive(), 100);
+    for (int i = 0; i < 100; ++i) {
+      BOOST_CHECK_EQUAL(objects[i]->value, i);
+      BOOST_CHECK_EQUAL(reinterpret_cast<size_t>(objects[i]) % sizeof(double), 0);
+    }
+
+    // deleted objects are reused
+    const size_t bytes = arena.GetBytes();
+    for (int i = 0; i < 50; ++i) {
+      delete objects[i];
+    }
+    for (int i = 0; i < 50; ++i) {
+      objects[i] = new Object(-i);
+    }
+    BOOST_CHECK_EQUAL(arena.GetRecycled(), 50);
+    BOOST_CHECK_EQUAL(arena.GetBytes(), bytes);
+
+    // objects from the heap can be deleted while the arena is active
+    delete heap;
+  }
+  BOOST_CHECK_EQUAL(arena.GetAllocations(), 150);
+
+  // and arena objects after it is not active any more
+  for (size_t i = 0; i < objects.size(); ++i) {
+    delete objects[i];
+  }
+  BOOST_CHECK_EQUAL(arena.GetLive(), 0);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
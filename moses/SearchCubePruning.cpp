@@ -95,6 +95,8 @@ void SearchCubePruning::Decode()
   VERBOSE(2,"Max Phrase length is "
           << m_manager.options()->search.max_phrase_length << std::endl);
 
+  Deadline &deadline = m_manager.GetDeadline();
+
   // go through each stack
   size_t stackNo = 1;
   int timelimit = m_options.search.timeout;
@@ -130,7 +132,8 @@ void SearchCubePruning::Decode()
     }
 
     // main search loop, pop k best hyps
-    for (size_t numpops = 1; numpops <= PopLimit && !BCQueue.empty(); numpops++) {
+    // (the pop limit shrinks when the deadline gets close)
+    for (size_t numpops = 1; numpops <= deadline.Limit(PopLimit) && !BCQueue.empty(); numpops++) {
       // get currently best hypothesis in queue
       m_manager.GetSentenceStats().StartTimeManageCubes();
       BitmapContainer *bc = BCQueue.top();
@@ -152,6 +155,7 @@ void SearchCubePruning::Decode()
       if (!bc->Empty())
         BCQueue.push(bc);
       m_manager.GetSentenceStats().StopTimeManageCubes();
+      deadline.Update();
     }
 
     // ensure diversity, a minimum number of inserted hyps for each bitmap container;
@@ -173,7 +177,7 @@ void SearchCubePruning::Decode()
     IFVERBOSE(2) {
       m_manager.GetSentenceStats().StartTimeStack();
     }
-    sourceHypoColl.PruneToSize(m_options.search.stack_size);
+    sourceHypoColl.PruneToSize(deadline.Limit(m_options.search.stack_size));
     VERBOSE(3,std::endl);
     sourceHypoColl.CleanupArcList();
     IFVERBOSE(2) {
@@ -238,6 +242,10 @@ void SearchCubePruning::CreateForwardTodos(HypothesisStackCubePruning &stack)
           CreateForwardTodos(bitmap, applyRange, bitmapContainer);
         }
       }
+
+      // past the deadline only the first gap is filled (monotone decoding)
+      if (m_manager.GetDeadline().IsMonotone())
+        break;
     }
   }
 }
@@ -52,11 +52,26 @@ ProcessOneStack(HypothesisStack* hstack)
   // the stack is pruned before processing (lazy pruning):
   VERBOSE(3,"processing hypothesis from next stack");
   IFVERBOSE(2) stats.StartTimeStack();
-  sourceHypoColl.PruneToSize(m_options.search.stack_size);
+  Deadline &deadline = m_manager.GetDeadline();
+  deadline.Update();
+  sourceHypoColl.PruneToSize(deadline.Limit(m_options.search.stack_size));
   VERBOSE(3,std::endl);
   sourceHypoColl.CleanupArcList();
   IFVERBOSE(2)  stats.StopTimeStack();
 
+  if (deadline.IsSet()) {
+    // expand the best hypotheses first, so that the ones dropped when the
+    // deadline tightens the stack size are the worst ones
+    std::vector<const Hypothesis*> hypos = sourceHypoColl.GetSortedList();
+    for (size_t i = 0; i < hypos.size(); ++i) {
+      const size_t limit = deadline.Limit(m_options.search.stack_size);
+      if (limit && i >= limit) break;
+      ProcessOneHypothesis(*hypos[i]);
+      deadline.Update();
+    }
+    return true;
+  }
+
   // go through each hypothesis on the stack and try to expand it
   // BOOST_FOREACH(Hypothesis* h, sourceHypoColl)
   HypothesisStackNormal::const_iterator h;
@@ -102,6 +117,9 @@ ProcessOneHypothesis(const Hypothesis &hypothesis)
   const Bitmap &hypoBitmap = hypothesis.GetWordsBitmap();
   const size_t hypoFirstGapPos = hypoBitmap.GetFirstGapPos();
   size_t const sourceSize = m_source.GetSize();
+  // past the deadline only the first gap is filled (monotone decoding)
+  size_t const lastStartPos = m_manager.GetDeadline().IsMonotone()
+                              ? hypoFirstGapPos + 1 : sourceSize;
 
   ReorderingConstraint const&
   ReoConstraint = m_source.GetReorderingConstraint();
@@ -109,7 +127,7 @@ ProcessOneHypothesis(const Hypothesis &hypothesis)
   // no limit of reordering: only check for overlap
   if (m_options.reordering.max_distortion < 0) {
 
-    for (size_t startPos = hypoFirstGapPos ; startPos < sourceSize ; ++startPos) {
+    for (size_t startPos = hypoFirstGapPos ; startPos < lastStartPos ; ++startPos) {
       TranslationOptionList const* tol;
       size_t endPos = startPos;
       for (tol = m_transOptColl.GetTranslationOptionList(startPos, endPos);
@@ -131,7 +149,7 @@ ProcessOneHypothesis(const Hypothesis &hypothesis)
   // There are reordering limits. Make sure they are not violated.
 
   Range prevRange = hypothesis.GetCurrSourceWordsRange();
-  for (size_t startPos = hypoFirstGapPos ; startPos < sourceSize ; ++startPos) {
+  for (size_t startPos = hypoFirstGapPos ; startPos < lastStartPos ; ++startPos) {
 
     // don't bother expanding phrases if the first position is already taken
     if(hypoBitmap.GetValue(startPos)) continue;
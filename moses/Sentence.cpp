@@ -185,7 +185,15 @@ init(string line)
   vector<pair<size_t, string> >placeholders;
   aux_interpret_xml(line, xmlWalls, placeholders);
 
-  Phrase::CreateFromString(Input, m_options->input.factor_order, line, NULL);
+  aux_init_words(line, xmlWalls, placeholders);
+}
+
+void
+Sentence::
+aux_init_words(StringPiece const& text, std::vector<size_t> const& xmlWalls,
+               std::vector<std::pair<size_t, std::string> > const& placeholders)
+{
+  Phrase::CreateFromString(Input, m_options->input.factor_order, text, NULL);
 
   ProcessPlaceholders(placeholders);
 
@@ -223,6 +231,26 @@ init(string line)
 
 }
 
+int
+Sentence::
+Read(StringPiece const& line)
+{
+  // SGML, dlt, passthrough and XML markup all need brackets
+  std::string const& open = m_options->input.xml_brackets.first;
+  if (m_options->input.continue_partial_translation
+      || line.find('<') != StringPiece::npos
+      || (open.size() && line.find(open[0]) != StringPiece::npos)) {
+    init(line.as_string());
+    return 1;
+  }
+
+  m_frontSpanCoveredLength = 0;
+  m_sourceCompleted.resize(0);
+  aux_init_words(line, std::vector<size_t>(),
+                 std::vector<std::pair<size_t, std::string> >());
+  return 1;
+}
+
 int
 Sentence::
 Read(std::istream& in)
@@ -98,6 +98,10 @@ public:
 
   virtual int
   Read(std::istream& in);
+
+  //! initialize from one line of input, tokenized in place if there is no markup
+  int
+  Read(StringPiece const& line);
   // , const std::vector<FactorType>& factorOrder, AllOptions const& opts);
 
   void Print(std::ostream& out) const;
@@ -143,6 +147,10 @@ private:
   void
   aux_init_partial_translation(std::string& line);
 
+  void
+  aux_init_words(StringPiece const& text, std::vector<size_t> const& xmlWalls,
+                 std::vector<std::pair<size_t, std::string> > const& placeholders);
+
 };
 
 
@@ -46,6 +46,8 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #include "DecodeGraph.h"
 #include "TranslationModel/PhraseDictionary.h"
 #include "TranslationModel/PhraseDictionaryTreeAdaptor.h"
+#include "ThreadPool.h"
+#include "util/usage.hh"
 
 #ifdef WITH_THREADS
 #include <boost/thread.hpp>
@@ -171,6 +173,24 @@ StaticData
 #endif
     }
   }
+
+  m_loadThreadCount = 1;
+  params = m_parameter->GetParam("load-threads");
+  if (params && params->size()) {
+#ifdef WITH_THREADS
+    if (params->at(0) == "all") {
+      m_loadThreadCount = std::max(1U, boost::thread::hardware_concurrency());
+    } else {
+      m_loadThreadCount = Scan<int>(params->at(0));
+      if (m_loadThreadCount < 1) {
+        std::cerr << "Specify at least one load thread.";
+        return false;
+      }
+    }
+#else
+    std::cerr << "Warning: -load-threads ignored, moses not built with thread support" << std::endl;
+#endif
+  }
   return true;
 }
 
@@ -592,9 +612,63 @@ CleanUpAfterSentenceProcessing(ttasksptr const& ttask) const
   }
 }
 
+namespace
+{
+/** Loads one feature function and records its wall time and the change in
+ *  resident memory. With several load threads running, the memory delta
+ *  also includes whatever the other threads allocated in the meantime.
+ */
+class FeatureLoadTask : public Task
+{
+public:
+  FeatureLoadTask(FeatureFunction *ff, AllOptions::ptr const& opts)
+    : m_ff(ff), m_opts(opts), m_seconds(0), m_rssDelta(0) {}
+
+  void Load() {
+    VERBOSE(1, "Loading " << m_ff->GetScoreProducerDescription() << endl);
+    uint64_t rssBefore = util::RSSCurrent();
+    Timer timer;
+    timer.start();
+    m_ff->Load(m_opts);
+    m_seconds = timer.get_elapsed_time();
+    m_rssDelta = (int64_t) util::RSSCurrent() - (int64_t) rssBefore;
+  }
+
+  //! pool entry point; exceptions must not escape a worker thread
+  void Run() {
+    try {
+      Load();
+    } catch (const std::exception &e) {
+      m_error = e.what();
+    }
+  }
+
+  void Report() const {
+    VERBOSE(1, "Loaded " << m_ff->GetScoreProducerDescription()
+            << " in " << m_seconds << " seconds, resident memory "
+            << (m_rssDelta >= 0 ? "+" : "") << (m_rssDelta >> 20) << " MB" << endl);
+  }
+
+  const FeatureFunction &GetFeature() const {
+    return *m_ff;
+  }
+  const std::string &GetError() const {
+    return m_error;
+  }
+
+private:
+  FeatureFunction *m_ff;
+  AllOptions::ptr m_opts;
+  double m_seconds;
+  int64_t m_rssDelta;
+  std::string m_error;
+};
+}
+
 void StaticData::LoadFeatureFunctions()
 {
   const std::vector<FeatureFunction*> &ffs = FeatureFunction::GetFeatureFunctions();
+  std::vector<FeatureFunction*> toLoad;
   std::vector<FeatureFunction*>::const_iterator iter;
   for (iter = ffs.begin(); iter != ffs.end(); ++iter) {
     FeatureFunction *ff = *iter;
@@ -609,21 +683,49 @@ void StaticData::LoadFeatureFunctions()
     }
 
     if (doLoad) {
-      VERBOSE(1, "Loading " << ff->GetScoreProducerDescription() << endl);
-      ff->Load(options());
+      toLoad.push_back(ff);
     }
   }
+  LoadFeatureFunctions(toLoad);
 
+  // phrase tables may score their rules with the features above,
+  // so they are only loaded once all other features are ready
   const std::vector<PhraseDictionary*> &pts = PhraseDictionary::GetColl();
-  for (size_t i = 0; i < pts.size(); ++i) {
-    PhraseDictionary *pt = pts[i];
-    VERBOSE(1, "Loading " << pt->GetScoreProducerDescription() << endl);
-    pt->Load(options());
-  }
+  LoadFeatureFunctions(std::vector<FeatureFunction*>(pts.begin(), pts.end()));
 
   CheckLEGACYPT();
 }
 
+void StaticData::LoadFeatureFunctions(const std::vector<FeatureFunction*> &ffs)
+{
+  std::vector<boost::shared_ptr<FeatureLoadTask> > tasks;
+  for (size_t i = 0; i < ffs.size(); ++i) {
+    tasks.push_back(boost::shared_ptr<FeatureLoadTask>(new FeatureLoadTask(ffs[i], options())));
+  }
+
+#ifdef WITH_THREADS
+  if (m_loadThreadCount > 1 && tasks.size() > 1) {
+    ThreadPool pool(std::min((size_t) m_loadThreadCount, tasks.size()));
+    for (size_t i = 0; i < tasks.size(); ++i) {
+      pool.Submit(tasks[i]);
+    }
+    pool.Stop(true);
+  } else
+#endif
+  {
+    for (size_t i = 0; i < tasks.size(); ++i) {
+      tasks[i]->Load();
+    }
+  }
+
+  for (size_t i = 0; i < tasks.size(); ++i) {
+    UTIL_THROW_IF2(!tasks[i]->GetError().empty(),
+                   "Error loading " << tasks[i]->GetFeature().GetScoreProducerDescription()
+                   << ": " << tasks[i]->GetError());
+    tasks[i]->Report();
+  }
+}
+
 bool StaticData::CheckWeights() const
 {
   set<string> weightNames = m_parameter->GetWeightNames();
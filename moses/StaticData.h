@@ -53,6 +53,7 @@ namespace Moses
 class InputType;
 class DecodeGraph;
 class DecodeStep;
+class FeatureFunction;
 
 class DynamicCacheBasedLanguageModel;
 class PhraseDictionaryDynamicCacheBased;
@@ -111,6 +112,7 @@ protected:
   UnknownLHSList m_unknownLHS;
 
   int m_threadCount;
+  int m_loadThreadCount; //! threads used by LoadFeatureFunctions (1 = sequential)
   // long m_startTranslationId;
 
   // alternate weight settings
@@ -347,6 +349,7 @@ public:
   void CleanUpAfterSentenceProcessing(ttasksptr const& ttask) const;
 
   void LoadFeatureFunctions();
+  void LoadFeatureFunctions(const std::vector<FeatureFunction*> &ffs);
   bool CheckWeights() const;
   void LoadSparseWeightsFromConfig();
   bool LoadWeightSettings();
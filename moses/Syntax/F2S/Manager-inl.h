@@ -125,7 +125,7 @@ void Manager<RuleMatcher>::Decode()
     CubeQueue cubeQueue(bundles.Begin(), bundles.End());
     std::size_t count = 0;
     std::vector<SHyperedge*> buffer;
-    while (count < popLimit && !cubeQueue.IsEmpty()) {
+    while (count < this->GetDeadline().Limit(popLimit) && !cubeQueue.IsEmpty()) {
       SHyperedge *hyperedge = cubeQueue.Pop();
       // FIXME See corresponding code in S2T::Manager
       // BEGIN{HACK}
@@ -133,6 +133,7 @@ void Manager<RuleMatcher>::Decode()
       // END{HACK}
       buffer.push_back(hyperedge);
       ++count;
+      this->GetDeadline().Update();
     }
 
     // Recombine SVertices and sort into a stack.
@@ -140,8 +141,9 @@ void Manager<RuleMatcher>::Decode()
     RecombineAndSort(buffer, stack);
 
     // Prune stack.
-    if (stackLimit > 0 && stack.size() > stackLimit) {
-      stack.resize(stackLimit);
+    const std::size_t limit = this->GetDeadline().Limit(stackLimit);
+    if (limit > 0 && stack.size() > limit) {
+      stack.resize(limit);
     }
   }
 }
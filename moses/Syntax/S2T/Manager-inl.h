@@ -205,7 +205,7 @@ void Manager<Parser>::Decode()
       typedef boost::unordered_map<Word, std::vector<SHyperedge*>,
               SymbolHasher, SymbolEqualityPred > BufferMap;
       BufferMap buffers;
-      while (count < popLimit && !cubeQueue.IsEmpty()) {
+      while (count < this->GetDeadline().Limit(popLimit) && !cubeQueue.IsEmpty()) {
         SHyperedge *hyperedge = cubeQueue.Pop();
         // BEGIN{HACK}
         // The way things currently work, the LHS of each hyperedge is not
@@ -219,6 +219,7 @@ void Manager<Parser>::Decode()
         // END{HACK}
         buffers[lhs].push_back(hyperedge);
         ++count;
+        this->GetDeadline().Update();
       }
 
       // Recombine SVertices and sort into stacks.
@@ -234,12 +235,13 @@ void Manager<Parser>::Decode()
       }
 
       // Prune stacks.
-      if (stackLimit > 0) {
+      const std::size_t limit = this->GetDeadline().Limit(stackLimit);
+      if (limit > 0) {
         for (SChart::Cell::NMap::Iterator p = scell.nonTerminalStacks.Begin();
              p != scell.nonTerminalStacks.End(); ++p) {
           SVertexStack &stack = p->second;
-          if (stack.size() > stackLimit) {
-            stack.resize(stackLimit);
+          if (stack.size() > limit) {
+            stack.resize(limit);
           }
         }
       }
@@ -39,6 +39,22 @@ using namespace std;
 
 namespace Moses
 {
+namespace
+{
+// Map of a copy-on-write member, allocated on first use and unshared
+// before it is modified.
+template <class T>
+T& Writable(boost::shared_ptr<T>& p)
+{
+  if (!p) {
+    p.reset(new T);
+  } else if (!p.unique()) {
+    p.reset(new T(*p));
+  }
+  return *p;
+}
+}
+
 TargetPhrase::TargetPhrase( std::string out_string, const PhraseDictionary *pt)
   :Phrase(0)
   , m_futureScore(0.0)
@@ -134,6 +150,7 @@ TargetPhrase::TargetPhrase(const TargetPhrase &copy)
   , m_alignNonTerm(copy.m_alignNonTerm)
   , m_properties(copy.m_properties)
   , m_container(copy.m_container)
+  , m_data(copy.m_data)
 {
   if (copy.m_lhsTarget) {
     m_lhsTarget = new Word(*copy.m_lhsTarget);
@@ -303,8 +320,10 @@ Merge(const TargetPhrase &copy, const std::vector<FactorType>& factorVec)
   m_futureScore += copy.m_futureScore;
   typedef ScoreCache_t::iterator iter;
   typedef ScoreCache_t::value_type item;
-  BOOST_FOREACH(item const& s, copy.m_cached_scores) {
-    pair<iter,bool> foo = m_cached_scores.insert(s);
+  if (!copy.m_cached_scores) return;
+  ScoreCache_t &cached_scores = Writable(m_cached_scores);
+  BOOST_FOREACH(item const& s, *copy.m_cached_scores) {
+    pair<iter,bool> foo = cached_scores.insert(s);
     if (foo.second == false)
       foo.first->second = mergescores(foo.first->second, s.second);
   }
@@ -314,15 +333,17 @@ TargetPhrase::ScoreCache_t const&
 TargetPhrase::
 GetExtraScores() const
 {
-  return m_cached_scores;
+  static const ScoreCache_t empty;
+  return m_cached_scores ? *m_cached_scores : empty;
 }
 
 Scores const*
 TargetPhrase::
 GetExtraScores(FeatureFunction const* ff) const
 {
-  ScoreCache_t::const_iterator m = m_cached_scores.find(ff);
-  return m != m_cached_scores.end() ? m->second.get() : NULL;
+  if (!m_cached_scores) return NULL;
+  ScoreCache_t::const_iterator m = m_cached_scores->find(ff);
+  return m != m_cached_scores->end() ? m->second.get() : NULL;
 }
 
 void
@@ -330,7 +351,16 @@ TargetPhrase::
 SetExtraScores(FeatureFunction const* ff,
                boost::shared_ptr<Scores> const& s)
 {
-  m_cached_scores[ff] = s;
+  Writable(m_cached_scores)[ff] = s;
+}
+
+bool TargetPhrase::SetData(const std::string& key, boost::shared_ptr<void> value) const
+{
+  if (m_data && m_data->find(key) != m_data->end()) {
+    return false;
+  }
+  Writable(m_data).insert(DataMap::value_type(key, value));
+  return true;
 }
 
 
@@ -362,14 +392,17 @@ void TargetPhrase::SetProperty(const std::string &key, const std::string &value)
 {
   const StaticData &staticData = StaticData::Instance();
   const PhrasePropertyFactory& phrasePropertyFactory = staticData.GetPhrasePropertyFactory();
-  m_properties[key] = phrasePropertyFactory.ProduceProperty(key,value);
+  Writable(m_properties)[key] = phrasePropertyFactory.ProduceProperty(key,value);
 }
 
 const PhraseProperty *TargetPhrase::GetProperty(const std::string &key) const
 {
-  std::map<std::string, boost::shared_ptr<PhraseProperty> >::const_iterator iter;
-  iter = m_properties.find(key);
-  if (iter != m_properties.end()) {
+  if (!m_properties) {
+    return NULL;
+  }
+  Properties::const_iterator iter;
+  iter = m_properties->find(key);
+  if (iter != m_properties->end()) {
     const boost::shared_ptr<PhraseProperty> &pp = iter->second;
     return pp.get();
   }
@@ -415,11 +448,11 @@ std::ostream& operator<<(std::ostream& os, const TargetPhrase& tp)
     os << " sourcePhrase=" << *sourcePhrase << flush;
   }
 
-  if (tp.m_properties.size()) {
+  if (tp.m_properties && tp.m_properties->size()) {
     os << " properties: " << flush;
 
     TargetPhrase::Properties::const_iterator iter;
-    for (iter = tp.m_properties.begin(); iter != tp.m_properties.end(); ++iter) {
+    for (iter = tp.m_properties->begin(); iter != tp.m_properties->end(); ++iter) {
       const string &key = iter->first;
       const PhraseProperty *prop = iter->second.get();
       assert(prop);
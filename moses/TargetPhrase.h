@@ -58,7 +58,9 @@ public:
 
 
 private:
-  ScoreCache_t m_cached_scores;
+  // The maps below are empty for most phrases, so they are only allocated
+  // when set, and shared between copies until one of them is modified.
+  boost::shared_ptr<ScoreCache_t> m_cached_scores;
   WPTR<ContextScope> m_scope;
 
 private:
@@ -73,11 +75,12 @@ private:
   mutable Phrase *m_ruleSource; // to be set by the feature function that needs it.
 
   typedef std::map<std::string, boost::shared_ptr<PhraseProperty> > Properties;
-  Properties m_properties;
+  boost::shared_ptr<Properties> m_properties;
 
   const PhraseDictionary *m_container;
 
-  mutable boost::unordered_map<const std::string, boost::shared_ptr<void> > m_data;
+  typedef boost::unordered_map<const std::string, boost::shared_ptr<void> > DataMap;
+  mutable boost::shared_ptr<DataMap> m_data;
 
 public:
   TargetPhrase(const PhraseDictionary *pt = NULL);
@@ -192,18 +195,14 @@ public:
     return m_container;
   }
 
-  bool SetData(const std::string& key, boost::shared_ptr<void> value) const {
-    std::pair< boost::unordered_map<const std::string, boost::shared_ptr<void> >::iterator, bool > inserted =
-      m_data.insert( std::pair<const std::string, boost::shared_ptr<void> >(key,value) );
-    if (!inserted.second) {
-      return false;
-    }
-    return true;
-  }
+  bool SetData(const std::string& key, boost::shared_ptr<void> value) const;
 
   boost::shared_ptr<void> GetData(const std::string& key) const {
-    boost::unordered_map<const std::string, boost::shared_ptr<void> >::const_iterator found = m_data.find(key);
-    if (found == m_data.end()) {
+    if (!m_data) {
+      return boost::shared_ptr<void>();
+    }
+    DataMap::const_iterator found = m_data->find(key);
+    if (found == m_data->end()) {
       return boost::shared_ptr<void>();
     }
     return found->second;
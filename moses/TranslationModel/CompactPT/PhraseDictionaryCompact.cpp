@@ -148,6 +148,13 @@ GetTargetPhraseCollectionRaw(const Phrase &sourcePhrase) const
   return m_phraseDecoder->CreateTargetPhraseCollection(sourcePhrase, true, false);
 }
 
+bool
+PhraseDictionaryCompact::
+PrefixExists(ttasksptr const& ttask, Phrase const& phrase) const
+{
+  return phrase.GetSize() <= m_phraseDecoder->GetMaxSourcePhraseLength();
+}
+
 PhraseDictionaryCompact::
 ~PhraseDictionaryCompact()
 {
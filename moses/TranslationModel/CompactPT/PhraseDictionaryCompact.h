@@ -72,6 +72,12 @@ public:
   TargetPhraseCollection::shared_ptr  GetTargetPhraseCollectionNonCacheLEGACY(const Phrase &source) const;
   TargetPhraseVectorPtr GetTargetPhraseCollectionRaw(const Phrase &source) const;
 
+  // only full source phrases are hashed, so only checks the phrase length
+  bool ProvidesPrefixCheck() const {
+    return true;
+  }
+  bool PrefixExists(ttasksptr const& ttask, Phrase const& phrase) const;
+
   void AddEquivPhrase(const Phrase &source, const TargetPhrase &targetPhrase);
 
   void CacheForCleanup(TargetPhraseCollection::shared_ptr  tpc);
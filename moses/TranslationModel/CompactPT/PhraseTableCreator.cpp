@@ -20,6 +20,7 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 ***********************************************************************/
 
 #include <cstdio>
+#include <cstring>
 
 #include "PhraseTableCreator.h"
 #include "ConsistentPhrases.h"
@@ -66,6 +67,9 @@ PhraseTableCreator::PhraseTableCreator(std::string inPath,
     m_quantize(quantize), m_maxRank(maxRank),
 #ifdef WITH_THREADS
     m_threads(threads),
+    // CMPH draws the seeds of its hash functions from rand(), so the source
+    // phrase ranges that are saved are hashed one after the other to keep
+    // the output independent of thread scheduling.
     m_srcHash(m_orderBits, m_fingerPrintBits, 1),
     m_rnkHash(10, 24, m_threads),
 #else
@@ -73,6 +77,7 @@ PhraseTableCreator::PhraseTableCreator(std::string inPath,
     m_rnkHash(m_orderBits, m_fingerPrintBits),
 #endif
     m_maxPhraseLength(0),
+    m_numOrderedTargetSymbols(0),
     m_lastFlushedLine(-1), m_lastFlushedSourceNum(0),
     m_lastFlushedSourcePhrase("")
 {
@@ -344,6 +349,12 @@ void PhraseTableCreator::EncodeTargetPhrases()
 {
   InputFileStream inFile(m_inPath);
 
+  // Symbols known before encoding keep their ids
+  m_numOrderedTargetSymbols = m_targetSymbolsMap.size();
+  m_orderedTargetSymbolIds.resize(m_numOrderedTargetSymbols);
+  for(unsigned i = 0; i < m_numOrderedTargetSymbols; i++)
+    m_orderedTargetSymbolIds[i] = i;
+
 #ifdef WITH_THREADS
   boost::thread_group threads;
   for (size_t i = 0; i < m_threads; ++i) {
@@ -357,6 +368,11 @@ void PhraseTableCreator::EncodeTargetPhrases()
   delete et;
 #endif
   FlushEncodedQueue(true);
+
+  for(boost::unordered_map<std::string, unsigned>::iterator it
+      = m_targetSymbolsMap.begin(); it != m_targetSymbolsMap.end(); it++)
+    it->second = GetOrderedTargetSymbolId(it->second);
+  std::vector<unsigned>().swap(m_orderedTargetSymbolIds);
 }
 
 
@@ -542,14 +558,12 @@ void PhraseTableCreator::EncodeTargetPhraseNone(std::vector<std::string>& t,
   while(j < t.size()) {
     unsigned targetSymbolId = GetOrAddTargetSymbolId(t[j]);
 
-    m_symbolCounter.Increase(targetSymbolId);
     os.write((char*)&targetSymbolId, sizeof(targetSymbolId));
     j++;
   }
 
   unsigned stopSymbolId = GetTargetSymbolId(m_phraseStopSymbol);
   os.write((char*)&stopSymbolId, sizeof(stopSymbolId));
-  m_symbolCounter.Increase(stopSymbolId);
 }
 
 void PhraseTableCreator::EncodeTargetPhraseREnc(std::vector<std::string>& s,
@@ -598,13 +612,11 @@ void PhraseTableCreator::EncodeTargetPhraseREnc(std::vector<std::string>& s,
     }
 
     os.write((char*)&encodedSymbol, sizeof(encodedSymbol));
-    m_symbolCounter.Increase(encodedSymbol);
   }
 
   unsigned stopSymbolId = GetTargetSymbolId(m_phraseStopSymbol);
   unsigned encodedSymbol = EncodeREncSymbol1(stopSymbolId);
   os.write((char*)&encodedSymbol, sizeof(encodedSymbol));
-  m_symbolCounter.Increase(encodedSymbol);
 }
 
 void PhraseTableCreator::EncodeTargetPhrasePREnc(std::vector<std::string>& s,
@@ -660,13 +672,11 @@ void PhraseTableCreator::EncodeTargetPhrasePREnc(std::vector<std::string>& s,
   while(j < t.size()) {
     if(encodedSymbolsLengths[j] > 0) {
       unsigned encodedSymbol = encodedSymbols[j];
-      m_symbolCounter.Increase(encodedSymbol);
       os.write((char*)&encodedSymbol, sizeof(encodedSymbol));
       j += encodedSymbolsLengths[j];
     } else {
       unsigned targetSymbolId = GetOrAddTargetSymbolId(t[j]);
       unsigned encodedSymbol = EncodePREncSymbol1(targetSymbolId);
-      m_symbolCounter.Increase(encodedSymbol);
       os.write((char*)&encodedSymbol, sizeof(encodedSymbol));
       j++;
     }
@@ -675,7 +685,6 @@ void PhraseTableCreator::EncodeTargetPhrasePREnc(std::vector<std::string>& s,
   unsigned stopSymbolId = GetTargetSymbolId(m_phraseStopSymbol);
   unsigned encodedSymbol = EncodePREncSymbol1(stopSymbolId);
   os.write((char*)&encodedSymbol, sizeof(encodedSymbol));
-  m_symbolCounter.Increase(encodedSymbol);
 }
 
 void PhraseTableCreator::EncodeScores(std::vector<float>& scores, std::ostream& os)
@@ -687,7 +696,6 @@ void PhraseTableCreator::EncodeScores(std::vector<float>& scores, std::ostream&
     score = scores[c];
     score = FloorScore(TransformScore(score));
     os.write((char*)&score, sizeof(score));
-    m_scoreCounters[m_multipleScoreTrees ? c : 0]->Increase(score);
     c++;
   }
 }
@@ -698,11 +706,9 @@ void PhraseTableCreator::EncodeAlignment(std::set<AlignPoint>& alignment,
   for(std::set<AlignPoint>::iterator it = alignment.begin();
       it != alignment.end(); it++) {
     os.write((char*)&(*it), sizeof(AlignPoint));
-    m_alignCounter.Increase(*it);
   }
   AlignPoint stop(-1, -1);
   os.write((char*) &stop, sizeof(AlignPoint));
-  m_alignCounter.Increase(stop);
 }
 
 std::string PhraseTableCreator::EncodeLine(std::vector<std::string>& tokens, size_t ownRank)
@@ -907,6 +913,68 @@ void PhraseTableCreator::AddEncodedLine(PackedItem& pi)
   m_queue.push(pi);
 }
 
+bool PhraseTableCreator::IsTargetSymbolId(unsigned symbol)
+{
+  if(m_coding == REnc)
+    return (symbol >> 30) == 0;
+  else if(m_coding == PREnc)
+    return (symbol >> 31) == 0;
+  else
+    return true;
+}
+
+unsigned PhraseTableCreator::GetOrderedTargetSymbolId(unsigned targetSymbolId)
+{
+  if(targetSymbolId >= m_orderedTargetSymbolIds.size())
+    m_orderedTargetSymbolIds.resize(targetSymbolId + 1, -1);
+  if(m_orderedTargetSymbolIds[targetSymbolId] == unsigned(-1))
+    m_orderedTargetSymbolIds[targetSymbolId] = m_numOrderedTargetSymbols++;
+  return m_orderedTargetSymbolIds[targetSymbolId];
+}
+
+// The encoding threads give out ids to new target symbols in the order they
+// happen to get to them, and count symbols, scores and alignment points in
+// that order. Both feed into the saved table, so they are redone here as the
+// lines are flushed in input order, which keeps the table independent of the
+// number of threads.
+void PhraseTableCreator::CountEncodedLine(std::string& encodedLine)
+{
+  unsigned stopSymbolId = GetTargetSymbolId(m_phraseStopSymbol);
+  size_t pos = 0;
+
+  unsigned symbol;
+  do {
+    std::memcpy(&symbol, &encodedLine[pos], sizeof(unsigned));
+    if(IsTargetSymbolId(symbol)) {
+      // REnc and PREnc store target symbol ids as they are, the other
+      // symbols of these encodings do not depend on the id order.
+      unsigned orderedSymbol = GetOrderedTargetSymbolId(symbol);
+      std::memcpy(&encodedLine[pos], &orderedSymbol, sizeof(unsigned));
+      m_symbolCounter.Increase(orderedSymbol);
+    } else {
+      m_symbolCounter.Increase(symbol);
+    }
+    pos += sizeof(unsigned);
+  } while(symbol != stopSymbolId);
+
+  for(size_t c = 0; c < m_numScoreComponent; c++) {
+    float score;
+    std::memcpy(&score, &encodedLine[pos], sizeof(float));
+    m_scoreCounters[m_multipleScoreTrees ? c : 0]->Increase(score);
+    pos += sizeof(float);
+  }
+
+  if(m_useAlignmentInfo) {
+    AlignPoint stop(-1, -1);
+    AlignPoint alignPoint;
+    do {
+      std::memcpy(&alignPoint, &encodedLine[pos], sizeof(AlignPoint));
+      m_alignCounter.Increase(alignPoint);
+      pos += sizeof(AlignPoint);
+    } while(alignPoint != stop);
+  }
+}
+
 void PhraseTableCreator::FlushEncodedQueue(bool force)
 {
   while(!m_queue.empty() && m_lastFlushedLine + 1 == m_queue.top().GetLine()) {
@@ -942,12 +1010,14 @@ void PhraseTableCreator::FlushEncodedQueue(bool force)
     }
 
     m_lastFlushedSourcePhrase = pi.GetSrc();
+    std::string encodedLine = pi.GetTrg();
+    CountEncodedLine(encodedLine);
     if(m_coding == PREnc) {
       if(m_lastCollection.size() <= pi.GetRank())
         m_lastCollection.resize(pi.GetRank() + 1);
-      m_lastCollection[pi.GetRank()] = pi.GetTrg();
+      m_lastCollection[pi.GetRank()] = encodedLine;
     } else {
-      m_lastCollection.push_back(pi.GetTrg());
+      m_lastCollection.push_back(encodedLine);
     }
   }
 
@@ -247,6 +247,11 @@ private:
   boost::unordered_map<std::string, unsigned> m_targetSymbolsMap;
   boost::unordered_map<std::string, unsigned> m_sourceSymbolsMap;
 
+  // Target symbol ids given out by the encoding threads, mapped to ids in
+  // order of first appearance in the phrase table
+  std::vector<unsigned> m_orderedTargetSymbolIds;
+  unsigned m_numOrderedTargetSymbols;
+
   typedef Counter<unsigned> SymbolCounter;
   typedef Counter<float> ScoreCounter;
   typedef Counter<AlignPoint> AlignCounter;
@@ -322,6 +327,9 @@ private:
 
   std::string EncodeLine(std::vector<std::string>& tokens, size_t ownRank);
   void AddEncodedLine(PackedItem& pi);
+  bool IsTargetSymbolId(unsigned symbol);
+  unsigned GetOrderedTargetSymbolId(unsigned targetSymbolId);
+  void CountEncodedLine(std::string& encodedLine);
   void FlushEncodedQueue(bool force = false);
 
   std::string CompressEncodedCollection(std::string encodedCollection);
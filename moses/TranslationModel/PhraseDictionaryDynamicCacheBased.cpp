@@ -46,6 +46,7 @@ PhraseDictionaryDynamicCacheBased::PhraseDictionaryDynamicCacheBased(const std::
   m_score_type = CBTM_SCORE_TYPE_HYPERBOLA;
   m_maxAge = 1000;
   m_entries = 0;
+  m_epoch = 0;
   m_name = "default";
   m_constant = false;
   ReadParameters();
@@ -153,24 +154,36 @@ void PhraseDictionaryDynamicCacheBased::InitializeForInput(ttasksptr const& ttas
 
 TargetPhraseCollection::shared_ptr PhraseDictionaryDynamicCacheBased::GetTargetPhraseCollection(const Phrase &source) const
 {
+  CacheEntryPtr entry;
+  unsigned int epoch;
+  {
 #ifdef WITH_THREADS
-  boost::shared_lock<boost::shared_mutex> read_lock(m_cacheLock);
+    boost::shared_lock<boost::shared_mutex> read_lock(m_cacheLock);
 #endif
-  TargetPhraseCollection::shared_ptr tpc;
-  cacheMap::const_iterator it = m_cacheTM.find(source);
-  if(it != m_cacheTM.end()) {
-    tpc.reset(new TargetPhraseCollection(*(it->second).first));
-
-    std::vector<const TargetPhrase*>::const_iterator it2 = tpc->begin();
+    cacheMap::const_iterator it = m_cacheTM.find(source);
+    if (it == m_cacheTM.end()) {
+      return TargetPhraseCollection::shared_ptr();
+    }
+    entry = it->second;
+    epoch = m_epoch;
+  }
 
-    while (it2 != tpc->end()) {
-      ((TargetPhrase*) *it2)->EvaluateInIsolation(source, GetFeaturesToApply());
-      it2++;
+  // score the target phrases according to their current age
+  TargetPhraseCollection::shared_ptr tpc(new TargetPhraseCollection);
+  for (size_t tp_pos = 0; tp_pos < entry->targets.GetSize(); ++tp_pos) {
+    const AgeStamp &stamp = entry->ages[tp_pos];
+    if (IsExpired(stamp, epoch)) {
+      continue;
     }
+    TargetPhrase *tp_ptr = new TargetPhrase(*entry->targets.GetTargetPhrase(tp_pos));
+    tp_ptr->GetScoreBreakdown().Assign(this, GetPreComputedScores(GetAge(stamp, epoch)));
+    tp_ptr->EvaluateInIsolation(source, GetFeaturesToApply());
+    tpc->Add(tp_ptr);
   }
-  if (tpc)  {
-    tpc->NthElement(m_tableLimit); // sort the phrases for the decoder
+  if (tpc->IsEmpty()) {
+    return TargetPhraseCollection::shared_ptr();
   }
+  tpc->NthElement(m_tableLimit); // sort the phrases for the decoder
 
   return tpc;
 }
@@ -291,7 +304,7 @@ void PhraseDictionaryDynamicCacheBased::SetPreComputedScores(const unsigned int
   VERBOSE(3, "SetPreComputedScores(const unsigned int): lower_age:|" << m_maxAge << "| lower_score:|" << m_lower_score << "|" << std::endl);
 }
 
-Scores PhraseDictionaryDynamicCacheBased::GetPreComputedScores(const unsigned int age)
+Scores PhraseDictionaryDynamicCacheBased::GetPreComputedScores(const unsigned int age) const
 {
   if (age < m_maxAge) {
     return precomputedScores.at(age);
@@ -355,7 +368,7 @@ void PhraseDictionaryDynamicCacheBased::ClearEntries(Phrase sp, Phrase tp)
 {
   VERBOSE(3,"PhraseDictionaryDynamicCacheBased::ClearEntries(Phrase sp, Phrase tp)" << std::endl);
 #ifdef WITH_THREADS
-  boost::shared_lock<boost::shared_mutex> lock(m_cacheLock);
+  boost::mutex::scoped_lock lock(m_updateLock);
 #endif
   VERBOSE(3, "PhraseDictionaryCache deleting sp:|" << sp << "| tp:|" << tp << "|" << std::endl);
 
@@ -364,20 +377,13 @@ void PhraseDictionaryDynamicCacheBased::ClearEntries(Phrase sp, Phrase tp)
   if(it!=m_cacheTM.end()) {
     VERBOSE(3,"sp:|" << sp << "| FOUND" << std::endl);
     // sp is found
-    // here we have to remove the target phrase from targetphrasecollection and from the TargetAgeMap
-    // and then add new entry
-
-    TargetCollectionAgePair TgtCollAgePair = it->second;
-    TargetPhraseCollection::shared_ptr  tpc = TgtCollAgePair.first;
-    AgeCollection* ac = TgtCollAgePair.second;
-    const Phrase* p_ptr = NULL;
-    TargetPhrase* tp_ptr = NULL;
+    // here we have to remove the target phrase from a copy of the entry
+
+    const CacheEntry &oldEntry = *it->second;
     bool found = false;
     size_t tp_pos=0;
-    while (!found && tp_pos < tpc->GetSize()) {
-      tp_ptr = (TargetPhrase*) tpc->GetTargetPhrase(tp_pos);
-      p_ptr = (const Phrase*) tp_ptr;
-      if (tp == *p_ptr) {
+    while (!found && tp_pos < oldEntry.targets.GetSize()) {
+      if (tp == *oldEntry.targets.GetTargetPhrase(tp_pos)) {
         found = true;
         continue;
       }
@@ -389,21 +395,17 @@ void PhraseDictionaryDynamicCacheBased::ClearEntries(Phrase sp, Phrase tp)
     } else {
       VERBOSE(3,"tp:|" << tp << "| FOUND" << std::endl);
 
-      tpc->Remove(tp_pos); //delete entry in the Target Phrase Collection
-      ac->erase(ac->begin() + tp_pos); //delete entry in the Age Collection
+      CacheEntry *entry = new CacheEntry(oldEntry);
+      delete entry->targets.GetTargetPhrase(tp_pos);
+      entry->targets.Remove(tp_pos); //delete entry in the Target Phrase Collection
+      entry->ages.erase(entry->ages.begin() + tp_pos); //delete entry in the Age Collection
       m_entries--;
-      VERBOSE(3,"tpc size:|" << tpc->GetSize() << "|" << std::endl);
-      VERBOSE(3,"ac size:|" << ac->size() << "|" << std::endl);
+      VERBOSE(3,"tpc size:|" << entry->targets.GetSize() << "|" << std::endl);
       VERBOSE(3,"tp:|" << tp << "| DELETED" << std::endl);
-    }
-    if (tpc->GetSize() == 0) {
-      // delete the entry from m_cacheTM in case it points to an empty TargetPhraseCollection and AgeCollection
-      ac->clear();
-      tpc.reset();
-      delete ac;
-      m_cacheTM.erase(sp);
-    }
 
+      // deletes the entry from m_cacheTM in case it is now empty
+      SetEntry(sp, entry);
+    }
   } else {
     VERBOSE(3,"sp:|" << sp << "| NOT FOUND" << std::endl);
     //do nothing
@@ -447,22 +449,18 @@ void PhraseDictionaryDynamicCacheBased::ClearSource(std::vector<std::string> ent
 void PhraseDictionaryDynamicCacheBased::ClearSource(Phrase sp)
 {
   VERBOSE(3,"void PhraseDictionaryDynamicCacheBased::ClearSource(Phrase sp) sp:|" << sp << "|" << std::endl);
+#ifdef WITH_THREADS
+  boost::mutex::scoped_lock lock(m_updateLock);
+#endif
   cacheMap::const_iterator it = m_cacheTM.find(sp);
   if (it != m_cacheTM.end()) {
     VERBOSE(3,"found:|" << sp << "|" << std::endl);
     //sp is found
 
-    TargetCollectionAgePair TgtCollAgePair = it->second;
-    TargetPhraseCollection::shared_ptr  tpc = TgtCollAgePair.first;
-    AgeCollection* ac = TgtCollAgePair.second;
-
-    m_entries-=tpc->GetSize(); //reduce the total amount of entries of the cache
+    m_entries-=it->second->targets.GetSize(); //reduce the total amount of entries of the cache
 
-    // delete the entry from m_cacheTM in case it points to an empty TargetPhraseCollection and AgeCollection
-    ac->clear();
-    tpc.reset();
-    delete ac;
-    m_cacheTM.erase(sp);
+    // delete the entry from m_cacheTM
+    SetEntry(sp, NULL);
   } else {
     //do nothing
   }
@@ -547,131 +545,134 @@ void PhraseDictionaryDynamicCacheBased::Update(Phrase sp, TargetPhrase tp, int a
 {
   VERBOSE(3,"PhraseDictionaryDynamicCacheBased::Update(Phrase sp, TargetPhrase tp, int age, std::string waString)" << std::endl);
 #ifdef WITH_THREADS
-  boost::shared_lock<boost::shared_mutex> lock(m_cacheLock);
+  boost::mutex::scoped_lock lock(m_updateLock);
 #endif
   VERBOSE(3, "PhraseDictionaryCache inserting sp:|" << sp << "| tp:|" << tp << "| age:|" << age << "| word-alignment |" << waString << "|" << std::endl);
 
+  AgeStamp stamp;
+  stamp.age = age;
+  stamp.epoch = m_epoch;
+
+  // the entry in the cache is replaced by an updated copy
+  CacheEntry *entry;
   cacheMap::const_iterator it = m_cacheTM.find(sp);
   VERBOSE(3,"sp:|" << sp << "|" << std::endl);
   if(it!=m_cacheTM.end()) {
     VERBOSE(3,"sp:|" << sp << "| FOUND" << std::endl);
-    // sp is found
-    // here we have to remove the target phrase from targetphrasecollection and from the TargetAgeMap
-    // and then add new entry
-
-    TargetCollectionAgePair TgtCollAgePair = it->second;
-    TargetPhraseCollection::shared_ptr  tpc = TgtCollAgePair.first;
-    AgeCollection* ac = TgtCollAgePair.second;
-//    const TargetPhrase* p_ptr = NULL;
-    const Phrase* p_ptr = NULL;
-    TargetPhrase* tp_ptr = NULL;
-    bool found = false;
-    size_t tp_pos=0;
-    while (!found && tp_pos < tpc->GetSize()) {
-      tp_ptr = (TargetPhrase*) tpc->GetTargetPhrase(tp_pos);
-      p_ptr = (const TargetPhrase*) tp_ptr;
-      if ((Phrase) tp == *p_ptr) {
-        found = true;
-        continue;
-      }
-      tp_pos++;
-    }
-    if (!found) {
-      VERBOSE(3,"tp:|" << tp << "| NOT FOUND" << std::endl);
-      std::auto_ptr<TargetPhrase> targetPhrase(new TargetPhrase(tp));
-
-      targetPhrase->GetScoreBreakdown().Assign(this, GetPreComputedScores(age));
-      if (!waString.empty()) targetPhrase->SetAlignmentInfo(waString);
-
-      tpc->Add(targetPhrase.release());
-
-      tp_pos = tpc->GetSize()-1;
-      ac->push_back(age);
-      m_entries++;
-      VERBOSE(3,"sp:|" << sp << "tp:|" << tp << "| INSERTED" << std::endl);
-    } else {
-      tp_ptr->GetScoreBreakdown().Assign(this, GetPreComputedScores(age));
-      if (!waString.empty()) tp_ptr->SetAlignmentInfo(waString);
-      ac->at(tp_pos) = age;
-      VERBOSE(3,"sp:|" << sp << "tp:|" << tp << "| UPDATED" << std::endl);
-    }
+    entry = new CacheEntry(*it->second);
   } else {
     VERBOSE(3,"sp:|" << sp << "| NOT FOUND" << std::endl);
-    // p is not found
-    // create target collection
-    // we have to create new target collection age pair and add new entry to target collection age pair
-
-    TargetPhraseCollection::shared_ptr tpc(new TargetPhraseCollection);
-    AgeCollection* ac = new AgeCollection();
-    m_cacheTM.insert(make_pair(sp,make_pair(tpc,ac)));
+    entry = new CacheEntry;
+  }
 
-    //tp is not found
+  bool found = false;
+  size_t tp_pos=0;
+  while (!found && tp_pos < entry->targets.GetSize()) {
+    if ((Phrase) tp == *entry->targets.GetTargetPhrase(tp_pos)) {
+      found = true;
+      continue;
+    }
+    tp_pos++;
+  }
+  if (!found) {
+    VERBOSE(3,"tp:|" << tp << "| NOT FOUND" << std::endl);
     std::auto_ptr<TargetPhrase> targetPhrase(new TargetPhrase(tp));
+
     targetPhrase->GetScoreBreakdown().Assign(this, GetPreComputedScores(age));
     if (!waString.empty()) targetPhrase->SetAlignmentInfo(waString);
 
-    tpc->Add(targetPhrase.release());
-    ac->push_back(age);
+    entry->targets.Add(targetPhrase.release());
+    entry->ages.push_back(stamp);
     m_entries++;
-    VERBOSE(3,"sp:|" << sp << "| tp:|" << tp << "| INSERTED" << std::endl);
+    VERBOSE(3,"sp:|" << sp << "tp:|" << tp << "| INSERTED" << std::endl);
+  } else {
+    TargetPhrase* tp_ptr = const_cast<TargetPhrase*>(entry->targets.GetTargetPhrase(tp_pos));
+    tp_ptr->GetScoreBreakdown().Assign(this, GetPreComputedScores(age));
+    if (!waString.empty()) tp_ptr->SetAlignmentInfo(waString);
+    entry->ages.at(tp_pos) = stamp;
+    VERBOSE(3,"sp:|" << sp << "tp:|" << tp << "| UPDATED" << std::endl);
   }
+
+  SetEntry(sp, entry);
 }
 
-void PhraseDictionaryDynamicCacheBased::Decay()
+void PhraseDictionaryDynamicCacheBased::SetEntry(const Phrase &sp, CacheEntry *entry)
 {
+  CacheEntryPtr entryPtr(entry);
 #ifdef WITH_THREADS
-  boost::shared_lock<boost::shared_mutex> lock(m_cacheLock);
+  boost::unique_lock<boost::shared_mutex> lock(m_cacheLock);
 #endif
-  cacheMap::iterator it;
-  for(it = m_cacheTM.begin(); it!=m_cacheTM.end(); it++) {
-    Decay((*it).first);
+  if (entry == NULL || entry->targets.IsEmpty()) {
+    m_cacheTM.erase(sp);
+  } else {
+    m_cacheTM[sp] = entryPtr;
   }
 }
 
-void PhraseDictionaryDynamicCacheBased::Decay(Phrase sp)
+unsigned int PhraseDictionaryDynamicCacheBased::GetAge(const AgeStamp &stamp, unsigned int epoch) const
 {
-  VERBOSE(3,"void PhraseDictionaryDynamicCacheBased::Decay(Phrase sp) sp:|" << sp << "|" << std::endl);
-  cacheMap::iterator it = m_cacheTM.find(sp);
-  if (it != m_cacheTM.end()) {
-    VERBOSE(3,"found:|" << sp << "|" << std::endl);
-    //sp is found
+  return stamp.age + (epoch - stamp.epoch);
+}
 
-    TargetCollectionAgePair TgtCollAgePair = it->second;
-    TargetPhraseCollection::shared_ptr  tpc = TgtCollAgePair.first;
-    AgeCollection* ac = TgtCollAgePair.second;
-
-    //loop in inverted order to allow a correct deletion of std::vectors tpc and ac
-    for (int tp_pos = tpc->GetSize() - 1 ; tp_pos >= 0; tp_pos--) {
-      unsigned int tp_age = ac->at(tp_pos); //increase the age by 1
-      tp_age++; //increase the age by 1
-      VERBOSE(3,"sp:|" << sp << "| " << " new tp_age:|" << tp_age << "|" << std::endl);
-
-      TargetPhrase* tp_ptr = (TargetPhrase*) tpc->GetTargetPhrase(tp_pos);
-
-      if (tp_age > m_maxAge) {
-        VERBOSE(3,"tp_age:|" << tp_age << "| TOO BIG" << std::endl);
-        tpc->Remove(tp_pos); //delete entry in the Target Phrase Collection
-        ac->erase(ac->begin() + tp_pos); //delete entry in the Age Collection
-        m_entries--;
-      } else {
-        VERBOSE(3,"tp_age:|" << tp_age << "| STILL GOOD" << std::endl);
-        tp_ptr->GetScoreBreakdown().Assign(this, GetPreComputedScores(tp_age));
-        ac->at(tp_pos) = tp_age;
-      }
+bool PhraseDictionaryDynamicCacheBased::IsExpired(const AgeStamp &stamp, unsigned int epoch) const
+{
+  // as entries used to be removed when aging, those inserted too old stay
+  // until the next epoch
+  return stamp.epoch != epoch && GetAge(stamp, epoch) > m_maxAge;
+}
+
+void PhraseDictionaryDynamicCacheBased::Decay()
+{
+#ifdef WITH_THREADS
+  boost::mutex::scoped_lock lock(m_updateLock);
+#endif
+  {
+#ifdef WITH_THREADS
+    boost::unique_lock<boost::shared_mutex> write_lock(m_cacheLock);
+#endif
+    ++m_epoch;
+  }
+
+  // expired entries are invisible to lookups; free their memory from time
+  // to time rather than traversing the cache at every epoch
+  if (m_maxAge == 0 || m_epoch % m_maxAge == 0) {
+    RemoveExpired();
+  }
+}
+
+void PhraseDictionaryDynamicCacheBased::RemoveExpired()
+{
+  // the caller holds m_updateLock
+  std::vector<std::pair<Phrase, CacheEntry*> > changed;
+  cacheMap::const_iterator it;
+  for(it = m_cacheTM.begin(); it!=m_cacheTM.end(); it++) {
+    const CacheEntry &oldEntry = *it->second;
+    size_t expired = 0;
+    for (size_t tp_pos = 0; tp_pos < oldEntry.ages.size(); ++tp_pos) {
+      expired += IsExpired(oldEntry.ages[tp_pos], m_epoch);
     }
-    if (tpc->GetSize() == 0) {
-      // delete the entry from m_cacheTM in case it points to an empty TargetPhraseCollection and AgeCollection
-      (((*it).second).second)->clear();
-      delete ((*it).second).second;
-      ((*it).second).first.reset();
-      m_cacheTM.erase(sp);
+    if (expired == 0) {
+      continue;
     }
-  } else {
-    //do nothing
-    VERBOSE(3,"sp:|" << sp << "| NOT FOUND" << std::endl);
+    VERBOSE(3,"sp:|" << it->first << "| " << expired << " entries TOO OLD" << std::endl);
+    m_entries -= expired;
+
+    CacheEntry *entry = NULL;
+    if (expired < oldEntry.ages.size()) {
+      entry = new CacheEntry;
+      for (size_t tp_pos = 0; tp_pos < oldEntry.ages.size(); ++tp_pos) {
+        if (!IsExpired(oldEntry.ages[tp_pos], m_epoch)) {
+          entry->targets.Add(new TargetPhrase(*oldEntry.targets.GetTargetPhrase(tp_pos)));
+          entry->ages.push_back(oldEntry.ages[tp_pos]);
+        }
+      }
+    }
+    changed.push_back(std::make_pair(it->first, entry));
   }
 
-  //put here the removal of entries with age greater than m_maxAge
+  for (size_t i = 0; i < changed.size(); ++i) {
+    SetEntry(changed[i].first, changed[i].second);
+  }
 }
 
 void PhraseDictionaryDynamicCacheBased::Execute(std::string command)
@@ -703,14 +704,9 @@ void PhraseDictionaryDynamicCacheBased::Execute_Single_Command(std::string comma
 void PhraseDictionaryDynamicCacheBased::Clear()
 {
 #ifdef WITH_THREADS
-  boost::shared_lock<boost::shared_mutex> lock(m_cacheLock);
+  boost::mutex::scoped_lock lock(m_updateLock);
+  boost::unique_lock<boost::shared_mutex> write_lock(m_cacheLock);
 #endif
-  cacheMap::iterator it;
-  for(it = m_cacheTM.begin(); it!=m_cacheTM.end(); it++) {
-    (((*it).second).second)->clear();
-    delete ((*it).second).second;
-    ((*it).second).first.reset();
-  }
   m_cacheTM.clear();
   m_entries = 0;
 }
@@ -748,10 +744,12 @@ void PhraseDictionaryDynamicCacheBased::Print() const
   cacheMap::const_iterator it;
   for(it = m_cacheTM.begin(); it!=m_cacheTM.end(); it++) {
     std::string source = (it->first).ToString();
-    TargetPhraseCollection::shared_ptr  tpc = (it->second).first;
-    TargetPhraseCollection::iterator itr;
-    for(itr = tpc->begin(); itr != tpc->end(); itr++) {
-      std::string target = (*itr)->ToString();
+    const CacheEntry &entry = *it->second;
+    for (size_t tp_pos = 0; tp_pos < entry.targets.GetSize(); ++tp_pos) {
+      if (IsExpired(entry.ages[tp_pos], m_epoch)) {
+        continue;
+      }
+      std::string target = entry.targets.GetTargetPhrase(tp_pos)->ToString();
       std::cout << source << " ||| " << target << std::endl;
     }
     source.clear();
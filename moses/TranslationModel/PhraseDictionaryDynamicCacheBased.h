@@ -22,10 +22,13 @@
 #ifndef moses_PhraseDictionaryDynamicCacheBased_H
 #define moses_PhraseDictionaryDynamicCacheBased_H
 
+#include <boost/unordered_map.hpp>
+
 #include "moses/TypeDef.h"
 #include "moses/TranslationModel/PhraseDictionary.h"
 
 #ifdef WITH_THREADS
+#include <boost/thread/mutex.hpp>
 #include <boost/thread/shared_mutex.hpp>
 #include <boost/thread/locks.hpp>
 #endif
@@ -52,12 +55,28 @@ class ChartRuleLookupManager;
 class PhraseDictionaryDynamicCacheBased : public PhraseDictionary
 {
 
-  typedef std::vector<unsigned int> AgeCollection;
-  typedef std::pair<TargetPhraseCollection::shared_ptr , AgeCollection*> TargetCollectionAgePair;
-  typedef std::map<Phrase, TargetCollectionAgePair> cacheMap;
+  // Entries are not rewritten when the cache ages: each target phrase keeps
+  // the age it was given and the epoch at that time, and its current age
+  // is computed at lookup time from the number of epochs since.
+  struct AgeStamp {
+    unsigned int age;
+    unsigned int epoch;
+  };
+  typedef std::vector<AgeStamp> AgeCollection;
+
+  // The target phrases of a source phrase. An entry is never modified once
+  // it is in the cache: updates build a new one and swap the pointer, so
+  // readers only hold the lock while they copy the pointer.
+  struct CacheEntry {
+    TargetPhraseCollection targets;
+    AgeCollection ages;
+  };
+  typedef boost::shared_ptr<const CacheEntry> CacheEntryPtr;
+  typedef boost::unordered_map<Phrase, CacheEntryPtr> cacheMap;
 
   // data structure for the cache
   cacheMap m_cacheTM;
+  unsigned int m_epoch; // number of times the cache has aged
   std::vector<Scores> precomputedScores;
   unsigned int m_maxAge;
   size_t m_score_type; //scoring type of the match
@@ -68,8 +87,10 @@ class PhraseDictionaryDynamicCacheBased : public PhraseDictionary
   std::string m_name; // internal name to identify this instance of the Cache-based phrase table
 
 #ifdef WITH_THREADS
-  //multiple readers - single writer lock
+  //multiple readers - single writer lock, for m_cacheTM and m_epoch
   mutable boost::shared_mutex m_cacheLock;
+  //serializes the updates
+  mutable boost::mutex m_updateLock;
 #endif
 
   friend std::ostream& operator<<(std::ostream&, const PhraseDictionaryDynamicCacheBased&);
@@ -153,8 +174,11 @@ protected:
   float decaying_score(const int age);  // calculates the decay score given the age
   void Insert(std::vector<std::string> entries);
 
-  void Decay();   // traverse through the cache and decay each entry
-  void Decay(Phrase p);   // traverse through the cache and decay each entry for a given Phrase
+  void Decay();   // age the cache by one epoch
+  void RemoveExpired();   // traverse through the cache and remove the entries older than m_maxAge
+  unsigned int GetAge(const AgeStamp &stamp, unsigned int epoch) const;
+  bool IsExpired(const AgeStamp &stamp, unsigned int epoch) const;
+  void SetEntry(const Phrase &sp, CacheEntry *entry);
   void Update(std::vector<std::string> entries, std::string ageString);
   void Update(std::string sourceString, std::string targetString, std::string ageString, std::string waString="");
   void Update(Phrase p, TargetPhrase tp, int age, std::string waString="");
@@ -171,7 +195,7 @@ protected:
 
 
   void SetPreComputedScores(const unsigned int numScoreComponent);
-  Scores GetPreComputedScores(const unsigned int age);
+  Scores GetPreComputedScores(const unsigned int age) const;
 
   void Load_Multiple_Files(std::vector<std::string> files);
   void Load_Single_File(const std::string file);
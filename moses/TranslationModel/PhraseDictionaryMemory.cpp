@@ -80,6 +80,19 @@ GetTargetPhraseCollectionLEGACY(const Phrase& sourceOrig) const
   return currNode->GetTargetPhraseCollection();
 }
 
+bool
+PhraseDictionaryMemory::
+PrefixExists(ttasksptr const& ttask, Phrase const& phrase) const
+{
+  const PhraseDictionaryNodeMemory *currNode = &m_collection;
+  for (size_t pos = 0; currNode && pos < phrase.GetSize(); ++pos) {
+    Word word = phrase.GetWord(pos);
+    word.OnlyTheseFactors(m_inputFactors);
+    currNode = currNode->GetChild(word);
+  }
+  return currNode != NULL;
+}
+
 PhraseDictionaryNodeMemory &PhraseDictionaryMemory::GetOrCreateNode(const Phrase &source
     , const TargetPhrase &target
     , const Word *sourceLHS)
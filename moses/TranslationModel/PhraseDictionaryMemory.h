@@ -62,6 +62,11 @@ public:
   void
   GetTargetPhraseCollectionBatch(const InputPathList &inputPathQueue) const;
 
+  bool ProvidesPrefixCheck() const {
+    return true;
+  }
+  bool PrefixExists(ttasksptr const& ttask, Phrase const& phrase) const;
+
   TO_STRING();
 
 protected:
@@ -92,6 +92,20 @@ void ProbingPT::GetTargetPhraseCollectionBatch(const InputPathList &inputPathQue
   }
 }
 
+bool ProbingPT::PrefixExists(ttasksptr const& ttask, Phrase const& phrase) const
+{
+  if (phrase.GetSize() > m_options->search.max_phrase_length) {
+    return false;
+  }
+  // no entry contains a word missing from the source vocabulary
+  for (size_t i = 0; i < phrase.GetSize(); ++i) {
+    if (GetSourceProbingId(phrase.GetFactor(i, m_input[0])) == m_unkId) {
+      return false;
+    }
+  }
+  return true;
+}
+
 std::vector<uint64_t> ProbingPT::ConvertToProbingSourcePhrase(const Phrase &sourcePhrase, bool &ok) const
 {
   size_t size = sourcePhrase.GetSize();
@@ -28,6 +28,12 @@ public:
   // for phrase-based model
   void GetTargetPhraseCollectionBatch(const InputPathList &inputPathQueue) const;
 
+  // hashed source phrases, so only checks the source vocabulary
+  bool ProvidesPrefixCheck() const {
+    return true;
+  }
+  bool PrefixExists(ttasksptr const& ttask, Phrase const& phrase) const;
+
   // for syntax/hiero model (CKY+ decoding)
   virtual ChartRuleLookupManager *CreateRuleLookupManager(
     const ChartParser &,
@@ -0,0 +1,29 @@
+#include "block_reader.hh"
+
+size_t read_blocks(util::FilePiece &filein, std::vector<std::vector<std::string> > &blocks, size_t max_blocks)
+{
+  if (blocks.size() < max_blocks) {
+    blocks.resize(max_blocks);
+  }
+
+  StringPiece line;
+  for (size_t i = 0; i < max_blocks; i++) {
+    std::vector<std::string> &block = blocks[i];
+    size_t num_lines = 0;
+    while (num_lines < BLOCK_LINES && filein.ReadLineOrEOF(line)) {
+      if (block.size() <= num_lines) {
+        block.resize(num_lines + 1);
+      }
+      block[num_lines].assign(line.data(), line.size());
+      num_lines++;
+    }
+    block.resize(num_lines);
+    if (num_lines == 0) {
+      return i;
+    }
+    if (num_lines < BLOCK_LINES) {
+      return i + 1;
+    }
+  }
+  return max_blocks;
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+//Reads the phrase table in blocks of lines that are processed in parallel
+#include <string>
+#include <vector>
+
+#include "util/file_piece.hh"
+
+#ifdef WITH_THREADS
+#include <boost/thread/thread.hpp>
+#endif
+
+//Number of lines parsed and encoded together
+const size_t BLOCK_LINES = 10000;
+
+//Reads up to max_blocks blocks of lines, returns the number of blocks read.
+//The blocks are reused between calls, so that their strings keep their memory.
+size_t read_blocks(util::FilePiece &filein, std::vector<std::vector<std::string> > &blocks, size_t max_blocks);
+
+//Calls job(i) for i = first, first + stride, ... below count
+template <class Job> class BlockWorker
+{
+  Job *job;
+  size_t first, count, stride;
+
+public:
+  BlockWorker(Job *job, size_t first, size_t count, size_t stride)
+    : job(job), first(first), count(count), stride(stride) {}
+
+  void operator()() {
+    for (size_t i = first; i < count; i += stride) {
+      (*job)(i);
+    }
+  }
+};
+
+//Calls job(i) for every i in [0, count), on up to num_threads threads
+template <class Job> void run_on_blocks(Job &job, size_t count, size_t num_threads)
+{
+#ifdef WITH_THREADS
+  if (num_threads > 1 && count > 1) {
+    boost::thread_group threads;
+    for (size_t i = 0; i < num_threads && i < count; i++) {
+      threads.create_thread(BlockWorker<Job>(&job, i, count, num_threads));
+    }
+    threads.join_all();
+    return;
+  }
+#endif
+  BlockWorker<Job>(&job, 0, count, 1)();
+}
@@ -1,6 +1,57 @@
 #include "huffmanish.hh"
 
-Huffman::Huffman (const char * filepath)
+namespace
+{
+
+//Counts of the elements of a block of lines
+struct BlockCounts {
+  std::map<std::string, unsigned int> target_phrase_words;
+  std::map<std::vector<unsigned char>, unsigned int> word_all1;
+  unsigned long source_changes; //Lines whose source phrase differs from that of the line before
+  std::string first_source;
+  std::string last_source;
+};
+
+struct CountingJob {
+  const std::vector<std::vector<std::string> > &blocks;
+  std::vector<BlockCounts> &counts;
+
+  CountingJob(const std::vector<std::vector<std::string> > &blocks, std::vector<BlockCounts> &counts)
+    : blocks(blocks), counts(counts) {}
+
+  void operator()(size_t i) {
+    const std::vector<std::string> &lines = blocks[i];
+    BlockCounts &block_counts = counts[i];
+    block_counts.target_phrase_words.clear();
+    block_counts.word_all1.clear();
+    block_counts.source_changes = 0;
+
+    StringPiece prev_source;
+    for (size_t j = 0; j < lines.size(); j++) {
+      line_text new_line = splitLine(lines[j]);
+      count_line_elements(new_line, &block_counts.target_phrase_words, &block_counts.word_all1);
+      if (j > 0 && new_line.source_phrase != prev_source) {
+        block_counts.source_changes++;
+      }
+      prev_source = new_line.source_phrase;
+    }
+    block_counts.first_source = splitLine(lines.front()).source_phrase.as_string();
+    block_counts.last_source = prev_source.as_string();
+  }
+};
+
+template <class Key> void merge_counts(std::map<Key, unsigned int> &from, std::map<Key, unsigned int> *to)
+{
+  typename std::map<Key, unsigned int>::iterator hint = to->begin();
+  for (typename std::map<Key, unsigned int>::const_iterator it = from.begin(); it != from.end(); it++) {
+    hint = to->insert(hint, std::pair<Key, unsigned int>(it->first, 0));
+    hint->second += it->second;
+  }
+}
+
+}
+
+Huffman::Huffman (const char * filepath, size_t num_threads)
 {
   //Read the file
   util::FilePiece filein(filepath);
@@ -8,50 +59,56 @@ Huffman::Huffman (const char * filepath)
   //Init uniq_lines to zero;
   uniq_lines = 0;
 
-  line_text prev_line; //Check for unique lines.
-  int num_lines = 0 ;
+  std::string prev_source; //Check for unique lines.
 
+  //Count blocks of lines in parallel and add up their counts in order
+  std::vector<std::vector<std::string> > blocks;
+  std::vector<BlockCounts> counts(num_threads * 2);
   while (true) {
-    line_text new_line;
-
-    num_lines++;
-
-    try {
-      //Process line read
-      new_line = splitLine(filein.ReadLine());
-      count_elements(new_line); //Counts the number of elements, adds new and increments counters.
+    size_t num_blocks = read_blocks(filein, blocks, counts.size());
+    CountingJob job(blocks, counts);
+    run_on_blocks(job, num_blocks, num_threads);
+
+    for (size_t i = 0; i < num_blocks; i++) {
+      merge_counts(counts[i].target_phrase_words, &target_phrase_words);
+      merge_counts(counts[i].word_all1, &word_all1);
+      uniq_lines += counts[i].source_changes;
+      if (counts[i].first_source != prev_source) {
+        uniq_lines++;
+      }
+      prev_source = counts[i].last_source;
+    }
 
-    } catch (util::EndOfFileException e) {
+    if (num_blocks < counts.size()) {
       std::cerr << "Unique entries counted: ";
       break;
     }
-
-    if (new_line.source_phrase == prev_line.source_phrase) {
-      continue;
-    } else {
-      uniq_lines++;
-      prev_line = new_line;
-    }
   }
 
   std::cerr << uniq_lines << std::endl;
 }
 
 void Huffman::count_elements(line_text linein)
+{
+  count_line_elements(linein, &target_phrase_words, &word_all1);
+}
+
+void count_line_elements(line_text linein, std::map<std::string, unsigned int> *target_phrase_words,
+                         std::map<std::vector<unsigned char>, unsigned int> *word_all1)
 {
   //For target phrase:
   util::TokenIter<util::SingleCharacter> it(linein.target_phrase, util::SingleCharacter(' '));
   while (it) {
     //Check if we have that entry
     std::map<std::string, unsigned int>::iterator mapiter;
-    mapiter = target_phrase_words.find(it->as_string());
+    mapiter = target_phrase_words->find(it->as_string());
 
-    if (mapiter != target_phrase_words.end()) {
+    if (mapiter != target_phrase_words->end()) {
       //If the element is found, increment the count.
       mapiter->second++;
     } else {
       //Else create a new entry;
-      target_phrase_words.insert(std::pair<std::string, unsigned int>(it->as_string(), 1));
+      target_phrase_words->insert(std::pair<std::string, unsigned int>(it->as_string(), 1));
     }
     it++;
   }
@@ -59,14 +116,14 @@ void Huffman::count_elements(line_text linein)
   //For word allignment 1
   std::map<std::vector<unsigned char>, unsigned int>::iterator mapiter3;
   std::vector<unsigned char> numbers = splitWordAll1(linein.word_align);
-  mapiter3 = word_all1.find(numbers);
+  mapiter3 = word_all1->find(numbers);
 
-  if (mapiter3 != word_all1.end()) {
+  if (mapiter3 != word_all1->end()) {
     //If the element is found, increment the count.
     mapiter3->second++;
   } else {
     //Else create a new entry;
-    word_all1.insert(std::pair<std::vector<unsigned char>, unsigned int>(numbers, 1));
+    word_all1->insert(std::pair<std::vector<unsigned char>, unsigned int>(numbers, 1));
   }
 
 }
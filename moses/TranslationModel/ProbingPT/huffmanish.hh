@@ -3,6 +3,7 @@
 //Huffman encodes a line and also produces the vocabulary ids
 #include "hash.hh"
 #include "line_splitter.hh"
+#include "block_reader.hh"
 #include <cstdio>
 #include <fstream>
 #include <iostream>
@@ -47,7 +48,8 @@ class Huffman
   std::map<unsigned int, std::vector<unsigned char> > lookup_word_all1;
 
 public:
-  Huffman (const char *);
+  //Counts the elements of the phrase table, in blocks spread over num_threads threads
+  Huffman (const char *, size_t num_threads = 1);
   void count_elements (line_text line);
   void assign_values();
   void serialize_maps(const char * dirname);
@@ -71,6 +73,10 @@ public:
   }
 };
 
+//Counts the target words and word alignments of a line into the given maps
+void count_line_elements(line_text linein, std::map<std::string, unsigned int> *target_phrase_words,
+                         std::map<std::vector<unsigned char>, unsigned int> *word_all1);
+
 class HuffmanDecoder
 {
   std::map<unsigned int, std::string> lookup_target_phrase;
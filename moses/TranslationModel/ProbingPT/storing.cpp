@@ -10,9 +10,11 @@ BinaryFileWriter::BinaryFileWriter (std::string basepath) : os ((basepath + "/bi
 
 void BinaryFileWriter::write (std::vector<unsigned char> * bytes)
 {
-  binfile.insert(it, bytes->begin(), bytes->end()); //Insert the bytes
+  //Insert the bytes. The vector may grow, so take the offset of the iterator first.
+  size_t offset = distance(binfile.begin(), it);
+  binfile.insert(it, bytes->begin(), bytes->end());
   //Keep track of the offsets
-  it += bytes->size();
+  it = binfile.begin() + offset + bytes->size();
   dist_from_start = distance(binfile.begin(),it);
   //Flush the vector to disk every once in a while so that we don't consume too much ram
   if (dist_from_start > 9000) {
@@ -38,15 +40,83 @@ BinaryFileWriter::~BinaryFileWriter ()
   binfile.clear();
 }
 
+namespace
+{
+
+//The key of a source phrase is the sum of hashes of individual words bitshifted by their position in the phrase.
+//Probably not entirerly correct, but fast and seems to work fine in practise.
+uint64_t source_phrase_key(StringPiece source_phrase)
+{
+  uint64_t key = 0;
+  std::vector<uint64_t> vocabid_source = getVocabIDs(source_phrase);
+  for (int i = 0; i < vocabid_source.size(); i++) {
+    key += (vocabid_source[i] << i);
+  }
+  return key;
+}
+
+//A block of lines, encoded
+struct EncodedBlock {
+  std::vector<unsigned char> bytes; //The encoded lines, one after the other
+  std::vector<size_t> ends; //End of each encoded line in bytes
+  std::vector<uint64_t> keys; //Key of the source phrase of each line that starts a new source phrase in the block
+  std::vector<bool> new_source;
+  std::map<uint64_t, std::string> source_vocabids;
+  std::string first_source;
+  std::string last_source;
+};
+
+struct EncodingJob {
+  const std::vector<std::vector<std::string> > &blocks;
+  std::vector<EncodedBlock> &encoded;
+  Huffman &huffmanEncoder;
+
+  EncodingJob(const std::vector<std::vector<std::string> > &blocks, std::vector<EncodedBlock> &encoded, Huffman &huffmanEncoder)
+    : blocks(blocks), encoded(encoded), huffmanEncoder(huffmanEncoder) {}
+
+  void operator()(size_t i) {
+    const std::vector<std::string> &lines = blocks[i];
+    EncodedBlock &block = encoded[i];
+    block.bytes.clear();
+    block.ends.resize(lines.size());
+    block.keys.resize(lines.size());
+    block.new_source.resize(lines.size());
+    block.source_vocabids.clear();
+
+    StringPiece prev_source;
+    for (size_t j = 0; j < lines.size(); j++) {
+      line_text line = splitLine(lines[j]);
+      //Add source phrases to vocabularyIDs
+      add_to_map(&block.source_vocabids, line.source_phrase);
+
+      block.new_source[j] = (j == 0 || line.source_phrase != prev_source);
+      if (block.new_source[j]) {
+        block.keys[j] = source_phrase_key(line.source_phrase);
+      }
+      prev_source = line.source_phrase;
+
+      //Encode a line
+      std::vector<unsigned char> encoded_line = huffmanEncoder.full_encode_line(line);
+      block.bytes.insert(block.bytes.end(), encoded_line.begin(), encoded_line.end());
+      block.ends[j] = block.bytes.size();
+    }
+    block.first_source = splitLine(lines.front()).source_phrase.as_string();
+    block.last_source = prev_source.as_string();
+  }
+};
+
+}
+
 void createProbingPT(const char * phrasetable_path, const char * target_path,
-                     const char * num_scores, const char * is_reordering)
+                     const char * num_scores, const char * is_reordering,
+                     size_t num_threads)
 {
   //Get basepath and create directory if missing
   std::string basepath(target_path);
   mkdir(basepath.c_str(), S_IRWXU | S_IRWXG | S_IROTH | S_IXOTH);
 
   //Set up huffman and serialize decoder maps.
-  Huffman huffmanEncoder(phrasetable_path); //initialize
+  Huffman huffmanEncoder(phrasetable_path, num_threads); //initialize
   huffmanEncoder.assign_values();
   huffmanEncoder.produce_lookups();
   huffmanEncoder.serialize_maps(target_path);
@@ -68,82 +138,78 @@ void createProbingPT(const char * phrasetable_path, const char * target_path,
 
   BinaryFileWriter binfile(basepath); //Init the binary file writer.
 
-  line_text prev_line; //Check if the source phrase of the previous line is the same
+  std::string prev_source; //Source phrase of the previous line
+  uint64_t prev_key = 0; //Key of the previous source phrase
+  bool first_line = true;
 
   //Keep track of the size of each group of target phrases
   uint64_t entrystartidx = 0;
-  //uint64_t line_num = 0;
 
+  //Read everything and processs: blocks of lines are parsed and encoded in
+  //parallel, then put into the table and written to disk in order.
+  std::vector<std::vector<std::string> > blocks;
+  std::vector<EncodedBlock> encoded(num_threads * 2);
+  while (true) {
+    size_t num_blocks = read_blocks(filein, blocks, encoded.size());
+    EncodingJob job(blocks, encoded, huffmanEncoder);
+    run_on_blocks(job, num_blocks, num_threads);
+
+    for (size_t i = 0; i < num_blocks; i++) {
+      EncodedBlock &block = encoded[i];
+      for (std::map<uint64_t, std::string>::const_iterator it = block.source_vocabids.begin();
+           it != block.source_vocabids.end(); it++) {
+        source_vocabids.insert(*it);
+      }
 
-  //Read everything and processs
-  while(true) {
-    try {
-      //Process line read
-      line_text line;
-      line = splitLine(filein.ReadLine());
-      //Add source phrases to vocabularyIDs
-      add_to_map(&source_vocabids, line.source_phrase);
-
-      if ((binfile.dist_from_start + binfile.extra_counter) == 0) {
-        prev_line = line; //For the first iteration assume the previous line is
-      } //The same as this one.
-
-      if (line.source_phrase != prev_line.source_phrase) {
-
-        //Create a new entry even
-
-        //Create an entry for the previous source phrase:
-        Entry pesho;
-        pesho.value = entrystartidx;
-        //The key is the sum of hashes of individual words bitshifted by their position in the phrase.
-        //Probably not entirerly correct, but fast and seems to work fine in practise.
-        pesho.key = 0;
-        std::vector<uint64_t> vocabid_source = getVocabIDs(prev_line.source_phrase);
-        for (int i = 0; i < vocabid_source.size(); i++) {
-          pesho.key += (vocabid_source[i] << i);
+      uint64_t block_start = binfile.dist_from_start + binfile.extra_counter;
+      for (size_t j = 0; j < block.ends.size(); j++) {
+        if (!block.new_source[j]) {
+          continue;
         }
-        pesho.bytes_toread = binfile.dist_from_start + binfile.extra_counter - entrystartidx;
-
-        //Put into table
-        table.Insert(pesho);
-
-        entrystartidx = binfile.dist_from_start + binfile.extra_counter; //Designate start idx for new entry
-
-        //Encode a line and write it to disk.
-        std::vector<unsigned char> encoded_line = huffmanEncoder.full_encode_line(line);
-        binfile.write(&encoded_line);
-
-        //Set prevLine
-        prev_line = line;
-
-      } else {
-        //If we still have the same line, just append to it:
-        std::vector<unsigned char> encoded_line = huffmanEncoder.full_encode_line(line);
-        binfile.write(&encoded_line);
+        if (first_line) {
+          //For the first line, there is no previous source phrase.
+          first_line = false;
+        } else if (j > 0 || block.first_source != prev_source) {
+          //Create an entry for the previous source phrase:
+          Entry pesho;
+          pesho.value = entrystartidx;
+          pesho.key = prev_key;
+          uint64_t line_start = block_start + (j > 0 ? block.ends[j - 1] : 0);
+          pesho.bytes_toread = line_start - entrystartidx;
+
+          //Put into table
+          table.Insert(pesho);
+
+          entrystartidx = line_start; //Designate start idx for new entry
+        } else {
+          //The block continues the source phrase of the previous one.
+          continue;
+        }
+        prev_key = block.keys[j];
       }
+      prev_source = block.last_source;
 
-    } catch (util::EndOfFileException e) {
-      std::cerr << "Reading phrase table finished, writing remaining files to disk." << std::endl;
-      binfile.flush();
-
-      //After the final entry is constructed we need to add it to the phrase_table
-      //Create an entry for the previous source phrase:
-      Entry pesho;
-      pesho.value = entrystartidx;
-      //The key is the sum of hashes of individual words. Probably not entirerly correct, but fast
-      pesho.key = 0;
-      std::vector<uint64_t> vocabid_source = getVocabIDs(prev_line.source_phrase);
-      for (int i = 0; i < vocabid_source.size(); i++) {
-        pesho.key += (vocabid_source[i] << i);
-      }
-      pesho.bytes_toread = binfile.dist_from_start + binfile.extra_counter - entrystartidx;
-      //Put into table
-      table.Insert(pesho);
+      //Write the encoded lines to disk.
+      binfile.write(&block.bytes);
+    }
 
+    if (num_blocks < encoded.size()) {
       break;
     }
   }
 
+  std::cerr << "Reading phrase table finished, writing remaining files to disk." << std::endl;
+  binfile.flush();
+
+  //After the final entry is constructed we need to add it to the phrase_table
+  //Create an entry for the previous source phrase:
+  Entry pesho;
+  pesho.value = entrystartidx;
+  pesho.key = prev_key;
+  pesho.bytes_toread = binfile.dist_from_start + binfile.extra_counter - entrystartidx;
+  //Put into table
+  table.Insert(pesho);
+
   serialize_table(mem, size, (basepath + "/probing_hash.dat").c_str());
 
   serialize_map(&source_vocabids, (basepath + "/source_vocabids").c_str());
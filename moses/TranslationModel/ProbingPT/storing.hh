@@ -15,7 +15,8 @@
 #define API_VERSION 3
 
 void createProbingPT(const char * phrasetable_path, const char * target_path,
-                     const char * num_scores, const char * is_reordering);
+                     const char * num_scores, const char * is_reordering,
+                     size_t num_threads = 1);
 
 class BinaryFileWriter
 {
@@ -42,6 +42,11 @@
 #include "util/double-conversion/double-conversion.h"
 #include "util/exception.hh"
 
+#ifdef WITH_THREADS
+#include <boost/bind.hpp>
+#include <boost/thread.hpp>
+#endif
+
 using namespace std;
 using namespace boost::algorithm;
 
@@ -140,6 +145,99 @@ void ReformatHieroRule(const string &lineOrig, string &out)
   out = ret.str();
 }
 
+bool RuleTableLoaderStandard::ParseLine(AllOptions const& opts, FormatType format
+                                        , const std::vector<FactorType> &input
+                                        , const std::vector<FactorType> &output
+                                        , StringPiece line
+                                        , size_t count
+                                        , const double_conversion::StringToDoubleConverter &converter
+                                        , RuleTableTrie &ruleTable
+                                        , ParsedRule &rule)
+{
+  std::string hiero_before, hiero_after;
+  if (format == HieroFormat) { // inefficiently reformat line
+    hiero_before.assign(line.data(), line.size());
+    ReformatHieroRule(hiero_before, hiero_after);
+    line = hiero_after;
+  }
+
+  util::TokenIter<util::MultiCharacter> pipes(line, "|||");
+  StringPiece sourcePhraseString(*pipes);
+  StringPiece targetPhraseString(*++pipes);
+  StringPiece scoreString(*++pipes);
+
+  StringPiece alignString;
+  if (++pipes) {
+    StringPiece temp(*pipes);
+    alignString = temp;
+  }
+
+  bool isLHSEmpty = (sourcePhraseString.find_first_not_of(" \t", 0) == string::npos);
+  if (isLHSEmpty && !opts.unk.word_deletion_enabled) {
+    TRACE_ERR( ruleTable.GetFilePath() << ":" << count << ": pt entry contains empty target, skipping\n");
+    return false;
+  }
+
+  vector<float> scoreVector;
+  for (util::TokenIter<util::AnyCharacter, true> s(scoreString, " \t"); s; ++s) {
+    int processed;
+    float score = converter.StringToFloat(s->data(), s->length(), &processed);
+    UTIL_THROW_IF2(isnan(score), "Bad score " << *s << " on line " << count);
+    scoreVector.push_back(FloorScore(TransformScore(score)));
+  }
+  const size_t numScoreComponents = ruleTable.GetNumScoreComponents();
+  if (scoreVector.size() != numScoreComponents) {
+    UTIL_THROW2("Size of scoreVector != number (" << scoreVector.size() << "!="
+                << numScoreComponents << ") of score components on line " << count);
+  }
+
+  // parse source & find pt node
+
+  // constituent labels
+  rule.sourceLHS = NULL;
+  Word *targetLHS;
+
+  // create target phrase obj
+  TargetPhrase *targetPhrase = new TargetPhrase(&ruleTable);
+  rule.targetPhrase = targetPhrase;
+  targetPhrase->CreateFromString(Output, output, targetPhraseString, &targetLHS);
+  // source
+  rule.sourcePhrase.Clear();
+  rule.sourcePhrase.CreateFromString(Input, input, sourcePhraseString, &rule.sourceLHS);
+
+  // rest of target phrase
+  targetPhrase->SetAlignmentInfo(alignString);
+  targetPhrase->SetTargetLHS(targetLHS);
+
+  ++pipes;  // skip over counts field
+
+  if (++pipes) {
+    StringPiece sparseString(*pipes);
+    targetPhrase->SetSparseScore(&ruleTable, sparseString);
+  }
+
+  if (++pipes) {
+    StringPiece propertiesString(*pipes);
+    targetPhrase->SetProperties(propertiesString);
+  }
+
+  targetPhrase->GetScoreBreakdown().Assign(&ruleTable, scoreVector);
+  targetPhrase->EvaluateInIsolation(rule.sourcePhrase, ruleTable.GetFeaturesToApply());
+
+  return true;
+}
+
+void RuleTableLoaderStandard::AddRule(RuleTableTrie &ruleTable, ParsedRule &rule)
+{
+  TargetPhraseCollection::shared_ptr phraseColl
+  = GetOrCreateTargetPhraseCollection(ruleTable, rule.sourcePhrase,
+                                      *rule.targetPhrase, rule.sourceLHS);
+  phraseColl->Add(rule.targetPhrase);
+
+  // not implemented correctly in memory pt. just delete it for now
+  delete rule.sourceLHS;
+}
+
 bool RuleTableLoaderStandard::Load(AllOptions const& opts, FormatType format
                                    , const std::vector<FactorType> &input
                                    , const std::vector<FactorType> &output
@@ -151,17 +249,23 @@ bool RuleTableLoaderStandard::Load(AllOptions const& opts, FormatType format
 
   // const StaticData &staticData = StaticData::Instance();
 
-  string lineOrig;
   size_t count = 0;
 
   std::ostream *progress = NULL;
   IFVERBOSE(1) progress = &std::cerr;
   util::FilePiece in(inFile.c_str(), progress);
 
+#ifdef WITH_THREADS
+  if (ruleTable.GetLoadThreads() > 1) {
+    LoadParallel(opts, format, input, output, in, ruleTable);
+    SortAndPrune(ruleTable);
+    return true;
+  }
+#endif
+
   // reused variables
-  vector<float> scoreVector;
   StringPiece line;
-  std::string hiero_before, hiero_after;
+  ParsedRule rule;
 
   double_conversion::StringToDoubleConverter converter(double_conversion::StringToDoubleConverter::NO_FLAGS, NAN, NAN, "inf", "nan");
 
@@ -172,89 +276,236 @@ bool RuleTableLoaderStandard::Load(AllOptions const& opts, FormatType format
       break;
     }
 
-    if (format == HieroFormat) { // inefficiently reformat line
-      hiero_before.assign(line.data(), line.size());
-      ReformatHieroRule(hiero_before, hiero_after);
-      line = hiero_after;
+    if (!ParseLine(opts, format, input, output, line, count, converter, ruleTable, rule)) {
+      continue;
     }
+    AddRule(ruleTable, rule);
 
-    util::TokenIter<util::MultiCharacter> pipes(line, "|||");
-    StringPiece sourcePhraseString(*pipes);
-    StringPiece targetPhraseString(*++pipes);
-    StringPiece scoreString(*++pipes);
+    count++;
+  }
 
-    StringPiece alignString;
-    if (++pipes) {
-      StringPiece temp(*pipes);
-      alignString = temp;
-    }
+  // sort and prune each target phrase collection
+  SortAndPrune(ruleTable);
 
-    bool isLHSEmpty = (sourcePhraseString.find_first_not_of(" \t", 0) == string::npos);
-    if (isLHSEmpty && !opts.unk.word_deletion_enabled) {
-      TRACE_ERR( ruleTable.GetFilePath() << ":" << count << ": pt entry contains empty target, skipping\n");
-      continue;
+  return true;
+}
+
+#ifdef WITH_THREADS
+namespace
+{
+/** Hands out blocks of rule table lines to the parsing threads and
+ *  gives them back to the inserting thread in file order. The number of
+ *  blocks in flight is bounded to cap memory use.
+ */
+template<class Rule>
+class RuleBlockQueue
+{
+public:
+  struct Block {
+    size_t id;
+    size_t firstLine;
+    bool parsed;
+    std::vector<std::string> lines;
+    std::vector<Rule> rules;
+  };
+
+  explicit RuleBlockQueue(size_t maxInFlight)
+    : m_maxInFlight(maxInFlight), m_nextRead(0), m_nextParse(0)
+    , m_eof(false), m_abort(false) {}
+
+  ~RuleBlockQueue() {
+    typename std::map<size_t, Block*>::iterator iter;
+    for (iter = m_inFlight.begin(); iter != m_inFlight.end(); ++iter) {
+      delete iter->second;
     }
+  }
 
-    scoreVector.clear();
-    for (util::TokenIter<util::AnyCharacter, true> s(scoreString, " \t"); s; ++s) {
-      int processed;
-      float score = converter.StringToFloat(s->data(), s->length(), &processed);
-      UTIL_THROW_IF2(isnan(score), "Bad score " << *s << " on line " << count);
-      scoreVector.push_back(FloorScore(TransformScore(score)));
+  //! reader: blocks until there is room for another block
+  bool Push(Block *block) {
+    boost::mutex::scoped_lock lock(m_mutex);
+    while (!m_abort && m_inFlight.size() >= m_maxInFlight) {
+      m_cond.wait(lock);
     }
-    const size_t numScoreComponents = ruleTable.GetNumScoreComponents();
-    if (scoreVector.size() != numScoreComponents) {
-      UTIL_THROW2("Size of scoreVector != number (" << scoreVector.size() << "!="
-                  << numScoreComponents << ") of score components on line " << count);
+    if (m_abort) return false;
+    block->id = m_nextRead++;
+    block->parsed = false;
+    m_inFlight[block->id] = block;
+    m_cond.notify_all();
+    return true;
+  }
+
+  void SetEOF() {
+    boost::mutex::scoped_lock lock(m_mutex);
+    m_eof = true;
+    m_cond.notify_all();
+  }
+
+  //! parser: next unparsed block, or NULL when the input is exhausted
+  Block *NextToParse() {
+    boost::mutex::scoped_lock lock(m_mutex);
+    while (!m_abort && !m_eof && m_nextParse == m_nextRead) {
+      m_cond.wait(lock);
     }
+    if (m_abort || m_nextParse == m_nextRead) return NULL;
+    return m_inFlight[m_nextParse++];
+  }
 
-    // parse source & find pt node
+  void DoneParsing(Block *block) {
+    boost::mutex::scoped_lock lock(m_mutex);
+    block->parsed = true;
+    m_cond.notify_all();
+  }
 
-    // constituent labels
-    Word *sourceLHS = NULL;
-    Word *targetLHS;
+  //! inserter: block number id once it is parsed, NULL if there is none
+  Block *WaitParsed(size_t id) {
+    boost::mutex::scoped_lock lock(m_mutex);
+    while (!m_abort && !IsParsed(id) && !(m_eof && id >= m_nextRead)) {
+      m_cond.wait(lock);
+    }
+    if (m_abort || !IsParsed(id)) return NULL;
+    return m_inFlight[id];
+  }
 
-    // create target phrase obj
-    TargetPhrase *targetPhrase = new TargetPhrase(&ruleTable);
-    targetPhrase->CreateFromString(Output, output, targetPhraseString, &targetLHS);
-    // source
-    Phrase sourcePhrase;
-    sourcePhrase.CreateFromString(Input, input, sourcePhraseString, &sourceLHS);
+  void Release(size_t id) {
+    boost::mutex::scoped_lock lock(m_mutex);
+    delete m_inFlight[id];
+    m_inFlight.erase(id);
+    m_cond.notify_all();
+  }
 
-    // rest of target phrase
-    targetPhrase->SetAlignmentInfo(alignString);
-    targetPhrase->SetTargetLHS(targetLHS);
+  void Abort(const std::string &error) {
+    boost::mutex::scoped_lock lock(m_mutex);
+    if (!m_abort) m_error = error;
+    m_abort = true;
+    m_cond.notify_all();
+  }
 
-    ++pipes;  // skip over counts field
+  bool Aborted() const {
+    boost::mutex::scoped_lock lock(m_mutex);
+    return m_abort;
+  }
+  std::string GetError() const {
+    boost::mutex::scoped_lock lock(m_mutex);
+    return m_error;
+  }
 
-    if (++pipes) {
-      StringPiece sparseString(*pipes);
-      targetPhrase->SetSparseScore(&ruleTable, sparseString);
-    }
+private:
+  bool IsParsed(size_t id) const {
+    typename std::map<size_t, Block*>::const_iterator iter = m_inFlight.find(id);
+    return iter != m_inFlight.end() && iter->second->parsed;
+  }
 
-    if (++pipes) {
-      StringPiece propertiesString(*pipes);
-      targetPhrase->SetProperties(propertiesString);
+  size_t m_maxInFlight;
+  size_t m_nextRead, m_nextParse;
+  std::map<size_t, Block*> m_inFlight;
+  bool m_eof, m_abort;
+  std::string m_error;
+  mutable boost::mutex m_mutex;
+  boost::condition_variable m_cond;
+};
+
+template<class Queue>
+void ReadRuleBlocks(util::FilePiece *in, Queue *queue, size_t blockSize)
+{
+  try {
+    size_t lineNum = 0;
+    bool eof = false;
+    while (!eof) {
+      typename Queue::Block *block = new typename Queue::Block;
+      block->firstLine = lineNum;
+      block->lines.reserve(blockSize);
+      while (block->lines.size() < blockSize) {
+        try {
+          block->lines.push_back(in->ReadLine().as_string());
+        } catch (const util::EndOfFileException &e) {
+          eof = true;
+          break;
+        }
+      }
+      lineNum += block->lines.size();
+      if (block->lines.empty() || !queue->Push(block)) {
+        delete block;
+        break;
+      }
     }
+  } catch (const std::exception &e) {
+    queue->Abort(e.what());
+  }
+  queue->SetEOF();
+}
+}
 
-    targetPhrase->GetScoreBreakdown().Assign(&ruleTable, scoreVector);
-    targetPhrase->EvaluateInIsolation(sourcePhrase, ruleTable.GetFeaturesToApply());
-
-    TargetPhraseCollection::shared_ptr phraseColl
-    = GetOrCreateTargetPhraseCollection(ruleTable, sourcePhrase,
-                                        *targetPhrase, sourceLHS);
-    phraseColl->Add(targetPhrase);
+//! worker thread body of LoadParallel
+template<class Queue>
+void RuleTableLoaderStandard::ParseBlocks(Queue *queue
+    , AllOptions const* opts
+    , FormatType format
+    , const std::vector<FactorType> *input
+    , const std::vector<FactorType> *output
+    , const double_conversion::StringToDoubleConverter *converter
+    , RuleTableTrie *ruleTable)
+{
+  typename Queue::Block *block;
+  while ((block = queue->NextToParse()) != NULL) {
+    block->rules.resize(block->lines.size());
+    try {
+      for (size_t i = 0; i < block->lines.size(); ++i) {
+        std::pair<bool, ParsedRule> &rule = block->rules[i];
+        rule.first = ParseLine(*opts, format, *input, *output, block->lines[i],
+                               block->firstLine + i, *converter, *ruleTable, rule.second);
+      }
+    } catch (const std::exception &e) {
+      queue->Abort(e.what());
+    }
+    block->lines.clear();
+    queue->DoneParsing(block);
+  }
+}
 
-    // not implemented correctly in memory pt. just delete it for now
-    delete sourceLHS;
+/** Three stage pipeline: one thread reads the (possibly compressed) file in
+ *  blocks of lines, GetLoadThreads() threads parse and score the rules, and
+ *  the calling thread inserts them into the trie. Blocks are inserted in
+ *  file order, so the table is identical to the one the sequential loader
+ *  builds.
+ */
+void RuleTableLoaderStandard::LoadParallel(AllOptions const& opts
+    , FormatType format
+    , const std::vector<FactorType> &input
+    , const std::vector<FactorType> &output
+    , util::FilePiece &in
+    , RuleTableTrie &ruleTable)
+{
+  typedef RuleBlockQueue<std::pair<bool, ParsedRule> > Queue;
+  const size_t blockSize = 10000;
+  const size_t numThreads = ruleTable.GetLoadThreads();
+  Queue queue(4 * numThreads);
+  double_conversion::StringToDoubleConverter converter(double_conversion::StringToDoubleConverter::NO_FLAGS, NAN, NAN, "inf", "nan");
 
-    count++;
+  boost::thread_group threads;
+  threads.create_thread(boost::bind(&ReadRuleBlocks<Queue>, &in, &queue, blockSize));
+  for (size_t i = 0; i < numThreads; ++i) {
+    threads.create_thread(boost::bind(&RuleTableLoaderStandard::ParseBlocks<Queue>, &queue,
+                                      &opts, format, &input, &output, &converter, &ruleTable));
   }
 
-  // sort and prune each target phrase collection
-  SortAndPrune(ruleTable);
+  try {
+    Queue::Block *block;
+    for (size_t id = 0; (block = queue.WaitParsed(id)) != NULL; ++id) {
+      for (size_t i = 0; i < block->rules.size(); ++i) {
+        if (block->rules[i].first) {
+          AddRule(ruleTable, block->rules[i].second);
+        }
+      }
+      queue.Release(id);
+    }
+  } catch (const std::exception &e) {
+    queue.Abort(e.what());
+  }
 
-  return true;
+  threads.join_all();
+  UTIL_THROW_IF2(queue.Aborted(), "Error loading " << ruleTable.GetFilePath()
+                 << ": " << queue.GetError());
 }
+#endif
 
 }
@@ -20,6 +20,18 @@
 #pragma once
 
 #include "Loader.h"
+#include "moses/Phrase.h"
+#include "util/string_piece.hh"
+
+namespace util
+{
+class FilePiece;
+}
+
+namespace double_conversion
+{
+class StringToDoubleConverter;
+}
 
 namespace Moses
 {
@@ -28,6 +40,41 @@ namespace Moses
 class RuleTableLoaderStandard : public RuleTableLoader
 {
 protected:
+  //! one rule table line, parsed and scored but not yet in the trie
+  struct ParsedRule {
+    TargetPhrase *targetPhrase;
+    Phrase sourcePhrase;
+    Word *sourceLHS;
+  };
+
+  static bool ParseLine(AllOptions const& opts,
+                        FormatType format,
+                        const std::vector<FactorType> &input,
+                        const std::vector<FactorType> &output,
+                        StringPiece line,
+                        size_t count,
+                        const double_conversion::StringToDoubleConverter &converter,
+                        RuleTableTrie &ruleTable,
+                        ParsedRule &rule);
+
+  template<class Queue>
+  static void ParseBlocks(Queue *queue,
+                          AllOptions const* opts,
+                          FormatType format,
+                          const std::vector<FactorType> *input,
+                          const std::vector<FactorType> *output,
+                          const double_conversion::StringToDoubleConverter *converter,
+                          RuleTableTrie *ruleTable);
+
+  void AddRule(RuleTableTrie &ruleTable, ParsedRule &rule);
+
+  void LoadParallel(AllOptions const& opts,
+                    FormatType format,
+                    const std::vector<FactorType> &input,
+                    const std::vector<FactorType> &output,
+                    util::FilePiece &in,
+                    RuleTableTrie &ruleTable);
+
 
   bool Load(AllOptions const& opts,
             FormatType format,
@@ -19,15 +19,9 @@
  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
  ***********************************************************************/
 
-#include <cstdio>
 #include <cstdlib>
-#include <cstring>
-#include <climits>
-#include <sys/types.h>
-#include <unistd.h>
-#include <dirent.h>
 
-#include <fstream>
+#include <sstream>
 #include <string>
 #include <iterator>
 #include <algorithm>
@@ -44,45 +38,16 @@
 #include "moses/TranslationModel/fuzzy-match/FuzzyMatchWrapper.h"
 #include "moses/TranslationModel/fuzzy-match/SentenceAlignment.h"
 #include "moses/TranslationTask.h"
-#include "util/file.hh"
 #include "util/exception.hh"
-#include "util/random.hh"
 
 using namespace std;
 
-#if defined __MINGW32__ && !defined mkdtemp
-#include <windows.h>
-#include <cerrno>
-char *mkdtemp(char *tempbuf)
-{
-  int rand_value = 0;
-  char* tempbase = NULL;
-  char tempbasebuf[MAX_PATH] = "";
-
-  if (strcmp(&tempbuf[strlen(tempbuf)-6], "XXXXXX")) {
-    errno = EINVAL;
-    return NULL;
-  }
-
-  util::rand_init();
-  rand_value = util::rand_excl(1e6);
-  tempbase = strrchr(tempbuf, '/');
-  tempbase = tempbase ? tempbase+1 : tempbuf;
-  strcpy(tempbasebuf, tempbase);
-  sprintf(&tempbasebuf[strlen(tempbasebuf)-6], "%d", rand_value);
-  ::GetTempPath(MAX_PATH, tempbuf);
-  strcat(tempbuf, tempbasebuf);
-  ::CreateDirectory(tempbuf, NULL);
-  return tempbuf;
-}
-#endif
-
 namespace Moses
 {
 
 PhraseDictionaryFuzzyMatch::PhraseDictionaryFuzzyMatch(const std::string &line)
   :PhraseDictionary(line, true)
-  ,m_config(3)
+  ,m_config(4)
   ,m_FuzzyMatchWrapper(NULL)
 {
   ReadParameters();
@@ -98,7 +63,11 @@ void PhraseDictionaryFuzzyMatch::Load(AllOptions::ptr const& opts)
   m_options = opts;
   SetFeaturesToApply();
 
-  m_FuzzyMatchWrapper = new tmmt::FuzzyMatchWrapper(m_config[0], m_config[1], m_config[2]);
+  if (!m_config[3].empty()) {
+    m_FuzzyMatchWrapper = new tmmt::FuzzyMatchWrapper(m_config[3]);
+  } else {
+    m_FuzzyMatchWrapper = new tmmt::FuzzyMatchWrapper(m_config[0], m_config[1], m_config[2]);
+  }
 }
 
 ChartRuleLookupManager *PhraseDictionaryFuzzyMatch::CreateRuleLookupManager(
@@ -119,135 +88,49 @@ SetParameter(const std::string& key, const std::string& value)
     m_config[1] = value;
   } else if (key == "alignment") {
     m_config[2] = value;
+  } else if (key == "index") {
+    m_config[3] = value;
   } else {
     PhraseDictionary::SetParameter(key, value);
   }
 }
 
-int removedirectoryrecursively(const char *dirname)
-{
-#if defined __MINGW32__
-  //TODO(jie): replace this function with boost implementation
-#else
-  DIR *dir;
-  struct dirent *entry;
-  char path[PATH_MAX];
-
-  dir = opendir(dirname);
-  if (dir == NULL) {
-    perror("Error opendir()");
-    return 0;
-  }
-
-  while ((entry = readdir(dir)) != NULL) {
-    if (strcmp(entry->d_name, ".") && strcmp(entry->d_name, "..")) {
-      snprintf(path, (size_t) PATH_MAX, "%s/%s", dirname, entry->d_name);
-      if (entry->d_type == DT_DIR) {
-        removedirectoryrecursively(path);
-      }
-
-      remove(path);
-      /*
-       * Here, the actual deletion must be done.  Beacuse this is
-       * quite a dangerous thing to do, and this program is not very
-       * well tested, we are just printing as if we are deleting.
-       */
-      //printf("(not really) Deleting: %s\n", path);
-      /*
-       * When you are finished testing this and feel you are ready to do the real
-       * deleting, use this: remove*STUB*(path);
-       * (see "man 3 remove")
-       * Please note that I DONT TAKE RESPONSIBILITY for data you delete with this!
-       */
-    }
-
-  }
-  closedir(dir);
-
-  rmdir(dirname);
-  /*
-   * Now the directory is emtpy, finally delete the directory itself. (Just
-   * printing here, see above)
-   */
-  //printf("(not really) Deleting: %s\n", dirname);
-#endif
-  return 1;
-}
-
 void PhraseDictionaryFuzzyMatch::InitializeForInput(ttasksptr const& ttask)
 {
   InputType const& inputSentence = *ttask->GetSource();
-#if defined __MINGW32__
-  char dirName[] = "moses.XXXXXX";
-#else
-  char dirName[] = "/tmp/moses.XXXXXX";
-#endif // defined
-  char *temp = mkdtemp(dirName);
-  UTIL_THROW_IF2(temp == NULL,
-                 "Couldn't create temporary directory " << dirName);
-
-  string dirNameStr(dirName);
-
-  string inFileName(dirNameStr + "/in");
-
-  ofstream inFile(inFileName.c_str());
 
+  std::ostringstream input;
   for (size_t i = 1; i < inputSentence.GetSize() - 1; ++i) {
-    inFile << inputSentence.GetWord(i);
+    input << inputSentence.GetWord(i);
   }
-  inFile << endl;
-  inFile.close();
 
+  // rules are created and scored in memory
   long translationId = inputSentence.GetTranslationId();
-  string ptFileName = m_FuzzyMatchWrapper->Extract(translationId, dirNameStr);
+  vector<tmmt::FuzzyMatchWrapper::Rule> rules;
+  m_FuzzyMatchWrapper->Extract(translationId, input.str(), rules);
 
   // populate with rules for this sentence
   PhraseDictionaryNodeMemory &rootNode = m_collection[translationId];
-  FormatType format = MosesFormat;
-
-  // data from file
-  InputFileStream inStream(ptFileName);
 
   // copied from class LoaderStandard
   PrintUserTime("Start loading fuzzy-match phrase model");
 
-  const StaticData &staticData = StaticData::Instance();
-
-
-  string lineOrig;
   size_t count = 0;
 
-  while(getline(inStream, lineOrig)) {
-    const string *line;
-    if (format == HieroFormat) { // reformat line
-      UTIL_THROW(util::Exception, "Cannot be Hiero format");
-      //line = ReformatHieroRule(lineOrig);
-    } else {
-      // do nothing to format of line
-      line = &lineOrig;
-    }
-
-    vector<string> tokens;
-    vector<float> scoreVector;
-
-    TokenizeMultiCharSeparator(tokens, *line , "|||" );
-
-    if (tokens.size() != 4 && tokens.size() != 5) {
-      UTIL_THROW2("Syntax error at " << ptFileName << ":" << count);
-    }
+  for (size_t ruleInd = 0; ruleInd < rules.size(); ++ruleInd) {
+    const tmmt::FuzzyMatchWrapper::Rule &rule = rules[ruleInd];
 
-    const string &sourcePhraseString = tokens[0]
-                                       , &targetPhraseString = tokens[1]
-                                           , &scoreString        = tokens[2]
-                                               , &alignString        = tokens[3];
+    const string &sourcePhraseString = rule.source
+                                       , &targetPhraseString = rule.target
+                                           , &alignString        = rule.alignment;
 
     bool isLHSEmpty = (sourcePhraseString.find_first_not_of(" \t", 0) == string::npos);
     if (isLHSEmpty && !ttask->options()->unk.word_deletion_enabled) {
-      TRACE_ERR( ptFileName << ":" << count << ": pt entry contains empty target, skipping\n");
+      TRACE_ERR( "fuzzy-match rule " << count << ": pt entry contains empty target, skipping\n");
       continue;
     }
 
-    Tokenize<float>(scoreVector, scoreString);
+    vector<float> scoreVector(rule.scores);
     const size_t numScoreComponents = GetNumScoreComponents();
     if (scoreVector.size() != numScoreComponents) {
       UTIL_THROW2("Size of scoreVector != number (" << scoreVector.size() << "!="
@@ -289,19 +172,10 @@ void PhraseDictionaryFuzzyMatch::InitializeForInput(ttasksptr const& ttask)
     phraseColl->Add(targetPhrase);
 
     count++;
-
-    if (format == HieroFormat) { // reformat line
-      delete line;
-    } else {
-      // do nothing
-    }
-
   }
 
   // sort and prune each target phrase collection
   SortAndPrune(rootNode);
-
-  //removedirectoryrecursively(dirName);
 }
 
 TargetPhraseCollection::shared_ptr
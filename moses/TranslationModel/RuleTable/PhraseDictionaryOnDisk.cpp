@@ -165,6 +165,33 @@ void PhraseDictionaryOnDisk::GetTargetPhraseCollectionBatch(InputPath &inputPath
   }
 }
 
+bool
+PhraseDictionaryOnDisk::
+PrefixExists(ttasksptr const& ttask, Phrase const& phrase) const
+{
+  OnDiskPt::OnDiskWrapper &wrapper = const_cast<OnDiskPt::OnDiskWrapper&>(GetImplementation());
+  const OnDiskPt::PhraseNode *currNode = &wrapper.GetRootSourceNode();
+  for (size_t pos = 0; currNode && pos < phrase.GetSize(); ++pos) {
+    Word word = phrase.GetWord(pos);
+    word.OnlyTheseFactors(m_inputFactors);
+    OnDiskPt::Word *wordOnDisk = wrapper.ConvertFromMoses(m_input, word);
+    const OnDiskPt::PhraseNode *nextNode = NULL;
+    if (wordOnDisk) {
+      nextNode = currNode->GetChild(*wordOnDisk, wrapper);
+      delete wordOnDisk;
+    }
+    if (pos) {
+      delete currNode;
+    }
+    currNode = nextNode;
+  }
+  bool ret = currNode != NULL;
+  if (phrase.GetSize()) {
+    delete currNode;
+  }
+  return ret;
+}
+
 TargetPhraseCollection::shared_ptr
 PhraseDictionaryOnDisk::
 GetTargetPhraseCollection(const OnDiskPt::PhraseNode *ptNode) const
@@ -78,6 +78,11 @@ public:
   virtual void InitializeForInput(ttasksptr const& ttask);
   void GetTargetPhraseCollectionBatch(const InputPathList &inputPathQueue) const;
 
+  bool ProvidesPrefixCheck() const {
+    return true;
+  }
+  bool PrefixExists(ttasksptr const& ttask, Phrase const& phrase) const;
+
   TargetPhraseCollection::shared_ptr
   GetTargetPhraseCollection(const OnDiskPt::PhraseNode *ptNode) const;
 
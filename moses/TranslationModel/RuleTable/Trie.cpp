@@ -51,4 +51,14 @@ void RuleTableTrie::Load(AllOptions::ptr const& opts)
   }
 }
 
+void RuleTableTrie::SetParameter(const std::string& key, const std::string& value)
+{
+  if (key == "load-threads") {
+    m_loadThreads = Scan<size_t>(value);
+    UTIL_THROW_IF2(m_loadThreads == 0, "load-threads must be at least 1");
+  } else {
+    PhraseDictionary::SetParameter(key, value);
+  }
+}
+
 }  // namespace Moses
@@ -41,13 +41,24 @@ class RuleTableTrie : public PhraseDictionary
 {
 public:
   RuleTableTrie(const std::string &line)
-    : PhraseDictionary(line, true) {
+    : PhraseDictionary(line, true)
+    , m_loadThreads(1) {
   }
 
   virtual ~RuleTableTrie();
 
   void Load(AllOptions::ptr const& opts);
 
+  void SetParameter(const std::string& key, const std::string& value);
+
+  //! number of threads a text rule table loader may use (1 = sequential)
+  size_t GetLoadThreads() const {
+    return m_loadThreads;
+  }
+
+protected:
+  size_t m_loadThreads;
+
 private:
   friend class RuleTableLoader;
 
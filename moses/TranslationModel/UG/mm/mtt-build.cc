@@ -10,6 +10,7 @@
 #include <boost/program_options/parsers.hpp>
 #include <boost/program_options/variables_map.hpp>
 #include <boost/iostreams/device/mapped_file.hpp>
+#include <boost/unordered_map.hpp>
 
 #include <iostream>
 #include <fstream>
@@ -28,6 +29,9 @@
 #include "ug_deptree.h"
 #include "moses/TranslationModel/UG/generic/sorting/VectorIndexSorter.h"
 #include "moses/TranslationModel/UG/mm/ug_im_tsa.h"
+#include "util/file_piece.hh"
+#include "util/tokenize_piece.hh"
+#include "util/usage.hh"
 
 using namespace std;
 using namespace sapt;
@@ -43,6 +47,7 @@ int with_sfas;
 bool incremental = false; // build / grow vocabs automatically
 bool is_conll    = false; // text or conll format?
 bool quiet       = false; // no progress reporting
+size_t threads   = 0;     // threads for sorting (0: all cores)
 
 string vocabBase; // base name for existing vocabs that should be used
 string baseName;  // base name for all files
@@ -152,6 +157,15 @@ void fill_rec(Conll_Record& rec, vector<string> const& w)
     }
 }
 
+// report the time spent in a phase of the build and start the next one
+void log_phase(char const* phase, double& start_time)
+{
+  if (quiet) return;
+  double now = util::WallTime();
+  cerr << phase << " took " << now - start_time << " seconds." << endl;
+  start_time = now;
+}
+
 void log_progress(size_t ctr)
 {
   if (ctr % 100000 == 0)
@@ -166,22 +180,43 @@ void log_progress(size_t ctr)
 }
 
 
+// Streams the corpus from stdin into the token track. Token ids of words
+// already seen are cached, which spares most lookups in (and, in
+// incremental mode, locking of) the vocabulary. Ids are written in blocks
+// in the byte order of tpt::numwrite.
 size_t
 process_plain_input(ostream& out, vector<id_type> & s_index)
 {
+  typedef boost::unordered_map<string,id_type> cache_t;
+  cache_t known;
+  vector<char> block;
+  block.reserve(1<<20);
   id_type totalWords = 0;
-  string line,w;
-  while (getline(cin,line))
+  util::FilePiece in(0, "stdin");
+  StringPiece line;
+  string w;
+  while (in.ReadLineOrEOF(line))
     {
-      istringstream buf(line);
       if (!quiet) log_progress(s_index.size());
       s_index.push_back(totalWords);
-      while (buf>>w)
+      for (util::TokenIter<util::BoolCharacter, true> t(line, util::kSpaces); t; ++t)
 	{
-	  tpt::numwrite(out,get_id(SF,w));
+	  w.assign(t->data(), t->size());
+	  cache_t::iterator m = known.find(w);
+	  id_type id;
+	  if (m != known.end()) id = m->second;
+	  else if ((id = get_id(SF,w)) != 1) known[w] = id;
+	  for (size_t i = 0; i < sizeof(id_type); ++i, id >>= 8)
+	    block.push_back(id%256);
 	  ++totalWords;
 	}
+      if (block.size() >= (1<<20) - 4096)
+	{
+	  out.write(&block[0], block.size());
+	  block.clear();
+	}
     }
+  if (block.size()) out.write(&block[0], block.size());
   s_index.push_back(totalWords);
   return totalWords;
 }
@@ -367,8 +402,10 @@ build_mmTSA(string infile, string outfile)
   boost::shared_ptr<mmTtrack<Token> > T(new mmTtrack<Token>(infile));
   bdBitset filter;
   filter.resize(T->size(),true);
-  imTSA<Token> S(T,&filter,(quiet?NULL:&cerr));
+  imTSA<Token> S(T,&filter,(quiet?NULL:&cerr),threads);
+  double start_time = util::WallTime();
   S.save_as_mm_tsa(outfile);
+  log_phase(("Writing " + outfile).c_str(), start_time);
   // exit(0);
 }
 
@@ -416,7 +453,9 @@ void build_conll_tsas()
 int main(int argc, char* argv[])
 {
   init(argc,argv);
+  double start_time = util::WallTime();
   numberize();
+  log_phase("Numberizing", start_time);
   if (SF.totalVocabSize() > SF.knownVocabSize() ||
       LM.totalVocabSize() > LM.knownVocabSize() ||
       PS.totalVocabSize() > PS.knownVocabSize() ||
@@ -424,9 +463,11 @@ int main(int argc, char* argv[])
     {
       remap();
       save_vocabs();
+      log_phase("Remapping and writing vocabularies", start_time);
     }
   if (is_conll) build_conll_tsas();
   else          build_plaintext_tsas();
+  log_phase("Building suffix arrays", start_time);
   if (!quiet) cerr << endl;
   rename(tmpFile.c_str(),mttFile.c_str());
 }
@@ -469,6 +510,9 @@ interpret_args(int ac, char* av[])
     ("unk,u", po::value<string>(&UNK)->default_value("UNK"),
      "label for unknown tokens")
 
+    ("threads,t", po::value<size_t>(&threads)->default_value(0),
+     "number of threads for sorting (0: all cores)")
+
     // ("map,m", po::value<string>(&vmap),
     // "map words to word classes for indexing")
 
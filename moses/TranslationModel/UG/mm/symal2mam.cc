@@ -13,6 +13,7 @@
 #include "tpt_pickler.h"
 #include "moses/TranslationModel/UG/generic/program_options/ug_get_options.h"
 #include "moses/TranslationModel/UG/generic/file_io/ug_stream.h"
+#include "moses/TranslationModel/UG/generic/threading/ug_thread_pool.h"
 
 #include <iostream>
 #include <string>
@@ -20,6 +21,7 @@
 
 #include <boost/program_options.hpp>
 #include <boost/scoped_ptr.hpp>
+#include <boost/thread.hpp>
 
 #include "util/exception.hh"
 // #include "headers-base/util/check.hh"
@@ -39,6 +41,7 @@ size_t lineCtr=0,sid=0;
 bool conll=false;
 bool skip=false;
 bool debug=false;
+size_t threads=0;
 TokenIndex V1;
 
 string mtt1name,mtt2name,o1name,o2name,mamname,cfgFile;
@@ -63,6 +66,7 @@ interpret_args(int ac, char* av[])
     ("t1",    po::value<string>(&mtt1name), "file name of L1 mapped token track")
     ("t2",    po::value<string>(&mtt2name), "file name of L2 mapped token track")
     ("format,F", po::value<string>(&dataFormat)->default_value("plain"), "data format (plain or conll)")
+    ("threads,t", po::value<size_t>(&threads)->default_value(0), "number of threads for parsing symal output (0: all cores)")
     ;
 
   h.add_options()
@@ -96,6 +100,8 @@ interpret_args(int ac, char* av[])
       cerr << "--skip requires --o1 and --o2" << endl;
       exit(1);
     }
+  if (threads == 0)
+    threads = max(boost::thread::hardware_concurrency(), 1U);
 }
 
 template<typename track_t>
@@ -107,23 +113,96 @@ copySentence(track_t const& T, size_t sid, ostream& dest)
   dest.write(a,z-a);
 }
 
-size_t
-procSymalLine(string const& line, ostream& out)
+// A line of symal output and the lengths of the sentences it aligns
+// (0 if unknown); an empty line leaves the word alignment matrix blank.
+struct SymalLine
+{
+  string line;
+  int len1, len2;
+  string mam; // binary encoding of the alignment points
+};
+
+// buf and out are passed in so that a thread can reuse them for all its lines
+void
+procSymalLine(SymalLine& s, istringstream& buf, ostringstream& out)
 {
   ushort a,b; char dash;
-  istringstream buf(line);
+  buf.clear();
+  buf.str(s.line);
+  out.str("");
   while (buf>>a>>dash>>b)
     {
-      if (debug && ((len1 && a >= len1) || (len2 && b >= len2)))
+      if (debug && ((s.len1 && a >= s.len1) || (s.len2 && b >= s.len2)))
         {
-          cerr << a << "-" << b << " " << len1 << "/" << len2 << endl;
+          cerr << a << "-" << b << " " << s.len1 << "/" << s.len2 << endl;
         }
-      assert(len1 == 0 || a<len1);
-      assert(len2 == 0 || b<len2);
+      assert(s.len1 == 0 || a<s.len1);
+      assert(s.len2 == 0 || b<s.len2);
       tpt::binwrite(out,a);
       tpt::binwrite(out,b);
     }
-  return out.tellp();
+  s.mam = out.str();
+}
+
+// converts a slice of a batch of lines; job for the thread pool
+class SymalConverter
+{
+  vector<SymalLine>* m_batch;
+  size_t m_begin, m_end;
+public:
+  SymalConverter(vector<SymalLine>* batch, size_t begin, size_t end)
+    : m_batch(batch), m_begin(begin), m_end(end) { }
+
+  bool
+  operator()()
+  {
+    istringstream buf;
+    ostringstream out;
+    for (size_t i = m_begin; i < m_end; ++i)
+      procSymalLine((*m_batch)[i], buf, out);
+    return true;
+  }
+};
+
+size_t const BATCH_SIZE = 100000;
+
+// Converts the lines in a batch in parallel, then appends their alignments
+// to the .mam file in input order.
+void
+flushBatch(vector<SymalLine>& batch, ofstream& out, vector<id_type>& idx)
+{
+  if (threads == 1)
+    {
+      SymalConverter job(&batch, 0, batch.size());
+      job();
+    }
+  else
+    {
+      ug::ThreadPool pool(threads);
+      size_t const step = (batch.size() + threads - 1) / threads;
+      for (size_t i = 0; i < batch.size(); i += step)
+        {
+          SymalConverter job(&batch, i, min(i + step, batch.size()));
+          pool.add(job);
+        }
+    } // the pool's destructor waits for all jobs to finish
+  for (size_t i = 0; i < batch.size(); ++i)
+    {
+      out.write(batch[i].mam.data(), batch[i].mam.size());
+      idx.push_back(out.tellp());
+    }
+  batch.clear();
+}
+
+void
+addLine(vector<SymalLine>& batch, string const& line,
+        ofstream& out, vector<id_type>& idx)
+{
+  batch.push_back(SymalLine());
+  batch.back().line = line;
+  batch.back().len1 = len1;
+  batch.back().len2 = len2;
+  if (batch.size() == BATCH_SIZE) flushBatch(batch, out, idx);
 }
 
 void finiMAM(ofstream& out, vector<id_type>& idx, id_type numTok)
@@ -182,12 +261,14 @@ go()
   idxm.reserve(10000000);
   idxm.push_back(mam.tellp());
   string line;
+  vector<SymalLine> batch;
   while(getline(cin,line))
     {
-      idxm.push_back(procSymalLine(line,mam));
+      addLine(batch,line,mam,idxm);
       if (debug && ++ctr%100000==0)
 	cerr << ctr/1000 << "K lines processed" << endl;
     }
+  flushBatch(batch,mam,idxm);
   finiMAM(mam,idxm,0);
   cout << idxm.size() << endl;
 }
@@ -205,6 +286,7 @@ go(string t1name, string t2name, string A3filename)
   vector<id_type> idx1(1,0),idx2(1,0),idxm(1, mam.tellp());
   size_t tokenCount1=0,tokenCount2=0;
   size_t skipCtr=0,lineCtr=0;
+  vector<SymalLine> batch;
   if (!getCheckValues(A3file, check1, check2))
     UTIL_THROW(util::Exception, "Mismatch in input files!");
 
@@ -228,7 +310,7 @@ go(string t1name, string t2name, string A3filename)
             }
           else
             {
-              idxm.push_back(mam.tellp());
+              addLine(batch,"",mam,idxm);
             }
           if (len1 > 100 || len2 > 100)
             {
@@ -250,13 +332,14 @@ go(string t1name, string t2name, string A3filename)
 	UTIL_THROW(util::Exception, "Too few lines in symal input!");
 
       lineCtr++;
-      idxm.push_back(procSymalLine(line,mam));
+      addLine(batch,line,mam,idxm);
       if (debug) cerr << "[" << lineCtr << "] "
                       << check1 << " (" << len1 <<") "
                       << check2 << " (" << len2 <<") "
                       << line << endl;
       getCheckValues(A3file,check1,check2);
     }
+  flushBatch(batch,mam,idxm);
   if (skip)
     {
       finalize(t1out,idx1,tokenCount1);
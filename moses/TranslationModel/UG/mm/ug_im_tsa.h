@@ -3,9 +3,7 @@
 #ifndef _ug_im_tsa_h
 #define _ug_im_tsa_h
 
-// TO DO:
-// - multi-threaded sorting during TSA construction (currently painfully slow!)
-
+#include <algorithm>
 #include <iostream>
 
 #include <boost/iostreams/device/mapped_file.hpp>
@@ -51,6 +49,34 @@ namespace sapt
     
   };
 
+  // merges two adjacent sorted runs [begin,mid) and [mid,end)
+  template<typename TOKEN, typename SORTER>
+  class TsaMerger
+  {
+  public:
+    typedef typename Ttrack<TOKEN>::Position cpos;
+    typedef typename std::vector<cpos>::iterator iter;
+  private:
+    SORTER m_sorter;
+    iter m_begin;
+    iter m_mid;
+    iter m_end;
+  public:
+    TsaMerger(SORTER sorter, iter begin, iter mid, iter end)
+      : m_sorter(sorter),
+        m_begin(begin),
+        m_mid(mid),
+        m_end(end) { }
+
+    bool
+    operator()()
+    {
+      std::inplace_merge(m_begin, m_mid, m_end, m_sorter);
+      return true;
+    }
+
+  };
+
 
  //-----------------------------------------------------------------------
   template<typename TOKEN>
@@ -169,7 +195,7 @@ namespace sapt
 	bdBitset const* filter,	std::ostream* log, size_t threads)
   {
     if (threads == 0) 
-      threads = boost::thread::hardware_concurrency();
+      threads = std::max(boost::thread::hardware_concurrency(), 1U);
     assert(c);
     this->corpus = c;
     bdBitset  filter2;
@@ -188,6 +214,9 @@ namespace sapt
     //       each section separately.
 
     if (log) *log << "counting tokens ... ";
+#ifndef NO_MOSES
+    double start_time = util::WallTime();
+#endif
     int slimit = 65536;
     // slimit=65536 is the upper bound of what we can fit into a ushort which
     // we currently use for the offset. Actually, due to (memory) word
@@ -224,18 +253,30 @@ namespace sapt
             assert(p < c->sntLen(sid));
 	  }
       }
+#ifndef NO_MOSES
+    if (log) *log << "Done counting after " << util::WallTime() - start_time
+		  << " seconds." << std::endl;
+#endif
 
-    // Now sort the array
+    // Now sort the array. The buckets of frequent words (punctuation,
+    // function words) hold a large share of all positions, so a bucket
+    // larger than a thread's share is sorted in one chunk per thread and
+    // the sorted chunks are merged pairwise afterwards. Since no two
+    // positions compare equal, the result does not depend on the number
+    // of threads.
     if (log) *log << "sorting .... with " << threads << " threads." << std::endl;
 #ifndef NO_MOSES
-    double start_time = util::WallTime();
+    start_time = util::WallTime();
 #endif
     boost::scoped_ptr<ug::ThreadPool> tpool;
     tpool.reset(new ug::ThreadPool(threads));
-    
+
     index.resize(wcnt.size()+1,0);
     typedef typename ttrack::Position::LESS<Ttrack<TOKEN> > sorter_t;
+    typedef typename std::vector<cpos>::iterator iter;
     sorter_t sorter(c.get());
+    size_t const max_chunk = std::max(sufa.size() / threads, size_t(2));
+    std::vector<std::vector<size_t> > runs; // chunk boundaries of split buckets
     for (size_t i = 0; i < wcnt.size(); i++)
       {
         // if (log && wcnt[i] > 5000)
@@ -243,20 +284,53 @@ namespace sapt
         //        << " entries starting with id " << i << "." << std::endl;
         index[i+1] = index[i]+wcnt[i];
         assert(index[i+1]==tmp[i]); // sanity check
-        if (wcnt[i]>1)
+        if (wcnt[i] > max_chunk && threads > 1)
+          {
+            runs.push_back(std::vector<size_t>(threads+1));
+            std::vector<size_t>& r = runs.back();
+            for (size_t k = 0; k <= threads; ++k)
+              r[k] = index[i] + wcnt[i] * k / threads;
+            for (size_t k = 0; k < threads; ++k)
+              {
+                iter b = sufa.begin()+r[k];
+                iter e = sufa.begin()+r[k+1];
+                TsaSorter<TOKEN,sorter_t> foo(sorter,b,e);
+                tpool->add(foo);
+              }
+          }
+        else if (wcnt[i]>1)
 	  {
-	    typename std::vector<cpos>::iterator b,e;
-	    b = sufa.begin()+index[i];
-	    e = sufa.begin()+index[i+1];
+	    iter b = sufa.begin()+index[i];
+	    iter e = sufa.begin()+index[i+1];
 	    TsaSorter<TOKEN,sorter_t> foo(sorter,b,e);
 	    tpool->add(foo);
 	    // sort(sufa.begin()+index[i],sufa.begin()+index[i+1],sorter);
 	  }
       }
     tpool.reset();
+
+    // merge the chunks of split buckets, halving the number of runs per round
+    for (size_t width = 1; width < threads; width *= 2)
+      {
+        tpool.reset(new ug::ThreadPool(threads));
+        for (size_t i = 0; i < runs.size(); ++i)
+          {
+            std::vector<size_t> const& r = runs[i];
+            for (size_t k = 0; k + width < threads; k += 2 * width)
+              {
+                size_t const stop = std::min(k + 2 * width, threads);
+                TsaMerger<TOKEN,sorter_t> foo(sorter, sufa.begin()+r[k],
+                                              sufa.begin()+r[k+width],
+                                              sufa.begin()+r[stop]);
+                tpool->add(foo);
+              }
+          }
+        tpool.reset();
+      }
 #ifndef NO_MOSES
     if (log) *log << "Done sorting after " << util::WallTime() - start_time
-		  << " seconds." << std::endl;
+		  << " seconds (" << runs.size() << " large buckets split)."
+		  << std::endl;
 #endif
     this->startArray = reinterpret_cast<char const*>(&(*sufa.begin()));
     this->endArray   = reinterpret_cast<char const*>(&(*sufa.end()));
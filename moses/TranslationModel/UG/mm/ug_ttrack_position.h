@@ -71,7 +71,13 @@ namespace sapt
             a = next(a);
             b = next(b);
             if (a < bosA || a >= eosA)
-              return (b >= bosB && b < eosB);
+              {
+                if (b >= bosB && b < eosB) return true;
+                // Identical sequences: order them by position, so that the
+                // order does not depend on the sorting algorithm.
+                return (b < bosB || b >= eosB) &&
+                  (A.sid < B.sid || (A.sid == B.sid && A.offset < B.offset));
+              }
             if (b < bosB || b >= eosB)
                 return false;
           }
@@ -0,0 +1,122 @@
+//
+//  EditDistance.h
+//  fuzzy-match
+//
+
+#ifndef fuzzy_match_EditDistance_h
+#define fuzzy_match_EditDistance_h
+
+#include <algorithm>
+#include <climits>
+#include <utility>
+#include <vector>
+
+#include <stdint.h>
+
+namespace tmmt
+{
+
+/* Levenshtein distance (unit cost insertion, deletion and substitution)
+ between a fixed pattern and any number of texts, computed with the
+ bit-parallel algorithm of Myers (1999) in the formulation of Hyyro (2001):
+ one column of the dynamic programming table is encoded in two bit vectors,
+ so each text symbol costs a few word operations instead of a table row.
+ Patterns of up to 64 symbols are supported (see Supported()).
+
+ Sequence is any container of comparable symbols, e.g. a sentence
+ (std::vector<WORD_ID>) or a word (std::string). */
+
+template <class Sequence>
+class EditDistance
+{
+public:
+  typedef typename Sequence::value_type Symbol;
+
+  static const size_t MAX_PATTERN_LENGTH = 64;
+
+  explicit EditDistance(const Sequence &pattern)
+    :m_length(pattern.size()) {
+    if (!Supported()) {
+      return;
+    }
+    // bit mask of the pattern positions of each symbol
+    for (size_t i = 0; i < m_length; ++i) {
+      m_peq.push_back(std::make_pair(pattern[i], uint64_t(1) << i));
+    }
+    std::sort(m_peq.begin(), m_peq.end());
+    size_t last = 0;
+    for (size_t i = 1; i < m_peq.size(); ++i) {
+      if (m_peq[i].first == m_peq[last].first) {
+        m_peq[last].second |= m_peq[i].second;
+      } else {
+        m_peq[++last] = m_peq[i];
+      }
+    }
+    if (!m_peq.empty()) {
+      m_peq.resize(last + 1);
+    }
+  }
+
+  bool Supported() const {
+    return m_length <= MAX_PATTERN_LENGTH;
+  }
+
+  /* Distance between the pattern and the text. Stops early once the
+   distance is known to exceed maxCost, returning a lower bound that is
+   larger than maxCost. */
+  unsigned int Distance(const Sequence &text, unsigned int maxCost = UINT_MAX) const {
+    const size_t n = text.size();
+    if (m_length == 0) {
+      return n;
+    }
+
+    const uint64_t last = uint64_t(1) << (m_length - 1);
+    uint64_t pv = ~uint64_t(0);
+    uint64_t mv = 0;
+    unsigned int score = m_length;
+
+    for (size_t j = 0; j < n; ++j) {
+      const uint64_t eq = Peq(text[j]);
+      const uint64_t xv = eq | mv;
+      const uint64_t xh = (((eq & pv) + pv) ^ pv) | eq;
+      uint64_t ph = mv | ~(xh | pv);
+      uint64_t mh = pv & xh;
+      if (ph & last) {
+        ++score;
+      } else if (mh & last) {
+        --score;
+      }
+      // the first row of the table is 0, 1, 2, ...
+      ph = (ph << 1) | 1;
+      mh <<= 1;
+      pv = mh | ~(xv | ph);
+      mv = ph & xv;
+
+      // each remaining symbol lowers the distance by at most 1
+      const size_t remaining = n - j - 1;
+      if (score > remaining && score - remaining > maxCost) {
+        return score - remaining;
+      }
+    }
+    return score;
+  }
+
+protected:
+  typedef std::pair<Symbol, uint64_t> PeqEntry;
+
+  uint64_t Peq(const Symbol &symbol) const {
+    typename std::vector<PeqEntry>::const_iterator found
+    = std::lower_bound(m_peq.begin(), m_peq.end(), PeqEntry(symbol, 0));
+    if (found == m_peq.end() || found->first != symbol) {
+      return 0;
+    }
+    return found->second;
+  }
+
+  size_t m_length;
+  std::vector<PeqEntry> m_peq;
+};
+
+}
+
+#endif
@@ -10,9 +10,9 @@
 #include "FuzzyMatchWrapper.h"
 #include "SentenceAlignment.h"
 #include "Match.h"
+#include "EditDistance.h"
 #include "create_xml.h"
 #include "moses/Util.h"
-#include "moses/StaticData.h"
 #include "util/file.hh"
 
 using namespace std;
@@ -21,27 +21,22 @@ namespace tmmt
 {
 
 FuzzyMatchWrapper::FuzzyMatchWrapper(const std::string &sourcePath, const std::string &targetPath, const std::string &alignmentPath)
-  :basic_flag(false)
-  ,lsed_flag(true)
-  ,refined_flag(true)
-  ,length_filter_flag(true)
-  ,parse_flag(true)
-  ,min_match(70)
-  ,multiple_flag(true)
-  ,multiple_slack(0)
-  ,multiple_max(100)
 {
+  init_flags();
+
   cerr << "creating suffix array" << endl;
   suffixArray = new tmmt::SuffixArray( sourcePath );
 
   //cerr << "loading source data" << endl;
   //load_corpus(sourcePath, source);
 
+  vector< vector< SentenceAlignment > > targets;
   cerr << "loading target data" << endl;
-  load_target(targetPath, targetAndAlignment);
+  load_target(targetPath, targets);
 
   cerr << "loading alignment" << endl;
-  load_alignment(alignmentPath, targetAndAlignment);
+  load_alignment(alignmentPath, targets);
+  targetAndAlignment.Assign(targets);
 
   // create suffix array
   //load_corpus(m_config[0], input);
@@ -49,57 +44,64 @@ FuzzyMatchWrapper::FuzzyMatchWrapper(const std::string &sourcePath, const std::s
   cerr << "loading completed" << endl;
 }
 
-string FuzzyMatchWrapper::Extract(long translationId, const string &dirNameStr)
+FuzzyMatchWrapper::FuzzyMatchWrapper(const std::string &indexPath)
 {
-  const Moses::StaticData &staticData = Moses::StaticData::Instance();
+  init_flags();
 
-  WordIndex wordIndex;
+  cerr << "loading translation memory index " << indexPath << endl;
+  m_index.reset(new IndexReader(indexPath));
+  suffixArray = new tmmt::SuffixArray( *m_index );
+  targetAndAlignment.Read(*m_index);
 
-  string fuzzyMatchFile = ExtractTM(wordIndex, translationId, dirNameStr);
-
-  // create extrac files
-  create_xml(fuzzyMatchFile);
-
-  // create phrase table with usual Moses scoring and consolidate programs
-  string cmd;
-  cmd = "LC_ALL=C sort " + fuzzyMatchFile + ".extract | gzip -c > "
-        + fuzzyMatchFile + ".extract.sorted.gz";
-  system(cmd.c_str());
-  cmd = "LC_ALL=C sort " + fuzzyMatchFile + ".extract.inv | gzip -c > "
-        + fuzzyMatchFile + ".extract.inv.sorted.gz";
-  system(cmd.c_str());
-
-#ifdef IS_XCODE
-  cmd = "/Users/hieuhoang/unison/workspace/github/moses-smt/bin";
-#elif IS_ECLIPSE
-  cmd = "/home/hieu/workspace/github/moses-smt/bin";
-#else
-  cmd = staticData.GetBinDirectory();
-#endif
+  cerr << "loading completed" << endl;
+}
 
-  cmd += string("/../scripts/training/train-model.perl -dont-zip -first-step 6 -last-step 6 -f en -e fr -hierarchical ")
-         + " -extract-file " + fuzzyMatchFile + ".extract -lexical-file - -score-options \"--NoLex\" "
-         + " -phrase-translation-table " + fuzzyMatchFile + ".pt";
-  system(cmd.c_str());
+FuzzyMatchWrapper::~FuzzyMatchWrapper()
+{
+  delete suffixArray;
+}
 
+void FuzzyMatchWrapper::init_flags()
+{
+  basic_flag = false;
+  lsed_flag = true;
+  refined_flag = true;
+  length_filter_flag = true;
+  parse_flag = true;
+  min_match = 70;
+  multiple_flag = true;
+  multiple_slack = 0;
+  multiple_max = 100;
+}
 
-  return fuzzyMatchFile + ".pt.gz";
+void FuzzyMatchWrapper::SaveIndex(const std::string &indexPath) const
+{
+  IndexWriter writer(indexPath);
+  suffixArray->Save(writer);
+  targetAndAlignment.Save(writer);
 }
 
-string FuzzyMatchWrapper::ExtractTM(WordIndex &wordIndex, long translationId, const string &dirNameStr)
+void FuzzyMatchWrapper::Extract(long translationId, const string &inputStr, vector<Rule> &rules)
 {
-  const std::vector< std::vector< WORD_ID > > &source = suffixArray->GetCorpus();
+  WordIndex wordIndex;
 
-  string inputPath = dirNameStr + "/in";
-  string fuzzyMatchFile = dirNameStr + "/fuzzyMatchFile";
-  ofstream fuzzyMatchStream(fuzzyMatchFile.c_str());
+  vector< WORD_ID > input = GetVocabulary().Tokenize( inputStr.c_str() );
 
-  vector< vector< WORD_ID > > input;
-  load_corpus(inputPath, input);
+  vector< ExtractedRule > extracted;
+  ExtractTM(wordIndex, translationId, input, extracted);
+
+  // score as the phrase-extract score and consolidate programs would
+  score_rules(extracted, rules);
+}
 
-  assert(input.size() == 1);
+void FuzzyMatchWrapper::ExtractTM(WordIndex &wordIndex, long translationId, const vector< WORD_ID > &inputSentence, vector< ExtractedRule > &extracted)
+{
+  vector< vector< WORD_ID > > input(1, inputSentence);
   size_t sentenceInd = 0;
 
+  // bit-parallel edit distance to the input, for validating the candidates
+  EditDistance< vector< WORD_ID > > inputDistance(input[sentenceInd]);
+
   clock_t start_clock = clock();
   // if (i % 10 == 0) cerr << ".";
 
@@ -254,8 +256,10 @@ string FuzzyMatchWrapper::ExtractTM(WordIndex &wordIndex, long translationId, co
   for(I tm=sentence_match.begin(); tm!=sentence_match.end(); tm++) {
     int tmID = tm->first;
     int tm_length = suffixArray->GetSentenceLength(tmID);
+    vector< WORD_ID > tmSentence;
+    suffixArray->GetSentenceWords(tmID, tmSentence);
     vector< Match > &match = tm->second;
-    add_short_matches(wordIndex, translationId, match, source[tmID], input_length, best_cost );
+    add_short_matches(wordIndex, translationId, match, tmSentence, input_length, best_cost );
 
     //cerr << "match in sentence " << tmID << ": " << match.size() << " [" << tm_length << "]" << endl;
 
@@ -289,8 +293,13 @@ string FuzzyMatchWrapper::ExtractTM(WordIndex &wordIndex, long translationId, co
     clock_t clock_validation_start = clock();
     if (! parse_flag ||
         pruned.size()>=10) { // to prevent worst cases
-      string path;
-      cost = sed( input[sentenceInd], source[tmID], path, false );
+      if (inputDistance.Supported()) {
+        // only exact up to best_cost, which is all that matters here
+        cost = inputDistance.Distance( tmSentence, best_cost );
+      } else {
+        string path;
+        cost = sed( input[sentenceInd], tmSentence, path, false );
+      }
       if (cost <  best_cost) {
         best_cost = cost;
       }
@@ -326,10 +335,12 @@ string FuzzyMatchWrapper::ExtractTM(WordIndex &wordIndex, long translationId, co
     for(size_t si=0; si<best_tm.size(); si++) {
       int s = best_tm[si];
       string path;
-      sed( input[sentenceInd], source[s], path, true );
-      const vector<WORD_ID> &sourceSentence = source[s];
-      vector<SentenceAlignment> &targets = targetAndAlignment[s];
-      create_extract(sentenceInd, best_cost, sourceSentence, targets, inputStr, path, fuzzyMatchStream);
+      vector<WORD_ID> sourceSentence;
+      suffixArray->GetSentenceWords(s, sourceSentence);
+      sed( input[sentenceInd], sourceSentence, path, true );
+      vector<SentenceAlignment> targets;
+      targetAndAlignment.Get(s, targets);
+      create_extract(sentenceInd, best_cost, sourceSentence, targets, inputStr, path, extracted);
 
     }
   } // if (multiple_flag)
@@ -344,7 +355,9 @@ string FuzzyMatchWrapper::ExtractTM(WordIndex &wordIndex, long translationId, co
       for(size_t si=0; si<best_tm.size(); si++) {
         int s = best_tm[si];
         string path;
-        unsigned int letter_cost = sed( input[sentenceInd], source[s], path, true );
+        vector<WORD_ID> sourceSentence;
+        suffixArray->GetSentenceWords(s, sourceSentence);
+        unsigned int letter_cost = sed( input[sentenceInd], sourceSentence, path, true );
         if (letter_cost < best_letter_cost) {
           best_letter_cost = letter_cost;
           best_path = path;
@@ -356,7 +369,9 @@ string FuzzyMatchWrapper::ExtractTM(WordIndex &wordIndex, long translationId, co
     else {
       if (best_tm.size() > 0) {
         string path;
-        sed( input[sentenceInd], source[best_tm[0]], path, false );
+        vector<WORD_ID> sourceSentence;
+        suffixArray->GetSentenceWords(best_tm[0], sourceSentence);
+        sed( input[sentenceInd], sourceSentence, path, false );
         best_path = path;
         best_match = best_tm[0];
       }
@@ -377,20 +392,18 @@ string FuzzyMatchWrapper::ExtractTM(WordIndex &wordIndex, long translationId, co
     //cout << " ||| " << best_match << " ||| " << best_path << endl;
 
     if (best_match == -1) {
-      UTIL_THROW_IF2(source.size() == 0, "Empty source phrase");
+      UTIL_THROW_IF2(suffixArray->GetSentenceCount() == 0, "Empty source phrase");
       best_match = 0;
     }
 
     // creat xml & extracts
-    const vector<WORD_ID> &sourceSentence = source[best_match];
-    vector<SentenceAlignment> &targets = targetAndAlignment[best_match];
-    create_extract(sentenceInd, best_cost, sourceSentence, targets, inputStr, best_path, fuzzyMatchStream);
+    vector<WORD_ID> sourceSentence;
+    suffixArray->GetSentenceWords(best_match, sourceSentence);
+    vector<SentenceAlignment> targets;
+    targetAndAlignment.Get(best_match, targets);
+    create_extract(sentenceInd, best_cost, sourceSentence, targets, inputStr, best_path, extracted);
 
   } // else if (multiple_flag)
-
-  fuzzyMatchStream.close();
-
-  return fuzzyMatchFile;
 }
 
 void FuzzyMatchWrapper::load_corpus( const std::string &fileName, vector< vector< WORD_ID > > &corpus )
@@ -516,7 +529,7 @@ bool FuzzyMatchWrapper::GetLSEDCache(const std::pair< WORD_ID, WORD_ID > &key, u
 #ifdef WITH_THREADS
   boost::shared_lock<boost::shared_mutex> read_lock(m_accessLock);
 #endif
-  map< pair< WORD_ID, WORD_ID >, unsigned int >::const_iterator lookup = m_lsed.find( key );
+  boost::unordered_map< pair< WORD_ID, WORD_ID >, unsigned int >::const_iterator lookup = m_lsed.find( key );
   if (lookup != m_lsed.end()) {
     value = lookup->second;
     return true;
@@ -549,6 +562,14 @@ unsigned int FuzzyMatchWrapper::letter_sed( WORD_ID aIdx, WORD_ID bIdx )
   const string &a = GetVocabulary().GetWord( aIdx );
   const string &b = GetVocabulary().GetWord( bIdx );
 
+  // bit-parallel for all but very long words
+  EditDistance< string > distance( a );
+  if (distance.Supported()) {
+    unsigned int final = distance.Distance( b );
+    SetLSEDCache(pIdx, final);
+    return final;
+  }
+
   // initialize cost matrix
   unsigned int **cost  = (unsigned int**) calloc( sizeof( unsigned int*  ), a.size()+1 );
   for( unsigned int i=0; i<=a.size(); i++ ) {
@@ -1000,7 +1021,7 @@ int FuzzyMatchWrapper::parse_matches( vector< Match > &match, int input_length,
 }
 
 
-void FuzzyMatchWrapper::create_extract(int sentenceInd, int cost, const vector< WORD_ID > &sourceSentence, const vector<SentenceAlignment> &targets, const string &inputStr, const string  &path, ofstream &outputFile)
+void FuzzyMatchWrapper::create_extract(int sentenceInd, int cost, const vector< WORD_ID > &sourceSentence, const vector<SentenceAlignment> &targets, const string &inputStr, const string  &path, vector< ExtractedRule > &extracted)
 {
   string sourceStr;
   for (size_t pos = 0; pos < sourceSentence.size(); ++pos) {
@@ -1013,16 +1034,54 @@ void FuzzyMatchWrapper::create_extract(int sentenceInd, int cost, const vector<
     string targetStr = sentenceAlignment.getTargetString(GetVocabulary());
     string alignStr = sentenceAlignment.getAlignmentString();
 
-    outputFile
-        << sentenceInd << endl
-        << cost << endl
-        << sourceStr << endl
-        << inputStr << endl
-        << targetStr << endl
-        << alignStr << endl
-        << path << endl
-        << sentenceAlignment.count << endl;
+    CreateXMLRetValues ret = createXML(extracted.size() + 1, sourceStr, inputStr, targetStr, alignStr, path + "X");
+
+    ExtractedRule rule;
+    rule.source = ret.ruleS + " [X]";
+    rule.target = ret.ruleT + " [X]";
+    rule.alignment = ret.ruleAlignment;
+    rule.count = sentenceAlignment.count;
+    extracted.push_back(rule);
+  }
+}
+
+/* relative frequencies of the extracted rules in both directions, with the
+ most frequent alignment of each rule */
+
+void FuzzyMatchWrapper::score_rules(const vector< ExtractedRule > &extracted, vector< Rule > &rules)
+{
+  typedef pair< string, string > RuleKey;
+  map< RuleKey, map< string, float > > ruleCount;
+  map< string, float > sourceCount, targetCount;
+
+  for (size_t i = 0; i < extracted.size(); ++i) {
+    const ExtractedRule &rule = extracted[i];
+    ruleCount[ RuleKey(rule.source, rule.target) ][ rule.alignment ] += rule.count;
+    sourceCount[ rule.source ] += rule.count;
+    targetCount[ rule.target ] += rule.count;
+  }
+
+  rules.reserve(rules.size() + ruleCount.size());
+  typedef map< RuleKey, map< string, float > >::const_iterator I;
+  for (I iter = ruleCount.begin(); iter != ruleCount.end(); ++iter) {
+    const map< string, float > &alignments = iter->second;
+    float count = 0, bestCount = -1;
+    string bestAlignment;
+    for (map< string, float >::const_iterator a = alignments.begin(); a != alignments.end(); ++a) {
+      count += a->second;
+      if (a->second > bestCount) {
+        bestCount = a->second;
+        bestAlignment = a->first;
+      }
+    }
 
+    Rule rule;
+    rule.source = iter->first.first;
+    rule.target = iter->first.second;
+    rule.alignment = bestAlignment;
+    rule.scores.push_back(count / targetCount[ rule.target ]);
+    rule.scores.push_back(count / sourceCount[ rule.source ]);
+    rules.push_back(rule);
   }
 }
 
@@ -15,7 +15,11 @@
 
 #include <fstream>
 #include <string>
+#include <boost/scoped_ptr.hpp>
+#include <boost/unordered_map.hpp>
 #include "SuffixArray.h"
+#include "SentenceAlignment.h"
+#include "IndexFile.h"
 #include "Vocabulary.h"
 #include "Match.h"
 #include "moses/InputType.h"
@@ -30,11 +34,31 @@ class FuzzyMatchWrapper
 public:
   FuzzyMatchWrapper(const std::string &source, const std::string &target, const std::string &alignment);
 
-  std::string Extract(long translationId, const std::string &dirNameStr);
+  /* open a translation memory index written by SaveIndex() read-only, so
+   that processes using the same index share its memory */
+  explicit FuzzyMatchWrapper(const std::string &index);
+
+  ~FuzzyMatchWrapper();
+
+  //! write the suffix array, vocabulary, targets and alignments to one file
+  void SaveIndex(const std::string &index) const;
+
+  /* hierarchical rule extracted from the best matching TM sentences and
+   scored as by the phrase-extract score and consolidate programs,
+   i.e. with the scores p(f|e) and p(e|f) */
+  struct Rule {
+    std::string source, target, alignment;
+    std::vector<float> scores;
+  };
+
+  /* create the rule table for one input sentence, without going through
+   the file system */
+  void Extract(long translationId, const std::string &input, std::vector<Rule> &rules);
 
 protected:
   // tm-mt
-  std::vector< std::vector< tmmt::SentenceAlignment > > targetAndAlignment;
+  boost::scoped_ptr< IndexReader > m_index;
+  tmmt::TargetCorpus targetAndAlignment;
   tmmt::SuffixArray *suffixArray;
   int basic_flag;
   int lsed_flag;
@@ -49,13 +73,14 @@ protected:
   typedef std::map< WORD_ID,std::vector< int > > WordIndex;
 
   // global cache for word pairs
-  std::map< std::pair< WORD_ID, WORD_ID >, unsigned int > m_lsed;
+  boost::unordered_map< std::pair< WORD_ID, WORD_ID >, unsigned int > m_lsed;
 #ifdef WITH_THREADS
   //reader-writer lock
   mutable boost::shared_mutex m_accessLock;
 #endif
 
   void load_corpus( const std::string &fileName, std::vector< std::vector< tmmt::WORD_ID > > &corpus );
+  void init_flags();
   void load_target( const std::string &fileName, std::vector< std::vector< tmmt::SentenceAlignment > > &corpus);
   void load_alignment( const std::string &fileName, std::vector< std::vector< tmmt::SentenceAlignment > > &corpus );
 
@@ -74,9 +99,16 @@ protected:
   std::vector< Match > prune_matches( const std::vector< Match > &match, int best_cost );
   int parse_matches( std::vector< Match > &match, int input_length, int tm_length, int &best_cost );
 
-  void create_extract(int sentenceInd, int cost, const std::vector< WORD_ID > &sourceSentence, const std::vector<SentenceAlignment> &targets, const std::string &inputStr, const std::string  &path, std::ofstream &outputFile);
+  /* extracted rule before scoring, weighted by the count of the TM target */
+  struct ExtractedRule {
+    std::string source, target, alignment;
+    int count;
+  };
+
+  void create_extract(int sentenceInd, int cost, const std::vector< WORD_ID > &sourceSentence, const std::vector<SentenceAlignment> &targets, const std::string &inputStr, const std::string  &path, std::vector<ExtractedRule> &extracted);
+  void score_rules(const std::vector<ExtractedRule> &extracted, std::vector<Rule> &rules);
 
-  std::string ExtractTM(WordIndex &wordIndex, long translationId, const std::string &inputPath);
+  void ExtractTM(WordIndex &wordIndex, long translationId, const std::vector< WORD_ID > &input, std::vector<ExtractedRule> &extracted);
   Vocabulary &GetVocabulary() {
     return suffixArray->GetVocabulary();
   }
@@ -0,0 +1,75 @@
+//
+//  IndexFile.cpp
+//  fuzzy-match
+//
+
+#include <cstring>
+
+#include "IndexFile.h"
+#include "util/exception.hh"
+
+using namespace std;
+
+namespace
+{
+
+const char INDEX_MAGIC[8] = { 't', 'm', 'm', 't', 'i', 'd', 'x', '\0' };
+const uint64_t INDEX_VERSION = 1;
+
+const size_t ALIGNMENT = 8;
+
+size_t Padding(uint64_t offset)
+{
+  return (ALIGNMENT - offset % ALIGNMENT) % ALIGNMENT;
+}
+
+}
+
+namespace tmmt
+{
+
+IndexWriter::IndexWriter(const std::string &fileName)
+  :m_file(util::CreateOrThrow(fileName.c_str()))
+  ,m_offset(0)
+{
+  WriteAligned(INDEX_MAGIC, sizeof(INDEX_MAGIC));
+  WriteAligned(&INDEX_VERSION, sizeof(INDEX_VERSION));
+}
+
+void IndexWriter::WriteAligned(const void *data, size_t bytes)
+{
+  static const char zeros[ALIGNMENT] = { 0 };
+  util::WriteOrThrow(m_file.get(), data, bytes);
+  const size_t padding = Padding(m_offset + bytes);
+  util::WriteOrThrow(m_file.get(), zeros, padding);
+  m_offset += bytes + padding;
+}
+
+IndexReader::IndexReader(const std::string &fileName)
+  :m_fileName(fileName)
+  ,m_offset(0)
+{
+  util::scoped_fd file(util::OpenReadOrThrow(fileName.c_str()));
+  const uint64_t size = util::SizeOrThrow(file.get());
+  UTIL_THROW_IF2(size < sizeof(INDEX_MAGIC) + sizeof(INDEX_VERSION),
+                 "Not a fuzzy-match index: " << fileName);
+  util::MapRead(util::LAZY, file.get(), 0, size, m_memory);
+
+  UTIL_THROW_IF2(memcmp(ReadAligned(sizeof(INDEX_MAGIC)), INDEX_MAGIC, sizeof(INDEX_MAGIC)) != 0,
+                 "Not a fuzzy-match index: " << fileName);
+  const uint64_t version = *static_cast<const uint64_t*>(ReadAligned(sizeof(uint64_t)));
+  UTIL_THROW_IF2(version != INDEX_VERSION,
+                 "Fuzzy-match index " << fileName << " has version " << version
+                 << ", expected " << INDEX_VERSION);
+}
+
+const void *IndexReader::ReadAligned(size_t bytes)
+{
+  UTIL_THROW_IF2(m_offset + bytes > m_memory.size(),
+                 "Truncated fuzzy-match index: " << m_fileName);
+  const char *data = static_cast<const char*>(m_memory.get()) + m_offset;
+  m_offset += bytes + Padding(m_offset + bytes);
+  return data;
+}
+
+}
@@ -0,0 +1,110 @@
+//
+//  IndexFile.h
+//  fuzzy-match
+//
+
+#ifndef fuzzy_match_IndexFile_h
+#define fuzzy_match_IndexFile_h
+
+#include <string>
+#include <vector>
+
+#include <stdint.h>
+
+#include "util/file.hh"
+#include "util/mmap.hh"
+
+namespace tmmt
+{
+
+/* Index file of a translation memory: a header, then a sequence of arrays,
+ each stored as its element count followed by the elements at an 8-byte
+ aligned offset. The arrays are used in place from a read-only shared memory
+ mapping, so that decoder processes using the same translation memory share
+ its pages. */
+class IndexWriter
+{
+public:
+  explicit IndexWriter(const std::string &fileName);
+
+  template <class T>
+  void Write(const T *data, size_t count) {
+    const uint64_t size = count;
+    WriteAligned(&size, sizeof(size));
+    WriteAligned(data, sizeof(T) * count);
+  }
+
+private:
+  util::scoped_fd m_file;
+  uint64_t m_offset;
+
+  void WriteAligned(const void *data, size_t bytes);
+};
+
+class IndexReader
+{
+public:
+  explicit IndexReader(const std::string &fileName);
+
+  template <class T>
+  const T *Read(size_t &count) {
+    count = *static_cast<const uint64_t*>(ReadAligned(sizeof(uint64_t)));
+    return static_cast<const T*>(ReadAligned(sizeof(T) * count));
+  }
+
+private:
+  std::string m_fileName;
+  util::scoped_memory m_memory;
+  uint64_t m_offset;
+
+  const void *ReadAligned(size_t bytes);
+};
+
+/* array that is either built in memory or points into an index file */
+template <class T>
+class IndexArray
+{
+public:
+  IndexArray()
+    :m_data(NULL)
+    ,m_size(0) {
+  }
+
+  //! take over the contents of a vector built in memory
+  void Assign(std::vector<T> &data) {
+    m_owned.swap(data);
+    m_data = m_owned.empty() ? NULL : &m_owned[0];
+    m_size = m_owned.size();
+  }
+
+  //! use the next array of an index file, which must outlive this one
+  void Read(IndexReader &reader) {
+    std::vector<T>().swap(m_owned);
+    m_data = reader.Read<T>(m_size);
+  }
+
+  void Write(IndexWriter &writer) const {
+    writer.Write(m_data, m_size);
+  }
+
+  const T &operator[](size_t i) const {
+    return m_data[i];
+  }
+
+  size_t size() const {
+    return m_size;
+  }
+
+private:
+  std::vector<T> m_owned;
+  const T *m_data;
+  size_t m_size;
+
+  // No copying allowed.
+  IndexArray(const IndexArray&);
+  void operator=(const IndexArray&);
+};
+
+}
+
+#endif
@@ -22,4 +22,66 @@ std::string SentenceAlignment::getTargetString(const Vocabulary &vocab) const
   return strme.str();
 }
 
+void TargetCorpus::Assign(const std::vector< std::vector< SentenceAlignment > > &corpus)
+{
+  std::vector< unsigned int > targetBegin(1, 0), wordBegin(1, 0), alignmentBegin(1, 0);
+  std::vector< int > count, alignment;
+  std::vector< WORD_ID > words;
+  for (size_t s = 0; s < corpus.size(); ++s) {
+    for (size_t t = 0; t < corpus[s].size(); ++t) {
+      const SentenceAlignment &target = corpus[s][t];
+      count.push_back(target.count);
+      words.insert(words.end(), target.target.begin(), target.target.end());
+      wordBegin.push_back(words.size());
+      for (size_t i = 0; i < target.alignment.size(); ++i) {
+        alignment.push_back(target.alignment[i].first);
+        alignment.push_back(target.alignment[i].second);
+      }
+      alignmentBegin.push_back(alignment.size() / 2);
+    }
+    targetBegin.push_back(count.size());
+  }
+  m_targetBegin.Assign(targetBegin);
+  m_count.Assign(count);
+  m_wordBegin.Assign(wordBegin);
+  m_words.Assign(words);
+  m_alignmentBegin.Assign(alignmentBegin);
+  m_alignment.Assign(alignment);
+}
+
+void TargetCorpus::Get(size_t sentenceId, std::vector< SentenceAlignment > &targets) const
+{
+  targets.resize(m_targetBegin[sentenceId + 1] - m_targetBegin[sentenceId]);
+  for (size_t i = 0; i < targets.size(); ++i) {
+    const size_t t = m_targetBegin[sentenceId] + i;
+    SentenceAlignment &target = targets[i];
+    target.count = m_count[t];
+    target.target.assign(&m_words[0] + m_wordBegin[t], &m_words[0] + m_wordBegin[t + 1]);
+    target.alignment.clear();
+    for (size_t a = m_alignmentBegin[t]; a < m_alignmentBegin[t + 1]; ++a) {
+      target.alignment.push_back(std::make_pair(m_alignment[2 * a], m_alignment[2 * a + 1]));
+    }
+  }
+}
+
+void TargetCorpus::Save(IndexWriter &writer) const
+{
+  m_targetBegin.Write(writer);
+  m_count.Write(writer);
+  m_wordBegin.Write(writer);
+  m_words.Write(writer);
+  m_alignmentBegin.Write(writer);
+  m_alignment.Write(writer);
+}
+
+void TargetCorpus::Read(IndexReader &reader)
+{
+  m_targetBegin.Read(reader);
+  m_count.Read(reader);
+  m_wordBegin.Read(reader);
+  m_words.Read(reader);
+  m_alignmentBegin.Read(reader);
+  m_alignment.Read(reader);
+}
+
 }
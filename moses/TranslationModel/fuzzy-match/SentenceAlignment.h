@@ -12,6 +12,7 @@
 #include <sstream>
 #include <vector>
 #include "Vocabulary.h"
+#include "IndexFile.h"
 #include "util/string_stream.hh"
 
 namespace tmmt
@@ -38,6 +39,26 @@ struct SentenceAlignment {
 
 };
 
+/* target sentences and alignments of all TM sentences, in flat arrays that
+ are built in memory or read from an index file */
+class TargetCorpus
+{
+public:
+  void Assign(const std::vector< std::vector< SentenceAlignment > > &corpus);
+  void Get(size_t sentenceId, std::vector< SentenceAlignment > &targets) const;
+
+  void Save(IndexWriter &writer) const;
+  void Read(IndexReader &reader);
+
+private:
+  IndexArray< unsigned int > m_targetBegin; // first target of each TM sentence, and end
+  IndexArray< int > m_count;
+  IndexArray< unsigned int > m_wordBegin; // first word of each target, and end
+  IndexArray< WORD_ID > m_words;
+  IndexArray< unsigned int > m_alignmentBegin; // first point of each target, and end
+  IndexArray< int > m_alignment; // source and target position of each point
+};
+
 }
 
 #endif
@@ -1,13 +1,30 @@
 #include "SuffixArray.h"
+#include <algorithm>
 #include <string>
 #include <stdlib.h>
 #include <cstring>
 
+#include "util/exception.hh"
+#include "util/suffix_array.hh"
+
 using namespace std;
 
 namespace tmmt
 {
 
+namespace
+{
+
+struct CompareWordString {
+  explicit CompareWordString( const vector< WORD > &vocab ) : m_vocab(vocab) {}
+  bool operator()( WORD_ID a, WORD_ID b ) const {
+    return m_vocab[a] < m_vocab[b];
+  }
+  const vector< WORD > &m_vocab;
+};
+
+}
+
 SuffixArray::SuffixArray( string fileName )
 {
   m_vcb.StoreIfNew( "<uNk>" );
@@ -17,6 +34,7 @@ SuffixArray::SuffixArray( string fileName )
 
   // count the number of words first;
   extractFile.open(fileName.c_str());
+  UTIL_THROW_IF2(!extractFile, "file not found: " << fileName);
   istream *fileP = &extractFile;
   m_size = 0;
   size_t sentenceCount = 0;
@@ -29,13 +47,14 @@ SuffixArray::SuffixArray( string fileName )
   }
   extractFile.close();
   cerr << m_size << " words (incl. sentence boundaries)" << endl;
+  UTIL_THROW_IF2(m_size >= (INDEX) -2, "Corpus too large for 32-bit suffix array indices: " << fileName);
 
   // allocate memory
-  m_array = (WORD_ID*) calloc( sizeof( WORD_ID ), m_size );
-  m_index = (INDEX*) calloc( sizeof( INDEX ), m_size );
-  m_wordInSentence = (char*) calloc( sizeof( char ), m_size );
-  m_sentence = (size_t*) calloc( sizeof( size_t ), m_size );
-  m_sentenceLength = (char*) calloc( sizeof( char ), sentenceCount );
+  vector< WORD_ID > array( m_size );
+  vector< char > wordInSentence( m_size );
+  vector< INDEX > sentence( m_size );
+  vector< char > sentenceLength( sentenceCount );
+  vector< INDEX > sentenceStart( sentenceCount );
 
   // fill the array
   int wordIndex = 0;
@@ -45,68 +64,93 @@ SuffixArray::SuffixArray( string fileName )
   while(getline(*fileP, line)) {
     vector< WORD_ID > words = m_vcb.Tokenize( line.c_str() );
 
-    // add to corpus vector
-    corpus.push_back(words);
-
-    // create SA
-
+    sentenceStart[ sentenceId ] = wordIndex;
     vector< WORD_ID >::const_iterator i;
     for( i=words.begin(); i!=words.end(); i++) {
-      m_index[ wordIndex ] = wordIndex;
-      m_sentence[ wordIndex ] = sentenceId;
-      m_wordInSentence[ wordIndex ] = i-words.begin();
-      m_array[ wordIndex++ ] = *i;
+      sentence[ wordIndex ] = sentenceId;
+      wordInSentence[ wordIndex ] = i-words.begin();
+      array[ wordIndex++ ] = *i;
     }
-    m_index[ wordIndex ] = wordIndex;
-    m_array[ wordIndex++ ] = m_endOfSentence;
-    m_sentenceLength[ sentenceId++ ] = words.size();
+    array[ wordIndex++ ] = m_endOfSentence;
+    sentenceLength[ sentenceId++ ] = words.size();
   }
   extractFile.close();
   cerr << "done reading " << wordIndex << " words, " << sentenceId << " sentences." << endl;
-  // List(0,9);
+
+  m_array.Assign( array );
+  m_wordInSentence.Assign( wordInSentence );
+  m_sentence.Assign( sentence );
+  m_sentenceLength.Assign( sentenceLength );
+  m_sentenceStart.Assign( sentenceStart );
 
   // sort
-  m_buffer = (INDEX*) calloc( sizeof( INDEX ), m_size );
-  Sort( 0, m_size-1 );
-  free( m_buffer );
+  ComputeWordRanks();
+  vector< INDEX > index;
+  Sort( index );
+  m_index.Assign( index );
   cerr << "done sorting" << endl;
 }
 
-// good ol' quick sort
-void SuffixArray::Sort(INDEX start, INDEX end)
-{
-  if (start == end) return;
-  INDEX mid = (start+end+1)/2;
-  Sort( start, mid-1 );
-  Sort( mid, end );
-
-  // merge
-  size_t i = start;
-  size_t j = mid;
-  size_t k = 0;
-  size_t length = end-start+1;
-  while( k<length ) {
-    if (i == mid ) {
-      m_buffer[ k++ ] = m_index[ j++ ];
-    } else if (j > end ) {
-      m_buffer[ k++ ] = m_index[ i++ ];
-    } else {
-      if (CompareIndex( m_index[i], m_index[j] ) < 0) {
-        m_buffer[ k++ ] = m_index[ i++ ];
-      } else {
-        m_buffer[ k++ ] = m_index[ j++ ];
-      }
-    }
+SuffixArray::SuffixArray( IndexReader &reader )
+{
+  m_vcb.Load( reader );
+  m_endOfSentence = m_vcb.StoreIfNew( "<s>" );
+  m_array.Read( reader );
+  m_index.Read( reader );
+  m_wordInSentence.Read( reader );
+  m_sentence.Read( reader );
+  m_sentenceLength.Read( reader );
+  m_sentenceStart.Read( reader );
+  m_size = m_array.size();
+  ComputeWordRanks();
+}
+
+void SuffixArray::Save( IndexWriter &writer ) const
+{
+  m_vcb.Save( writer );
+  m_array.Write( writer );
+  m_index.Write( writer );
+  m_wordInSentence.Write( writer );
+  m_sentence.Write( writer );
+  m_sentenceLength.Write( writer );
+  m_sentenceStart.Write( writer );
+}
+
+// the order of the words in the suffix array is the string order, so
+// number them in that order to compare words as integers
+void SuffixArray::ComputeWordRanks()
+{
+  vector< WORD_ID > ids( m_vcb.vocab.size() );
+  for(WORD_ID id=0; id<ids.size(); id++) {
+    ids[id] = id;
+  }
+  sort( ids.begin(), ids.end(), CompareWordString( m_vcb.vocab ) );
+  m_wordRank.resize( ids.size() );
+  for(INDEX rank=0; rank<ids.size(); rank++) {
+    m_wordRank[ ids[rank] ] = rank;
+  }
+}
+
+// induced sorting over the word ranks, with a sentinel that makes a suffix
+// that runs into the end of the corpus sort before its extensions
+void SuffixArray::Sort( vector< INDEX > &index ) const
+{
+  vector< INDEX > text( m_size+1 );
+  for(INDEX i=0; i<m_size; i++) {
+    text[i] = m_wordRank[ m_array[i] ] + 1;
   }
+  text[ m_size ] = 0;
+  index.resize( m_size+1 );
+  util::InducedSuffixSort< INDEX >( &text[0], &index[0], m_size+1, m_wordRank.size()+1 );
 
-  memcpy( ((char*)m_index) + sizeof( INDEX ) * start,
-          ((char*)m_buffer), sizeof( INDEX ) * (end-start+1) );
+  // drop the sentinel, which is the smallest suffix
+  index.erase( index.begin() );
 }
 
-SuffixArray::~SuffixArray()
+void SuffixArray::GetSentenceWords( size_t sentenceId, vector< WORD_ID > &words ) const
 {
-  free(m_index);
-  free(m_array);
+  const INDEX start = m_sentenceStart[ sentenceId ];
+  words.assign( &m_array[ start ], &m_array[ start ] + m_sentenceLength[ sentenceId ] );
 }
 
 int SuffixArray::CompareIndex( INDEX a, INDEX b ) const
@@ -155,10 +199,13 @@ int SuffixArray::FindMatches( const vector< WORD > &phrase, INDEX &firstMatch, I
 
 int SuffixArray::LimitedCount( const vector< WORD > &phrase, INDEX min, INDEX &firstMatch, INDEX &lastMatch, INDEX search_start, INDEX search_end )
 {
+  vector< INDEX > ranks;
+  if (!GetWordRanks( phrase, ranks )) return 0; // word not in corpus
+
   // cerr << "FindFirst\n";
   INDEX start = search_start;
   INDEX end = (search_end == -1) ? (m_size-1) : search_end;
-  INDEX mid = FindFirst( phrase, start, end );
+  INDEX mid = FindFirst( ranks, start, end );
   // cerr << "done\n";
   if (mid == m_size) return 0; // no matches
   if (min == 1) return 1;      // only existance check
@@ -166,24 +213,38 @@ int SuffixArray::LimitedCount( const vector< WORD > &phrase, INDEX min, INDEX &f
   int matchCount = 1;
 
   //cerr << "before...\n";
-  firstMatch = FindLast( phrase, mid, start, -1 );
+  firstMatch = FindLast( ranks, mid, start, -1 );
   matchCount += mid - firstMatch;
 
   //cerr << "after...\n";
-  lastMatch = FindLast( phrase, mid, end, 1 );
+  lastMatch = FindLast( ranks, mid, end, 1 );
   matchCount += lastMatch - mid;
 
   return matchCount;
 }
 
-SuffixArray::INDEX SuffixArray::FindLast( const vector< WORD > &phrase, INDEX start, INDEX end, int direction )
+// the words of the phrase as word ranks, false if one of them does not occur
+// in the corpus (it may have been added to the vocabulary since)
+bool SuffixArray::GetWordRanks( const vector< WORD > &phrase, vector< INDEX > &ranks )
+{
+  ranks.resize( phrase.size() );
+  for(size_t i=0; i<phrase.size(); i++) {
+    WORD_ID id = m_vcb.GetWordID( phrase[i] );
+    if (id >= m_wordRank.size()) return false;
+    ranks[i] = m_wordRank[ id ];
+  }
+  return true;
+}
+
+SuffixArray::INDEX SuffixArray::FindLast( const vector< INDEX > &phrase, INDEX start, INDEX end, int direction ) const
 {
   end += direction;
   while(true) {
     INDEX mid = ( start + end + (direction>0 ? 0 : 1) )/2;
 
     int match = Match( phrase, mid );
-    int matchNext = Match( phrase, mid+direction );
+    INDEX next = mid+direction;
+    int matchNext = next < m_size ? Match( phrase, next ) : 1; // also catches -1
     //cerr << "\t" << start << ";" << mid << ";" << end << " -> " << match << "," << matchNext << endl;
 
     if (match == 0 && matchNext != 0) return mid;
@@ -195,7 +256,7 @@ SuffixArray::INDEX SuffixArray::FindLast( const vector< WORD > &phrase, INDEX st
   }
 }
 
-SuffixArray::INDEX SuffixArray::FindFirst( const vector< WORD > &phrase, INDEX &start, INDEX &end )
+SuffixArray::INDEX SuffixArray::FindFirst( const vector< INDEX > &phrase, INDEX &start, INDEX &end ) const
 {
   while(true) {
     INDEX mid = ( start + end + 1 )/2;
@@ -212,14 +273,14 @@ SuffixArray::INDEX SuffixArray::FindFirst( const vector< WORD > &phrase, INDEX &
   }
 }
 
-int SuffixArray::Match( const vector< WORD > &phrase, INDEX index )
+int SuffixArray::Match( const vector< INDEX > &phrase, INDEX index ) const
 {
   INDEX pos = m_index[ index ];
   for(INDEX i=0; i<phrase.size() && i+pos<m_size; i++) {
-    int match = CompareWord( m_vcb.GetWordID( phrase[i] ), m_array[ pos+i ] );
-    // cerr << "{" << index << "+" << i << "," << pos+i << ":" << match << "}" << endl;
-    if (match != 0)
-      return match;
+    INDEX word = m_wordRank[ m_array[ pos+i ] ];
+    // cerr << "{" << index << "+" << i << "," << pos+i << ":" << word << "}" << endl;
+    if (phrase[i] != word)
+      return phrase[i] < word ? -1 : 1;
   }
   return 0;
 }
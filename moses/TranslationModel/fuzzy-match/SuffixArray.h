@@ -1,4 +1,5 @@
 #include "Vocabulary.h"
+#include "IndexFile.h"
 
 #pragma once
 
@@ -13,23 +14,32 @@ public:
   typedef unsigned int INDEX;
 
 private:
-  std::vector< std::vector< WORD_ID > > corpus;
-
-  WORD_ID *m_array;
-  INDEX *m_index;
-  INDEX *m_buffer;
-  char *m_wordInSentence;
-  size_t *m_sentence;
-  char *m_sentenceLength;
+  IndexArray< WORD_ID > m_array;
+  IndexArray< INDEX > m_index;
+  IndexArray< char > m_wordInSentence;
+  IndexArray< INDEX > m_sentence;
+  IndexArray< char > m_sentenceLength;
+  IndexArray< INDEX > m_sentenceStart;
+  std::vector< INDEX > m_wordRank; // position of each word in string order
   WORD_ID m_endOfSentence;
   Vocabulary m_vcb;
   INDEX m_size;
 
+  void ComputeWordRanks();
+  void Sort( std::vector< INDEX > &index ) const;
+  bool GetWordRanks( const std::vector< WORD > &phrase, std::vector< INDEX > &ranks );
+  INDEX FindFirst( const std::vector< INDEX > &ranks, INDEX &start, INDEX &end ) const;
+  INDEX FindLast( const std::vector< INDEX > &ranks, INDEX start, INDEX end, int direction ) const;
+  int Match( const std::vector< INDEX > &ranks, INDEX index ) const;
+
 public:
+  // build from a tokenized corpus, one sentence per line
   SuffixArray( std::string fileName );
-  ~SuffixArray();
+  // use the arrays written to an index file by Save()
+  explicit SuffixArray( IndexReader &reader );
+
+  void Save( IndexWriter &writer ) const;
 
-  void Sort(INDEX start, INDEX end);
   int CompareIndex( INDEX a, INDEX b ) const;
   inline int CompareWord( WORD_ID a, WORD_ID b ) const;
   int Count( const std::vector< WORD > &phrase );
@@ -37,9 +47,6 @@ public:
   bool Exists( const std::vector< WORD > &phrase );
   int FindMatches( const std::vector< WORD > &phrase, INDEX &firstMatch, INDEX &lastMatch, INDEX search_start = 0, INDEX search_end = -1 );
   int LimitedCount( const std::vector< WORD > &phrase, INDEX min, INDEX &firstMatch, INDEX &lastMatch, INDEX search_start = -1, INDEX search_end = 0 );
-  INDEX FindFirst( const std::vector< WORD > &phrase, INDEX &start, INDEX &end );
-  INDEX FindLast( const std::vector< WORD > &phrase, INDEX start, INDEX end, int direction );
-  int Match( const std::vector< WORD > &phrase, INDEX index );
   void List( INDEX start, INDEX end );
   inline INDEX GetPosition( INDEX index ) {
     return m_index[ index ];
@@ -56,14 +63,14 @@ public:
   inline INDEX GetSize() {
     return m_size;
   }
+  inline size_t GetSentenceCount() const {
+    return m_sentenceLength.size();
+  }
+  void GetSentenceWords( size_t sentenceId, std::vector< WORD_ID > &words ) const;
 
   Vocabulary &GetVocabulary() {
     return m_vcb;
   }
-  const std::vector< std::vector< WORD_ID > > &GetCorpus() const {
-    return corpus;
-  }
 };
 
 }
-
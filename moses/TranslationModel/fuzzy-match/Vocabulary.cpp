@@ -1,5 +1,7 @@
 // $Id: Vocabulary.cpp 1565 2008-02-22 14:42:01Z bojar $
 #include "Vocabulary.h"
+#include "IndexFile.h"
+#include <cstring>
 #ifdef WITH_THREADS
 #include <boost/thread/locks.hpp>
 #endif
@@ -67,5 +69,24 @@ WORD_ID Vocabulary::GetWordID( const WORD &word )
   return w;
 }
 
+// the words in the order of their ids, each terminated by a null character
+void Vocabulary::Save( IndexWriter &writer ) const
+{
+  vector< char > words;
+  for(size_t i=0; i<vocab.size(); i++) {
+    words.insert( words.end(), vocab[i].begin(), vocab[i].end() );
+    words.push_back( '\0' );
+  }
+  writer.Write( words.empty() ? NULL : &words[0], words.size() );
 }
 
+void Vocabulary::Load( IndexReader &reader )
+{
+  size_t size;
+  const char *words = reader.Read< char >( size );
+  for(const char *word = words; word < words + size; word += strlen( word ) + 1) {
+    StoreIfNew( word );
+  }
+}
+
+}
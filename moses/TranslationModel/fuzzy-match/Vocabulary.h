@@ -9,6 +9,7 @@
 #include <string>
 #include <queue>
 #include <map>
+#include <vector>
 #include <cmath>
 
 #ifdef WITH_THREADS
@@ -17,6 +18,9 @@
 
 namespace tmmt
 {
+class IndexReader;
+class IndexWriter;
+
 typedef std::string WORD;
 typedef unsigned int WORD_ID;
 
@@ -33,6 +37,9 @@ public:
     return i;
   }
 
+  void Save( IndexWriter &writer ) const;
+  void Load( IndexReader &reader );
+
 protected:
 #ifdef WITH_THREADS
   //reader-writer lock
@@ -1,5 +1,14 @@
+
 #pragma once
 
 #include <string>
 
+class CreateXMLRetValues
+{
+public:
+  std::string frame, ruleS, ruleT, ruleAlignment, ruleAlignmentInv;
+};
+
+CreateXMLRetValues createXML(int ruleCount, const std::string &source, const std::string &input, const std::string &target, const std::string &align, const std::string &path );
+
 void create_xml(const std::string &inPath);
@@ -34,6 +34,7 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #include "Util.h"
 #include "TypeDef.h"
 #include "ScoreComponentCollection.h"
+#include "ScratchArena.h"
 #include "StaticData.h"
 namespace Moses
 {
@@ -88,6 +89,14 @@ public:
   };
 
 
+  //! allocated from the scratch arena of the sentence, see ScratchArena
+  static void *operator new(size_t size) {
+    return ScratchArena::Allocate(size);
+  }
+  static void operator delete(void *ptr) {
+    ScratchArena::Free(ptr);
+  }
+
   explicit TranslationOption(); // For initial hypo that does translate nothing
 
   /** constructor. Used by initial translation step */
@@ -33,6 +33,7 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #include "StaticData.h"
 #include "DecodeStepTranslation.h"
 #include "DecodeStepGeneration.h"
+#include "DecodeStepExpansion.h"
 #include "DecodeGraph.h"
 #include "InputPath.h"
 #include "moses/FF/UnknownWordPenaltyProducer.h"
@@ -408,27 +409,39 @@ CreateTranslationOptionsForRange
 
     // do rest of decode steps
     int indexStep = 0;
+    const bool lazy = m_ttask.lock()->options()->search.lazy_decode_steps;
 
     for (++d ; d != dgraph.end() ; ++d) {
       const DecodeStep *dstep = *d;
       PartialTranslOptColl* newPtoc = new PartialTranslOptColl(m_max_phrase_length);
 
-      // go thru each intermediate trans opt just created
-      const vector<TranslationOption*>& partTransOptList = oldPtoc->GetList();
-      vector<TranslationOption*>::const_iterator pto;
-      for (pto = partTransOptList.begin() ; pto != partTransOptList.end() ; ++pto) {
-        TranslationOption &inputPartialTranslOpt = **pto;
-        if (const Tstep *tstep = dynamic_cast<const Tstep*>(dstep)) {
-          const PhraseDictionary &pdict = *tstep->GetPhraseDictionaryFeature();
-          TargetPhraseCollection::shared_ptr targetPhrases = inputPath.GetTargetPhrases(pdict);
-          tstep->Process(inputPartialTranslOpt, *dstep, *newPtoc,
-                         this, adhereTableLimit, targetPhrases);
-        } else {
-          const Gstep *genStep = dynamic_cast<const Gstep*>(dstep);
-          UTIL_THROW_IF2(!genStep, "Decode steps must be either "
-                         << "Translation or Generation Steps!");
-          genStep->Process(inputPartialTranslOpt, *dstep, *newPtoc,
-                           this, adhereTableLimit);
+      if (lazy) {
+        // best-first, up to the per-span limit for the last step
+        list <const DecodeStep* >::const_iterator next = d;
+        size_t maxOptions = newPtoc->GetMaxSize();
+        if (++next == dgraph.end() && m_maxNoTransOptPerCoverage > 0) {
+          maxOptions = std::min(maxOptions, m_maxNoTransOptPerCoverage);
+        }
+        CreateExpansionsLazily(*dstep, *oldPtoc, *newPtoc, maxOptions,
+                               adhereTableLimit, inputPath);
+      } else {
+        // go thru each intermediate trans opt just created
+        const vector<TranslationOption*>& partTransOptList = oldPtoc->GetList();
+        vector<TranslationOption*>::const_iterator pto;
+        for (pto = partTransOptList.begin() ; pto != partTransOptList.end() ; ++pto) {
+          TranslationOption &inputPartialTranslOpt = **pto;
+          if (const Tstep *tstep = dynamic_cast<const Tstep*>(dstep)) {
+            const PhraseDictionary &pdict = *tstep->GetPhraseDictionaryFeature();
+            TargetPhraseCollection::shared_ptr targetPhrases = inputPath.GetTargetPhrases(pdict);
+            tstep->Process(inputPartialTranslOpt, *dstep, *newPtoc,
+                           this, adhereTableLimit, targetPhrases);
+          } else {
+            const Gstep *genStep = dynamic_cast<const Gstep*>(dstep);
+            UTIL_THROW_IF2(!genStep, "Decode steps must be either "
+                           << "Translation or Generation Steps!");
+            genStep->Process(inputPartialTranslOpt, *dstep, *newPtoc,
+                             this, adhereTableLimit);
+          }
         }
       }
 
@@ -465,6 +478,41 @@ CreateTranslationOptionsForRange
   return true;
 }
 
+void
+TranslationOptionCollection::
+CreateExpansionsLazily
+(const DecodeStep &dstep, const PartialTranslOptColl &oldPtoc,
+ PartialTranslOptColl &newPtoc, size_t maxOptions,
+ bool adhereTableLimit, InputPath &inputPath)
+{
+  typedef DecodeStepTranslation Tstep;
+  typedef DecodeStepGeneration Gstep;
+
+  const Tstep *tstep = dynamic_cast<const Tstep*>(&dstep);
+  const Gstep *genStep = dynamic_cast<const Gstep*>(&dstep);
+  UTIL_THROW_IF2(!tstep && !genStep, "Decode steps must be either "
+                 << "Translation or Generation Steps!");
+  TargetPhraseCollection::shared_ptr targetPhrases;
+  if (tstep) {
+    targetPhrases = inputPath.GetTargetPhrases(*tstep->GetPhraseDictionaryFeature());
+  }
+
+  vector<DecodeStepExpansion*> expansions;
+  const vector<TranslationOption*>& partTransOptList = oldPtoc.GetList();
+  vector<TranslationOption*>::const_iterator pto;
+  for (pto = partTransOptList.begin() ; pto != partTransOptList.end() ; ++pto) {
+    DecodeStepExpansion *expansion = tstep
+                                     ? tstep->CreateExpansion(**pto, adhereTableLimit, targetPhrases)
+                                     : genStep->CreateExpansion(**pto);
+    if (expansion) {
+      expansions.push_back(expansion);
+    }
+  }
+
+  ExpandBestFirst(expansions, newPtoc, maxOptions, m_translationOptionThreshold);
+  RemoveAllInColl(expansions);
+}
+
 void
 TranslationOptionCollection::
 SetInputScore(const InputPath &inputPath, PartialTranslOptColl &oldPtoc)
@@ -648,6 +696,13 @@ GetTranslationOptionList(size_t sPos, size_t ePos) const
 void
 TranslationOptionCollection::
 GetTargetPhraseCollectionBatch()
+{
+  GetTargetPhraseCollectionBatch(m_inputPathQueue);
+}
+
+void
+TranslationOptionCollection::
+GetTargetPhraseCollectionBatch(const InputPathList &inputPathQueue)
 {
   typedef DecodeStepTranslation Tstep;
   const vector <DecodeGraph*> &dgl = StaticData::Instance().GetDecodeGraphs();
@@ -657,7 +712,7 @@ GetTargetPhraseCollectionBatch()
       const Tstep* tstep = dynamic_cast<const Tstep *>(*i);
       if (tstep) {
         const PhraseDictionary &pdict = *tstep->GetPhraseDictionaryFeature();
-        pdict.GetTargetPhraseCollectionBatch(m_ttask.lock(), m_inputPathQueue);
+        pdict.GetTargetPhraseCollectionBatch(m_ttask.lock(), inputPathQueue);
       }
     }
   }
@@ -44,6 +44,7 @@ class InputType;
 class FactorMask;
 class Word;
 class DecodeGraph;
+class DecodeStep;
 class PhraseDictionary;
 class InputPath;
 
@@ -113,6 +114,8 @@ protected:
   void CacheLexReordering();
 
   void GetTargetPhraseCollectionBatch();
+  //! look up only the given input paths, a subset of m_inputPathQueue
+  void GetTargetPhraseCollectionBatch(const InputPathList &inputPathQueue);
 
   bool CreateTranslationOptionsForRange(
     const DecodeGraph &decodeGraph
@@ -124,6 +127,11 @@ protected:
 
   void SetInputScore(const InputPath &inputPath, PartialTranslOptColl &oldPtoc);
 
+  //! apply a decode step to the partial translation options best-first (cube pruning)
+  void CreateExpansionsLazily(const DecodeStep &dstep, const PartialTranslOptColl &oldPtoc,
+                              PartialTranslOptColl &newPtoc, size_t maxOptions,
+                              bool adhereTableLimit, InputPath &inputPath);
+
 public:
   virtual ~TranslationOptionCollection();
 
@@ -25,8 +25,11 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #include "DecodeStepTranslation.h"
 #include "FactorCollection.h"
 #include "Range.h"
+#include "DecodeGraph.h"
+#include "StaticData.h"
 #include <list>
 #include "TranslationTask.h"
+#include "TranslationModel/PhraseDictionary.h"
 
 using namespace std;
 
@@ -165,9 +168,64 @@ InputPath &TranslationOptionCollectionText::GetInputPath(size_t startPos, size_t
   return *m_inputPathMatrix[startPos][offset];
 }
 
+/** The input paths worth looking up in the phrase tables. Spans longer than
+ * the maximum phrase length never get translation options. If all
+ * translation tables provide a prefix check, a span is only extended as long
+ * as one of them has an entry starting with it.
+ */
+void TranslationOptionCollectionText::GetLookupPaths(InputPathList &paths) const
+{
+  vector<const PhraseDictionary*> tables;
+  bool prefixCheck = true;
+  const vector<DecodeGraph*> &decodeGraphs = StaticData::Instance().GetDecodeGraphs();
+  for (size_t i = 0; i < decodeGraphs.size(); ++i) {
+    list<const DecodeStep*>::const_iterator iterStep;
+    for (iterStep = decodeGraphs[i]->begin(); iterStep != decodeGraphs[i]->end(); ++iterStep) {
+      const DecodeStepTranslation *transStep = dynamic_cast<const DecodeStepTranslation*>(*iterStep);
+      if (transStep) {
+        const PhraseDictionary *phraseDictionary = transStep->GetPhraseDictionaryFeature();
+        prefixCheck = prefixCheck && phraseDictionary->ProvidesPrefixCheck();
+        tables.push_back(phraseDictionary);
+      }
+    }
+  }
+
+  // longest span worth looking up from each position
+  ttasksptr ttask = m_ttask.lock();
+  size_t size = m_source.GetSize();
+  vector<size_t> maxLength(size, 0);
+  for (size_t startPos = 0; startPos < size; ++startPos) {
+    size_t maxSize = std::min(size - startPos, m_max_phrase_length);
+    for (size_t length = 1; length <= maxSize; ++length) {
+      if (prefixCheck) {
+        const Phrase &phrase = m_inputPathMatrix[startPos][length - 1]->GetPhrase();
+        bool found = false;
+        for (size_t i = 0; !found && i < tables.size(); ++i) {
+          found = tables[i]->PrefixExists(ttask, phrase);
+        }
+        if (!found) break;
+      }
+      maxLength[startPos] = length;
+    }
+  }
+
+  // keep the order of m_inputPathQueue, prefixes before their extensions
+  InputPathList::const_iterator iter;
+  for (iter = m_inputPathQueue.begin(); iter != m_inputPathQueue.end(); ++iter) {
+    const Range &range = (*iter)->GetWordsRange();
+    if (range.GetNumWordsCovered() <= maxLength[range.GetStartPos()]) {
+      paths.push_back(*iter);
+    }
+  }
+  VERBOSE(3, "Looking up " << paths.size() << " of " << m_inputPathQueue.size()
+          << " input paths" << endl);
+}
+
 void TranslationOptionCollectionText::CreateTranslationOptions()
 {
-  GetTargetPhraseCollectionBatch();
+  InputPathList paths;
+  GetLookupPaths(paths);
+  GetTargetPhraseCollectionBatch(paths);
   TranslationOptionCollection::CreateTranslationOptions();
 }
 
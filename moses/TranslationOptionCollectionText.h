@@ -45,6 +45,8 @@ protected:
 
   InputPath &GetInputPath(size_t startPos, size_t endPos);
 
+  void GetLookupPaths(InputPathList &paths) const;
+
 public:
   void ProcessUnknownWord(size_t sourcePos);
 
@@ -185,12 +185,19 @@ void TranslationTask::Run()
   Timer initTime;
   initTime.start();
 
+  // objects of the sentence that opt in are allocated from m_arena,
+  // they must be gone by the end of Run()
+  ScratchArena::Scope arenaScope(m_arena);
   boost::shared_ptr<BaseManager> manager = SetupManager(m_options->search.algo);
 
   VERBOSE(1, "Line " << translationId << ": Initialize search took "
           << initTime << " seconds total" << endl);
 
   manager->Decode();
+  if (manager->GetDeadline().IsSet()) {
+    VERBOSE(1, "Line " << translationId << ": Degradation level "
+            << manager->GetDeadline().GetLevel() << endl);
+  }
 
   // new: stop here if m_ioWrapper is NULL. This means that the
   // owner of the TranslationTask will take care of the output
@@ -252,6 +259,10 @@ void TranslationTask::Run()
           << additionalReportingTime << " seconds total" << endl);
   VERBOSE(1, "Line " << translationId << ": Translation took "
           << translationTime << " seconds total" << endl);
+  VERBOSE(2, "Line " << translationId << ": Scratch arena: "
+          << m_arena.GetAllocations() << " allocations, "
+          << m_arena.GetRecycled() << " recycled, "
+          << m_arena.GetBytes() << " bytes" << endl);
   IFVERBOSE(2) {
     PrintUserTime("Sentence Decoding Time:");
   }
@@ -9,6 +9,7 @@
 #include "moses/Manager.h"
 #include "moses/ChartManager.h"
 #include "moses/ContextScope.h"
+#include "moses/ScratchArena.h"
 
 #include "moses/Syntax/F2S/Manager.h"
 #include "moses/Syntax/S2T/Manager.h"
@@ -139,6 +140,7 @@ public:
 protected:
   boost::shared_ptr<Moses::InputType> m_source;
   boost::shared_ptr<Moses::IOWrapper> m_ioWrapper;
+  ScratchArena m_arena; // translation options etc. of the sentence, see Run()
 
   void interpret_dlt();
 };
@@ -45,44 +45,6 @@ max_fax()
   return 1;
 }
 
-// static
-int Word::Compare(const Word &targetWord, const Word &sourceWord)
-{
-  if (targetWord.IsNonTerminal() != sourceWord.IsNonTerminal()) {
-    return targetWord.IsNonTerminal() ? -1 : 1;
-  }
-
-  for (size_t factorType = 0 ; factorType < MAX_NUM_FACTORS ; factorType++) {
-    const Factor *targetFactor = targetWord[factorType];
-    const Factor *sourceFactor = sourceWord[factorType];
-
-    if (targetFactor == NULL || sourceFactor == NULL)
-      continue;
-    if (targetFactor == sourceFactor)
-      continue;
-
-    return (targetFactor<sourceFactor) ? -1 : +1;
-  }
-  return 0;
-}
-
-bool Word::operator==(const Word &compare) const
-{
-  if (IsNonTerminal() != compare.IsNonTerminal()) {
-    return false;
-  }
-
-  for (size_t factorType = 0 ; factorType < MAX_NUM_FACTORS ; factorType++) {
-    const Factor *thisFactor = GetFactor(factorType);
-    const Factor *otherFactor = compare.GetFactor(factorType);
-
-    if (thisFactor != otherFactor) {
-      return false;
-    }
-  }
-  return true;
-}
-
 void Word::Merge(const Word &sourceWord)
 {
   for (unsigned int currFactor = 0 ; currFactor < MAX_NUM_FACTORS ; currFactor++) {
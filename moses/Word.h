@@ -116,7 +116,22 @@ public:
   StringPiece  GetString(FactorType factorType) const;
   TO_STRING();
 
-  bool operator== (const Word &compare) const;
+  /* The comparisons are inline as they are on the hot path of phrase table
+   * lookups and hypothesis recombination; MAX_NUM_FACTORS is a compile-time
+   * constant, so a build with --max-factors=1 reduces them to a single
+   * pointer comparison. */
+  bool operator== (const Word &compare) const {
+    if (IsNonTerminal() != compare.IsNonTerminal()) {
+      return false;
+    }
+
+    for (size_t factorType = 0 ; factorType < MAX_NUM_FACTORS ; factorType++) {
+      if (m_factorArray[factorType] != compare.m_factorArray[factorType]) {
+        return false;
+      }
+    }
+    return true;
+  }
 
   inline bool operator!= (const Word &compare) const {
     return !(*this == compare);
@@ -128,7 +143,24 @@ public:
   *	Only compare the co-joined factors, ie. where factor exists for both words.
   *	Should make it non-static
   */
-  static int Compare(const Word &targetWord, const Word &sourceWord);
+  static int Compare(const Word &targetWord, const Word &sourceWord) {
+    if (targetWord.IsNonTerminal() != sourceWord.IsNonTerminal()) {
+      return targetWord.IsNonTerminal() ? -1 : 1;
+    }
+
+    for (size_t factorType = 0 ; factorType < MAX_NUM_FACTORS ; factorType++) {
+      const Factor *targetFactor = targetWord.m_factorArray[factorType];
+      const Factor *sourceFactor = sourceWord.m_factorArray[factorType];
+
+      if (targetFactor == NULL || sourceFactor == NULL)
+        continue;
+      if (targetFactor == sourceFactor)
+        continue;
+
+      return (targetFactor<sourceFactor) ? -1 : +1;
+    }
+    return 0;
+  }
 
   void CreateFromString(FactorDirection direction
                         , const std::vector<FactorType> &factorOrder
@@ -0,0 +1,123 @@
+/***********************************************************************
+Moses - factored phrase-based language decoder
+Copyright (C) 2006 University of Edinburgh
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+
+/* Measures the cost of word sequence storage, comparison and hashing as done
+ * by Phrase for phrase table lookups and hypothesis recombination. Build it
+ * with different --max-factors settings to compare factored and
+ * single-factor decoding:
+ *
+ *   word_benchmark [phrases] [vocabulary]
+ */
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#include <boost/functional/hash.hpp>
+#include <boost/lexical_cast.hpp>
+#include <boost/unordered_set.hpp>
+
+#include "FactorCollection.h"
+#include "Word.h"
+#include "util/random.hh"
+#include "util/usage.hh"
+
+using namespace std;
+using namespace Moses;
+
+namespace
+{
+
+typedef vector<Word> Words;
+
+// Phrase::operator< and Phrase::operator==
+struct WordsLess {
+  bool operator()(const Words &a, const Words &b) const {
+    if (a.size() != b.size()) return a.size() < b.size();
+    for (size_t i = 0; i < a.size(); ++i) {
+      int ret = Word::Compare(a[i], b[i]);
+      if (ret) return ret < 0;
+    }
+    return false;
+  }
+};
+
+// Phrase::hash
+struct WordsHash {
+  size_t operator()(const Words &words) const {
+    size_t seed = 0;
+    for (size_t i = 0; i < words.size(); ++i) {
+      boost::hash_combine(seed, words[i]);
+    }
+    return seed;
+  }
+};
+
+}
+
+int main(int argc, char *argv[])
+{
+  const size_t numPhrases = argc > 1 ? boost::lexical_cast<size_t>(argv[1]) : 2000000;
+  const size_t vocabSize = argc > 2 ? boost::lexical_cast<size_t>(argv[2]) : 50000;
+
+  vector<const Factor*> vocab(vocabSize);
+  for (size_t i = 0; i < vocabSize; ++i) {
+    vocab[i] = FactorCollection::Instance().AddFactor("w" + boost::lexical_cast<string>(i));
+  }
+
+  util::rand_init(1);
+  vector<Words> phrases(numPhrases);
+  for (size_t i = 0; i < numPhrases; ++i) {
+    const size_t size = 1 + util::rand_excl(5);
+    phrases[i].resize(size);
+    for (size_t j = 0; j < size; ++j) {
+      // skewed towards frequent words, so that many phrases share prefixes
+      const size_t r = util::rand_excl(vocabSize);
+      phrases[i][j][0] = vocab[r * r / vocabSize];
+    }
+  }
+
+  cerr << "MAX_NUM_FACTORS=" << MAX_NUM_FACTORS
+       << " sizeof(Word)=" << sizeof(Word) << endl;
+
+  size_t words = 0;
+  for (size_t i = 0; i < numPhrases; ++i) words += phrases[i].size();
+  cerr << "Words: " << words << " taking " << words * sizeof(Word) << " bytes" << endl;
+
+  double start = util::WallTime();
+  boost::unordered_set<Words, WordsHash> unique(phrases.begin(), phrases.end());
+  size_t found = 0;
+  for (size_t i = 0; i < numPhrases; ++i) found += unique.count(phrases[i]);
+  cerr << "Hash insert and lookup: " << (util::WallTime() - start) << " s ("
+       << unique.size() << " unique, " << found << " found)" << endl;
+
+  start = util::WallTime();
+  sort(phrases.begin(), phrases.end(), WordsLess());
+  cerr << "Sort: " << (util::WallTime() - start) << " s" << endl;
+
+  start = util::WallTime();
+  size_t equal = 0;
+  for (size_t i = 1; i < numPhrases; ++i) equal += (phrases[i] == phrases[i - 1]);
+  cerr << "Adjacent equality: " << (util::WallTime() - start) << " s ("
+       << equal << " equal)" << endl;
+
+  util::PrintUsage(cerr);
+  return 0;
+}
@@ -13,6 +13,12 @@
 // #include "moses/StaticData.h"
 #include "moses/Util.h"
 #include "mbr.h"
+#include "util/murmur_hash.hh"
+
+#include <boost/unordered_map.hpp>
+#ifdef WITH_THREADS
+#include <boost/thread.hpp>
+#endif
 
 using namespace std ;
 using namespace Moses;
@@ -35,68 +41,233 @@ using namespace Moses;
 int BLEU_ORDER = 4;
 int SMOOTH = 1;
 float min_interval = 1e-4;
-void extract_ngrams(const vector<const Factor* >& sentence, map < vector < const Factor* >, int >  & allngrams)
+void extract_ngrams(const vector<const Factor* >& sentence, MBRNgramStats &stats)
 {
-  vector< const Factor* > ngram;
+  stats.length = sentence.size();
+  stats.counts.assign(BLEU_ORDER, MBRNgramStats::Counts());
   for (int k = 0; k < BLEU_ORDER; k++) {
+    MBRNgramStats::Counts &counts = stats.counts[k];
     for(int i =0; i < max((int)sentence.size()-k,0); i++) {
-      for ( int j = i; j<= i+k; j++) {
-        ngram.push_back(sentence[j]);
+      uint64_t id = util::MurmurHashNative(&sentence[i], (k+1) * sizeof(const Factor*));
+      counts.push_back(make_pair(id, 1));
+    }
+    // merge the counts of repeated n-grams
+    sort(counts.begin(), counts.end());
+    size_t last = 0;
+    for (size_t i = 1; i < counts.size(); ++i) {
+      if (counts[i].first == counts[last].first) {
+        counts[last].second += counts[i].second;
+      } else {
+        counts[++last] = counts[i];
       }
-      ++allngrams[ngram];
-      ngram.clear();
     }
+    if (!counts.empty()) counts.resize(last + 1);
   }
 }
 
-float calculate_score(const vector< vector<const Factor*> > & sents, int ref, int hyp,  vector < map < vector < const Factor *>, int > > & ngram_stats )
+namespace
 {
-  int comps_n = 2*BLEU_ORDER+1;
-  vector<int> comps(comps_n);
-  float logbleu = 0.0, brevity;
-
-  int hyp_length = sents[hyp].size();
-
-  for (int i =0; i<BLEU_ORDER; i++) {
-    comps[2*i] = 0;
-    comps[2*i+1] = max(hyp_length-i,0);
-  }
-
-  map< vector < const Factor * > ,int > & hyp_ngrams = ngram_stats[hyp] ;
-  map< vector < const Factor * >, int > & ref_ngrams = ngram_stats[ref] ;
 
-  for (map< vector< const Factor * >, int >::iterator it = hyp_ngrams.begin();
-       it != hyp_ngrams.end(); it++) {
-    map< vector< const Factor * >, int >::iterator ref_it = ref_ngrams.find(it->first);
-    if(ref_it != ref_ngrams.end()) {
-      comps[2* (it->first.size()-1)] += min(ref_it->second,it->second);
+//! clipped matches of hyp in ref, both sorted by n-gram id
+template <class RefCount>
+float clipped_matches(const MBRNgramStats::Counts &hyp,
+                      const vector<pair<uint64_t, RefCount> > &ref)
+{
+  float matches = 0;
+  typename vector<pair<uint64_t, RefCount> >::const_iterator ref_it = ref.begin();
+  for (MBRNgramStats::Counts::const_iterator it = hyp.begin();
+       it != hyp.end() && ref_it != ref.end(); ++it) {
+    while (ref_it != ref.end() && ref_it->first < it->first) ++ref_it;
+    if (ref_it != ref.end() && ref_it->first == it->first) {
+      matches += min((float)ref_it->second, (float)it->second);
     }
   }
-  comps[comps_n-1] = sents[ref].size();
+  return matches;
+}
 
+//! smoothed sentence BLEU from matches per order and the reference length
+float bleu_from_matches(const vector<float> &matches, int hyp_length, float ref_length)
+{
+  float logbleu = 0.0, brevity;
   for (int i=0; i<BLEU_ORDER; i++) {
-    if (comps[0] == 0)
+    if (matches[0] == 0)
       return 0.0;
+    float total = max(hyp_length-i,0);
     if ( i > 0 )
-      logbleu += log((float)comps[2*i]+SMOOTH)-log((float)comps[2*i+1]+SMOOTH);
+      logbleu += log(matches[i]+SMOOTH)-log(total+SMOOTH);
     else
-      logbleu += log((float)comps[2*i])-log((float)comps[2*i+1]);
+      logbleu += log(matches[i])-log(total);
   }
   logbleu /= BLEU_ORDER;
-  brevity = 1.0-(float)comps[comps_n-1]/comps[1]; // comps[comps_n-1] is the ref length, comps[1] is the test length
+  brevity = 1.0-ref_length/hyp_length;
   if (brevity < 0.0)
     logbleu += brevity;
   return exp(logbleu);
 }
 
-const TrellisPath doMBR(const TrellisPathList& nBestList, AllOptions const& opts)
+}
+
+float calculate_score(const vector<MBRNgramStats> &ngram_stats, int ref, int hyp)
+{
+  const MBRNgramStats &hyp_ngrams = ngram_stats[hyp];
+  const MBRNgramStats &ref_ngrams = ngram_stats[ref];
+
+  vector<float> matches(BLEU_ORDER);
+  for (int i =0; i<BLEU_ORDER; i++) {
+    matches[i] = clipped_matches(hyp_ngrams.counts[i], ref_ngrams.counts[i]);
+  }
+  return bleu_from_matches(matches, hyp_ngrams.length, ref_ngrams.length);
+}
+
+namespace
+{
+
+//! MBR loss of the candidates start, start + step, ... under 1 - BLEU
+struct MBRLossRows {
+  const vector<MBRNgramStats> *ngram_stats;
+  const vector<float> *posteriors;
+  size_t start, step;
+  float minMBRLoss;
+  int minMBRLossIdx;
+
+  void operator()() {
+    const size_t size = posteriors->size();
+    for (size_t i = start; i < size; i += step) {
+      float weightedLossCumul = 0;
+      for (size_t j = 0; j < size; j++) {
+        if ( i != j) {
+          float bleu = calculate_score(*ngram_stats, j, i);
+          weightedLossCumul += ( 1 - bleu) * (*posteriors)[j];
+          if (weightedLossCumul > minMBRLoss)
+            break;
+        }
+      }
+      if (weightedLossCumul < minMBRLoss) {
+        minMBRLoss = weightedLossCumul;
+        minMBRLossIdx = i;
+      }
+    }
+  }
+};
+
+/* Exact MBR, O(n^2) sentence BLEU computations. With several threads each
+   takes every threads-th candidate; the candidate with the smallest loss,
+   the first one on ties, is the same as with one thread. */
+size_t exact_mbr(const vector<MBRNgramStats> &ngram_stats,
+                 const vector<float> &posteriors, size_t threads)
+{
+  threads = max<size_t>(1, min(threads, posteriors.size()));
+  vector<MBRLossRows> rows(threads);
+  for (size_t t = 0; t < threads; ++t) {
+    rows[t].ngram_stats = &ngram_stats;
+    rows[t].posteriors = &posteriors;
+    rows[t].start = t;
+    rows[t].step = threads;
+    rows[t].minMBRLoss = 1000000;
+    rows[t].minMBRLossIdx = -1;
+  }
+
+#ifdef WITH_THREADS
+  if (threads > 1) {
+    boost::thread_group group;
+    for (size_t t = 0; t < threads; ++t) {
+      group.create_thread(boost::ref(rows[t]));
+    }
+    group.join_all();
+  } else {
+    rows[0]();
+  }
+#else
+  UTIL_THROW_IF2(threads > 1, "MBR threads require a build with threads");
+  rows[0]();
+#endif
+
+  float minMBRLoss = 1000000;
+  int minMBRLossIdx = -1;
+  for (size_t t = 0; t < threads; ++t) {
+    if (rows[t].minMBRLossIdx < 0) continue;
+    if (rows[t].minMBRLoss < minMBRLoss
+        || (rows[t].minMBRLoss == minMBRLoss && rows[t].minMBRLossIdx < minMBRLossIdx)) {
+      minMBRLoss = rows[t].minMBRLoss;
+      minMBRLossIdx = rows[t].minMBRLossIdx;
+    }
+  }
+  return minMBRLossIdx < 0 ? 0 : minMBRLossIdx;
+}
+
+/* Linear expected BLEU (DeNero et al. 2009): the candidates are compared
+   once with the expected n-gram counts and length of the posterior weighted
+   list, instead of with each other. O(n) sentence BLEU computations. */
+size_t linear_mbr(const vector<MBRNgramStats> &ngram_stats,
+                  const vector<float> &posteriors)
+{
+  typedef vector<pair<uint64_t, float> > ExpectedCounts;
+  vector<ExpectedCounts> expected(BLEU_ORDER);
+  float expected_length = 0;
+  for (int k = 0; k < BLEU_ORDER; k++) {
+    boost::unordered_map<uint64_t, float> counts;
+    for (size_t j = 0; j < ngram_stats.size(); ++j) {
+      const MBRNgramStats::Counts &hyp = ngram_stats[j].counts[k];
+      for (size_t n = 0; n < hyp.size(); ++n) {
+        counts[hyp[n].first] += posteriors[j] * hyp[n].second;
+      }
+    }
+    expected[k].assign(counts.begin(), counts.end());
+    sort(expected[k].begin(), expected[k].end());
+  }
+  for (size_t j = 0; j < ngram_stats.size(); ++j) {
+    expected_length += posteriors[j] * ngram_stats[j].length;
+  }
+
+  float maxBleu = -1;
+  size_t maxBleuIdx = 0;
+  vector<float> matches(BLEU_ORDER);
+  for (size_t i = 0; i < ngram_stats.size(); ++i) {
+    for (int k = 0; k < BLEU_ORDER; k++) {
+      matches[k] = clipped_matches(ngram_stats[i].counts[k], expected[k]);
+    }
+    float bleu = bleu_from_matches(matches, ngram_stats[i].length, expected_length);
+    if (bleu > maxBleu) {
+      maxBleu = bleu;
+      maxBleuIdx = i;
+    }
+  }
+  return maxBleuIdx;
+}
+
+}
+
+size_t doMBR(const vector< vector<const Factor*> > &translations,
+             const vector<float> &joint_prob_vec, MBR_Options const& opts)
 {
   float marginal = 0;
+  for (size_t i = 0; i < joint_prob_vec.size(); ++i) {
+    marginal += joint_prob_vec[i];
+  }
+  vector<float> posteriors(joint_prob_vec.size());
+  for (size_t i = 0; i < joint_prob_vec.size(); ++i) {
+    posteriors[i] = joint_prob_vec[i] / marginal;
+  }
+
+  // collect n-gram counts
+  vector<MBRNgramStats> ngram_stats(translations.size());
+  for (size_t i = 0; i < translations.size(); ++i) {
+    extract_ngrams(translations[i], ngram_stats[i]);
+  }
+
+  /* Main MBR computation done here */
+  if (opts.linear) {
+    return linear_mbr(ngram_stats, posteriors);
+  }
+  return exact_mbr(ngram_stats, posteriors, opts.threads);
+}
+
+const TrellisPath doMBR(const TrellisPathList& nBestList, AllOptions const& opts)
+{
   float mbr_scale = opts.mbr.scale;
   vector<float> joint_prob_vec;
   vector< vector<const Factor*> > translations;
   float joint_prob;
-  vector< map < vector <const Factor *>, int > > ngram_stats;
 
   TrellisPathList::const_iterator iter;
 
@@ -113,49 +284,16 @@ const TrellisPath doMBR(const TrellisPathList& nBestList, AllOptions const& opts
   for (iter = nBestList.begin() ; iter != nBestList.end() ; ++iter) {
     const TrellisPath &path = **iter;
     joint_prob = UntransformScore(mbr_scale * path.GetScoreBreakdown()->GetWeightedScore() - maxScore);
-    marginal += joint_prob;
     joint_prob_vec.push_back(joint_prob);
 
     // get words in translation
     vector<const Factor*> translation;
     GetOutputFactors(path, oFactors[0], translation);
-
-    // collect n-gram counts
-    map < vector < const Factor *>, int > counts;
-    extract_ngrams(translation,counts);
-
-    ngram_stats.push_back(counts);
     translations.push_back(translation);
   }
 
-  vector<float> mbr_loss;
-  float bleu, weightedLoss;
-  float weightedLossCumul = 0;
-  float minMBRLoss = 1000000;
-  int minMBRLossIdx = -1;
-
-  /* Main MBR computation done here */
-  iter = nBestList.begin();
-  for (unsigned int i = 0; i < nBestList.GetSize(); i++) {
-    weightedLossCumul = 0;
-    for (unsigned int j = 0; j < nBestList.GetSize(); j++) {
-      if ( i != j) {
-        bleu = calculate_score(translations, j, i,ngram_stats );
-        weightedLoss = ( 1 - bleu) * ( joint_prob_vec[j]/marginal);
-        weightedLossCumul += weightedLoss;
-        if (weightedLossCumul > minMBRLoss)
-          break;
-      }
-    }
-    if (weightedLossCumul < minMBRLoss) {
-      minMBRLoss = weightedLossCumul;
-      minMBRLossIdx = i;
-    }
-    iter++;
-  }
   /* Find sentence that minimises Bayes Risk under 1- BLEU loss */
-  return nBestList.at(minMBRLossIdx);
-  //return translations[minMBRLossIdx];
+  return nBestList.at(doMBR(translations, joint_prob_vec, opts.mbr));
 }
 
 void
@@ -21,19 +21,45 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 
 #ifndef moses_cmd_mbr_h
 #define moses_cmd_mbr_h
+#include <utility>
+#include <vector>
+#include <stdint.h>
 #include "moses/parameters/AllOptions.h"
 
+namespace Moses
+{
+class Factor;
+class TrellisPath;
+class TrellisPathList;
+}
+
+/** n-gram counts of a translation for sentence BLEU. N-grams are identified
+ *  by a 64 bit hash of their factors; the counts of each order are sorted
+ *  by id so that two translations are compared by merging. */
+struct MBRNgramStats {
+  typedef std::vector<std::pair<uint64_t, int> > Counts;
+
+  int length;
+  std::vector<Counts> counts; //! by n-gram order - 1
+};
+
 Moses::TrellisPath const
 doMBR(Moses::TrellisPathList const& nBestList, Moses::AllOptions const& opts);
 
+//! index of the MBR translation, given the unnormalised posteriors
+size_t
+doMBR(const std::vector< std::vector<const Moses::Factor*> > &translations,
+      const std::vector<float> &joint_prob_vec, Moses::MBR_Options const& opts);
+
 void
 GetOutputFactors(const Moses::TrellisPath &path, Moses::FactorType const f,
                  std::vector <const Moses::Factor*> &translation);
 
+void
+extract_ngrams(const std::vector<const Moses::Factor*> &sentence,
+               MBRNgramStats &stats);
+
 float
-calculate_score(const std::vector< std::vector<const Moses::Factor*> > & sents,
-                int ref, int hyp,
-                std::vector<std::map<std::vector<const Moses::Factor*>,int> > &
-                ngram_stats );
+calculate_score(const std::vector<MBRNgramStats> &ngram_stats, int ref, int hyp);
 
 #endif
@@ -7,6 +7,7 @@ namespace Moses {
   LMBR_Options() 
     : enabled(false)
     , use_lattice_hyp_set(false)
+    , legacy(false)
     , precision(0.8f)
     , ratio(0.6f)
     , map_weight(0.8f)
@@ -24,6 +25,7 @@ namespace Moses {
     param.SetParameter(map_weight, "lmbr-map-weight", 0.0f);
     param.SetParameter(pruning_factor, "lmbr-pruning-factor", size_t(30));
     param.SetParameter(use_lattice_hyp_set, "lattice-hypo-set", false);
+    param.SetParameter(legacy, "lmbr-legacy-lattice", false);
     
     PARAM_VEC const* params = param.GetParam("lmbr-thetas");
     if (params) theta = Scan<float>(*params);
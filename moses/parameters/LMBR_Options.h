@@ -13,6 +13,7 @@ namespace Moses
   {
     bool enabled;
     bool use_lattice_hyp_set; //! to use nbest as hypothesis set during lattice MBR
+    bool legacy; //! phrase-keyed n-gram statistics instead of the ArrayLattice
     float precision; //! unigram precision theta - see Tromble et al 08 for more details
     float ratio;     //! decaying factor for ngram thetas - see Tromble et al 08
     float map_weight; //! Weight given to the map solution. See Kumar et al 09 
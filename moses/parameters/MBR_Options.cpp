@@ -8,6 +8,8 @@ namespace Moses {
     : enabled(false)
     , size(200)
     , scale(1.0f)
+    , linear(false)
+    , threads(1)
   {}
 
 
@@ -18,6 +20,8 @@ namespace Moses {
     param.SetParameter(enabled, "minimum-bayes-risk", false);
     param.SetParameter<size_t>(size, "mbr-size", 200);
     param.SetParameter(scale, "mbr-scale", 1.0f);
+    param.SetParameter(linear, "mbr-linear", false);
+    param.SetParameter<size_t>(threads, "mbr-threads", 1);
     return true;
   }
 
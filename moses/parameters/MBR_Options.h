@@ -14,6 +14,8 @@ namespace Moses
     size_t size; //! number of translation candidates considered
     float scale; /*! scaling factor for computing marginal probability 
                   *  of candidate translation */
+    bool linear; //! linear expected BLEU instead of pairwise sentence BLEU
+    size_t threads; //! threads for pairwise sentence BLEU
     bool init(Parameter const& param);
     MBR_Options();
   };
@@ -13,8 +13,10 @@ namespace Moses
     , max_phrase_length(DEFAULT_MAX_PHRASE_LENGTH)
     , max_trans_opt_per_cov(DEFAULT_MAX_TRANS_OPT_SIZE)
     , max_partial_trans_opt(DEFAULT_MAX_PART_TRANS_OPT_SIZE)
+    , lazy_decode_steps(false)
     , beam_width(DEFAULT_BEAM_WIDTH)
     , timeout(0)
+    , deadline(0)
     , consensus(false)
     , early_discarding_threshold(DEFAULT_EARLY_DISCARDING_THRESHOLD)
     , trans_opt_threshold(DEFAULT_TRANSLATION_OPTION_THRESHOLD)
@@ -38,6 +40,7 @@ namespace Moses
     param.SetParameter(early_discarding_threshold, "early-discarding-threshold", 
                        DEFAULT_EARLY_DISCARDING_THRESHOLD);
     param.SetParameter(timeout, "time-out", 0);
+    param.SetParameter(deadline, "decoding-deadline", 0.0f);
     param.SetParameter(max_phrase_length, "max-phrase-length", 
                        DEFAULT_MAX_PHRASE_LENGTH);
     param.SetParameter(trans_opt_threshold, "translation-option-threshold", 
@@ -46,6 +49,7 @@ namespace Moses
                        DEFAULT_MAX_TRANS_OPT_SIZE);
     param.SetParameter(max_partial_trans_opt, "max-partial-trans-opt", 
                        DEFAULT_MAX_PART_TRANS_OPT_SIZE);
+    param.SetParameter(lazy_decode_steps, "lazy-decode-steps", false);
 
     param.SetParameter(consensus, "consensus-decoding", false);
     param.SetParameter(disable_discarding, "disable-discarding", false);
@@ -95,6 +99,9 @@ namespace Moses
 
       si = params.find("time-out");
       if (si != params.end()) timeout = xmlrpc_c::value_int(si->second);
+
+      si = params.find("decoding-deadline");
+      if (si != params.end()) deadline = xmlrpc_c::value_double(si->second);
       
       si = params.find("max-phrase-length");
       if (si != params.end()) max_phrase_length = xmlrpc_c::value_int(si->second);
@@ -21,10 +21,12 @@ namespace Moses
     size_t max_phrase_length;
     size_t max_trans_opt_per_cov; 
     size_t max_partial_trans_opt;
+    bool lazy_decode_steps; // cube pruning over factored decode steps
     // beam search
     float beam_width;
 
     int timeout;
+    float deadline; // wall-clock seconds per sentence before degrading the search
 
     bool consensus; //! Use Consensus decoding  (DeNero et al 2009)
     
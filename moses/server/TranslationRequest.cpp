@@ -346,6 +346,8 @@ run_chart_decoder()
 
   m_target_string = out.str();
   m_retData["text"] = xmlrpc_c::value_string(m_target_string);
+  if (manager.GetDeadline().IsSet())
+    m_retData["degradation-level"] = xmlrpc_c::value_int(manager.GetDeadline().GetLevel());
 
   if (m_withGraphInfo) {
     std::ostringstream sgstream;
@@ -411,6 +413,8 @@ run_phrase_decoder()
   pack_hypothesis(manager, manager.GetBestHypothesis(), "text", m_retData);
   if (m_session_id)
     m_retData["session-id"] = xmlrpc_c::value_int(m_session_id);
+  if (manager.GetDeadline().IsSet())
+    m_retData["degradation-level"] = xmlrpc_c::value_int(manager.GetDeadline().GetLevel());
   
   if (m_withGraphInfo) insertGraphInfo(manager,m_retData);
   if (m_withTopts) insertTranslationOptions(manager,m_retData);
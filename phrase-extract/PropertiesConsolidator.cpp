@@ -109,7 +109,7 @@ void PropertiesConsolidator::ActivateTargetSyntacticPreferencesProcessing(const
 }
 
 
-void PropertiesConsolidator::ProcessPropertiesString(const std::string &propertiesString, Moses::OutputFileStream& out) const
+void PropertiesConsolidator::ProcessPropertiesString(const std::string &propertiesString, std::ostream& out) const
 {
   if ( propertiesString.empty() ) {
     return;
@@ -177,7 +177,7 @@ void PropertiesConsolidator::ProcessPropertiesString(const std::string &properti
 }
 
 
-void PropertiesConsolidator::ProcessSourceLabelsPropertyValue(const std::string &value, Moses::OutputFileStream& out) const
+void PropertiesConsolidator::ProcessSourceLabelsPropertyValue(const std::string &value, std::ostream& out) const
 {
   // SourceLabels property: replace strings with vocabulary indices
   std::istringstream tokenizer(value);
@@ -238,7 +238,7 @@ void PropertiesConsolidator::ProcessSourceLabelsPropertyValue(const std::string
 }
 
 
-void PropertiesConsolidator::ProcessPOSPropertyValue(const std::string &value, Moses::OutputFileStream& out) const
+void PropertiesConsolidator::ProcessPOSPropertyValue(const std::string &value, std::ostream& out) const
 {
   std::istringstream tokenizer(value);
   while (tokenizer.peek() != EOF) {
@@ -285,7 +285,7 @@ bool PropertiesConsolidator::GetPOSPropertyValueFromPropertiesString(const std::
 }
 
 
-void PropertiesConsolidator::ProcessTargetSyntacticPreferencesPropertyValue(const std::string &value, Moses::OutputFileStream& out) const
+void PropertiesConsolidator::ProcessTargetSyntacticPreferencesPropertyValue(const std::string &value, std::ostream& out) const
 {
   // TargetPreferences property: replace strings with vocabulary indices
   std::istringstream tokenizer(value);
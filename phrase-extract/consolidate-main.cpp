@@ -18,10 +18,19 @@
  ***********************************************************************/
 
 #include <cstdlib>
+#include <sstream>
 #include <vector>
 #include <string>
 
+#ifdef WITH_THREADS
+#include <boost/scoped_ptr.hpp>
+#endif
+
 #include "util/exception.hh"
+#include "util/file_piece.hh"
+#include "util/string_stream.hh"
+#include "moses/OutputCollector.h"
+#include "moses/ThreadPool.h"
 #include "moses/Util.h"
 #include "InputFileStream.h"
 #include "OutputFileStream.h"
@@ -49,11 +58,26 @@ std::vector< float > countOfCounts;
 std::vector< float > goodTuringDiscount;
 float kneserNey_D1, kneserNey_D2, kneserNey_D3, totalCount = -1;
 
+int threads = 1;
+
+// number of phrase pairs read, consolidated and written together
+const size_t BLOCK_SIZE = 10000;
+
+// a block of lines of the direct and the indirect rule table,
+// the first of which is line firstLine
+struct PhrasePairBlock {
+  size_t firstLine;
+  std::vector< std::string > direct;
+  std::vector< std::string > indirect;
+};
+
 
 void processFiles( const std::string&, const std::string&, const std::string&, const std::string&, const std::string&, const std::string&, const std::string& );
 void loadCountOfCounts( const std::string& );
 void breakdownCoreAndSparse( const std::string &combined, std::string &core, std::string &sparse );
-bool getLine( Moses::InputFileStream &file, std::vector< std::string > &item );
+bool readBlock( util::FilePiece &fileDirect, util::FilePiece &fileIndirect, PhrasePairBlock &block );
+void consolidateBlock( const PhrasePairBlock &block, const MosesTraining::PropertiesConsolidator &propertiesConsolidator, std::string &output );
+void consolidatePhrasePair( size_t lineNum, const std::string &lineDirect, const std::string &lineIndirect, const MosesTraining::PropertiesConsolidator &propertiesConsolidator, util::StringStream &out, std::ostringstream &properties );
 
 
 inline float maybeLogProb( float a )
@@ -68,6 +92,38 @@ inline bool isNonTerminal( const std::string &word )
 }
 
 
+#ifdef WITH_THREADS
+// Consolidates a block of phrase pairs in a worker thread and hands the
+// result to the OutputCollector, which writes the blocks in input order.
+class ConsolidateTask : public Moses::Task
+{
+public:
+  ConsolidateTask( int blockId, PhrasePairBlock &block,
+                   const MosesTraining::PropertiesConsolidator &propertiesConsolidator,
+                   Moses::OutputCollector &collector )
+    : m_blockId(blockId)
+    , m_propertiesConsolidator(propertiesConsolidator)
+    , m_collector(collector) {
+    m_block.firstLine = block.firstLine;
+    m_block.direct.swap(block.direct);
+    m_block.indirect.swap(block.indirect);
+  }
+
+  virtual void Run() {
+    std::string output;
+    consolidateBlock( m_block, m_propertiesConsolidator, output );
+    m_collector.Write( m_blockId, output );
+  }
+
+private:
+  int m_blockId;
+  PhrasePairBlock m_block;
+  const MosesTraining::PropertiesConsolidator &m_propertiesConsolidator;
+  Moses::OutputCollector &m_collector;
+};
+#endif
+
+
 int main(int argc, char* argv[])
 {
   std::cerr << "Consolidate v2.0 written by Philipp Koehn" << std::endl
@@ -84,7 +140,8 @@ int main(int argc, char* argv[])
               "[--KneserNey counts-of-counts-file] [--LowCountFeature] "
               "[--SourceLabels source-labels-file] "
               "[--PartsOfSpeech parts-of-speech-file] "
-              "[--MinScore id:threshold[,id:threshold]*]"
+              "[--MinScore id:threshold[,id:threshold]*] "
+              "[--Threads number-of-threads]"
               << std::endl;
     exit(1);
   }
@@ -184,6 +241,14 @@ int main(int argc, char* argv[])
           UTIL_THROW2("MinScore currently only supported for indirect (0) and direct (2) phrase translation probabilities");
         }
       }
+    } else if (strcmp(argv[i],"--Threads") == 0) {
+      UTIL_THROW_IF2(i+1==argc, "specify number of threads!");
+      threads = std::atoi( argv[++i] );
+      UTIL_THROW_IF2(threads < 1, "number of threads must be at least 1");
+#ifndef WITH_THREADS
+      UTIL_THROW_IF2(threads > 1, "multi-threaded consolidation requires a build with thread support");
+#endif
+      std::cerr << "consolidating with " << threads << " threads" << std::endl;
     } else {
       UTIL_THROW2("unknown option " << argv[i]);
     }
@@ -244,11 +309,9 @@ void processFiles( const std::string& fileNameDirect,
   if (goodTuringFlag || kneserNeyFlag)
     loadCountOfCounts( fileNameCountOfCounts );
 
-  // open input files
-  Moses::InputFileStream fileDirect(fileNameDirect);
-  UTIL_THROW_IF2(fileDirect.fail(), "could not open phrase table file " << fileNameDirect);
-  Moses::InputFileStream fileIndirect(fileNameIndirect);
-  UTIL_THROW_IF2(fileIndirect.fail(), "could not open phrase table file " << fileNameIndirect);
+  // open input files (read in large blocks, decompressed if need be)
+  util::FilePiece fileDirect(fileNameDirect.c_str());
+  util::FilePiece fileIndirect(fileNameIndirect.c_str());
 
   // open output file: consolidated phrase table
   Moses::OutputFileStream fileConsolidated;
@@ -268,190 +331,274 @@ void processFiles( const std::string& fileNameDirect,
     propertiesConsolidator.ActivateTargetSyntacticPreferencesProcessing(fileNameTargetSyntacticPreferencesLabelSet);
   }
 
+#ifdef WITH_THREADS
+  // In multi-threaded mode, the blocks of phrase pairs are consolidated by a
+  // pool of worker threads.  An OutputCollector puts them back into input
+  // order and writes (and compresses) them in a thread of its own.
+  boost::scoped_ptr<Moses::ThreadPool> pool;
+  boost::scoped_ptr<Moses::OutputCollector> collector;
+  if (threads > 1) {
+    pool.reset(new Moses::ThreadPool(threads));
+    pool->SetQueueLimit(threads * 4);
+    collector.reset(new Moses::OutputCollector(&fileConsolidated));
+    collector->StartWriter();
+  }
+  int blockId = 0;
+#endif
+
   // loop through all extracted phrase translations
-  int i=0;
-  while(true) {
-    // Print progress dots to stderr.
-    i++;
-    if (i%100000 == 0) std::cerr << "." << std::flush;
-
-    std::vector< std::string > itemDirect, itemIndirect;
-    if (! getLine(fileIndirect, itemIndirect) ||
-        ! getLine(fileDirect, itemDirect))
-      break;
-
-    // direct: target source alignment probabilities
-    // indirect: source target probabilities
-
-    // consistency checks
-    UTIL_THROW_IF2(itemDirect[0].compare( itemIndirect[0] ) != 0,
-                   "target phrase does not match in line " << i << ": '" << itemDirect[0] << "' != '" << itemIndirect[0] << "'");
-    UTIL_THROW_IF2(itemDirect[1].compare( itemIndirect[1] ) != 0,
-                   "source phrase does not match in line " << i << ": '" << itemDirect[1] << "' != '" << itemIndirect[1] << "'");
-
-    // SCORES ...
-    std::string directScores, directSparseScores, indirectScores, indirectSparseScores;
-    breakdownCoreAndSparse( itemDirect[3], directScores, directSparseScores );
-    breakdownCoreAndSparse( itemIndirect[3], indirectScores, indirectSparseScores );
-
-    std::vector<std::string> directCounts;
-    Moses::Tokenize( directCounts, itemDirect[4] );
-    std::vector<std::string> indirectCounts;
-    Moses::Tokenize( indirectCounts, itemIndirect[4] );
-    float countF  = std::atof( directCounts[0].c_str() );
-    float countE  = std::atof( indirectCounts[0].c_str() );
-    float countEF = std::atof( indirectCounts[1].c_str() );
-    float n1_F, n1_E;
-    if (kneserNeyFlag) {
-      n1_F = std::atof( directCounts[2].c_str() );
-      n1_E = std::atof( indirectCounts[2].c_str() );
-    }
+  PhrasePairBlock block;
+  block.firstLine = 1;
+  std::string output;
+  bool more = true;
+  while (more) {
+    more = readBlock( fileDirect, fileIndirect, block );
+    const size_t blockSize = block.direct.size();
 
-    // Good Turing discounting
-    float adjustedCountEF = countEF;
-    if (goodTuringFlag && countEF+0.99999 < goodTuringDiscount.size()-1)
-      adjustedCountEF *= goodTuringDiscount[(int)(countEF+0.99998)];
-    float adjustedCountEF_indirect = adjustedCountEF;
-
-    // Kneser Ney discounting [Foster et al, 2006]
-    if (kneserNeyFlag) {
-      float D = kneserNey_D3;
-      if (countEF < 2) D = kneserNey_D1;
-      else if (countEF < 3) D = kneserNey_D2;
-      if (D > countEF) D = countEF - 0.01; // sanity constraint
-
-      float p_b_E = n1_E / totalCount; // target phrase prob based on distinct
-      float alpha_F = D * n1_F / countF; // available mass
-      adjustedCountEF = countEF - D + countF * alpha_F * p_b_E;
-
-      // for indirect
-      float p_b_F = n1_F / totalCount; // target phrase prob based on distinct
-      float alpha_E = D * n1_E / countE; // available mass
-      adjustedCountEF_indirect = countEF - D + countE * alpha_E * p_b_F;
+    // Print progress dots to stderr.
+    for (size_t i=block.firstLine; i<block.firstLine+blockSize; i++) {
+      if (i%100000 == 0) std::cerr << "." << std::flush;
     }
 
-    // drop due to MinScore thresholding
-    if ((minScore0 > 0 && adjustedCountEF_indirect/countE < minScore0) ||
-        (minScore2 > 0 && adjustedCountEF         /countF < minScore2)) {
+#ifdef WITH_THREADS
+    if (pool) {
+      boost::shared_ptr<ConsolidateTask> task(
+        new ConsolidateTask(blockId++, block, propertiesConsolidator, *collector));
+      pool->Submit(task);
+      block.firstLine += blockSize;
       continue;
     }
+#endif
 
-    // output phrase pair
-    fileConsolidated << itemDirect[0] << " ||| ";
-
-    if (partsOfSpeechFlag) {
-      // write POS factor from property
-      std::vector<std::string> targetTokens;
-      Moses::Tokenize( targetTokens, itemDirect[1] );
-      std::vector<std::string> propertyValuePOS;
-      propertiesConsolidator.GetPOSPropertyValueFromPropertiesString(itemDirect[5], propertyValuePOS);
-      size_t targetTerminalIndex = 0;
-      for (std::vector<std::string>::const_iterator targetTokensIt=targetTokens.begin();
-           targetTokensIt!=targetTokens.end(); ++targetTokensIt) {
-        fileConsolidated << *targetTokensIt;
-        if (!isNonTerminal(*targetTokensIt)) {
-          assert(propertyValuePOS.size() > targetTerminalIndex);
-          fileConsolidated << "|" << propertyValuePOS[targetTerminalIndex];
-          ++targetTerminalIndex;
-        }
-        fileConsolidated << " ";
-      }
-      fileConsolidated << "|||";
+    consolidateBlock( block, propertiesConsolidator, output );
+    fileConsolidated.write( output.data(), output.size() );
+    block.firstLine += blockSize;
+  }
 
-    } else {
+#ifdef WITH_THREADS
+  if (pool) {
+    pool->Stop(true);
+    collector->StopWriter();
+  }
+#endif
 
-      fileConsolidated << itemDirect[1] << " |||";
-    }
+  fileConsolidated.Close();
+
+  // We've been printing progress dots to stderr.  End the line.
+  std::cerr << std::endl;
+}
 
 
-    // prob indirect
-    if (!onlyDirectFlag) {
-      fileConsolidated << " " << maybeLogProb(adjustedCountEF_indirect/countE);
-      fileConsolidated << " " << indirectScores;
-    }
+// Reads the next block of lines from both rule tables.  Returns false once
+// the end of either of them has been reached.
+bool readBlock( util::FilePiece &fileDirect, util::FilePiece &fileIndirect, PhrasePairBlock &block )
+{
+  block.direct.clear();
+  block.indirect.clear();
+
+  StringPiece lineDirect, lineIndirect;
+  while (block.direct.size() < BLOCK_SIZE) {
+    if (! fileIndirect.ReadLineOrEOF(lineIndirect, '\n', false) ||
+        ! fileDirect.ReadLineOrEOF(lineDirect, '\n', false))
+      return false;
+    block.indirect.push_back(lineIndirect.as_string());
+    block.direct.push_back(lineDirect.as_string());
+  }
+  return true;
+}
 
-    // prob direct
-    fileConsolidated << " " << maybeLogProb(adjustedCountEF/countF);
-    fileConsolidated << " " << directScores;
 
-    // phrase count feature
-    if (phraseCountFlag) {
-      fileConsolidated << " " << maybeLogProb(2.718);
-    }
+void consolidateBlock( const PhrasePairBlock &block,
+                       const MosesTraining::PropertiesConsolidator &propertiesConsolidator,
+                       std::string &output )
+{
+  util::StringStream out;
+  std::ostringstream properties;
+  for (size_t i=0; i<block.direct.size(); i++) {
+    consolidatePhrasePair( block.firstLine+i, block.direct[i], block.indirect[i],
+                           propertiesConsolidator, out, properties );
+  }
+  out.swap(output);
+}
 
-    // low count feature
-    if (lowCountFlag) {
-      fileConsolidated << " " << maybeLogProb(std::exp(-1.0/countEF));
-    }
 
-    // count bin feature (as a core feature)
-    if (countBin.size()>0 && !sparseCountBinFeatureFlag) {
-      bool foundBin = false;
-      for(size_t i=0; i < countBin.size(); i++) {
-        if (!foundBin && countEF <= countBin[i]) {
-          fileConsolidated << " " << maybeLogProb(2.718);
-          foundBin = true;
-        } else {
-          fileConsolidated << " " << maybeLogProb(1);
-        }
+void consolidatePhrasePair( size_t lineNum,
+                            const std::string &lineDirect,
+                            const std::string &lineIndirect,
+                            const MosesTraining::PropertiesConsolidator &propertiesConsolidator,
+                            util::StringStream &out,
+                            std::ostringstream &properties )
+{
+  std::vector< std::string > itemDirect, itemIndirect;
+  Moses::TokenizeMultiCharSeparator(itemIndirect, lineIndirect, " ||| ");
+  Moses::TokenizeMultiCharSeparator(itemDirect, lineDirect, " ||| ");
+
+  // direct: target source alignment probabilities
+  // indirect: source target probabilities
+
+  // consistency checks
+  UTIL_THROW_IF2(itemDirect[0].compare( itemIndirect[0] ) != 0,
+                 "target phrase does not match in line " << lineNum << ": '" << itemDirect[0] << "' != '" << itemIndirect[0] << "'");
+  UTIL_THROW_IF2(itemDirect[1].compare( itemIndirect[1] ) != 0,
+                 "source phrase does not match in line " << lineNum << ": '" << itemDirect[1] << "' != '" << itemIndirect[1] << "'");
+
+  // SCORES ...
+  std::string directScores, directSparseScores, indirectScores, indirectSparseScores;
+  breakdownCoreAndSparse( itemDirect[3], directScores, directSparseScores );
+  breakdownCoreAndSparse( itemIndirect[3], indirectScores, indirectSparseScores );
+
+  std::vector<std::string> directCounts;
+  Moses::Tokenize( directCounts, itemDirect[4] );
+  std::vector<std::string> indirectCounts;
+  Moses::Tokenize( indirectCounts, itemIndirect[4] );
+  float countF  = std::atof( directCounts[0].c_str() );
+  float countE  = std::atof( indirectCounts[0].c_str() );
+  float countEF = std::atof( indirectCounts[1].c_str() );
+  float n1_F, n1_E;
+  if (kneserNeyFlag) {
+    n1_F = std::atof( directCounts[2].c_str() );
+    n1_E = std::atof( indirectCounts[2].c_str() );
+  }
+
+  // Good Turing discounting
+  float adjustedCountEF = countEF;
+  if (goodTuringFlag && countEF+0.99999 < goodTuringDiscount.size()-1)
+    adjustedCountEF *= goodTuringDiscount[(int)(countEF+0.99998)];
+  float adjustedCountEF_indirect = adjustedCountEF;
+
+  // Kneser Ney discounting [Foster et al, 2006]
+  if (kneserNeyFlag) {
+    float D = kneserNey_D3;
+    if (countEF < 2) D = kneserNey_D1;
+    else if (countEF < 3) D = kneserNey_D2;
+    if (D > countEF) D = countEF - 0.01; // sanity constraint
+
+    float p_b_E = n1_E / totalCount; // target phrase prob based on distinct
+    float alpha_F = D * n1_F / countF; // available mass
+    adjustedCountEF = countEF - D + countF * alpha_F * p_b_E;
+
+    // for indirect
+    float p_b_F = n1_F / totalCount; // target phrase prob based on distinct
+    float alpha_E = D * n1_E / countE; // available mass
+    adjustedCountEF_indirect = countEF - D + countE * alpha_E * p_b_F;
+  }
+
+  // drop due to MinScore thresholding
+  if ((minScore0 > 0 && adjustedCountEF_indirect/countE < minScore0) ||
+      (minScore2 > 0 && adjustedCountEF         /countF < minScore2)) {
+    return;
+  }
+
+  // output phrase pair
+  out << itemDirect[0] << " ||| ";
+
+  if (partsOfSpeechFlag) {
+    // write POS factor from property
+    std::vector<std::string> targetTokens;
+    Moses::Tokenize( targetTokens, itemDirect[1] );
+    std::vector<std::string> propertyValuePOS;
+    propertiesConsolidator.GetPOSPropertyValueFromPropertiesString(itemDirect[5], propertyValuePOS);
+    size_t targetTerminalIndex = 0;
+    for (std::vector<std::string>::const_iterator targetTokensIt=targetTokens.begin();
+         targetTokensIt!=targetTokens.end(); ++targetTokensIt) {
+      out << *targetTokensIt;
+      if (!isNonTerminal(*targetTokensIt)) {
+        assert(propertyValuePOS.size() > targetTerminalIndex);
+        out << "|" << propertyValuePOS[targetTerminalIndex];
+        ++targetTerminalIndex;
       }
-      fileConsolidated << " " << maybeLogProb( foundBin ? 1 : 2.718 );
+      out << " ";
     }
+    out << "|||";
 
-    // alignment
-    fileConsolidated << " |||";
-    if (!itemDirect[2].empty()) {
-      fileConsolidated << " " << itemDirect[2];;
-    }
+  } else {
 
-    // counts, for debugging
-    fileConsolidated << " ||| " << countE << " " << countF << " " << countEF;
-
-    // sparse features
-    fileConsolidated << " |||";
-    if (directSparseScores.compare("") != 0)
-      fileConsolidated << " " << directSparseScores;
-    if (indirectSparseScores.compare("") != 0)
-      fileConsolidated << " " << indirectSparseScores;
-
-    // count bin feature (as a sparse feature)
-    if (sparseCountBinFeatureFlag) {
-      bool foundBin = false;
-      for(size_t i=0; i < countBin.size(); i++) {
-        if (!foundBin && countEF <= countBin[i]) {
-          fileConsolidated << " cb_";
-          if (i == 0 && countBin[i] > 1)
-            fileConsolidated << "1_";
-          else if (i > 0 && countBin[i-1]+1 < countBin[i])
-            fileConsolidated << (countBin[i-1]+1) << "_";
-          fileConsolidated << countBin[i] << " 1";
-          foundBin = true;
-        }
-      }
-      if (!foundBin) {
-        fileConsolidated << " cb_max 1";
+    out << itemDirect[1] << " |||";
+  }
+
+
+  // prob indirect
+  if (!onlyDirectFlag) {
+    out << " " << maybeLogProb(adjustedCountEF_indirect/countE);
+    out << " " << indirectScores;
+  }
+
+  // prob direct
+  out << " " << maybeLogProb(adjustedCountEF/countF);
+  out << " " << directScores;
+
+  // phrase count feature
+  if (phraseCountFlag) {
+    out << " " << maybeLogProb(2.718);
+  }
+
+  // low count feature
+  if (lowCountFlag) {
+    out << " " << maybeLogProb(std::exp(-1.0/countEF));
+  }
+
+  // count bin feature (as a core feature)
+  if (countBin.size()>0 && !sparseCountBinFeatureFlag) {
+    bool foundBin = false;
+    for(size_t i=0; i < countBin.size(); i++) {
+      if (!foundBin && countEF <= countBin[i]) {
+        out << " " << maybeLogProb(2.718);
+        foundBin = true;
+      } else {
+        out << " " << maybeLogProb(1);
       }
     }
+    out << " " << maybeLogProb( foundBin ? 1 : 2.718 );
+  }
 
-    // arbitrary key-value pairs
-    fileConsolidated << " |||";
-    if (itemDirect.size() >= 6) {
-      propertiesConsolidator.ProcessPropertiesString(itemDirect[5], fileConsolidated);
-    }
+  // alignment
+  out << " |||";
+  if (!itemDirect[2].empty()) {
+    out << " " << itemDirect[2];;
+  }
 
-    if (countsProperty) {
-      fileConsolidated << " {{Counts " << countE << " " << countF << " " << countEF << "}}";
+  // counts, for debugging
+  out << " ||| " << countE << " " << countF << " " << countEF;
+
+  // sparse features
+  out << " |||";
+  if (directSparseScores.compare("") != 0)
+    out << " " << directSparseScores;
+  if (indirectSparseScores.compare("") != 0)
+    out << " " << indirectSparseScores;
+
+  // count bin feature (as a sparse feature)
+  if (sparseCountBinFeatureFlag) {
+    bool foundBin = false;
+    for(size_t i=0; i < countBin.size(); i++) {
+      if (!foundBin && countEF <= countBin[i]) {
+        out << " cb_";
+        if (i == 0 && countBin[i] > 1)
+          out << "1_";
+        else if (i > 0 && countBin[i-1]+1 < countBin[i])
+          out << (countBin[i-1]+1) << "_";
+        out << countBin[i] << " 1";
+        foundBin = true;
+      }
     }
+    if (!foundBin) {
+      out << " cb_max 1";
+    }
+  }
 
-    fileConsolidated << std::endl;
+  // arbitrary key-value pairs
+  out << " |||";
+  if (itemDirect.size() >= 6) {
+    properties.str("");
+    propertiesConsolidator.ProcessPropertiesString(itemDirect[5], properties);
+    out << properties.str();
   }
 
-  fileDirect.Close();
-  fileIndirect.Close();
-  fileConsolidated.Close();
+  if (countsProperty) {
+    out << " {{Counts " << countE << " " << countF << " " << countEF << "}}";
+  }
 
-  // We've been printing progress dots to stderr.  End the line.
-  std::cerr << std::endl;
+  out << '\n';
 }
 
 
@@ -473,18 +620,3 @@ void breakdownCoreAndSparse( const std::string &combined, std::string &core, std
   if (sparse.size() > 0 ) sparse = sparse.substr(1);
 }
 
-
-bool getLine( Moses::InputFileStream &file, std::vector< std::string > &item )
-{
-  if (file.eof())
-    return false;
-
-  std::string line;
-  if (!getline(file, line))
-    return false;
-
-  Moses::TokenizeMultiCharSeparator(item, line, " ||| ");
-
-  return true;
-}
-
@@ -29,10 +29,19 @@
 #include <vector>
 
 #include <boost/program_options.hpp>
+#include <boost/shared_ptr.hpp>
+
+#ifdef WITH_THREADS
+#include <boost/scoped_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+#endif
 
 #include "syntax-common/exception.h"
 #include "syntax-common/xml_tree_parser.h"
 
+#include "moses/OutputCollector.h"
+#include "moses/ThreadPool.h"
+
 #include "InputFileStream.h"
 #include "OutputFileStream.h"
 #include "SyntaxNode.h"
@@ -60,6 +69,112 @@ namespace Syntax
 namespace GHKM
 {
 
+ExtractionStatistics::ExtractionStatistics()
+  : l2rOrientationPriorCounts(PhraseOrientation::REO_CLASS_UNKNOWN+1, 0.0f)
+  , r2lOrientationPriorCounts(PhraseOrientation::REO_CLASS_UNKNOWN+1, 0.0f)
+{
+}
+
+void ExtractionStatistics::Add(const ExtractionStatistics &other)
+{
+  targetLabelSet.insert(other.targetLabelSet.begin(),
+                        other.targetLabelSet.end());
+  for (std::map<std::string, int>::const_iterator p =
+         other.targetTopLabelSet.begin();
+       p != other.targetTopLabelSet.end(); ++p) {
+    targetTopLabelSet[p->first] += p->second;
+  }
+  sourceLabelSet.insert(other.sourceLabelSet.begin(),
+                        other.sourceLabelSet.end());
+
+  // Only the labels of singletons are used, so it does not matter which
+  // sentence's label is kept for the other words.
+  for (std::map<std::string, int>::const_iterator p =
+         other.targetWordCount.begin();
+       p != other.targetWordCount.end(); ++p) {
+    targetWordCount[p->first] += p->second;
+  }
+  for (std::map<std::string, std::string>::const_iterator p =
+         other.targetWordLabel.begin();
+       p != other.targetWordLabel.end(); ++p) {
+    targetWordLabel[p->first] = p->second;
+  }
+  for (std::map<std::string, int>::const_iterator p =
+         other.sourceWordCount.begin();
+       p != other.sourceWordCount.end(); ++p) {
+    sourceWordCount[p->first] += p->second;
+  }
+  for (std::map<std::string, std::string>::const_iterator p =
+         other.sourceWordLabel.begin();
+       p != other.sourceWordLabel.end(); ++p) {
+    sourceWordLabel[p->first] = p->second;
+  }
+
+  for (size_t i = 0; i < l2rOrientationPriorCounts.size(); ++i) {
+    l2rOrientationPriorCounts[i] += other.l2rOrientationPriorCounts[i];
+    r2lOrientationPriorCounts[i] += other.r2lOrientationPriorCounts[i];
+  }
+}
+
+#ifdef WITH_THREADS
+// Extracts the rules of one sentence triple in a worker thread and hands the
+// output to the OutputCollectors, which write it in input order.
+class ExtractTask : public Moses::Task
+{
+public:
+  ExtractTask(const ExtractGHKM &tool, int sentenceId, size_t lineNum,
+              const std::string &targetLine, const std::string &sourceLine,
+              const std::string &alignmentLine, const Options &options,
+              ExtractionStatistics &stats, boost::mutex &statsMutex,
+              Moses::OutputCollector &fwdCollector,
+              Moses::OutputCollector &invCollector)
+    : m_tool(tool)
+    , m_sentenceId(sentenceId)
+    , m_lineNum(lineNum)
+    , m_targetLine(targetLine)
+    , m_sourceLine(sourceLine)
+    , m_alignmentLine(alignmentLine)
+    , m_options(options)
+    , m_stats(stats)
+    , m_statsMutex(statsMutex)
+    , m_fwdCollector(fwdCollector)
+    , m_invCollector(invCollector) {}
+
+  virtual void Run() {
+    XmlTreeParser targetXmlTreeParser;
+    XmlTreeParser sourceXmlTreeParser;
+    ExtractionStatistics stats;
+    std::ostringstream fwd;
+    std::ostringstream inv;
+    std::ostringstream log;
+    m_tool.ExtractSentence(m_lineNum, m_targetLine, m_sourceLine,
+                           m_alignmentLine, m_options, targetXmlTreeParser,
+                           sourceXmlTreeParser, stats, fwd, inv, log);
+    m_fwdCollector.Write(m_sentenceId, fwd.str(), log.str());
+    m_invCollector.Write(m_sentenceId, inv.str());
+
+    stats.targetLabelSet = targetXmlTreeParser.label_set();
+    stats.targetTopLabelSet = targetXmlTreeParser.top_label_set();
+    stats.sourceLabelSet = sourceXmlTreeParser.label_set();
+    boost::mutex::scoped_lock lock(m_statsMutex);
+    m_stats.Add(stats);
+  }
+
+private:
+  const ExtractGHKM &m_tool;
+  int m_sentenceId;
+  size_t m_lineNum;
+  std::string m_targetLine;
+  std::string m_sourceLine;
+  std::string m_alignmentLine;
+  const Options &m_options;
+  ExtractionStatistics &m_stats;
+  boost::mutex &m_statsMutex;
+  Moses::OutputCollector &m_fwdCollector;
+  Moses::OutputCollector &m_invCollector;
+};
+#endif
+
 int ExtractGHKM::Main(int argc, char *argv[])
 {
   using Moses::InputFileStream;
@@ -121,23 +236,33 @@ int ExtractGHKM::Main(int argc, char *argv[])
     OpenOutputFileOrDie(options.unknownWordSoftMatchesFile, unknownWordSoftMatchesStream);
   }
 
-  // Word count statistics for producing unknown word labels.
-  std::map<std::string, int> targetWordCount;
-  std::map<std::string, std::string> targetWordLabel;
-
-  // Word count statistics for producing unknown word labels: source side.
-  std::map<std::string, int> sourceWordCount;
-  std::map<std::string, std::string> sourceWordLabel;
-
+  ExtractionStatistics stats;
   std::string targetLine;
   std::string sourceLine;
   std::string alignmentLine;
-  Alignment alignment;
   XmlTreeParser targetXmlTreeParser;
   XmlTreeParser sourceXmlTreeParser;
-  ScfgRuleWriter scfgWriter(fwdExtractStream, invExtractStream, options);
-  StsgRuleWriter stsgWriter(fwdExtractStream, invExtractStream, options);
   size_t lineNum = options.sentenceOffset;
+
+#ifdef WITH_THREADS
+  // In multi-threaded mode, the sentences are extracted by a pool of worker
+  // threads.  Their output is put back into input order by an OutputCollector
+  // per extract file, which writes (and compresses) it in a thread of its own.
+  boost::scoped_ptr<Moses::ThreadPool> pool;
+  boost::scoped_ptr<Moses::OutputCollector> fwdCollector;
+  boost::scoped_ptr<Moses::OutputCollector> invCollector;
+  boost::mutex statsMutex;
+  if (options.threads > 1) {
+    pool.reset(new Moses::ThreadPool(options.threads));
+    pool->SetQueueLimit(options.threads * 64);
+    fwdCollector.reset(new Moses::OutputCollector(&fwdExtractStream));
+    invCollector.reset(new Moses::OutputCollector(&invExtractStream));
+    fwdCollector->StartWriter();
+    invCollector->StartWriter();
+  }
+  int sentenceId = 0;
+#endif
+
   while (true) {
     std::getline(targetStream, targetLine);
     std::getline(sourceStream, sourceLine);
@@ -153,154 +278,44 @@ int ExtractGHKM::Main(int argc, char *argv[])
 
     ++lineNum;
 
-    // Parse target tree.
-    if (targetLine.size() == 0) {
-      std::cerr << "skipping line " << lineNum << " with empty target tree\n";
-      continue;
-    }
-    std::auto_ptr<SyntaxTree> targetParseTree;
-    try {
-      targetParseTree = targetXmlTreeParser.Parse(targetLine);
-      assert(targetParseTree.get());
-    } catch (const Exception &e) {
-      std::ostringstream oss;
-      oss << "Failed to parse target XML tree at line " << lineNum;
-      if (!e.msg().empty()) {
-        oss << ": " << e.msg();
-      }
-      Error(oss.str());
-    }
-
-    // Read source tokens (and parse tree if using source labels).
-    std::vector<std::string> sourceTokens;
-    std::auto_ptr<SyntaxTree> sourceParseTree;
-    if (!options.sourceLabels) {
-      sourceTokens = ReadTokens(sourceLine);
-    } else {
-      try {
-        sourceParseTree = sourceXmlTreeParser.Parse(sourceLine);
-        assert(sourceParseTree.get());
-      } catch (const Exception &e) {
-        std::ostringstream oss;
-        oss << "Failed to parse source XML tree at line " << lineNum;
-        if (!e.msg().empty()) {
-          oss << ": " << e.msg();
-        }
-        Error(oss.str());
-      }
-      sourceTokens = sourceXmlTreeParser.words();
-    }
-
-    // Read word alignments.
-    try {
-      ReadAlignment(alignmentLine, alignment);
-    } catch (const Exception &e) {
-      std::ostringstream oss;
-      oss << "Failed to read alignment at line " << lineNum << ": ";
-      oss << e.msg();
-      Error(oss.str());
-    }
-    if (alignment.size() == 0) {
-      std::cerr << "skipping line " << lineNum << " without alignment points\n";
+#ifdef WITH_THREADS
+    if (pool) {
+      boost::shared_ptr<ExtractTask> task(
+        new ExtractTask(*this, sentenceId++, lineNum, targetLine, sourceLine,
+                        alignmentLine, options, stats, statsMutex,
+                        *fwdCollector, *invCollector));
+      pool->Submit(task);
       continue;
     }
-    if (options.t2s) {
-      FlipAlignment(alignment);
-    }
-
-    // Record word counts.
-    if (!options.targetUnknownWordFile.empty()) {
-      CollectWordLabelCounts(*targetParseTree, options, targetWordCount,
-                             targetWordLabel);
-    }
-
-    // Record word counts: source side.
-    if (options.sourceLabels && !options.sourceUnknownWordFile.empty()) {
-      CollectWordLabelCounts(*sourceParseTree, options, sourceWordCount,
-                             sourceWordLabel);
-    }
-
-    // Form an alignment graph from the target tree, source words, and
-    // alignment.
-    AlignmentGraph graph(targetParseTree.get(), sourceTokens, alignment);
-
-    // Extract minimal rules, adding each rule to its root node's rule set.
-    graph.ExtractMinimalRules(options);
-
-    // Extract composed rules.
-    if (!options.minimal) {
-      graph.ExtractComposedRules(options);
-    }
+#endif
 
-    // Initialize phrase orientation scoring object
-    PhraseOrientation phraseOrientation(sourceTokens.size(),
-                                        targetXmlTreeParser.words().size(), alignment);
-
-    // Write the rules, subject to scope pruning.
-    const std::vector<Node *> &targetNodes = graph.GetTargetNodes();
-    for (std::vector<Node *>::const_iterator p = targetNodes.begin();
-         p != targetNodes.end(); ++p) {
-
-      const std::vector<const Subgraph *> &rules = (*p)->GetRules();
-
-      PhraseOrientation::REO_CLASS l2rOrientation=PhraseOrientation::REO_CLASS_UNKNOWN, r2lOrientation=PhraseOrientation::REO_CLASS_UNKNOWN;
-      if (options.phraseOrientation && !rules.empty()) {
-        int sourceSpanBegin = *((*p)->GetSpan().begin());
-        int sourceSpanEnd   = *((*p)->GetSpan().rbegin());
-        l2rOrientation = phraseOrientation.GetOrientationInfo(sourceSpanBegin,sourceSpanEnd,PhraseOrientation::REO_DIR_L2R);
-        r2lOrientation = phraseOrientation.GetOrientationInfo(sourceSpanBegin,sourceSpanEnd,PhraseOrientation::REO_DIR_R2L);
-        // std::cerr << "span " << sourceSpanBegin << " " << sourceSpanEnd << std::endl;
-        // std::cerr << "phraseOrientation " << phraseOrientation.GetOrientationInfo(sourceSpanBegin,sourceSpanEnd) << std::endl;
-      }
+    ExtractSentence(lineNum, targetLine, sourceLine, alignmentLine, options,
+                    targetXmlTreeParser, sourceXmlTreeParser, stats,
+                    fwdExtractStream, invExtractStream, std::cerr);
+  }
 
-      for (std::vector<const Subgraph *>::const_iterator q = rules.begin();
-           q != rules.end(); ++q) {
-        // STSG output.
-        if (options.stsg) {
-          StsgRule rule(**q);
-          if (rule.Scope() <= options.maxScope) {
-            stsgWriter.Write(rule);
-          }
-          continue;
-        }
-        // SCFG output.
-        ScfgRule *r = 0;
-        if (options.sourceLabels) {
-          r = new ScfgRule(**q, &sourceXmlTreeParser.node_collection());
-        } else {
-          r = new ScfgRule(**q);
-        }
-        // TODO Can scope pruning be done earlier?
-        if (r->Scope() <= options.maxScope) {
-          scfgWriter.Write(*r,lineNum,false);
-          if (options.treeFragments) {
-            fwdExtractStream << " {{Tree ";
-            (*q)->PrintTree(fwdExtractStream);
-            fwdExtractStream << "}}";
-          }
-          if (options.partsOfSpeech) {
-            fwdExtractStream << " {{POS";
-            (*q)->PrintPartsOfSpeech(fwdExtractStream);
-            fwdExtractStream << "}}";
-          }
-          if (options.phraseOrientation) {
-            fwdExtractStream << " {{Orientation ";
-            phraseOrientation.WriteOrientation(fwdExtractStream,l2rOrientation);
-            fwdExtractStream << " ";
-            phraseOrientation.WriteOrientation(fwdExtractStream,r2lOrientation);
-            fwdExtractStream << "}}";
-            phraseOrientation.IncrementPriorCount(PhraseOrientation::REO_DIR_L2R,l2rOrientation,1);
-            phraseOrientation.IncrementPriorCount(PhraseOrientation::REO_DIR_R2L,r2lOrientation,1);
-          }
-          fwdExtractStream << std::endl;
-          invExtractStream << std::endl;
-        }
-        delete r;
-      }
-    }
+#ifdef WITH_THREADS
+  if (pool) {
+    pool->Stop(true);
+    fwdCollector->StopWriter();
+    invCollector->StopWriter();
+  } else
+#endif
+  {
+    stats.targetLabelSet = targetXmlTreeParser.label_set();
+    stats.targetTopLabelSet = targetXmlTreeParser.top_label_set();
+    stats.sourceLabelSet = sourceXmlTreeParser.label_set();
   }
 
   if (options.phraseOrientation) {
+    PhraseOrientation phraseOrientation;
+    for (size_t i = 0; i < stats.l2rOrientationPriorCounts.size(); ++i) {
+      PhraseOrientation::REO_CLASS orient = PhraseOrientation::REO_CLASS(i);
+      phraseOrientation.IncrementPriorCount(PhraseOrientation::REO_DIR_L2R, orient,
+                                            stats.l2rOrientationPriorCounts[i]);
+      phraseOrientation.IncrementPriorCount(PhraseOrientation::REO_DIR_R2L, orient,
+                                            stats.r2lOrientationPriorCounts[i]);
+    }
     std::string phraseOrientationPriorsFileName = options.extractFile + std::string(".phraseOrientationPriors");
     OutputFileStream phraseOrientationPriorsStream;
     OpenOutputFileOrDie(phraseOrientationPriorsFileName, phraseOrientationPriorsStream);
@@ -309,7 +324,7 @@ int ExtractGHKM::Main(int argc, char *argv[])
 
   std::map<std::string,size_t> sourceLabels;
   if (options.sourceLabels && !options.sourceLabelSetFile.empty()) {
-    std::set<std::string> extendedLabelSet = sourceXmlTreeParser.label_set();
+    std::set<std::string> extendedLabelSet = stats.sourceLabelSet;
     extendedLabelSet.insert("XLHS"); // non-matching label (left-hand side)
     extendedLabelSet.insert("XRHS"); // non-matching label (right-hand side)
     extendedLabelSet.insert("TOPLABEL");  // as used in the glue grammar
@@ -326,8 +341,7 @@ int ExtractGHKM::Main(int argc, char *argv[])
   std::map<std::string, int> strippedTargetTopLabelSet;
   if (options.stripBitParLabels &&
       (!options.glueGrammarFile.empty() || !options.unknownWordSoftMatchesFile.empty())) {
-    StripBitParLabels(targetXmlTreeParser.label_set(),
-                      targetXmlTreeParser.top_label_set(),
+    StripBitParLabels(stats.targetLabelSet, stats.targetTopLabelSet,
                       strippedTargetLabelSet, strippedTargetTopLabelSet);
   }
 
@@ -335,25 +349,26 @@ int ExtractGHKM::Main(int argc, char *argv[])
     if (options.stripBitParLabels) {
       WriteGlueGrammar(strippedTargetLabelSet, strippedTargetTopLabelSet, sourceLabels, options, glueGrammarStream);
     } else {
-      WriteGlueGrammar(targetXmlTreeParser.label_set(),
-                       targetXmlTreeParser.top_label_set(),
+      WriteGlueGrammar(stats.targetLabelSet, stats.targetTopLabelSet,
                        sourceLabels, options, glueGrammarStream);
     }
   }
 
   if (!options.targetUnknownWordFile.empty()) {
-    WriteUnknownWordLabel(targetWordCount, targetWordLabel, options, targetUnknownWordStream);
+    WriteUnknownWordLabel(stats.targetWordCount, stats.targetWordLabel, options,
+                          targetUnknownWordStream);
   }
 
   if (options.sourceLabels && !options.sourceUnknownWordFile.empty()) {
-    WriteUnknownWordLabel(sourceWordCount, sourceWordLabel, options, sourceUnknownWordStream, true);
+    WriteUnknownWordLabel(stats.sourceWordCount, stats.sourceWordLabel, options,
+                          sourceUnknownWordStream, true);
   }
 
   if (!options.unknownWordSoftMatchesFile.empty()) {
     if (options.stripBitParLabels) {
       WriteUnknownWordSoftMatches(strippedTargetLabelSet, unknownWordSoftMatchesStream);
     } else {
-      WriteUnknownWordSoftMatches(targetXmlTreeParser.label_set(),
+      WriteUnknownWordSoftMatches(stats.targetLabelSet,
                                   unknownWordSoftMatchesStream);
     }
   }
@@ -361,6 +376,168 @@ int ExtractGHKM::Main(int argc, char *argv[])
   return 0;
 }
 
+void ExtractGHKM::ExtractSentence(size_t lineNum,
+                                  const std::string &targetLine,
+                                  const std::string &sourceLine,
+                                  const std::string &alignmentLine,
+                                  const Options &options,
+                                  XmlTreeParser &targetXmlTreeParser,
+                                  XmlTreeParser &sourceXmlTreeParser,
+                                  ExtractionStatistics &stats,
+                                  std::ostream &fwd,
+                                  std::ostream &inv,
+                                  std::ostream &log) const
+{
+  // Parse target tree.
+  if (targetLine.size() == 0) {
+    log << "skipping line " << lineNum << " with empty target tree\n";
+    return;
+  }
+  std::auto_ptr<SyntaxTree> targetParseTree;
+  try {
+    targetParseTree = targetXmlTreeParser.Parse(targetLine);
+    assert(targetParseTree.get());
+  } catch (const Exception &e) {
+    std::ostringstream oss;
+    oss << "Failed to parse target XML tree at line " << lineNum;
+    if (!e.msg().empty()) {
+      oss << ": " << e.msg();
+    }
+    Error(oss.str());
+  }
+
+  // Read source tokens (and parse tree if using source labels).
+  std::vector<std::string> sourceTokens;
+  std::auto_ptr<SyntaxTree> sourceParseTree;
+  if (!options.sourceLabels) {
+    sourceTokens = ReadTokens(sourceLine);
+  } else {
+    try {
+      sourceParseTree = sourceXmlTreeParser.Parse(sourceLine);
+      assert(sourceParseTree.get());
+    } catch (const Exception &e) {
+      std::ostringstream oss;
+      oss << "Failed to parse source XML tree at line " << lineNum;
+      if (!e.msg().empty()) {
+        oss << ": " << e.msg();
+      }
+      Error(oss.str());
+    }
+    sourceTokens = sourceXmlTreeParser.words();
+  }
+
+  // Read word alignments.
+  Alignment alignment;
+  try {
+    ReadAlignment(alignmentLine, alignment);
+  } catch (const Exception &e) {
+    std::ostringstream oss;
+    oss << "Failed to read alignment at line " << lineNum << ": ";
+    oss << e.msg();
+    Error(oss.str());
+  }
+  if (alignment.size() == 0) {
+    log << "skipping line " << lineNum << " without alignment points\n";
+    return;
+  }
+  if (options.t2s) {
+    FlipAlignment(alignment);
+  }
+
+  // Record word counts.
+  if (!options.targetUnknownWordFile.empty()) {
+    CollectWordLabelCounts(*targetParseTree, options, stats.targetWordCount,
+                           stats.targetWordLabel);
+  }
+
+  // Record word counts: source side.
+  if (options.sourceLabels && !options.sourceUnknownWordFile.empty()) {
+    CollectWordLabelCounts(*sourceParseTree, options, stats.sourceWordCount,
+                           stats.sourceWordLabel);
+  }
+
+  // Form an alignment graph from the target tree, source words, and
+  // alignment.
+  AlignmentGraph graph(targetParseTree.get(), sourceTokens, alignment);
+
+  // Extract minimal rules, adding each rule to its root node's rule set.
+  graph.ExtractMinimalRules(options);
+
+  // Extract composed rules.
+  if (!options.minimal) {
+    graph.ExtractComposedRules(options);
+  }
+
+  // Initialize phrase orientation scoring object
+  PhraseOrientation phraseOrientation(sourceTokens.size(),
+                                      targetXmlTreeParser.words().size(), alignment);
+
+  // Write the rules, subject to scope pruning.
+  ScfgRuleWriter scfgWriter(fwd, inv, options);
+  StsgRuleWriter stsgWriter(fwd, inv, options);
+  const std::vector<Node *> &targetNodes = graph.GetTargetNodes();
+  for (std::vector<Node *>::const_iterator p = targetNodes.begin();
+       p != targetNodes.end(); ++p) {
+
+    const std::vector<const Subgraph *> &rules = (*p)->GetRules();
+
+    PhraseOrientation::REO_CLASS l2rOrientation=PhraseOrientation::REO_CLASS_UNKNOWN, r2lOrientation=PhraseOrientation::REO_CLASS_UNKNOWN;
+    if (options.phraseOrientation && !rules.empty()) {
+      int sourceSpanBegin = *((*p)->GetSpan().begin());
+      int sourceSpanEnd   = *((*p)->GetSpan().rbegin());
+      l2rOrientation = phraseOrientation.GetOrientationInfo(sourceSpanBegin,sourceSpanEnd,PhraseOrientation::REO_DIR_L2R);
+      r2lOrientation = phraseOrientation.GetOrientationInfo(sourceSpanBegin,sourceSpanEnd,PhraseOrientation::REO_DIR_R2L);
+      // std::cerr << "span " << sourceSpanBegin << " " << sourceSpanEnd << std::endl;
+      // std::cerr << "phraseOrientation " << phraseOrientation.GetOrientationInfo(sourceSpanBegin,sourceSpanEnd) << std::endl;
+    }
+
+    for (std::vector<const Subgraph *>::const_iterator q = rules.begin();
+         q != rules.end(); ++q) {
+      // STSG output.
+      if (options.stsg) {
+        StsgRule rule(**q);
+        if (rule.Scope() <= options.maxScope) {
+          stsgWriter.Write(rule);
+        }
+        continue;
+      }
+      // SCFG output.
+      ScfgRule *r = 0;
+      if (options.sourceLabels) {
+        r = new ScfgRule(**q, &sourceXmlTreeParser.node_collection());
+      } else {
+        r = new ScfgRule(**q);
+      }
+      // TODO Can scope pruning be done earlier?
+      if (r->Scope() <= options.maxScope) {
+        scfgWriter.Write(*r,lineNum,false);
+        if (options.treeFragments) {
+          fwd << " {{Tree ";
+          (*q)->PrintTree(fwd);
+          fwd << "}}";
+        }
+        if (options.partsOfSpeech) {
+          fwd << " {{POS";
+          (*q)->PrintPartsOfSpeech(fwd);
+          fwd << "}}";
+        }
+        if (options.phraseOrientation) {
+          fwd << " {{Orientation ";
+          phraseOrientation.WriteOrientation(fwd,l2rOrientation);
+          fwd << " ";
+          phraseOrientation.WriteOrientation(fwd,r2lOrientation);
+          fwd << "}}";
+          ++stats.l2rOrientationPriorCounts[l2rOrientation];
+          ++stats.r2lOrientationPriorCounts[r2lOrientation];
+        }
+        fwd << std::endl;
+        inv << std::endl;
+      }
+      delete r;
+    }
+  }
+}
+
 void ExtractGHKM::ProcessOptions(int argc, char *argv[],
                                  Options &options) const
 {
@@ -456,6 +633,9 @@ void ExtractGHKM::ProcessOptions(int argc, char *argv[],
    "output STSG rules (default is SCFG)")
   ("T2S",
    "enable tree-to-string rule extraction (string-to-tree is assumed by default)")
+  ("Threads",
+   po::value(&options.threads)->default_value(options.threads),
+   "extract with this many worker threads; the extract files are then written\n(and compressed) by threads of their own")
   ("TreeFragments",
    "output parse tree information")
   ("SourceLabels",
@@ -591,6 +771,15 @@ void ExtractGHKM::ProcessOptions(int argc, char *argv[],
     options.unpairedExtractFormat = true;
   }
 
+  if (options.threads < 1) {
+    Error("number of threads must be at least 1");
+  }
+#ifndef WITH_THREADS
+  if (options.threads > 1) {
+    Error("multi-threaded extraction requires a build with thread support");
+  }
+#endif
+
   // Workaround for extract-parallel issue.
   if (options.sentenceOffset > 0) {
     options.targetUnknownWordFile.clear();
@@ -768,7 +957,7 @@ void ExtractGHKM::CollectWordLabelCounts(
   SyntaxTree &root,
   const Options &options,
   std::map<std::string, int> &wordCount,
-  std::map<std::string, std::string> &wordLabel)
+  std::map<std::string, std::string> &wordLabel) const
 {
   for (SyntaxTree::ConstLeafIterator p(root);
        p != SyntaxTree::ConstLeafIterator(); ++p) {
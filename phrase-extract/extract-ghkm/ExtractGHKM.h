@@ -29,6 +29,7 @@
 #include "SyntaxTree.h"
 
 #include "syntax-common/tool.h"
+#include "syntax-common/xml_tree_parser.h"
 
 namespace MosesTraining
 {
@@ -38,6 +39,34 @@ namespace GHKM
 {
 
 struct Options;
+class ExtractTask;
+
+// Statistics that are collected over the whole corpus during extraction and
+// written once all sentences have been processed.  In multi-threaded mode,
+// each sentence collects its own statistics, which are then added to those of
+// the corpus.
+struct ExtractionStatistics {
+  ExtractionStatistics();
+
+  void Add(const ExtractionStatistics &);
+
+  // Label sets, as collected by the tree parsers.
+  std::set<std::string> targetLabelSet;
+  std::map<std::string, int> targetTopLabelSet;
+  std::set<std::string> sourceLabelSet;
+
+  // Word count statistics for producing unknown word labels.
+  std::map<std::string, int> targetWordCount;
+  std::map<std::string, std::string> targetWordLabel;
+
+  // Word count statistics for producing unknown word labels: source side.
+  std::map<std::string, int> sourceWordCount;
+  std::map<std::string, std::string> sourceWordLabel;
+
+  // Phrase orientation prior counts, indexed by PhraseOrientation::REO_CLASS.
+  std::vector<float> l2rOrientationPriorCounts;
+  std::vector<float> r2lOrientationPriorCounts;
+};
 
 class ExtractGHKM : public Tool
 {
@@ -47,11 +76,24 @@ public:
   virtual int Main(int argc, char *argv[]);
 
 private:
+  friend class ExtractTask;
+
+  void ExtractSentence(size_t lineNum,
+                       const std::string &targetLine,
+                       const std::string &sourceLine,
+                       const std::string &alignmentLine,
+                       const Options &,
+                       XmlTreeParser &targetXmlTreeParser,
+                       XmlTreeParser &sourceXmlTreeParser,
+                       ExtractionStatistics &,
+                       std::ostream &fwd,
+                       std::ostream &inv,
+                       std::ostream &log) const;
   void RecordTreeLabels(const SyntaxTree &, std::set<std::string> &);
   void CollectWordLabelCounts(SyntaxTree &,
                               const Options &,
                               std::map<std::string, int> &,
-                              std::map<std::string, std::string> &);
+                              std::map<std::string, std::string> &) const;
   void WriteUnknownWordLabel(const std::map<std::string, int> &,
                              const std::map<std::string, std::string> &,
                              const Options &,
@@ -49,6 +49,7 @@ public:
     , stripBitParLabels(false)
     , stsg(false)
     , t2s(false)
+    , threads(1)
     , treeFragments(false)
     , unknownWordMinRelFreq(0.03f)
     , unknownWordUniform(false)
@@ -83,6 +84,7 @@ public:
   bool stsg;
   bool t2s;
   std::string targetUnknownWordFile;
+  int threads;
   bool treeFragments;
   float unknownWordMinRelFreq;
   std::string unknownWordSoftMatchesFile;
@@ -0,0 +1,2 @@
+#!/bin/sh
+./bjam -j1 -q --notrace cxxflags=-std=gnu++11 link=static moses/
@@ -0,0 +1,128 @@
+#ifndef UTIL_SUFFIX_ARRAY_H
+#define UTIL_SUFFIX_ARRAY_H
+
+#include <algorithm>
+#include <vector>
+
+namespace util {
+
+namespace detail {
+
+template <class Index> void SuffixBuckets(const Index *text, Index n, Index alphabet_size, std::vector<Index> &bucket, bool end) {
+  bucket.assign(alphabet_size, 0);
+  for (Index i = 0; i < n; ++i) {
+    ++bucket[text[i]];
+  }
+  Index sum = 0;
+  for (Index c = 0; c < alphabet_size; ++c) {
+    sum += bucket[c];
+    bucket[c] = end ? sum : sum - bucket[c];
+  }
+}
+
+// Leftmost S-type position: S-type with an L-type predecessor.
+template <class Index> inline bool IsLeftmostS(const std::vector<bool> &is_s, Index i) {
+  return i > 0 && i != static_cast<Index>(-1) && is_s[i] && !is_s[i - 1];
+}
+
+// Sort the L-type suffixes from the sorted LMS suffixes, then the S-type ones.
+template <class Index> void InduceSuffixes(const Index *text, Index *sa, Index n, Index alphabet_size, const std::vector<bool> &is_s, std::vector<Index> &bucket) {
+  const Index kEmpty = static_cast<Index>(-1);
+  SuffixBuckets(text, n, alphabet_size, bucket, false);
+  for (Index i = 0; i < n; ++i) {
+    Index j = sa[i];
+    if (j != kEmpty && j > 0 && !is_s[j - 1]) sa[bucket[text[j - 1]]++] = j - 1;
+  }
+  SuffixBuckets(text, n, alphabet_size, bucket, true);
+  for (Index i = n; i-- > 0; ) {
+    Index j = sa[i];
+    if (j != kEmpty && j > 0 && is_s[j - 1]) sa[--bucket[text[j - 1]]] = j - 1;
+  }
+}
+
+} // namespace detail
+
+/* Suffix array construction by induced sorting (SA-IS: Nong, Zhang and Chan,
+ * "Two efficient algorithms for linear time suffix array construction", 2011)
+ * in time and extra space linear in the length of the text.
+ *
+ * text[0, n) consists of symbols below alphabet_size and ends in the unique
+ * smallest symbol 0.  Index is an unsigned integer type whose maximum value is
+ * used as a marker, so n must be below it.  On return, sa[0, n) holds the
+ * positions of the suffixes in lexicographic order, so sa[0] == n - 1.
+ */
+template <class Index> void InducedSuffixSort(const Index *text, Index *sa, Index n, Index alphabet_size) {
+  const Index kEmpty = static_cast<Index>(-1);
+  if (n == 1) {
+    sa[0] = 0;
+    return;
+  }
+  std::vector<bool> is_s(n);
+  is_s[n - 1] = true;
+  for (Index i = n - 1; i-- > 0; ) {
+    is_s[i] = text[i] < text[i + 1] || (text[i] == text[i + 1] && is_s[i + 1]);
+  }
+
+  // Sort the LMS substrings.
+  std::vector<Index> bucket;
+  detail::SuffixBuckets(text, n, alphabet_size, bucket, true);
+  std::fill(sa, sa + n, kEmpty);
+  for (Index i = 1; i < n; ++i) {
+    if (detail::IsLeftmostS(is_s, i)) sa[--bucket[text[i]]] = i;
+  }
+  detail::InduceSuffixes(text, sa, n, alphabet_size, is_s, bucket);
+
+  // Name them in order, equal substrings getting the same name.
+  Index lms_count = 0;
+  for (Index i = 0; i < n; ++i) {
+    if (detail::IsLeftmostS(is_s, sa[i])) sa[lms_count++] = sa[i];
+  }
+  std::fill(sa + lms_count, sa + n, kEmpty);
+  Index names = 0;
+  Index previous = kEmpty;
+  for (Index i = 0; i < lms_count; ++i) {
+    Index position = sa[i];
+    bool differ = false;
+    for (Index d = 0; d < n; ++d) {
+      if (previous == kEmpty || text[position + d] != text[previous + d] || is_s[position + d] != is_s[previous + d]) {
+        differ = true;
+        break;
+      }
+      if (d > 0 && (detail::IsLeftmostS(is_s, position + d) || detail::IsLeftmostS(is_s, previous + d))) break;
+    }
+    if (differ) {
+      ++names;
+      previous = position;
+    }
+    sa[lms_count + position / 2] = names - 1;
+  }
+  for (Index i = n, j = n; i-- > lms_count; ) {
+    if (sa[i] != kEmpty) sa[--j] = sa[i];
+  }
+
+  // Sort the LMS suffixes, recursing on the names unless they are unique.
+  Index *reduced = sa + n - lms_count;
+  if (names < lms_count) {
+    InducedSuffixSort(reduced, sa, lms_count, names);
+  } else {
+    for (Index i = 0; i < lms_count; ++i) sa[reduced[i]] = i;
+  }
+
+  // Induce the order of all suffixes from the sorted LMS suffixes.
+  for (Index i = 1, j = 0; i < n; ++i) {
+    if (detail::IsLeftmostS(is_s, i)) reduced[j++] = i;
+  }
+  for (Index i = 0; i < lms_count; ++i) sa[i] = reduced[sa[i]];
+  std::fill(sa + lms_count, sa + n, kEmpty);
+  detail::SuffixBuckets(text, n, alphabet_size, bucket, true);
+  for (Index i = lms_count; i-- > 0; ) {
+    Index j = sa[i];
+    sa[i] = kEmpty;
+    sa[--bucket[text[j]]] = j;
+  }
+  detail::InduceSuffixes(text, sa, n, alphabet_size, is_s, bucket);
+}
+
+} // namespace util
+
+#endif // UTIL_SUFFIX_ARRAY_H
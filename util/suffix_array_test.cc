@@ -0,0 +1,70 @@
+#include "util/suffix_array.hh"
+
+#define BOOST_TEST_MODULE SuffixArrayTest
+#include <boost/test/unit_test.hpp>
+
+#include <algorithm>
+#include <vector>
+
+namespace util { namespace {
+
+struct CompareSuffix {
+  explicit CompareSuffix(const std::vector<unsigned int> &text) : text_(text) {}
+  bool operator()(unsigned int a, unsigned int b) const {
+    return std::lexicographical_compare(text_.begin() + a, text_.end(), text_.begin() + b, text_.end());
+  }
+  const std::vector<unsigned int> &text_;
+};
+
+void CheckAgainstSort(const std::vector<unsigned int> &text, unsigned int alphabet_size) {
+  std::vector<unsigned int> expected(text.size());
+  for (unsigned int i = 0; i < text.size(); ++i) expected[i] = i;
+  std::sort(expected.begin(), expected.end(), CompareSuffix(text));
+  std::vector<unsigned int> sa(text.size());
+  InducedSuffixSort<unsigned int>(&text[0], &sa[0], text.size(), alphabet_size);
+  BOOST_CHECK_EQUAL_COLLECTIONS(expected.begin(), expected.end(), sa.begin(), sa.end());
+}
+
+BOOST_AUTO_TEST_CASE(sentinel_only) {
+  std::vector<unsigned int> text(1, 0);
+  CheckAgainstSort(text, 1);
+}
+
+BOOST_AUTO_TEST_CASE(banana) {
+  // b a n a n a $
+  unsigned int symbols[] = {2, 1, 3, 1, 3, 1, 0};
+  std::vector<unsigned int> text(symbols, symbols + 7);
+  std::vector<unsigned int> sa(7);
+  InducedSuffixSort<unsigned int>(&text[0], &sa[0], 7, 4);
+  unsigned int expected[] = {6, 5, 3, 1, 0, 4, 2};
+  BOOST_CHECK_EQUAL_COLLECTIONS(expected, expected + 7, sa.begin(), sa.end());
+}
+
+BOOST_AUTO_TEST_CASE(repeats) {
+  // Long runs and repeated blocks need several levels of recursion.
+  std::vector<unsigned int> text;
+  for (unsigned int i = 0; i < 50; ++i) text.push_back(1);
+  for (unsigned int block = 0; block < 20; ++block) {
+    text.push_back(2);
+    text.push_back(1);
+    text.push_back(3);
+    text.push_back(1);
+  }
+  text.push_back(0);
+  CheckAgainstSort(text, 4);
+}
+
+BOOST_AUTO_TEST_CASE(pseudo_random) {
+  for (unsigned int alphabet_size = 2; alphabet_size < 100; alphabet_size *= 3) {
+    std::vector<unsigned int> text;
+    unsigned int state = 12345;
+    for (unsigned int i = 0; i < 1000; ++i) {
+      state = state * 1103515245 + 12345;
+      text.push_back(1 + (state >> 16) % (alphabet_size - 1));
+    }
+    text.push_back(0);
+    CheckAgainstSort(text, alphabet_size);
+  }
+}
+
+}} // namespaces
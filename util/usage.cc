@@ -157,6 +157,19 @@ uint64_t RSSMax() {
 #endif
 }
 
+uint64_t RSSCurrent() {
+#if defined(_WIN32) || defined(_WIN64) || defined(__MACH__) || defined(__APPLE__)
+  return 0;
+#else
+  // Second field of statm is the resident page count.
+  std::ifstream statm("/proc/self/statm", std::ios::in);
+  uint64_t size, resident;
+  if (!(statm >> size >> resident))
+    return 0;
+  return resident * static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+#endif
+}
+
 void PrintUsage(std::ostream &out) {
 #if !defined(_WIN32) && !defined(_WIN64)
   // Linux doesn't set memory usage in getrusage :-(
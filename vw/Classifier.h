@@ -7,7 +7,9 @@
 #include <sstream>
 #include <deque>
 #include <vector>
+#include <stdint.h>
 #include <boost/shared_ptr.hpp>
+#include <boost/unordered_map.hpp>
 
 #include <boost/noncopyable.hpp>
 #include <boost/thread/condition_variable.hpp>
@@ -25,6 +27,9 @@ class ezexample;
 namespace Discriminative
 {
 
+typedef std::pair<uint32_t, float> FeatureType; // feature id (assigned by the classifier) and value
+typedef std::vector<FeatureType> FeatureVector;
+
 /**
 * Abstract class to be implemented by classifiers.
 */
@@ -41,6 +46,18 @@ public:
    */
   virtual void AddLabelDependentFeature(const StringPiece &name, float value) = 0;
 
+  /**
+   * Id of a label-dependent feature, e.g. its hash, so that the feature can be added
+   * repeatedly with AddLabelDependentFeatures() without processing its name again.
+   * Ids are only valid for the classifier instance that assigned them.
+   */
+  virtual uint32_t GetLabelDependentFeatureId(const StringPiece &name) = 0;
+
+  /**
+   * Add label-dependent features by their ids.
+   */
+  virtual void AddLabelDependentFeatures(const FeatureVector &features) = 0;
+
   /**
    * Train using current example. Use loss to distinguish positive and negative training examples.
    * Throws away current label-dependent features (so that features for another label/class can now be set).
@@ -53,6 +70,19 @@ public:
    */
   virtual float Predict(const StringPiece &label) = 0;
 
+  /**
+   * Predict the losses of several classes for the current label-independent features,
+   * each class given by its label-dependent features.
+   */
+  virtual void Predict(const StringPiece &label, const std::vector<const FeatureVector*> &classes,
+                       std::vector<float> &losses) {
+    losses.resize(classes.size());
+    for (size_t i = 0; i < classes.size(); i++) {
+      AddLabelDependentFeatures(*classes[i]);
+      losses[i] = Predict(label);
+    }
+  }
+
   // helper methods for indicator features
   void AddLabelIndependentFeature(const StringPiece &name) {
     AddLabelIndependentFeature(name, 1.0);
@@ -97,6 +127,8 @@ public:
 
   virtual void AddLabelIndependentFeature(const StringPiece &name, float value);
   virtual void AddLabelDependentFeature(const StringPiece &name, float value);
+  virtual uint32_t GetLabelDependentFeatureId(const StringPiece &name);
+  virtual void AddLabelDependentFeatures(const FeatureVector &features);
   virtual void Train(const StringPiece &label, float loss);
   virtual float Predict(const StringPiece &label);
 
@@ -109,6 +141,11 @@ private:
   boost::iostreams::filtering_ostream m_bfos;
   std::deque<std::string> m_outputBuffer;
 
+  // escaped names of the features that were given ids
+  boost::unordered_map<std::string, uint32_t> m_featureIds;
+  std::vector<std::string> m_featureNames;
+
+  void StartTarget();
   void WriteBuffer();
 };
 
@@ -123,16 +160,23 @@ public:
 
   virtual void AddLabelIndependentFeature(const StringPiece &name, float value);
   virtual void AddLabelDependentFeature(const StringPiece &name, float value);
+  virtual uint32_t GetLabelDependentFeatureId(const StringPiece &name);
+  virtual void AddLabelDependentFeatures(const FeatureVector &features);
   virtual void Train(const StringPiece &label, float loss);
   virtual float Predict(const StringPiece &label);
+  virtual void Predict(const StringPiece &label, const std::vector<const FeatureVector*> &classes,
+                       std::vector<float> &losses);
 
   friend class ClassifierFactory;
 
 protected:
   void AddFeature(const StringPiece &name, float values);
+  void StartTarget();
 
   ::vw *m_VWInstance, *m_VWParser;
   ::ezexample *m_ex;
+  uint64_t m_targetNamespaceHash; // seed for hashing the features of namespace 't'
+
   // if true, then the VW instance is owned by an external party and should NOT be
   // deleted at end; if false, then we own the VW instance and must clean up after it.
   bool m_sharedVwInstance;
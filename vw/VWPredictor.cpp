@@ -17,6 +17,7 @@ VWPredictor::VWPredictor(const string &modelFile, const string &vwOptions)
   m_sharedVwInstance = false;
   m_ex = new ::ezexample(m_VWInstance, false, m_VWParser);
   m_isFirstSource = m_isFirstTarget = true;
+  m_targetNamespaceHash = VW::hash_space(*m_VWInstance, "t");
 }
 
 VWPredictor::VWPredictor(vw *instance, const string &vwOptions)
@@ -26,6 +27,7 @@ VWPredictor::VWPredictor(vw *instance, const string &vwOptions)
   m_sharedVwInstance = true;
   m_ex = new ::ezexample(m_VWInstance, false, m_VWParser);
   m_isFirstSource = m_isFirstTarget = true;
+  m_targetNamespaceHash = VW::hash_space(*m_VWInstance, "t");
 }
 
 VWPredictor::~VWPredictor()
@@ -57,13 +59,31 @@ void VWPredictor::AddLabelDependentFeature(const StringPiece &name, float value)
   // namespaces, where the source namespace ('s') contains label-independent features and the target
   // namespace ('t') contains label-dependent features
 
+  StartTarget();
+  AddFeature(name, value);
+}
+
+uint32_t VWPredictor::GetLabelDependentFeatureId(const StringPiece &name)
+{
+  // the hash that ezexample::addf() computes for a feature of namespace 't'
+  return VW::hash_feature(*m_VWParser, EscapeSpecialChars(name.as_string()), m_targetNamespaceHash);
+}
+
+void VWPredictor::AddLabelDependentFeatures(const FeatureVector &features)
+{
+  StartTarget();
+  for (FeatureVector::const_iterator it = features.begin(); it != features.end(); ++it)
+    m_ex->addf(it->first, it->second);
+}
+
+void VWPredictor::StartTarget()
+{
   if (m_isFirstTarget) {
     // the first target-side feature => create namespace 't'
     m_isFirstTarget = false;
     m_ex->addns('t');
     if (DEBUG) std::cerr << "VW :: Setting target namespace\n";
   }
-  AddFeature(name, value);
 }
 
 void VWPredictor::Train(const StringPiece &label, float loss)
@@ -82,6 +102,26 @@ float VWPredictor::Predict(const StringPiece &label)
   return loss;
 }
 
+void VWPredictor::Predict(const StringPiece &label, const vector<const FeatureVector*> &classes,
+                          vector<float> &losses)
+{
+  // the source namespace stays in the example, only the target namespace
+  // is replaced for each class
+  m_ex->set_label(label.as_string());
+  losses.resize(classes.size());
+  for (size_t i = 0; i < classes.size(); i++) {
+    m_ex->addns('t');
+    const FeatureVector &features = *classes[i];
+    for (FeatureVector::const_iterator it = features.begin(); it != features.end(); ++it)
+      m_ex->addf(it->first, it->second);
+    losses[i] = m_ex->predict_partial();
+    m_ex->remns();
+  }
+  m_isFirstSource = true;
+  m_isFirstTarget = true;
+  if (DEBUG) std::cerr << "VW :: Predicted losses of " << classes.size() << " classes\n";
+}
+
 void VWPredictor::AddFeature(const StringPiece &name, float value)
 {
   if (DEBUG) std::cerr << "VW :: Adding feature: " << EscapeSpecialChars(name.as_string()) << ":" << value << "\n";
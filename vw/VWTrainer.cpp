@@ -46,6 +46,29 @@ void VWTrainer::AddLabelIndependentFeature(const StringPiece &name, float value)
 }
 
 void VWTrainer::AddLabelDependentFeature(const StringPiece &name, float value)
+{
+  StartTarget();
+  AddFeature(name, value);
+}
+
+uint32_t VWTrainer::GetLabelDependentFeatureId(const StringPiece &name)
+{
+  // the training file needs the names, so ids index the names seen so far
+  pair<boost::unordered_map<string, uint32_t>::iterator, bool> ins
+    = m_featureIds.insert(make_pair(EscapeSpecialChars(name.as_string()), m_featureNames.size()));
+  if (ins.second)
+    m_featureNames.push_back(ins.first->first);
+  return ins.first->second;
+}
+
+void VWTrainer::AddLabelDependentFeatures(const FeatureVector &features)
+{
+  StartTarget();
+  for (FeatureVector::const_iterator it = features.begin(); it != features.end(); ++it)
+    m_outputBuffer.push_back(m_featureNames[it->first] + ":" + SPrint(it->second));
+}
+
+void VWTrainer::StartTarget()
 {
   if (m_isFirstTarget) {
     m_isFirstTarget = false;
@@ -54,8 +77,6 @@ void VWTrainer::AddLabelDependentFeature(const StringPiece &name, float value)
 
     m_outputBuffer.push_back("|t");
   }
-
-  AddFeature(name, value);
 }
 
 void VWTrainer::Train(const StringPiece &label, float loss)